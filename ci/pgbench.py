@@ -520,6 +520,11 @@ class PgBenchTest:
 		parser.add_argument('--checkpoint_timeout', type=check_positive,
 							default=300)
 		parser.add_argument('--max_io_concurrency', type=int, default=0)
+		parser.add_argument('--numa_aware_pools',
+							type=parse_on_off, default='off',
+							help='split orioledb page pools per NUMA node')
+		parser.add_argument('--compress', default=None,
+							help='compression of orioledb tables: zstd level or lz4')
 		parser.add_argument('--initdb',
 							type=parse_on_off_bool, default='on')
 		parser.add_argument('--device_filename', default=None)
@@ -610,10 +615,12 @@ class PgBenchTest:
 								 "orioledb.main_buffers = %s\n"
 								 "orioledb.undo_buffers = %s\n"
 								 "orioledb.checkpoint_completion_ratio = 1.0\n"
-								 "orioledb.max_io_concurrency = %s\n" %
+								 "orioledb.max_io_concurrency = %s\n"
+								 "orioledb.numa_aware_pools = %s\n" %
 								 (args.shared_buffers,
 								  args.undo_buffers,
-								  args.max_io_concurrency))
+								  args.max_io_concurrency,
+								  args.numa_aware_pools))
 
 			if args.device_filename:
 				node.append_conf("orioledb.use_mmap = %s\n"
@@ -671,24 +678,27 @@ class PgBenchTest:
 								   ");\n")
 
 				if 'orioledb' in args.engines:
+					compress_clause = ''
+					if args.compress:
+						compress_clause = " WITH (compress = '%s')" % args.compress
 					node.safe_psql('postgres',
 								   "CREATE TABLE orioledb.pgbench_accounts (\n"
 								   "	aid integer NOT NULL PRIMARY KEY,\n"
 								   "	bid integer,\n"
 								   "	abalance integer,\n"
 								   "	filler character(84)\n"
-								   ") USING orioledb;\n"
+								   ") USING orioledb%s;\n"
 								   "CREATE TABLE orioledb.pgbench_branches (\n"
 								   "	bid integer NOT NULL PRIMARY KEY,\n"
 								   "	bbalance integer,\n"
 								   "	filler character(88)\n"
-								   ") USING orioledb;\n"
+								   ") USING orioledb%s;\n"
 								   "CREATE TABLE orioledb.pgbench_tellers (\n"
 								   "	tid integer NOT NULL PRIMARY KEY,\n"
 								   "	bid integer,\n"
 								   "	tbalance integer,\n"
 								   "	filler character(84)\n"
-								   ") USING orioledb;\n"
+								   ") USING orioledb%s;\n"
 								   "CREATE TABLE orioledb.pgbench_history\n"
 								   "(\n"
 								   "	tid integer NOT NULL,\n"
@@ -698,7 +708,8 @@ class PgBenchTest:
 								   "	mtime timestamp NOT NULL,\n"
 								   "	filler character(22),\n"
 								   "	PRIMARY KEY(bid, mtime, tid, aid, delta)\n"
-								   ") USING orioledb;\n")
+								   ") USING orioledb%s;\n" %
+								   ((compress_clause, ) * 4))
 
 				for engine in args.engines:
 					schema = engineGetSchema(engine)
@@ -0,0 +1,31 @@
+/*-------------------------------------------------------------------------
+ *
+ * adaptive_hash.h
+ *		Declarations for the backend-local adaptive hash index over B-tree
+ *		leaf locations.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/include/btree/adaptive_hash.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef __BTREE_ADAPTIVE_HASH_H__
+#define __BTREE_ADAPTIVE_HASH_H__
+
+#include "btree/btree.h"
+
+extern int	adaptive_hash_max_entries;
+
+extern bool btree_ahi_lookup(BTreeDescr *desc, void *key, BTreeKeyType kind,
+							 uint32 *hash, BTreeLocationHint *hint);
+extern void btree_ahi_update(BTreeDescr *desc, uint32 hash, bool hit,
+							 bool found, OInMemoryBlkno blkno,
+							 uint32 pageChangeCount);
+extern void btree_ahi_get_stats(BTreeDescr *desc, uint32 *nentries,
+								uint64 *hits, uint64 *misses);
+extern void btree_ahi_free(BTreeDescr *desc);
+
+#endif							/* __BTREE_ADAPTIVE_HASH_H__ */
@@ -27,6 +27,7 @@
 #define BTREE_NUM_META_LWLOCKS	(128)
 
 typedef struct BTreeDescr BTreeDescr;
+typedef struct BTreeAdaptiveHash BTreeAdaptiveHash;
 typedef struct BTreeIterator BTreeIterator;
 typedef struct CheckpointFileHeader CheckpointFileHeader;
 
@@ -150,6 +151,14 @@ typedef struct
 							   OTuple newTuple, OXid newOxid);
 	uint32		(*hash) (BTreeDescr *desc, OTuple tuple, BTreeKeyType tupleType);
 	uint32		(*unique_hash) (BTreeDescr *desc, OTuple tuple);
+
+	/*
+	 * Hashes the search key for the adaptive hash index.  Returns false if
+	 * the key can't be hashed.  May be NULL if the tree doesn't support the
+	 * adaptive hash index.
+	 */
+	bool		(*key_hash) (BTreeDescr *desc, void *key, BTreeKeyType keyType,
+							 uint32 *hash);
 	OBTreeKeyCmp cmp;
 } BTreeOps;
 
@@ -179,6 +188,10 @@ struct BTreeDescr
 	OPagePool  *ppool;
 	OCompress	compress;
 	uint8		fillfactor;
+	/* soft limit of the tree pages in memory, 0 if none */
+	OInMemoryBlkno memoryQuota;
+	/* protect the tree pages from eviction */
+	bool		memoryPin;
 	UndoLogType undoType;
 	BTreeStorageType storageType;
 	SeqBufDescPrivate freeBuf;
@@ -187,6 +200,8 @@ struct BTreeDescr
 	BTreeS3PartsInfo buildPartsInfo[2];
 	OXid		createOxid;
 	BTreeOps   *ops;
+	/* backend-local adaptive hash index, see adaptive_hash.c */
+	BTreeAdaptiveHash *ahi;
 };
 
 static inline int
@@ -271,6 +286,12 @@ typedef struct
 #define TREE_NUM_LEAF_PAGES(desc) \
 	(pg_atomic_read_u32(&BTREE_GET_META(desc)->leafPagesNum))
 
+/*
+ * Get number of tree pages in the page pool, the root page excluded.
+ */
+#define TREE_NUM_PAGES_IN_MEMORY(desc) \
+	(pg_atomic_read_u32(&BTREE_GET_META(desc)->numPagesInMemory))
+
 /*
  * Check if given tree needs WAL and XIP records.  Currently, only primary index
  * tree and TOAST tree need it.  Argument is (BTreeDescr *).
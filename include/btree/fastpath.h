@@ -21,6 +21,8 @@
 #define FASTPATH_FIND_DOWNLINK_MAX_KEYS (4)
 #define FASTPATH_FIND_DOWNLINK_FLAG_MINUS_INF (1)
 #define FASTPATH_FIND_DOWNLINK_FLAG_PLUS_INF (2)
+#define FASTPATH_FIND_DOWNLINK_FLAG_NULL (4)
+#define FASTPATH_FIND_DOWNLINK_FLAG_EXCLUSIVE (8)
 
 typedef void (*ArraySearchFunc) (Pointer p, int stride,
 								 int *lower, int *upper, Datum keyDatum);
@@ -36,8 +38,28 @@ typedef struct
 	ArraySearchFunc funcs[FASTPATH_FIND_DOWNLINK_MAX_KEYS];
 	Datum		values[FASTPATH_FIND_DOWNLINK_MAX_KEYS];
 	uint8		flags[FASTPATH_FIND_DOWNLINK_MAX_KEYS];
+
+	/*
+	 * Normalized key prefix search for non-leaf pages, which don't have the
+	 * fixed-stride layout.  The prefix covers the leading exact by-value
+	 * columns followed by at most one column having abbreviated keys.
+	 */
+	bool		prefixEnabled;
+	int			prefixIndexKeys;	/* prefix columns cached per page */
+	int			prefixNumKeys;	/* prefix columns compared for this key */
+	bool		prefixAbbrev[FASTPATH_FIND_DOWNLINK_MAX_KEYS];
+	Datum		prefixValues[FASTPATH_FIND_DOWNLINK_MAX_KEYS];
+	uint8		prefixFlags[FASTPATH_FIND_DOWNLINK_MAX_KEYS];
 } FastpathFindDownlinkMeta;
 
+/* Instruction set used by the array search kernels */
+typedef enum
+{
+	FastpathSimdNone = 0,
+	FastpathSimdSSE42 = 1,
+	FastpathSimdAVX2 = 2
+} FastpathSimdLevel;
+
 typedef enum
 {
 	OBTreeFastPathFindOK,
@@ -46,6 +68,9 @@ typedef enum
 	OBTreeFastPathFindSlowpath
 } OBTreeFastPathFindResult;
 
+extern FastpathSimdLevel fastpath_simd_level;
+
+extern void fastpath_init_array_search(void);
 extern void can_fastpath_find_downlink(OBTreeFindPageContext *context,
 									   void *key,
 									   BTreeKeyType keyType,
@@ -59,5 +84,10 @@ extern OBTreeFastPathFindResult fastpath_find_downlink(Pointer pagePtr,
 													   FastpathFindDownlinkMeta *meta,
 													   BTreePageItemLocator *loc,
 													   BTreeNonLeafTuphdr **tuphdrPtr);
+extern void fastpath_prefix_search_items(BTreeDescr *desc, Pointer pagePtr,
+										 OInMemoryBlkno blkno,
+										 FastpathFindDownlinkMeta *meta,
+										 void *key, BTreeKeyType keyType,
+										 BTreePageItemLocator *loc);
 
 #endif							/* __BTREE_FASTPATH_H__ */
@@ -67,6 +67,12 @@ typedef struct
 	 */
 	OFixedKey	undoLokey;
 	uint16		flags;
+
+	/*
+	 * btree_dirty_chkp_num() as of the path start from the root, zero if
+	 * there was no such start.
+	 */
+	uint32		chkpNum;
 } OBTreeFindPageContext;
 
 /* OBTreeFindPageContext flags */
@@ -97,6 +103,13 @@ typedef enum
 extern bool btree_page_search(BTreeDescr *desc, Page p, Pointer key,
 							  BTreeKeyType keyType, PartialPageState *partial,
 							  BTreePageItemLocator *locator);
+extern bool btree_page_search_chunk(BTreeDescr *desc, Page p, Pointer key,
+									BTreeKeyType keyType,
+									PartialPageState *partial,
+									BTreePageItemLocator *locator);
+extern void btree_page_search_items(BTreeDescr *desc, Page p, Pointer key,
+									BTreeKeyType keyType,
+									BTreePageItemLocator *locator);
 extern void init_page_find_context(OBTreeFindPageContext *context,
 								   BTreeDescr *desc,
 								   CommitSeqNo csn, uint16 flags);
@@ -110,6 +123,7 @@ extern OFindPageResult refind_page(OBTreeFindPageContext *context, void *key,
 extern bool find_right_page(OBTreeFindPageContext *context, OFixedKey *hikey);
 extern bool find_left_page(OBTreeFindPageContext *context, OFixedKey *hikey);
 extern OTuple btree_find_context_lokey(OBTreeFindPageContext *context);
+extern void btree_find_context_mark_dirty(OBTreeFindPageContext *context);
 extern void btree_find_context_from_modify_to_read(OBTreeFindPageContext *context,
 												   Pointer key,
 												   BTreeKeyType keyType,
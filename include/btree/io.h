@@ -49,11 +49,18 @@ extern int	btree_smgr_read(BTreeDescr *desc, char *buffer, uint32 chkpNum,
 							int amount, off_t offset);
 extern void btree_smgr_writeback(BTreeDescr *desc, uint32 chkpNum,
 								 off_t offset, int amount);
+extern void btree_smgr_prefetch(BTreeDescr *desc, uint32 chkpNum,
+								off_t offset, int amount);
 extern void btree_smgr_sync(BTreeDescr *desc, uint32 chkpNum, off_t length);
 extern void btree_smgr_punch_hole(BTreeDescr *desc, uint32 chkpNum,
 								  off_t offset, int length);
 extern void init_btree_io_lwlocks(void);
 extern bool read_page_from_disk(BTreeDescr *desc, Pointer img, uint64 downlink, FileExtent *extent);
+extern void btree_downlink_get_disk_range(BTreeDescr *desc, uint64 downlink,
+										  off_t *offset, int *amount);
+extern void btree_prefetch_downlink(BTreeDescr *desc, uint64 downlink);
+extern bool btree_relocate_disk_page(BTreeDescr *desc, uint64 downlink,
+									 uint32 chkpNum, uint64 *new_downlink);
 extern void load_page(OBTreeFindPageContext *context);
 extern uint64 perform_page_io(BTreeDescr *desc, OInMemoryBlkno blkno,
 							  Page img, uint32 checkpoint_number,
@@ -62,6 +69,8 @@ extern uint64 perform_page_io_autonomous(BTreeDescr *desc, uint32 chkpNum,
 										 Page img, FileExtent *extent);
 extern uint64 perform_page_io_build(BTreeDescr *desc, Page img,
 									FileExtent *extent, BTreeMetaPage *metaPageBlkno);
+extern void btree_offload_compression(BTreeDescr *desc, uint32 chkpNum,
+									  uint64 *downlinks, int count);
 extern BTreeDescr *index_oids_get_btree_descr(ORelOids oids, OIndexType type);
 extern void try_to_punch_holes(BTreeDescr *desc);
 
@@ -43,6 +43,12 @@ extern OTuple o_btree_find_tuple_by_key(BTreeDescr *desc, void *key,
 										MemoryContext mcxt,
 										BTreeLocationHint *hint);
 
+extern void o_btree_find_tuples_by_keys(BTreeDescr *desc, void **keys,
+										int nkeys, BTreeKeyType kind,
+										OSnapshot *read_o_snapshot,
+										MemoryContext mcxt, OTuple *results,
+										CommitSeqNo *out_csns);
+
 extern BTreeIterator *o_btree_iterator_create(BTreeDescr *desc, void *key,
 											  BTreeKeyType kind,
 											  OSnapshot *o_snapshot,
@@ -65,6 +65,13 @@ extern OBTreeModifyResult o_btree_modify(BTreeDescr *desc,
 										 RowLockMode lockMode,
 										 BTreeLocationHint *hint,
 										 BTreeModifyCallbackInfo *callbackInfo);
+extern OBTreeModifyResult o_btree_insert_sorted(BTreeDescr *desc,
+												OTuple tuple,
+												Pointer key,
+												BTreeKeyType keyType,
+												OXid oxid, CommitSeqNo csn,
+												BTreeLocationHint *hint,
+												BTreeModifyCallbackInfo *callbackInfo);
 extern OBTreeModifyResult o_btree_delete_moved_partitions(BTreeDescr *desc,
 														  Pointer key,
 														  BTreeKeyType keyType,
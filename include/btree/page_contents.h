@@ -17,8 +17,24 @@
 #include "btree/page_state.h"
 #include "s3/queue.h"
 
+#include "datatype/timestamp.h"
+
 #define NUM_SEQ_SCANS_ARRAY_SIZE	32
 
+/* Size of the free extents front cache, see free_extents.c */
+#define EXTENT_CACHE_MAX_LEN		16
+#define EXTENT_CACHE_SLOTS			8
+
+/* Page churn events counted per tree, see btree_count_event() */
+typedef enum
+{
+	BTreeEventLoad,
+	BTreeEventEviction,
+	BTreeEventSplit,
+	BTreeEventMerge,
+	BTreeEventsCount
+} BTreeEventType;
+
 /* The structure of BTree meta page.  Referenced by metaPageBlkno. */
 typedef struct
 {
@@ -28,6 +44,13 @@ typedef struct
 	SeqBufDescShared tmpBuf[2];
 	pg_atomic_uint64 numFreeBlocks;
 	pg_atomic_uint64 datafileLength[2];
+
+	/*
+	 * Free extents front cache of compressed trees: slots per extent length
+	 * holding (offset + 1) or zero, and the end of the last given extent.
+	 */
+	pg_atomic_uint64 freeExtentSlots[EXTENT_CACHE_MAX_LEN][EXTENT_CACHE_SLOTS];
+	pg_atomic_uint64 lastExtentEnd;
 	LWLock		metaLock;
 	LWLock		copyBlknoLock;
 
@@ -49,10 +72,35 @@ typedef struct
 	bool		dirtyFlag1;
 	bool		dirtyFlag2;
 
+	/*
+	 * Checkpoints up to this number have to descend into every in-memory
+	 * subtree of the tree.  See btree_mark_subtrees_dirty().
+	 */
+	pg_atomic_uint32 dirtyChkpNum;
+
+	/*
+	 * Number of the pending leaves compaction request, zero if none.  See
+	 * orioledb_tbl_compact().
+	 */
+	pg_atomic_uint32 compactRequest;
+
 	BTreeS3PartsInfo partsInfo[2];
 
 	LWLock		punchHolesLock;
 	uint32		punchHolesChkpNum;
+
+	/*
+	 * Compression dictionary for the new page images: number and ID packed
+	 * by O_COMPRESS_DICT_MAKE(), zero if none.
+	 */
+	pg_atomic_uint64 compressDict;
+
+	/* Number of the tree pages in the page pool except the root */
+	pg_atomic_uint32 numPagesInMemory;
+
+	/* Page churn counters since the tree was loaded at statsSince */
+	pg_atomic_uint64 numEvents[BTreeEventsCount];
+	TimestampTz statsSince;
 } BTreeMetaPage;
 
 StaticAssertDecl(sizeof(BTreeMetaPage) <= ORIOLEDB_BLCKSZ,
@@ -358,6 +406,15 @@ extern UndoLocation read_page_from_undo(BTreeDescr *desc, Page img,
 										CommitSeqNo csn, void *key,
 										BTreeKeyType keyType, OFixedKey *lokey);
 
+extern void btree_inc_pages_in_memory(BTreeDescr *desc);
+extern void btree_dec_pages_in_memory(BTreeDescr *desc);
+extern void btree_count_event(BTreeDescr *desc, BTreeEventType type);
+extern uint32 btree_dirty_chkp_num(void);
+extern void btree_page_mark_subtree_dirty(OInMemoryBlkno blkno, uint32 chkpNum);
+extern void btree_page_inherit_subtree_dirty(OInMemoryBlkno blkno,
+											 OInMemoryBlkno srcBlkno);
+extern bool btree_may_skip_subtrees(BTreeDescr *desc);
+extern void btree_mark_subtrees_dirty(BTreeDescr *desc, uint32 chkpNum);
 extern void init_new_btree_page(BTreeDescr *desc, OInMemoryBlkno blkno,
 								uint16 flags, uint16 level, bool noLock);
 extern void init_meta_page(OInMemoryBlkno blkno, uint32 leafPagesNum);
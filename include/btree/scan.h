@@ -35,6 +35,7 @@ typedef struct BTreeSeqScanCallbacks
 } BTreeSeqScanCallbacks;
 
 extern BTreeScanShmem *btreeScanShmem;
+extern int	seqscan_readahead;
 
 extern Size btree_scan_shmem_needs(void);
 extern void btree_scan_init_shmem(Pointer ptr, bool found);
@@ -18,6 +18,9 @@
 
 extern FileExtent get_extent(BTreeDescr *desc, uint16 len);
 extern void free_extent(BTreeDescr *desc, FileExtent extent);
+extern int	free_extents_cache_drain(BTreeDescr *desc, FileExtent *extents);
+extern void free_extents_cache_return(BTreeDescr *desc, FileExtent *extents,
+									  int num);
 
 typedef void (*ForEachExtentCallback) (BTreeDescr *desc, FileExtent extent, void *arg);
 extern void foreach_free_extent(BTreeDescr *desc, ForEachExtentCallback callback,
@@ -77,6 +77,8 @@ typedef struct
 	 */
 	List	   *duplicates;
 	Oid			tablespace;
+	int32		memoryQuota;
+	bool		memoryPin;
 	MemoryContext index_mctx;
 } OIndex;
 
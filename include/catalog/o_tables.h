@@ -106,6 +106,8 @@ typedef struct
 	OTableField *fields;
 	AttrMissing *missing;		/* missing attributes values, NULL if none */
 	Oid			tablespace;
+	int32		memory_quota;	/* soft limit per tree in pages, 0 if none */
+	bool		memory_pin;		/* protect the tree pages from eviction */
 	uint32		version;		/* not serialized in serialize_o_table */
 	MemoryContext tbl_mctx;		/* not serialized in serialize_o_table */
 } OTable;
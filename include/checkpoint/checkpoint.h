@@ -20,6 +20,7 @@
 #include "rewind/rewind.h"
 
 #include "access/xlogdefs.h"
+#include "datatype/timestamp.h"
 
 struct CheckpointFileHeader
 {
@@ -155,10 +156,36 @@ typedef struct
 	CurKeyType	curKeyType;
 	OFixedShmemKey curKeyValue;
 	CheckpointPageInfo stack[ORIOLEDB_MAX_DEPTH];
+
+	/*
+	 * Leaves compaction of the current tree: the request being served, the
+	 * number of leaves relocated and the end of the last leaf extent.  See
+	 * checkpoint_compact_leaf().
+	 */
+	uint32		compactRequest;
+	int			compactPages;
+	uint64		compactPrevEnd;
 	/* pid of the worker */
 	pid_t		pid;
 	double		dirtyPagesEstimate;
-	uint64		pagesWritten;
+	/* written by checkpointer and checkpoint workers */
+	pg_atomic_uint64 pagesWritten;
+	/* start of the checkpoint, checkpoint workers are paced against it */
+	TimestampTz startTime;
+	/* number of processes writing the checkpoint */
+	int			pacingWriters;
+
+	/*
+	 * Adaptive pacing of the checkpoint writes: the current target write rate
+	 * (pages per second, zero if unthrottled), the moving average of the
+	 * writeback latency (microseconds) and the writeback batch size (blocks).
+	 * See checkpoint_pacing_delay().
+	 */
+	pg_atomic_uint64 pacingTargetRate;
+	pg_atomic_uint64 pacingLatency;
+	pg_atomic_uint32 pacingBatch;
+	/* number of in-memory subtrees skipped by checkpoints since startup */
+	pg_atomic_uint64 skippedSubtrees;
 	/* helps to avoid skip a new table for the checkpoint in progress */
 	int			oTablesMetaTrancheId;
 	LWLock		oTablesMetaLock;
@@ -222,6 +249,7 @@ typedef struct
 	} while (0)
 
 extern CheckpointState *checkpoint_state;
+extern bool IsCheckpointWorker;
 
 extern Size checkpoint_shmem_size(void);
 extern void checkpoint_shmem_init(Pointer ptr, bool found);
@@ -237,6 +265,11 @@ extern void o_after_checkpoint_cleanup_hook(XLogRecPtr checkPointRedo,
 extern bool page_is_under_checkpoint(BTreeDescr *desc, OInMemoryBlkno blkno,
 									 bool includingHikeyBlkno);
 extern bool tree_is_under_checkpoint(BTreeDescr *desc);
+extern bool tree_checkpoint_in_progress(BTreeDescr *desc);
+extern CheckpointState *tree_checkpoint_state(BTreeDescr *desc);
+extern bool checkpoint_has_hikey_blkno(int level, OInMemoryBlkno blkno);
+extern void checkpoint_move_hikey_blkno(int level, OInMemoryBlkno blkno,
+										OInMemoryBlkno newBlkno);
 extern bool get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno, uint32 *checkpoint_number, bool *copy_blkno);
 extern uint32 get_cur_checkpoint_number(ORelOids *oids, OIndexType type, bool *checkpoint_concurrent);
 extern bool can_use_checkpoint_extents(BTreeDescr *desc, uint32 chkp_num);
@@ -257,5 +290,7 @@ extern void systrees_lock_callback(UndoLogType undoType,
 extern void before_writing_xids_file(int chkpnum);
 extern void write_to_xids_queue(XidFileRec *rec);
 void		checkpoint_write_rewind_item(RewindItem *rewindItem);
+extern void register_checkpoint_worker(int num);
+PGDLLEXPORT void checkpoint_worker_main(Datum);
 
 #endif							/* __CHECKPOINT_H__ */
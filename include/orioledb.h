@@ -73,7 +73,7 @@
  */
 #define ORIOLEDB_DATA_VERSION	2	/* Version of system catalog */
 #define ORIOLEDB_PAGE_VERSION	1	/* Version of binary page format */
-#define ORIOLEDB_COMPRESS_VERSION 1 /* Version of page compression (only for
+#define ORIOLEDB_COMPRESS_VERSION 2 /* Version of page compression (only for
 									 * compressed pages) */
 
 /*
@@ -295,15 +295,23 @@ typedef struct
 	uint16		compress_page_size; /* Reserved for compressed pages. Empty
 									 * for non-compressed */
 	uint8		compress_version;	/* Reserved for compressed pages. Empty
-									 * for non-compressed */
+									 * for non-compressed.  Higher bits
+									 * contain the codec, see
+									 * O_COMPRESS_VERSION_MAKE() */
 
 	/*
 	 * Version of binary page format for possible conversion. For compressed
 	 * pages it should be used for conversion of uncompressed images
 	 */
 	uint8		page_version;
-	uint32		reserved1;
-	uint32		reserved2;
+
+	/*
+	 * Number of the tree compression dictionary used for the compressed page
+	 * or zero if no dictionary is used.  The dictionary ID is checked against
+	 * the loaded dictionary to detect the stale one after relnode reuse.
+	 */
+	uint32		compress_dict_num;
+	uint32		compress_dict_id;
 } OrioleDBOndiskPageHeader;
 
 #define O_PAGE_HEADER_SIZE		sizeof(OrioleDBPageHeader)
@@ -341,6 +349,13 @@ typedef struct
 	uint32		flags:4,
 				type:28;
 	OInMemoryBlkno leftBlkno;
+
+	/*
+	 * The last checkpoint number, which has to descend into the subtree of
+	 * this non-leaf page, because some of its descendants might be modified.
+	 * See btree_find_context_mark_dirty().
+	 */
+	pg_atomic_uint32 dirtyChkpNum;
 } OrioleDBPageDesc;
 
 /* orioledb.c */
@@ -360,7 +375,13 @@ extern int	max_procs;
 extern OrioleDBPageDesc *page_descs;
 extern bool remove_old_checkpoint_files;
 extern bool skip_unmodified_trees;
+extern bool skip_unmodified_subtrees;
 extern bool debug_disable_bgwriter;
+extern int	bgwriter_num_workers;
+extern int	checkpoint_num_workers;
+extern int	compaction_pages_per_checkpoint;
+extern bool checkpoint_adaptive_pacing;
+extern int	checkpoint_writeback_latency;
 extern MemoryContext btree_insert_context;
 extern MemoryContext btree_seqscan_context;
 extern double o_checkpoint_completion_ratio;
@@ -408,10 +429,15 @@ extern bool orioledb_strict_mode;
 
 extern void orioledb_check_shmem(void);
 
+/*
+ * Compression level of zstd or O_COMPRESS_LZ4, which selects the LZ4 codec.
+ */
 typedef int OCompress;
 #define O_COMPRESS_DEFAULT (10)
+#define O_COMPRESS_LZ4 (1000)
 #define InvalidOCompress (-1)
 #define OCompressIsValid(compress) ((compress) != InvalidOCompress)
+#define OCompressIsLZ4(compress) ((compress) == O_COMPRESS_LZ4)
 
 typedef struct ORelOptions
 {
@@ -420,6 +446,8 @@ typedef struct ORelOptions
 	int			primary_compress_offset;
 	int			toast_compress_offset;
 	bool		index_bridging;
+	int			memory_quota;
+	bool		memory_pin;
 } ORelOptions;
 
 typedef struct OBTOptions
@@ -294,6 +294,10 @@ extern OComparator *o_find_comparator(Oid opfamily,
 									  Oid collation);
 extern int	o_call_comparator(OComparator *comparator, Datum left,
 							  Datum right);
+extern bool o_comparator_can_abbreviate(OComparator *comparator);
+extern Datum o_call_abbrev_converter(OComparator *comparator, Datum value);
+extern int	o_call_abbrev_comparator(OComparator *comparator, Datum left,
+									 Datum right);
 extern void o_invalidate_comparator_cache(Oid opfamily, Oid lefttype,
 										  Oid righttype);
 
@@ -320,6 +320,7 @@ extern PendingTruncatesMeta *pending_truncates_meta;
 										&oProcData[MYPROCNUMBER].undoStackLocations[oProcData[MYPROCNUMBER].autonomousNestingLevel][(int) (undoType)])
 
 extern Size undo_shmem_needs(void);
+extern Size undo_circular_buffers_size(void);
 extern void undo_shmem_init(Pointer buf, bool found);
 extern UndoMeta *get_undo_meta_by_type(UndoLogType undoType);
 
@@ -14,9 +14,49 @@
 #ifndef __COMPRESS_H__
 #define __COMPRESS_H__
 
+/* Codec of the compressed page */
+typedef enum
+{
+	OCompressCodecZstd = 0,
+	OCompressCodecLZ4 = 1
+} OCompressCodec;
+
+/*
+ * compress_version of the on-disk page header contains the format version in
+ * the lower bits and the codec in the higher bits.  Pages written before
+ * codecs were introduced are zstd-compressed and have zero higher bits.
+ */
+#define O_COMPRESS_VERSION_MAKE(codec) \
+	((uint8) (ORIOLEDB_COMPRESS_VERSION | ((codec) << 4)))
+#define O_COMPRESS_VERSION_GET(version) ((version) & 0x0F)
+#define O_COMPRESS_VERSION_GET_CODEC(version) ((OCompressCodec) ((version) >> 4))
+#define O_COMPRESS_CODEC(compress) \
+	(OCompressIsLZ4(compress) ? OCompressCodecLZ4 : OCompressCodecZstd)
+
+/* Compression dictionary of the tree loaded into the backend memory */
+typedef struct OCompressDict OCompressDict;
+
+/* Packs the dictionary number and ID into uint64 */
+#define O_COMPRESS_DICT_MAKE(num, id) (((uint64) (num) << 32) | (uint64) (id))
+#define O_COMPRESS_DICT_GET_NUM(dict) ((uint32) ((dict) >> 32))
+#define O_COMPRESS_DICT_GET_ID(dict) ((uint32) (dict))
+
+/* Maximal size of the trained dictionary */
+#define O_COMPRESS_DICT_MAX_SIZE	(32 * 1024)
+
 extern void o_compress_init(void);
-extern Pointer o_compress_page(Pointer page, size_t *size, OCompress lvl);
-extern void o_decompress_page(Pointer src, size_t size, Pointer page);
+extern Pointer o_compress_page(Pointer page, size_t *size, OCompress lvl,
+							   OCompressDict *dict);
+extern void o_decompress_page(Pointer src, size_t size, Pointer page,
+							  OCompressCodec codec, OCompressDict *dict);
+extern OCompressDict *o_compress_get_dict(Oid datoid, Oid relnode,
+										  uint32 num, uint32 id);
+extern uint64 o_compress_find_latest_dict(Oid datoid, Oid relnode);
+extern size_t o_compress_train_dict(Pointer samples, size_t *sampleSizes,
+									int nsamples, Pointer dict,
+									size_t capacity);
+extern uint64 o_compress_save_dict(Oid datoid, Oid relnode, uint32 num,
+								   Pointer data, size_t size);
 extern OCompress o_compress_max_lvl(void);
 extern void validate_compress(OCompress compress, char *prefix);
 
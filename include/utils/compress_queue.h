@@ -0,0 +1,35 @@
+/*-------------------------------------------------------------------------
+ *
+ * compress_queue.h
+ *		Declarations for the queue of page images compressed by background
+ *		writers.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/include/utils/compress_queue.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef __COMPRESS_QUEUE_H__
+#define __COMPRESS_QUEUE_H__
+
+extern int	compress_offload_pages;
+
+extern Size o_compress_queue_shmem_needs(void);
+extern void o_compress_queue_shmem_init(Pointer ptr, bool found);
+extern int	o_compress_queue_free_slots(void);
+extern bool o_compress_queue_put(OInMemoryBlkno blkno, Oid datoid, Oid relnode,
+								 OCompress compress, uint64 compressDict,
+								 Page page, uint32 chkpNum);
+extern void o_compress_queue_wakeup(void);
+extern Pointer o_compress_queue_take(OInMemoryBlkno blkno, Oid datoid,
+									 Oid relnode, Page page,
+									 OCompress compress, uint64 compressDict,
+									 size_t *size);
+extern void o_compress_queue_reset(void);
+extern void o_compress_queue_register_worker(void);
+extern void o_compress_queue_process(void);
+
+#endif							/* __COMPRESS_QUEUE_H__ */
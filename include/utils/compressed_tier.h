@@ -0,0 +1,29 @@
+/*-------------------------------------------------------------------------
+ *
+ * compressed_tier.h
+ *		Declarations for the compressed in-memory tier of evicted pages.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/include/utils/compressed_tier.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef __COMPRESSED_TIER_H__
+#define __COMPRESSED_TIER_H__
+
+extern int	compressed_buffers_guc;
+
+extern Size o_compressed_tier_shmem_needs(void);
+extern void o_compressed_tier_shmem_init(Pointer ptr, bool found);
+extern void o_compressed_tier_put(Oid datoid, Oid relnode, uint64 downlink,
+								  Page page);
+extern bool o_compressed_tier_take(Oid datoid, Oid relnode, uint64 downlink,
+								   Page page);
+extern void o_compressed_tier_forget(Oid datoid, Oid relnode, uint64 offset);
+extern void o_compressed_tier_get_stats(uint64 *puts, uint64 *hits,
+										uint64 *misses);
+
+#endif							/* __COMPRESSED_TIER_H__ */
@@ -0,0 +1,39 @@
+/*-------------------------------------------------------------------------
+ *
+ * o_io_uring.h
+ * 		Declarations for io_uring-based batched writeback of data files.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/include/utils/o_io_uring.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef __O_IO_URING_H__
+#define __O_IO_URING_H__
+
+typedef enum
+{
+	OIOMethodSync,
+	OIOMethodIoUring
+} OIOMethod;
+
+/*
+ * Single writeback request: the range of the file to be flushed.
+ */
+typedef struct
+{
+	int			fd;
+	int			amount;
+	off_t		offset;
+} OIORequest;
+
+extern int	orioledb_io_method;
+
+extern bool o_io_uring_enabled(void);
+extern bool o_io_uring_writeback(OIORequest *requests, int nrequests,
+								 uint32 wait_event_info);
+
+#endif							/* __O_IO_URING_H__ */
@@ -0,0 +1,45 @@
+/*-------------------------------------------------------------------------
+ *
+ * o_mem_region.h
+ *		Declarations for the separately mapped region of OrioleDB buffers.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/include/utils/o_mem_region.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef __O_MEM_REGION_H__
+#define __O_MEM_REGION_H__
+
+typedef enum
+{
+	OHugePagesOff,
+	OHugePagesTry,
+	OHugePagesOn
+} OHugePagesMode;
+
+/*
+ * Items placed in the region.  Page pools go first, so that they start at
+ * the huge page boundary.
+ */
+typedef enum
+{
+	OMemRegionPagePools,
+	OMemRegionUndo,
+	OMemRegionItemsCount
+} OMemRegionItem;
+
+extern int	orioledb_huge_pages;
+extern int	orioledb_huge_page_size;
+extern bool orioledb_prefault_buffers;
+
+extern bool o_mem_region_enabled(void);
+extern void o_mem_region_map(Size sizes[OMemRegionItemsCount]);
+extern Pointer o_mem_region_get(OMemRegionItem item);
+extern void o_mem_region_prefault(void);
+extern Size o_mem_region_page_size(void);
+
+#endif							/* __O_MEM_REGION_H__ */
@@ -0,0 +1,24 @@
+/*-------------------------------------------------------------------------
+ *
+ * o_numa.h
+ *		Declarations for NUMA placement of the page pools.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/include/utils/o_numa.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef __O_NUMA_H__
+#define __O_NUMA_H__
+
+extern bool numa_aware_pools;
+
+extern int	o_numa_nodes_count(void);
+extern int	o_numa_current_node(void);
+extern void o_numa_bind_memory(Pointer ptr, Size size, int node);
+extern void o_numa_run_on_node(int node);
+
+#endif							/* __O_NUMA_H__ */
@@ -43,7 +43,11 @@ struct OPagePool
 	pg_atomic_uint64 *availablePagesCount;
 	/* count of dirty pages in the pool */
 	pg_atomic_uint32 *dirtyPagesCount;
-	/* init position for the ucm */
+	/* total count of pages taken from availablePagesCount */
+	pg_atomic_uint64 *allocatedPagesCount;
+	/* free pages headroom background writers try to keep */
+	pg_atomic_uint32 *targetFreePagesCount;
+	/* init position for the ucm, clock hand of the background writer */
 	OInMemoryBlkno location;
 	/* offset of the pool in the o_shared_buffers */
 	OInMemoryBlkno offset;
@@ -51,6 +55,13 @@ struct OPagePool
 	OInMemoryBlkno size;
 	/* reserved pages count by type array */
 	OInMemoryBlkno numPagesReserved[PPOOL_RESERVE_COUNT];
+	/* pages taken from availablePagesCount but not yet reserved by kind */
+	OInMemoryBlkno numPagesCached;
+	/* number of pages moved to the backend cache at once */
+	OInMemoryBlkno cacheBatch;
+	/* number of NUMA partitions and the partition local to the backend */
+	int			nPartitions;
+	int			partition;
 	/* usage counter map and their size in shared memory */
 	UsageCountMap ucm;
 	Size		ucmShmemSize;
@@ -63,10 +74,23 @@ extern void ppool_shmem_init(OPagePool *pool, Pointer ptr, bool found);
 extern OInMemoryBlkno ppool_free_pages_count(OPagePool *pool);
 extern OInMemoryBlkno ppool_dirty_pages_count(OPagePool *pool);
 extern void ppool_run_clock(OPagePool *pool, bool evict, volatile sig_atomic_t *shutdown_requested);
+extern bool ppool_run_clock_region(OPagePool *pool, bool evict,
+								   OInMemoryBlkno start, OInMemoryBlkno end,
+								   volatile sig_atomic_t *shutdown_requested);
+extern void ppool_worker_region(OPagePool *pool, int num, int nworkers,
+								OInMemoryBlkno *start, OInMemoryBlkno *end);
+extern int	ppool_partition_worker(OPagePool *pool, int nworkers);
 
 extern void ppool_reserve_pages(OPagePool *pool, int kind, int count);
 extern void ppool_release_reserved(OPagePool *pool, uint32 mask);
 extern void ppool_release_all_pages(void);
+extern void ppool_flush_caches(void);
+extern void ppool_bind_worker(int num);
+extern void ppool_ring_begin(void);
+extern void ppool_ring_end(void);
+extern void ppool_ring_reset(void);
+extern void ppool_ring_add(OInMemoryBlkno blkno);
+extern void ppool_ring_recycle(OPagePool *pool);
 extern OInMemoryBlkno ppool_get_metapage(OPagePool *pool);
 extern OInMemoryBlkno ppool_get_page(OPagePool *pool, int kind);
 extern void ppool_free_page(OPagePool *pool, OInMemoryBlkno blkno, bool haveLock);
@@ -33,18 +33,24 @@ typedef struct UsageCountMap
 	uint32		usageCounter;
 } UsageCountMap;
 
+extern bool scan_resistant_eviction;
+
 extern Size estimate_ucm_space(UsageCountMap *map, OInMemoryBlkno offset, OInMemoryBlkno size);
 extern void init_ucm(UsageCountMap *map, Pointer ptr, bool found);
 extern void ucm_inc(UsageCountMap *map, OInMemoryBlkno blkno, int prev, int next);
 extern void page_inc_usage_count(UsageCountMap *map, OInMemoryBlkno blkno);
 extern void page_change_usage_count(UsageCountMap *map, OInMemoryBlkno blkno, uint32 usageCount);
+extern uint32 ucm_load_usage_count(UsageCountMap *map, bool lowPriority);
+extern void ucm_protect_page(UsageCountMap *map, OInMemoryBlkno blkno);
 extern bool ucm_check_map(UsageCountMap *map);
 extern bool ucm_epoch_needs_shift(UsageCountMap *map);
 extern void ucm_epoch_shift(UsageCountMap *map);
 extern OInMemoryBlkno ucm_next_blkno(UsageCountMap *map, OInMemoryBlkno init_blkno, uint32 mask_src);
-extern OInMemoryBlkno ucm_occupy_free_page(UsageCountMap *map);
+extern OInMemoryBlkno ucm_occupy_free_page(UsageCountMap *map, OInMemoryBlkno init_blkno);
 extern void set_skip_ucm(void);
 extern void unset_skip_ucm(void);
+extern void set_ucm_scan_mode(void);
+extern void unset_ucm_scan_mode(void);
 
 static inline uint64
 ucm_update_state(UsageCountMap *map, OInMemoryBlkno blkno, uint64 state)
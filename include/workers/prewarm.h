@@ -0,0 +1,30 @@
+/*-------------------------------------------------------------------------
+ *
+ * prewarm.h
+ *		Declarations for saving and restoring the main pool working set.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/include/workers/prewarm.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef __PREWARM_H__
+#define __PREWARM_H__
+
+#define PREWARM_FILENAME	ORIOLEDB_DATA_DIR"/prewarm"
+
+extern bool prewarm_enabled;
+extern int	prewarm_interval;
+extern int	prewarm_num_workers;
+
+extern Size prewarm_shmem_needs(void);
+extern void prewarm_shmem_init(Pointer ptr, bool found);
+extern void o_prewarm_dump(void);
+extern void o_prewarm_dump_if_due(void);
+extern void register_prewarm_worker(int num);
+PGDLLEXPORT void prewarm_worker_main(Datum);
+
+#endif							/* __PREWARM_H__ */
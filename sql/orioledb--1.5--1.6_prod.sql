@@ -7,3 +7,83 @@ CREATE FUNCTION pg_stopevent_set(eventname text, condition jsonpath, flags text)
 RETURNS void
 AS 'MODULE_PATHNAME'
 LANGUAGE C STRICT;
+
+CREATE FUNCTION orioledb_get_adaptive_hash_stats(OUT datoid oid,
+                                                 OUT reloid oid,
+                                                 OUT relnode oid,
+                                                 OUT nentries int4,
+                                                 OUT hits int8,
+                                                 OUT misses int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+CREATE FUNCTION orioledb_tbl_train_compress_dict(relid oid)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+CREATE FUNCTION orioledb_tbl_compact(relid oid)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+CREATE FUNCTION orioledb_tbl_compact_pending(relid oid)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+CREATE FUNCTION orioledb_checkpoint_pacing(OUT target_rate float8,
+                                           OUT writeback_batch int4,
+                                           OUT writeback_latency float8)
+RETURNS record
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+CREATE FUNCTION orioledb_checkpoint_skipped_subtrees()
+RETURNS int8
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+CREATE FUNCTION orioledb_compressed_tier_stats(OUT puts int8,
+                                               OUT hits int8,
+                                               OUT misses int8)
+RETURNS record
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+DROP FUNCTION orioledb_page_stats();
+CREATE FUNCTION orioledb_page_stats(OUT pool_name text,
+                                    OUT busy_pages int8,
+                                    OUT free_pages int8,
+                                    OUT dirty_pages int8,
+                                    OUT all_pages int8,
+                                    OUT memory_page_size int8,
+                                    OUT tlb_entries int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+CREATE FUNCTION orioledb_get_tree_stats(OUT datoid oid,
+                                        OUT reloid oid,
+                                        OUT relnode oid,
+                                        OUT pages int8,
+                                        OUT pages_by_level int8[],
+                                        OUT dirty_pages int8,
+                                        OUT avg_usage float8,
+                                        OUT loads int8,
+                                        OUT evictions int8,
+                                        OUT splits int8,
+                                        OUT merges int8,
+                                        OUT loads_per_sec float8,
+                                        OUT evictions_per_sec float8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+VOLATILE LANGUAGE C;
+
+CREATE VIEW orioledb_tree_stats AS
+  SELECT * FROM orioledb_get_tree_stats();
+
+CREATE VIEW orioledb_tree_residency AS
+  SELECT datoid, reloid, relnode, pages, dirty_pages
+  FROM orioledb_get_tree_stats();
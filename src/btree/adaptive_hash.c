@@ -0,0 +1,262 @@
+/*-------------------------------------------------------------------------
+ *
+ * adaptive_hash.c
+ *		Backend-local adaptive hash index over B-tree leaf locations.
+ *
+ *	Point lookups of frequently read keys spend most of their time walking
+ *	the same path from the root to the leaf.  The adaptive hash index maps
+ *	hashes of the search keys to the location of the leaf page, where the key
+ *	was found the last time, so that the next lookup can go to this leaf
+ *	directly via refind_page().
+ *
+ *	Entries are never invalidated explicitly.  The page change count protects
+ *	from the page being evicted, freed or merged.  However, the key hash might
+ *	collide, so the caller has to check that the leaf really contains the
+ *	search key and fall back to the regular descent otherwise.
+ *
+ *	The hash table size adapts to the observed workload.  It grows when the
+ *	entries are frequently replaced by other keys, and it shrinks (down to
+ *	the full pause) when lookups rarely hit.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/src/btree/adaptive_hash.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "orioledb.h"
+
+#include "btree/adaptive_hash.h"
+#include "btree/btree.h"
+
+#include "port/pg_bitutils.h"
+#include "utils/memutils.h"
+
+/* Initial and minimal number of entries */
+#define AHI_MIN_ENTRIES		(64)
+/* Number of lookups between the adaptation decisions */
+#define AHI_WINDOW_LOOKUPS	(1024)
+/* Number of windows to skip after the hash index turned out to be useless */
+#define AHI_PAUSE_WINDOWS	(16)
+
+typedef struct
+{
+	uint32		hash;
+	uint32		pageChangeCount;
+	OInMemoryBlkno blkno;
+} BTreeAdaptiveHashEntry;
+
+struct BTreeAdaptiveHash
+{
+	/* Number of entries (power of two), zero while paused */
+	uint32		nentries;
+	uint32		pauseLookupsLeft;
+
+	/* Counters of the current adaptation window */
+	uint32		windowLookups;
+	uint32		windowHits;
+	uint32		windowReplaces;
+
+	uint64		hits;
+	uint64		misses;
+	BTreeAdaptiveHashEntry *entries;
+};
+
+int			adaptive_hash_max_entries = 0;
+
+static uint32
+ahi_max_entries(void)
+{
+	return Max(pg_prevpower2_32((uint32) adaptive_hash_max_entries),
+			   AHI_MIN_ENTRIES);
+}
+
+static void
+ahi_resize(BTreeAdaptiveHash *ahi, uint32 nentries)
+{
+	BTreeAdaptiveHashEntry *entries;
+	uint32		i;
+
+	entries = (BTreeAdaptiveHashEntry *)
+		MemoryContextAlloc(TopMemoryContext,
+						   sizeof(BTreeAdaptiveHashEntry) * nentries);
+	for (i = 0; i < nentries; i++)
+		entries[i].blkno = OInvalidInMemoryBlkno;
+
+	/* Entries keep the full hash, so they can be moved to the new table */
+	for (i = 0; i < ahi->nentries; i++)
+	{
+		BTreeAdaptiveHashEntry *entry = &ahi->entries[i];
+
+		if (OInMemoryBlknoIsValid(entry->blkno))
+			entries[entry->hash & (nentries - 1)] = *entry;
+	}
+
+	if (ahi->entries)
+		pfree(ahi->entries);
+	ahi->entries = entries;
+	ahi->nentries = nentries;
+}
+
+static void
+ahi_pause(BTreeAdaptiveHash *ahi)
+{
+	if (ahi->entries)
+		pfree(ahi->entries);
+	ahi->entries = NULL;
+	ahi->nentries = 0;
+	ahi->pauseLookupsLeft = AHI_WINDOW_LOOKUPS * AHI_PAUSE_WINDOWS;
+}
+
+static void
+ahi_adapt(BTreeAdaptiveHash *ahi)
+{
+	uint32		maxEntries = ahi_max_entries();
+	bool		fewHits = (ahi->windowHits * 20 < ahi->windowLookups);
+	bool		manyReplaces = (ahi->windowReplaces * 8 > ahi->windowLookups);
+
+	if (ahi->nentries > maxEntries)
+	{
+		ahi_resize(ahi, maxEntries);
+	}
+	else if (fewHits && (!manyReplaces || ahi->nentries == maxEntries))
+	{
+		/*
+		 * Either keys aren't repeated or the working set doesn't fit even the
+		 * maximal table.
+		 */
+		if (ahi->nentries > AHI_MIN_ENTRIES)
+			ahi_resize(ahi, ahi->nentries / 2);
+		else
+			ahi_pause(ahi);
+	}
+	else if (manyReplaces && ahi->nentries < maxEntries)
+	{
+		ahi_resize(ahi, ahi->nentries * 2);
+	}
+
+	ahi->windowLookups = 0;
+	ahi->windowHits = 0;
+	ahi->windowReplaces = 0;
+}
+
+/*
+ * Looks up the adaptive hash index for the given key.  Returns false if the
+ * hash index isn't used for this lookup.  Otherwise, returns the key hash and
+ * the location hint, which is invalid if there is no entry for the key.
+ * Caller must report the lookup result using btree_ahi_update().
+ */
+bool
+btree_ahi_lookup(BTreeDescr *desc, void *key, BTreeKeyType kind,
+				 uint32 *hash, BTreeLocationHint *hint)
+{
+	BTreeAdaptiveHash *ahi = desc->ahi;
+	BTreeAdaptiveHashEntry *entry;
+
+	if (adaptive_hash_max_entries <= 0 || !desc->ops->key_hash)
+		return false;
+
+	if (!ahi)
+	{
+		ahi = (BTreeAdaptiveHash *) MemoryContextAllocZero(TopMemoryContext,
+														   sizeof(BTreeAdaptiveHash));
+		desc->ahi = ahi;
+	}
+
+	if (ahi->nentries == 0)
+	{
+		if (ahi->pauseLookupsLeft > 0)
+		{
+			ahi->pauseLookupsLeft--;
+			return false;
+		}
+		ahi_resize(ahi, AHI_MIN_ENTRIES);
+	}
+
+	if (!desc->ops->key_hash(desc, key, kind, hash))
+		return false;
+
+	entry = &ahi->entries[*hash & (ahi->nentries - 1)];
+	if (OInMemoryBlknoIsValid(entry->blkno) && entry->hash == *hash)
+	{
+		hint->blkno = entry->blkno;
+		hint->pageChangeCount = entry->pageChangeCount;
+	}
+	else
+	{
+		hint->blkno = OInvalidInMemoryBlkno;
+		hint->pageChangeCount = InvalidOPageChangeCount;
+	}
+	return true;
+}
+
+/*
+ * Reports the result of the lookup started by btree_ahi_lookup().  `hit`
+ * means that the leaf from the hash index contained the key.  Otherwise,
+ * `found` tells whether the key was found by the regular descent in the leaf
+ * given by `blkno` and `pageChangeCount`.
+ */
+void
+btree_ahi_update(BTreeDescr *desc, uint32 hash, bool hit, bool found,
+				 OInMemoryBlkno blkno, uint32 pageChangeCount)
+{
+	BTreeAdaptiveHash *ahi = desc->ahi;
+	BTreeAdaptiveHashEntry *entry;
+
+	Assert(ahi && ahi->nentries > 0);
+	entry = &ahi->entries[hash & (ahi->nentries - 1)];
+
+	if (hit)
+	{
+		ahi->hits++;
+		ahi->windowHits++;
+	}
+	else
+	{
+		ahi->misses++;
+		if (found)
+		{
+			if (OInMemoryBlknoIsValid(entry->blkno) && entry->hash != hash)
+				ahi->windowReplaces++;
+			entry->hash = hash;
+			entry->blkno = blkno;
+			entry->pageChangeCount = pageChangeCount;
+		}
+		else if (entry->hash == hash)
+		{
+			entry->blkno = OInvalidInMemoryBlkno;
+		}
+	}
+
+	if (++ahi->windowLookups >= AHI_WINDOW_LOOKUPS)
+		ahi_adapt(ahi);
+}
+
+void
+btree_ahi_get_stats(BTreeDescr *desc, uint32 *nentries,
+					uint64 *hits, uint64 *misses)
+{
+	BTreeAdaptiveHash *ahi = desc->ahi;
+
+	*nentries = ahi ? ahi->nentries : 0;
+	*hits = ahi ? ahi->hits : 0;
+	*misses = ahi ? ahi->misses : 0;
+}
+
+void
+btree_ahi_free(BTreeDescr *desc)
+{
+	BTreeAdaptiveHash *ahi = desc->ahi;
+
+	if (!ahi)
+		return;
+
+	if (ahi->entries)
+		pfree(ahi->entries);
+	pfree(ahi);
+	desc->ahi = NULL;
+}
@@ -642,7 +642,7 @@ btree_check_compression_recursive(BTreeDescr *desc, BTreeCompressStats *stats, O
 
 	PG_TRY();
 	{
-		o_compress_page(buf, &compressed_size, lvl);
+		o_compress_page(buf, &compressed_size, lvl, NULL);
 
 		stats->totalSize += ORIOLEDB_BLCKSZ;
 		stats->totalCompressedSize += compressed_size;
@@ -25,12 +25,35 @@
 #include "btree/btree.h"
 #include "btree/fastpath.h"
 #include "btree/find.h"
+#include "catalog/o_sys_cache.h"
 #include "postgres_ext.h"
 #include "storage/itemptr.h"
+#include "tableam/descr.h"
 #include "tableam/key_range.h"
 
 #include "catalog/pg_opclass_d.h"
 #include "commands/defrem.h"
+#include "common/hashfn.h"
+#include "port/pg_bitutils.h"
+#include "port/pg_bswap.h"
+#include "utils/date.h"
+#include "utils/memutils.h"
+#include "utils/timestamp.h"
+#include "utils/uuid.h"
+
+/*
+ * Vectorized kernels are built with per-function target attributes, so the
+ * rest of the extension doesn't need to be compiled with -mavx2.  The actual
+ * kernel set is chosen once at startup by fastpath_init_array_search()
+ * depending on the CPU capabilities.
+ */
+#if (defined(__x86_64__) || defined(_M_AMD64)) && \
+	(defined(__GNUC__) || defined(__clang__))
+#define USE_FASTPATH_SIMD
+#include <immintrin.h>
+#define FASTPATH_TARGET_AVX2 __attribute__((target("avx2")))
+#define FASTPATH_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
 
 typedef struct
 {
@@ -39,6 +62,8 @@ typedef struct
 	int			typlen;
 	int			align;
 	ArraySearchFunc func;
+	ArraySearchFunc sse42Func;
+	ArraySearchFunc avx2Func;
 } ArraySearchDesc;
 
 static ArraySearchDesc *find_array_search_desc_by_typeid(Oid typeid);
@@ -48,6 +73,15 @@ static bool find_downlink_get_keys(BTreeDescr *desc,
 								   bool *inclusive, int numValues,
 								   Oid *types, Datum *values, uint8 *flags);
 
+static void can_prefix_search_items(OIndexDescr *id, void *key,
+									BTreeKeyType keyType,
+									FastpathFindDownlinkMeta *meta);
+static bool prefix_search_get_keys(OIndexDescr *id, void *key,
+								   BTreeKeyType keyType,
+								   FastpathFindDownlinkMeta *meta);
+
+static void int2_array_search(Pointer p, int stride, int *lower,
+							  int *upper, Datum keyDatum);
 static void oid_array_search(Pointer p, int stride, int *lower,
 							 int *upper, Datum keyDatum);
 static void int4_array_search(Pointer p, int stride, int *lower,
@@ -60,19 +94,113 @@ static void float8_array_search(Pointer p, int stride, int *lower,
 								int *upper, Datum keyDatum);
 static void tid_array_search(Pointer p, int stride, int *lower,
 							 int *upper, Datum keyDatum);
+static void uuid_array_search(Pointer p, int stride, int *lower,
+							  int *upper, Datum keyDatum);
+
+#ifdef USE_FASTPATH_SIMD
+static void oid_array_search_sse42(Pointer p, int stride, int *lower,
+								   int *upper, Datum keyDatum);
+static void int4_array_search_sse42(Pointer p, int stride, int *lower,
+									int *upper, Datum keyDatum);
+static void int8_array_search_sse42(Pointer p, int stride, int *lower,
+									int *upper, Datum keyDatum);
+static void float4_array_search_sse42(Pointer p, int stride, int *lower,
+									  int *upper, Datum keyDatum);
+static void float8_array_search_sse42(Pointer p, int stride, int *lower,
+									  int *upper, Datum keyDatum);
+static void oid_array_search_avx2(Pointer p, int stride, int *lower,
+								  int *upper, Datum keyDatum);
+static void int4_array_search_avx2(Pointer p, int stride, int *lower,
+								   int *upper, Datum keyDatum);
+static void int8_array_search_avx2(Pointer p, int stride, int *lower,
+								   int *upper, Datum keyDatum);
+static void float4_array_search_avx2(Pointer p, int stride, int *lower,
+									 int *upper, Datum keyDatum);
+static void float8_array_search_avx2(Pointer p, int stride, int *lower,
+									 int *upper, Datum keyDatum);
+static void tid_array_search_avx2(Pointer p, int stride, int *lower,
+								  int *upper, Datum keyDatum);
+
+#define ARRAY_SEARCH_SIMD_FUNCS(name) name##_sse42, name##_avx2
+#else
+#define ARRAY_SEARCH_SIMD_FUNCS(name) NULL, NULL
+#endif
 
+/*
+ * Types sharing the in-memory representation and the ordering with integers
+ * (date, time and timestamps) reuse the integer search functions.
+ */
 ArraySearchDesc arraySearchDescs[] = {
-	{OIDOID, OID_BTREE_OPS_OID, sizeof(Oid), ALIGNOF_INT, oid_array_search},
-	{INT4OID, INT4_BTREE_OPS_OID, sizeof(int32), ALIGNOF_INT, int4_array_search},
-	{INT8OID, INT8_BTREE_OPS_OID, sizeof(int64), ALIGNOF_DOUBLE, int8_array_search},
-	{FLOAT4OID, InvalidOid, sizeof(float4), ALIGNOF_INT, float4_array_search},
-	{FLOAT8OID, FLOAT8_BTREE_OPS_OID, sizeof(float8), ALIGNOF_DOUBLE, float8_array_search},
-	{TIDOID, InvalidOid, sizeof(ItemPointerData), ALIGNOF_SHORT, tid_array_search}
+	{INT2OID, INT2_BTREE_OPS_OID, sizeof(int16), ALIGNOF_SHORT, int2_array_search,
+	NULL, NULL},
+	{OIDOID, OID_BTREE_OPS_OID, sizeof(Oid), ALIGNOF_INT, oid_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(oid_array_search)},
+	{INT4OID, INT4_BTREE_OPS_OID, sizeof(int32), ALIGNOF_INT, int4_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(int4_array_search)},
+	{INT8OID, INT8_BTREE_OPS_OID, sizeof(int64), ALIGNOF_DOUBLE, int8_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(int8_array_search)},
+	{DATEOID, InvalidOid, sizeof(DateADT), ALIGNOF_INT, int4_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(int4_array_search)},
+	{TIMEOID, InvalidOid, sizeof(TimeADT), ALIGNOF_DOUBLE, int8_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(int8_array_search)},
+	{TIMESTAMPOID, InvalidOid, sizeof(Timestamp), ALIGNOF_DOUBLE, int8_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(int8_array_search)},
+	{TIMESTAMPTZOID, InvalidOid, sizeof(TimestampTz), ALIGNOF_DOUBLE, int8_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(int8_array_search)},
+	{FLOAT4OID, InvalidOid, sizeof(float4), ALIGNOF_INT, float4_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(float4_array_search)},
+	{FLOAT8OID, FLOAT8_BTREE_OPS_OID, sizeof(float8), ALIGNOF_DOUBLE, float8_array_search,
+	ARRAY_SEARCH_SIMD_FUNCS(float8_array_search)},
+#ifdef USE_FASTPATH_SIMD
+	/* There is no SSE4.2 kernel for tids: scalar loads dominate there */
+	{TIDOID, InvalidOid, sizeof(ItemPointerData), ALIGNOF_SHORT, tid_array_search,
+	NULL, tid_array_search_avx2},
+#else
+	{TIDOID, InvalidOid, sizeof(ItemPointerData), ALIGNOF_SHORT, tid_array_search,
+	NULL, NULL},
+#endif
+	{UUIDOID, InvalidOid, UUID_LEN, 1, uuid_array_search, NULL, NULL}
 };
 
+#define ARRAY_SEARCH_DESCS_COUNT (sizeof(arraySearchDescs) / sizeof(ArraySearchDesc))
+
+FastpathSimdLevel fastpath_simd_level = FastpathSimdNone;
+
+/*
+ * Chooses the array search kernels according to the CPU capabilities.  Should
+ * be called once at startup before any B-tree descent happens.
+ */
+void
+fastpath_init_array_search(void)
+{
+	int			i;
+
+	fastpath_simd_level = FastpathSimdNone;
+
+#ifdef USE_FASTPATH_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		fastpath_simd_level = FastpathSimdAVX2;
+	else if (__builtin_cpu_supports("sse4.2"))
+		fastpath_simd_level = FastpathSimdSSE42;
+#endif
+
+	for (i = 0; i < ARRAY_SEARCH_DESCS_COUNT; i++)
+	{
+		ArraySearchDesc *desc = &arraySearchDescs[i];
+
+		if (fastpath_simd_level == FastpathSimdAVX2 && desc->avx2Func)
+			desc->func = desc->avx2Func;
+		else if (fastpath_simd_level >= FastpathSimdSSE42 && desc->sse42Func)
+			desc->func = desc->sse42Func;
+	}
+}
+
 /*
  * Checks if the "fast path" the navigation can be applied to the given search
- * and fills *meta structure if so.
+ * and fills *meta structure if so.  When the key columns don't have the
+ * fixed-stride layout, checks if the normalized key prefix search can be used
+ * instead.
  */
 void
 can_fastpath_find_downlink(OBTreeFindPageContext *context,
@@ -88,22 +216,15 @@ can_fastpath_find_downlink(OBTreeFindPageContext *context,
 
 	ASAN_UNPOISON_MEMORY_REGION(meta, sizeof(*meta));
 
+	meta->enabled = false;
+	meta->prefixEnabled = false;
+
 	if (!BTREE_PAGE_FIND_IS(context, FETCH) ||
 		IS_SYS_TREE_OIDS(desc->oids))
-	{
-		meta->enabled = false;
 		return;
-	}
 
 	id = (OIndexDescr *) desc->arg;
 
-	if (id->nonLeafTupdesc->natts >= FASTPATH_FIND_DOWNLINK_MAX_KEYS ||
-		id->nonLeafSpec.natts != id->nonLeafTupdesc->natts)
-	{
-		meta->enabled = false;
-		return;
-	}
-
 	if (keyType == BTreeKeyUniqueLowerBound ||
 		keyType == BTreeKeyUniqueUpperBound)
 		meta->numKeys = id->nUniqueFields;
@@ -112,15 +233,22 @@ can_fastpath_find_downlink(OBTreeFindPageContext *context,
 	else
 		meta->numKeys = id->nonLeafSpec.natts;
 
+	if (id->nonLeafTupdesc->natts >= FASTPATH_FIND_DOWNLINK_MAX_KEYS ||
+		id->nonLeafSpec.natts != id->nonLeafTupdesc->natts)
+	{
+		can_prefix_search_items(id, key, keyType, meta);
+		return;
+	}
+
 	offset = 0;
 	for (i = 0; i < meta->numKeys; i++)
 	{
-		ArraySearchDesc *desc = find_array_search_desc_by_typeid(id->nonLeafTupdesc->attrs[0].atttypid);
+		ArraySearchDesc *desc = find_array_search_desc_by_typeid(id->nonLeafTupdesc->attrs[i].atttypid);
 		OIndexField *field = &id->fields[i];
 
 		if (!desc || desc->opcid != field->opclass)
 		{
-			meta->enabled = false;
+			can_prefix_search_items(id, key, keyType, meta);
 			return;
 		}
 
@@ -135,21 +263,173 @@ can_fastpath_find_downlink(OBTreeFindPageContext *context,
 	if (!find_downlink_get_keys(context->desc, key, keyType,
 								&meta->inclusive, meta->numKeys, types,
 								meta->values, meta->flags))
-	{
-		meta->enabled = false;
 		return;
-	}
 
 	meta->enabled = true;
 	meta->length = MAXALIGN(id->nonLeafSpec.len);
 }
 
+/*
+ * Checks if the non-leaf pages can be searched using the normalized key
+ * prefix and converts the search key into the prefix if so.
+ *
+ * The prefix consists of the leading by-value key columns, which are
+ * compared exactly, followed by at most one column whose opclass provides
+ * abbreviated keys (text, numeric and so on).  Abbreviated keys preserve the
+ * order of the values, but are lossy: equal abbreviated keys don't mean
+ * equal values.  So, the prefix only narrows the range of items the full
+ * comparison is needed for.
+ */
+static void
+can_prefix_search_items(OIndexDescr *id, void *key, BTreeKeyType keyType,
+						FastpathFindDownlinkMeta *meta)
+{
+	int			i,
+				numKeys;
+
+	if (keyType == BTreeKeyNone || keyType == BTreeKeyRightmost)
+		return;
+
+	numKeys = Min(meta->numKeys, FASTPATH_FIND_DOWNLINK_MAX_KEYS);
+	for (i = 0; i < numKeys; i++)
+	{
+		OIndexField *field = &id->fields[i];
+
+		if (OIgnoreColumn(id, i))
+			break;
+
+		if (TupleDescAttr(id->nonLeafTupdesc, i)->attbyval)
+		{
+			meta->prefixAbbrev[i] = false;
+		}
+		else if (o_comparator_can_abbreviate(field->comparator))
+		{
+			meta->prefixAbbrev[i] = true;
+			i++;
+			break;
+		}
+		else
+			break;
+	}
+	meta->prefixIndexKeys = i;
+
+	if (meta->prefixIndexKeys == 0)
+		return;
+
+	if (!prefix_search_get_keys(id, key, keyType, meta))
+		return;
+
+	meta->prefixEnabled = true;
+}
+
+/*
+ * Converts the search key into the normalized key prefix.  Bounds of the
+ * other types than the opclass input type are not supported.
+ */
+static bool
+prefix_search_get_keys(OIndexDescr *id, void *key, BTreeKeyType keyType,
+					   FastpathFindDownlinkMeta *meta)
+{
+	TupleDesc	tupdesc;
+	OTupleFixedFormatSpec *spec;
+	OTuple	   *tuple;
+	int			i;
+
+	if (keyType == BTreeKeyBound ||
+		keyType == BTreeKeyUniqueLowerBound ||
+		keyType == BTreeKeyUniqueUpperBound)
+	{
+		OBTreeKeyBound *bound = (OBTreeKeyBound *) key;
+
+		meta->prefixNumKeys = Min(meta->prefixIndexKeys, bound->nkeys);
+		for (i = 0; i < meta->prefixNumKeys; i++)
+		{
+			OBTreeValueBound *vb = &bound->keys[i];
+			uint8		f = 0;
+
+			if (vb->flags & O_VALUE_BOUND_UNBOUNDED)
+			{
+				meta->prefixFlags[i] = (vb->flags & O_VALUE_BOUND_LOWER) ? FASTPATH_FIND_DOWNLINK_FLAG_MINUS_INF : FASTPATH_FIND_DOWNLINK_FLAG_PLUS_INF;
+				meta->prefixValues[i] = (Datum) 0;
+				continue;
+			}
+
+			if (!(vb->flags & O_VALUE_BOUND_COERCIBLE) &&
+				vb->type != id->fields[i].inputtype)
+			{
+				meta->prefixNumKeys = i;
+				break;
+			}
+
+			/* Exclusive bound decides the comparison on the equal value */
+			if (!(vb->flags & O_VALUE_BOUND_INCLUSIVE))
+				f |= FASTPATH_FIND_DOWNLINK_FLAG_EXCLUSIVE;
+
+			if (vb->flags & O_VALUE_BOUND_NULL)
+			{
+				f |= FASTPATH_FIND_DOWNLINK_FLAG_NULL;
+				meta->prefixValues[i] = (Datum) 0;
+			}
+			else if (meta->prefixAbbrev[i])
+				meta->prefixValues[i] = o_call_abbrev_converter(id->fields[i].comparator,
+																vb->value);
+			else
+				meta->prefixValues[i] = vb->value;
+			meta->prefixFlags[i] = f;
+		}
+		return meta->prefixNumKeys > 0;
+	}
+
+	Assert(keyType == BTreeKeyLeafTuple ||
+		   keyType == BTreeKeyNonLeafKey ||
+		   keyType == BTreeKeyPageHiKey);
+
+	if (keyType == BTreeKeyLeafTuple)
+	{
+		tupdesc = id->leafTupdesc;
+		spec = &id->leafSpec;
+	}
+	else
+	{
+		tupdesc = id->nonLeafTupdesc;
+		spec = &id->nonLeafSpec;
+	}
+
+	tuple = (OTuple *) key;
+	meta->prefixNumKeys = meta->prefixIndexKeys;
+	for (i = 0; i < meta->prefixNumKeys; i++)
+	{
+		bool		isnull;
+		int			attnum;
+		Datum		value;
+
+		attnum = OIndexKeyAttnumToTupleAttnum(keyType, id, i + 1);
+		value = o_fastgetattr(*tuple, attnum, tupdesc, spec, &isnull);
+
+		if (isnull)
+		{
+			meta->prefixFlags[i] = FASTPATH_FIND_DOWNLINK_FLAG_NULL;
+			meta->prefixValues[i] = (Datum) 0;
+		}
+		else
+		{
+			meta->prefixFlags[i] = 0;
+			if (meta->prefixAbbrev[i])
+				meta->prefixValues[i] = o_call_abbrev_converter(id->fields[i].comparator,
+																value);
+			else
+				meta->prefixValues[i] = value;
+		}
+	}
+	return true;
+}
+
 static ArraySearchDesc *
 find_array_search_desc_by_typeid(Oid typeid)
 {
 	int			i;
 
-	for (i = 0; i < sizeof(arraySearchDescs) / sizeof(ArraySearchDesc); i++)
+	for (i = 0; i < ARRAY_SEARCH_DESCS_COUNT; i++)
 	{
 		if (arraySearchDescs[i].typeid == typeid)
 		{
@@ -487,6 +767,311 @@ fastpath_find_chunk(Pointer pagePtr,
 	return OBTreeFastPathFindOK;
 }
 
+/*
+ * Backend-local cache of the normalized key prefixes of non-leaf page chunks.
+ * Entry is identified by the page block number, its change count and the
+ * chunk offset, so it doesn't need an explicit invalidation.  The prefixes
+ * are built on the second visit of the same chunk image only, so that
+ * one-time descents don't pay for them.
+ */
+#define PREFIX_CACHE_SIZE (256)
+
+typedef struct
+{
+	ORelOids	oids;
+	OInMemoryBlkno blkno;
+	uint64		changeCount;
+	OffsetNumber chunkOffset;
+	int			itemsCount;
+	int			numKeys;
+	bool		built;
+	int			allocated;
+	Datum	   *values;
+	bool	   *isnull;
+} PrefixCacheEntry;
+
+static PrefixCacheEntry *prefixCache = NULL;
+static MemoryContext prefixCacheCxt = NULL;
+
+/*
+ * Fills the prefixes of all the chunk items.
+ */
+static void
+prefix_cache_build(OIndexDescr *id, Pointer pagePtr,
+				   BTreePageItemLocator *chunkLoc, PrefixCacheEntry *entry)
+{
+	BTreePageItemLocator loc = *chunkLoc;
+	int			count = loc.chunkItemsCount;
+	int			first = (loc.chunkOffset == 0) ? 1 : 0;
+	int			i,
+				j;
+
+	if (entry->allocated < count * entry->numKeys)
+	{
+		if (entry->values)
+		{
+			pfree(entry->values);
+			pfree(entry->isnull);
+		}
+		entry->allocated = count * entry->numKeys;
+		entry->values = MemoryContextAlloc(prefixCacheCxt,
+										   sizeof(Datum) * entry->allocated);
+		entry->isnull = MemoryContextAlloc(prefixCacheCxt,
+										   sizeof(bool) * entry->allocated);
+	}
+
+	for (i = first; i < count; i++)
+	{
+		OTuple		tup;
+
+		loc.itemOffset = i;
+		BTREE_PAGE_READ_TUPLE(tup, pagePtr, &loc);
+
+		for (j = 0; j < entry->numKeys; j++)
+		{
+			int			attnum = OIndexKeyAttnumToTupleAttnum(BTreeKeyNonLeafKey,
+															  id, j + 1);
+			Datum	   *value = &entry->values[i * entry->numKeys + j];
+			bool	   *isnull = &entry->isnull[i * entry->numKeys + j];
+
+			*value = o_fastgetattr(tup, attnum, id->nonLeafTupdesc,
+								   &id->nonLeafSpec, isnull);
+			if (*isnull)
+				*value = (Datum) 0;
+			else if (TupleDescAttr(id->nonLeafTupdesc, j)->attbyval)
+				continue;
+			else
+				*value = o_call_abbrev_converter(id->fields[j].comparator,
+												 *value);
+		}
+	}
+	entry->built = true;
+}
+
+/*
+ * Returns the prefixes of the chunk items if they are cached, or NULL.
+ */
+static PrefixCacheEntry *
+prefix_cache_get(BTreeDescr *desc, Pointer pagePtr, OInMemoryBlkno blkno,
+				 FastpathFindDownlinkMeta *meta, BTreePageItemLocator *loc)
+{
+	BTreePageHeader *hdr = (BTreePageHeader *) pagePtr;
+	uint64		changeCount = pg_atomic_read_u64(&hdr->o_header.state) & PAGE_STATE_CHANGE_COUNT_MASK;
+	PrefixCacheEntry *entry;
+	uint32		hash;
+
+	if (!OInMemoryBlknoIsValid(blkno))
+		return NULL;
+
+	if (prefixCache == NULL)
+	{
+		prefixCacheCxt = AllocSetContextCreate(TopMemoryContext,
+											   "orioledb fastpath prefix cache",
+											   ALLOCSET_DEFAULT_SIZES);
+		prefixCache = MemoryContextAllocZero(prefixCacheCxt,
+											 sizeof(PrefixCacheEntry) * PREFIX_CACHE_SIZE);
+	}
+
+	hash = hash_combine(hash_bytes_uint32(blkno), loc->chunkOffset);
+	entry = &prefixCache[hash % PREFIX_CACHE_SIZE];
+
+	if (entry->blkno != blkno ||
+		entry->changeCount != changeCount ||
+		entry->chunkOffset != loc->chunkOffset ||
+		entry->itemsCount != loc->chunkItemsCount ||
+		entry->numKeys != meta->prefixIndexKeys ||
+		!ORelOidsIsEqual(entry->oids, desc->oids))
+	{
+		entry->oids = desc->oids;
+		entry->blkno = blkno;
+		entry->changeCount = changeCount;
+		entry->chunkOffset = loc->chunkOffset;
+		entry->itemsCount = loc->chunkItemsCount;
+		entry->numKeys = meta->prefixIndexKeys;
+		entry->built = false;
+		return NULL;
+	}
+
+	if (!entry->built)
+		prefix_cache_build((OIndexDescr *) desc->arg, pagePtr, loc, entry);
+
+	return entry;
+}
+
+/*
+ * Compares the search key prefix with the prefix of the item.  Zero means
+ * the full comparison is needed to decide.
+ */
+static int
+prefix_cmp(OIndexDescr *id, FastpathFindDownlinkMeta *meta,
+		   PrefixCacheEntry *entry, int itemOffset)
+{
+	Datum	   *values = &entry->values[itemOffset * entry->numKeys];
+	bool	   *isnull = &entry->isnull[itemOffset * entry->numKeys];
+	int			i;
+
+	for (i = 0; i < meta->prefixNumKeys; i++)
+	{
+		OIndexField *field = &id->fields[i];
+		uint8		flags = meta->prefixFlags[i];
+		int			cmp;
+
+		if (flags & FASTPATH_FIND_DOWNLINK_FLAG_MINUS_INF)
+			return -1;
+		if (flags & FASTPATH_FIND_DOWNLINK_FLAG_PLUS_INF)
+			return 1;
+
+		if ((flags & FASTPATH_FIND_DOWNLINK_FLAG_NULL) || isnull[i])
+		{
+			if (!(flags & FASTPATH_FIND_DOWNLINK_FLAG_NULL))
+				return field->nullfirst ? 1 : -1;
+			if (!isnull[i])
+				return field->nullfirst ? -1 : 1;
+			cmp = 0;
+		}
+		else
+		{
+			if (meta->prefixAbbrev[i])
+				cmp = o_call_abbrev_comparator(field->comparator,
+											   meta->prefixValues[i],
+											   values[i]);
+			else
+				cmp = o_call_comparator(field->comparator,
+										meta->prefixValues[i],
+										values[i]);
+			if (!field->ascending)
+				cmp = -cmp;
+		}
+
+		if (cmp != 0)
+			return cmp;
+
+		/* The equal abbreviated keys or the exclusive bound decide nothing */
+		if (meta->prefixAbbrev[i] ||
+			(flags & FASTPATH_FIND_DOWNLINK_FLAG_EXCLUSIVE))
+			return 0;
+	}
+	return 0;
+}
+
+/*
+ * Full comparison of the search key with the item, the same as
+ * btree_page_search_items() does.
+ */
+static int
+prefix_search_full_cmp(BTreeDescr *desc, Pointer pagePtr, void *key,
+					   BTreeKeyType keyType, BTreePageItemLocator *loc,
+					   int itemOffset)
+{
+	OTuple		itemTup;
+
+	if (itemOffset == 0 && loc->chunkOffset == 0)
+		return 1;
+
+	loc->itemOffset = itemOffset;
+	BTREE_PAGE_READ_TUPLE(itemTup, pagePtr, loc);
+	return desc->ops->cmp(desc, key, keyType, &itemTup, BTreeKeyNonLeafKey);
+}
+
+/*
+ * Searches for the downlink within the non-leaf page chunk the locator points
+ * to.  Binary search over the cached normalized key prefixes narrows the
+ * range of items, which then are compared using the full comparator.  Falls
+ * back to btree_page_search_items() when the prefixes aren't cached yet.
+ *
+ * The cache is identified by the page change count, but we still verify that
+ * the neighbors of the found position which were compared by prefix only are
+ * on the right sides of the key.  That costs at most two comparisons.
+ */
+void
+fastpath_prefix_search_items(BTreeDescr *desc, Pointer pagePtr,
+							 OInMemoryBlkno blkno,
+							 FastpathFindDownlinkMeta *meta,
+							 void *key, BTreeKeyType keyType,
+							 BTreePageItemLocator *loc)
+{
+	OIndexDescr *id = (OIndexDescr *) desc->arg;
+	PrefixCacheEntry *entry;
+	int			first,
+				count,
+				lower,
+				upper,
+				low,
+				high,
+				mid,
+				targetCmpVal;
+
+	Assert(!O_PAGE_IS(pagePtr, LEAF));
+
+	if (loc->chunkItemsCount == 0 ||
+		(entry = prefix_cache_get(desc, pagePtr, blkno, meta, loc)) == NULL)
+	{
+		btree_page_search_items(desc, pagePtr, key, keyType, loc);
+		return;
+	}
+
+	o_set_sys_cache_search_datoid(desc->oids.datoid);
+
+	/* See btree_page_search_items() */
+	targetCmpVal = (keyType == BTreeKeyPageHiKey) ? 1 : 0;
+	if (keyType == BTreeKeyPageHiKey)
+		keyType = BTreeKeyNonLeafKey;
+
+	first = (loc->chunkOffset == 0) ? 1 : 0;
+	count = loc->chunkItemsCount;
+
+	/* Items before lower are less than the key by prefix */
+	low = first;
+	high = count;
+	while (high > low)
+	{
+		mid = low + ((high - low) / 2);
+		if (prefix_cmp(id, meta, entry, mid) > 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	lower = low;
+
+	/* Items at or after upper are greater than the key by prefix */
+	high = count;
+	while (high > low)
+	{
+		mid = low + ((high - low) / 2);
+		if (prefix_cmp(id, meta, entry, mid) >= 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	upper = low;
+
+	/* Full comparison within the range of the equal prefixes */
+	low = lower;
+	high = upper;
+	while (high > low)
+	{
+		mid = low + ((high - low) / 2);
+		if (prefix_search_full_cmp(desc, pagePtr, key, keyType, loc, mid) >= targetCmpVal)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if ((low == lower && low > first &&
+		 prefix_search_full_cmp(desc, pagePtr, key, keyType, loc, low - 1) < targetCmpVal) ||
+		(low == upper && low < count &&
+		 prefix_search_full_cmp(desc, pagePtr, key, keyType, loc, low) >= targetCmpVal))
+	{
+		entry->blkno = OInvalidInMemoryBlkno;
+		btree_page_search_items(desc, pagePtr, key,
+								targetCmpVal ? BTreeKeyPageHiKey : keyType,
+								loc);
+		return;
+	}
+
+	loc->itemOffset = low;
+}
+
 /*
  * Find the given value in the fixed-stride array of integers.  The functions
  * below do the same for other datatypes.
@@ -555,6 +1140,38 @@ int8_array_search(Pointer p, int stride, int *lower, int *upper, Datum keyDatum)
 		*lower = *upper;
 }
 
+static void
+int2_array_search(Pointer p, int stride, int *lower, int *upper, Datum keyDatum)
+{
+	int			i;
+	bool		lowerSet = false;
+	int16		key = DatumGetInt16(keyDatum);
+
+	p += *lower * stride;
+
+	for (i = *lower; i < *upper; i++)
+	{
+		int16		value = *((int16 *) p);
+
+		if (value == key && !lowerSet)
+		{
+			*lower = i;
+			lowerSet = true;
+		}
+		else if (value > key)
+		{
+			if (!lowerSet)
+				*lower = i;
+			*upper = i;
+			return;
+		}
+
+		p += stride;
+	}
+	if (!lowerSet)
+		*lower = *upper;
+}
+
 static void
 oid_array_search(Pointer p, int stride, int *lower, int *upper, Datum keyDatum)
 {
@@ -704,3 +1321,484 @@ tid_array_search(Pointer p, int stride, int *lower, int *upper, Datum keyDatum)
 	if (!lowerSet)
 		*lower = *upper;
 }
+
+/*
+ * Uuids are compared bytewise (see uuid_internal_cmp()).  So, we compare them
+ * as pairs of big-endian 64-bit integers, which gives the same order while
+ * avoiding memcmp() call per item.
+ */
+static inline void
+uuid_get_words(Pointer p, uint64 *hi, uint64 *lo)
+{
+	uint64		words[2];
+
+	memcpy(words, p, UUID_LEN);
+	*hi = pg_ntoh64(words[0]);
+	*lo = pg_ntoh64(words[1]);
+}
+
+static void
+uuid_array_search(Pointer p, int stride, int *lower, int *upper, Datum keyDatum)
+{
+	int			i;
+	bool		lowerSet = false;
+	uint64		keyHi,
+				keyLo;
+
+	uuid_get_words((Pointer) DatumGetUUIDP(keyDatum)->data, &keyHi, &keyLo);
+
+	p += *lower * stride;
+
+	for (i = *lower; i < *upper; i++)
+	{
+		uint64		valueHi,
+					valueLo;
+		bool		equal,
+					greater;
+
+		uuid_get_words(p, &valueHi, &valueLo);
+		equal = (valueHi == keyHi && valueLo == keyLo);
+		greater = (valueHi > keyHi || (valueHi == keyHi && valueLo > keyLo));
+
+		if (equal && !lowerSet)
+		{
+			*lower = i;
+			lowerSet = true;
+		}
+		else if (greater)
+		{
+			if (!lowerSet)
+				*lower = i;
+			*upper = i;
+			return;
+		}
+
+		p += stride;
+	}
+	if (!lowerSet)
+		*lower = *upper;
+}
+
+#ifdef USE_FASTPATH_SIMD
+
+/*
+ * Vectorized versions of the array search functions above.  They follow the
+ * same contract: *lower becomes the first position, where value >= key, and
+ * *upper becomes the first position, where value > key.  Instead of
+ * branching on every element, kernels compare the whole vector of values and
+ * take the positions from the comparison bitmasks.
+ */
+static inline bool
+array_search_apply_masks(int i, uint32 geMask, uint32 gtMask,
+						 bool *lowerSet, int *lower, int *upper)
+{
+	if (!*lowerSet && geMask != 0)
+	{
+		*lower = i + pg_rightmost_one_pos32(geMask);
+		*lowerSet = true;
+	}
+	if (gtMask != 0)
+	{
+		*upper = i + pg_rightmost_one_pos32(gtMask);
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Finish the search in the items not covered by full vectors using the scalar
+ * function.
+ */
+static inline void
+array_search_tail(ArraySearchFunc scalarFunc, Pointer p, int stride, int from,
+				  bool lowerSet, int *lower, int *upper, Datum keyDatum)
+{
+	int			tailLower = from;
+	int			tailUpper = *upper;
+
+	scalarFunc(p, stride, &tailLower, &tailUpper, keyDatum);
+
+	if (!lowerSet)
+		*lower = tailLower;
+	*upper = tailUpper;
+}
+
+FASTPATH_TARGET_SSE42 static void
+int4_array_search_sse42(Pointer p, int stride, int *lower, int *upper,
+						Datum keyDatum)
+{
+	__m128i		keyv = _mm_set1_epi32(DatumGetInt32(keyDatum));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i + 4 <= *upper; i += 4)
+	{
+		Pointer		q = p + i * stride;
+		__m128i		v = _mm_setr_epi32(*((int32 *) q),
+									   *((int32 *) (q + stride)),
+									   *((int32 *) (q + 2 * stride)),
+									   *((int32 *) (q + 3 * stride)));
+		__m128i		gt = _mm_cmpgt_epi32(v, keyv);
+		__m128i		ge = _mm_or_si128(gt, _mm_cmpeq_epi32(v, keyv));
+
+		if (array_search_apply_masks(i,
+									 _mm_movemask_ps(_mm_castsi128_ps(ge)),
+									 _mm_movemask_ps(_mm_castsi128_ps(gt)),
+									 &lowerSet, lower, upper))
+			return;
+	}
+	array_search_tail(int4_array_search, p, stride, i, lowerSet,
+					  lower, upper, keyDatum);
+}
+
+FASTPATH_TARGET_SSE42 static void
+oid_array_search_sse42(Pointer p, int stride, int *lower, int *upper,
+					   Datum keyDatum)
+{
+	/* Flip the sign bit to compare unsigned values using signed compare */
+	__m128i		bias = _mm_set1_epi32(PG_INT32_MIN);
+	__m128i		keyv = _mm_xor_si128(_mm_set1_epi32(DatumGetObjectId(keyDatum)),
+									 bias);
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i + 4 <= *upper; i += 4)
+	{
+		Pointer		q = p + i * stride;
+		__m128i		v = _mm_setr_epi32(*((Oid *) q),
+									   *((Oid *) (q + stride)),
+									   *((Oid *) (q + 2 * stride)),
+									   *((Oid *) (q + 3 * stride)));
+		__m128i		gt,
+					ge;
+
+		v = _mm_xor_si128(v, bias);
+		gt = _mm_cmpgt_epi32(v, keyv);
+		ge = _mm_or_si128(gt, _mm_cmpeq_epi32(v, keyv));
+
+		if (array_search_apply_masks(i,
+									 _mm_movemask_ps(_mm_castsi128_ps(ge)),
+									 _mm_movemask_ps(_mm_castsi128_ps(gt)),
+									 &lowerSet, lower, upper))
+			return;
+	}
+	array_search_tail(oid_array_search, p, stride, i, lowerSet,
+					  lower, upper, keyDatum);
+}
+
+FASTPATH_TARGET_SSE42 static void
+int8_array_search_sse42(Pointer p, int stride, int *lower, int *upper,
+						Datum keyDatum)
+{
+	__m128i		keyv = _mm_set1_epi64x(DatumGetInt64(keyDatum));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i + 2 <= *upper; i += 2)
+	{
+		Pointer		q = p + i * stride;
+		__m128i		v = _mm_set_epi64x(*((int64 *) (q + stride)),
+									   *((int64 *) q));
+		__m128i		gt = _mm_cmpgt_epi64(v, keyv);
+		__m128i		ge = _mm_or_si128(gt, _mm_cmpeq_epi64(v, keyv));
+
+		if (array_search_apply_masks(i,
+									 _mm_movemask_pd(_mm_castsi128_pd(ge)),
+									 _mm_movemask_pd(_mm_castsi128_pd(gt)),
+									 &lowerSet, lower, upper))
+			return;
+	}
+	array_search_tail(int8_array_search, p, stride, i, lowerSet,
+					  lower, upper, keyDatum);
+}
+
+FASTPATH_TARGET_SSE42 static void
+float4_array_search_sse42(Pointer p, int stride, int *lower, int *upper,
+						  Datum keyDatum)
+{
+	__m128		keyv = _mm_set1_ps(DatumGetFloat4(keyDatum));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i + 4 <= *upper; i += 4)
+	{
+		Pointer		q = p + i * stride;
+
+		/* cppcheck-suppress invalidPointerCast */
+		__m128		v = _mm_setr_ps(*((float4 *) q),
+									*((float4 *) (q + stride)),
+									*((float4 *) (q + 2 * stride)),
+									*((float4 *) (q + 3 * stride)));
+
+		if (array_search_apply_masks(i,
+									 _mm_movemask_ps(_mm_cmpge_ps(v, keyv)),
+									 _mm_movemask_ps(_mm_cmpgt_ps(v, keyv)),
+									 &lowerSet, lower, upper))
+			return;
+	}
+	array_search_tail(float4_array_search, p, stride, i, lowerSet,
+					  lower, upper, keyDatum);
+}
+
+FASTPATH_TARGET_SSE42 static void
+float8_array_search_sse42(Pointer p, int stride, int *lower, int *upper,
+						  Datum keyDatum)
+{
+	__m128d		keyv = _mm_set1_pd(DatumGetFloat8(keyDatum));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i + 2 <= *upper; i += 2)
+	{
+		Pointer		q = p + i * stride;
+
+		/* cppcheck-suppress invalidPointerCast */
+		__m128d		v = _mm_setr_pd(*((float8 *) q),
+									*((float8 *) (q + stride)));
+
+		if (array_search_apply_masks(i,
+									 _mm_movemask_pd(_mm_cmpge_pd(v, keyv)),
+									 _mm_movemask_pd(_mm_cmpgt_pd(v, keyv)),
+									 &lowerSet, lower, upper))
+			return;
+	}
+	array_search_tail(float8_array_search, p, stride, i, lowerSet,
+					  lower, upper, keyDatum);
+}
+
+/*
+ * AVX2 kernels gather strided values directly.  The tail is handled by
+ * masked gathers, which never touch memory of the disabled lanes.
+ */
+#define AVX2_LANES32 _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+#define AVX2_LANES64 _mm256_setr_epi64x(0, 1, 2, 3)
+
+FASTPATH_TARGET_AVX2 static void
+int4_array_search_avx2(Pointer p, int stride, int *lower, int *upper,
+					   Datum keyDatum)
+{
+	__m256i		keyv = _mm256_set1_epi32(DatumGetInt32(keyDatum));
+	__m256i		idx = _mm256_mullo_epi32(AVX2_LANES32, _mm256_set1_epi32(stride));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i < *upper; i += 8)
+	{
+		int			n = Min(8, *upper - i);
+		uint32		laneMask = (1U << n) - 1;
+		__m256i		lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(n), AVX2_LANES32);
+		__m256i		v,
+					gt,
+					ge;
+
+		v = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(),
+										(const int *) (p + i * stride),
+										idx, lanes, 1);
+		gt = _mm256_cmpgt_epi32(v, keyv);
+		ge = _mm256_or_si256(gt, _mm256_cmpeq_epi32(v, keyv));
+
+		if (array_search_apply_masks(i,
+									 _mm256_movemask_ps(_mm256_castsi256_ps(ge)) & laneMask,
+									 _mm256_movemask_ps(_mm256_castsi256_ps(gt)) & laneMask,
+									 &lowerSet, lower, upper))
+			return;
+	}
+	if (!lowerSet)
+		*lower = *upper;
+}
+
+FASTPATH_TARGET_AVX2 static void
+oid_array_search_avx2(Pointer p, int stride, int *lower, int *upper,
+					  Datum keyDatum)
+{
+	/* Flip the sign bit to compare unsigned values using signed compare */
+	__m256i		bias = _mm256_set1_epi32(PG_INT32_MIN);
+	__m256i		keyv = _mm256_xor_si256(_mm256_set1_epi32(DatumGetObjectId(keyDatum)),
+										bias);
+	__m256i		idx = _mm256_mullo_epi32(AVX2_LANES32, _mm256_set1_epi32(stride));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i < *upper; i += 8)
+	{
+		int			n = Min(8, *upper - i);
+		uint32		laneMask = (1U << n) - 1;
+		__m256i		lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(n), AVX2_LANES32);
+		__m256i		v,
+					gt,
+					ge;
+
+		v = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(),
+										(const int *) (p + i * stride),
+										idx, lanes, 1);
+		v = _mm256_xor_si256(v, bias);
+		gt = _mm256_cmpgt_epi32(v, keyv);
+		ge = _mm256_or_si256(gt, _mm256_cmpeq_epi32(v, keyv));
+
+		if (array_search_apply_masks(i,
+									 _mm256_movemask_ps(_mm256_castsi256_ps(ge)) & laneMask,
+									 _mm256_movemask_ps(_mm256_castsi256_ps(gt)) & laneMask,
+									 &lowerSet, lower, upper))
+			return;
+	}
+	if (!lowerSet)
+		*lower = *upper;
+}
+
+FASTPATH_TARGET_AVX2 static void
+int8_array_search_avx2(Pointer p, int stride, int *lower, int *upper,
+					   Datum keyDatum)
+{
+	__m256i		keyv = _mm256_set1_epi64x(DatumGetInt64(keyDatum));
+	__m128i		idx = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3),
+									  _mm_set1_epi32(stride));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i < *upper; i += 4)
+	{
+		int			n = Min(4, *upper - i);
+		uint32		laneMask = (1U << n) - 1;
+		__m256i		lanes = _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), AVX2_LANES64);
+		__m256i		v,
+					gt,
+					ge;
+
+		v = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(),
+										(const long long *) (p + i * stride),
+										idx, lanes, 1);
+		gt = _mm256_cmpgt_epi64(v, keyv);
+		ge = _mm256_or_si256(gt, _mm256_cmpeq_epi64(v, keyv));
+
+		if (array_search_apply_masks(i,
+									 _mm256_movemask_pd(_mm256_castsi256_pd(ge)) & laneMask,
+									 _mm256_movemask_pd(_mm256_castsi256_pd(gt)) & laneMask,
+									 &lowerSet, lower, upper))
+			return;
+	}
+	if (!lowerSet)
+		*lower = *upper;
+}
+
+FASTPATH_TARGET_AVX2 static void
+float4_array_search_avx2(Pointer p, int stride, int *lower, int *upper,
+						 Datum keyDatum)
+{
+	__m256		keyv = _mm256_set1_ps(DatumGetFloat4(keyDatum));
+	__m256i		idx = _mm256_mullo_epi32(AVX2_LANES32, _mm256_set1_epi32(stride));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i < *upper; i += 8)
+	{
+		int			n = Min(8, *upper - i);
+		uint32		laneMask = (1U << n) - 1;
+		__m256i		lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(n), AVX2_LANES32);
+		__m256		v;
+
+		v = _mm256_mask_i32gather_ps(_mm256_setzero_ps(),
+									 (const float *) (p + i * stride),
+									 idx, _mm256_castsi256_ps(lanes), 1);
+
+		if (array_search_apply_masks(i,
+									 _mm256_movemask_ps(_mm256_cmp_ps(v, keyv, _CMP_GE_OQ)) & laneMask,
+									 _mm256_movemask_ps(_mm256_cmp_ps(v, keyv, _CMP_GT_OQ)) & laneMask,
+									 &lowerSet, lower, upper))
+			return;
+	}
+	if (!lowerSet)
+		*lower = *upper;
+}
+
+FASTPATH_TARGET_AVX2 static void
+float8_array_search_avx2(Pointer p, int stride, int *lower, int *upper,
+						 Datum keyDatum)
+{
+	__m256d		keyv = _mm256_set1_pd(DatumGetFloat8(keyDatum));
+	__m128i		idx = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3),
+									  _mm_set1_epi32(stride));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i < *upper; i += 4)
+	{
+		int			n = Min(4, *upper - i);
+		uint32		laneMask = (1U << n) - 1;
+		__m256i		lanes = _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), AVX2_LANES64);
+		__m256d		v;
+
+		v = _mm256_mask_i32gather_pd(_mm256_setzero_pd(),
+									 (const double *) (p + i * stride),
+									 idx, _mm256_castsi256_pd(lanes), 1);
+
+		if (array_search_apply_masks(i,
+									 _mm256_movemask_pd(_mm256_cmp_pd(v, keyv, _CMP_GE_OQ)) & laneMask,
+									 _mm256_movemask_pd(_mm256_cmp_pd(v, keyv, _CMP_GT_OQ)) & laneMask,
+									 &lowerSet, lower, upper))
+			return;
+	}
+	if (!lowerSet)
+		*lower = *upper;
+}
+
+/*
+ * Tids are gathered as two overlapping 32-bit words: the first one contains
+ * both halves of the block number, the second one has the offset number in
+ * its upper half.  This relies on the little-endian layout, which is always
+ * the case for x86.
+ */
+FASTPATH_TARGET_AVX2 static void
+tid_array_search_avx2(Pointer p, int stride, int *lower, int *upper,
+					  Datum keyDatum)
+{
+	ItemPointer key = DatumGetItemPointer(keyDatum);
+	__m256i		bias = _mm256_set1_epi32(PG_INT32_MIN);
+	__m256i		keyBlkv = _mm256_xor_si256(_mm256_set1_epi32(ItemPointerGetBlockNumberNoCheck(key)),
+										   bias);
+	__m256i		keyOffv = _mm256_set1_epi32(ItemPointerGetOffsetNumberNoCheck(key));
+	__m256i		idx = _mm256_mullo_epi32(AVX2_LANES32, _mm256_set1_epi32(stride));
+	bool		lowerSet = false;
+	int			i;
+
+	for (i = *lower; i < *upper; i += 8)
+	{
+		int			n = Min(8, *upper - i);
+		uint32		laneMask = (1U << n) - 1;
+		__m256i		lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(n), AVX2_LANES32);
+		__m256i		w0,
+					w1,
+					blk,
+					off,
+					blkEq,
+					gt,
+					ge;
+
+		w0 = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(),
+										 (const int *) (p + i * stride),
+										 idx, lanes, 1);
+		w1 = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(),
+										 (const int *) (p + i * stride + offsetof(ItemPointerData, ip_blkid.bi_lo)),
+										 idx, lanes, 1);
+		blk = _mm256_or_si256(_mm256_slli_epi32(w0, 16), _mm256_srli_epi32(w0, 16));
+		blk = _mm256_xor_si256(blk, bias);
+		off = _mm256_srli_epi32(w1, 16);
+
+		blkEq = _mm256_cmpeq_epi32(blk, keyBlkv);
+		gt = _mm256_cmpgt_epi32(off, keyOffv);
+		ge = _mm256_or_si256(gt, _mm256_cmpeq_epi32(off, keyOffv));
+		gt = _mm256_or_si256(_mm256_cmpgt_epi32(blk, keyBlkv),
+							 _mm256_and_si256(blkEq, gt));
+		ge = _mm256_or_si256(_mm256_cmpgt_epi32(blk, keyBlkv),
+							 _mm256_and_si256(blkEq, ge));
+
+		if (array_search_apply_masks(i,
+									 _mm256_movemask_ps(_mm256_castsi256_ps(ge)) & laneMask,
+									 _mm256_movemask_ps(_mm256_castsi256_ps(gt)) & laneMask,
+									 &lowerSet, lower, upper))
+			return;
+	}
+	if (!lowerSet)
+		*lower = *upper;
+}
+
+#endif							/* USE_FASTPATH_SIMD */
@@ -20,6 +20,7 @@
 #include "btree/insert.h"
 #include "btree/io.h"
 #include "btree/page_chunks.h"
+#include "checkpoint/checkpoint.h"
 #include "tableam/descr.h"
 #include "utils/stopevent.h"
 
@@ -56,9 +57,6 @@ static bool btree_find_try_read_page(OBTreeFindPageContext *context,
 static OffsetNumber btree_page_binary_search_chunks(BTreeDescr *desc, Page p,
 													Pointer key,
 													BTreeKeyType keyType);
-static void btree_page_search_items(BTreeDescr *desc, Page p, Pointer key,
-									BTreeKeyType keyType,
-									BTreePageItemLocator *locator);
 
 /*
  * Initialize B-tree page find context.
@@ -73,6 +71,7 @@ init_page_find_context(OBTreeFindPageContext *context, BTreeDescr *desc,
 	context->csn = csn;
 	context->index = 0;
 	context->flags = flags;
+	context->chkpNum = 0;
 	context->imgUndoLoc = InvalidUndoLocation;
 	context->img = NULL;
 	context->imgEntry = NULL;
@@ -145,8 +144,19 @@ page_find_downlink(OBTreeFindPageInternalContext *intCxt,
 	{
 		Assert(key);
 		/* Have to do the binary search otherwise */
-		itemFound = btree_page_search(desc, intCxt->pagePtr, key, keyType,
-									  intCxt->partial, loc);
+		if (meta->prefixEnabled)
+		{
+			itemFound = btree_page_search_chunk(desc, intCxt->pagePtr,
+												key, keyType,
+												intCxt->partial, loc);
+			if (itemFound)
+				fastpath_prefix_search_items(desc, intCxt->pagePtr,
+											 intCxt->blkno, meta,
+											 key, keyType, loc);
+		}
+		else
+			itemFound = btree_page_search(desc, intCxt->pagePtr, key, keyType,
+										  intCxt->partial, loc);
 		if (itemFound)
 		{
 			BTREE_PAGE_LOCATOR_PREV(intCxt->pagePtr, loc);
@@ -396,7 +406,10 @@ find_page(OBTreeFindPageContext *context, void *key, BTreeKeyType keyType,
 
 	ASAN_UNPOISON_MEMORY_REGION(&fastpathMeta, sizeof(fastpathMeta));
 	if (STOPEVENTS_ENABLED())
+	{
 		fastpathMeta.enabled = false;
+		fastpathMeta.prefixEnabled = false;
+	}
 	else
 		can_fastpath_find_downlink(context, key, keyType, &fastpathMeta);
 
@@ -420,6 +433,13 @@ find_page(OBTreeFindPageContext *context, void *key, BTreeKeyType keyType,
 	context->partial.isPartial = false;
 	context->index = 0;
 
+	/* see btree_find_context_mark_dirty() */
+	if (modifyFlag)
+	{
+		context->chkpNum = checkpoint_state->lastCheckpointNumber + 2;
+		pg_read_barrier();
+	}
+
 	/* starts from the rootPageBlkno */
 	intCxt.blkno = desc->rootInfo.rootPageBlkno;
 	intCxt.pageChangeCount = desc->rootInfo.rootPageChangeCount;
@@ -1001,6 +1021,14 @@ retry:
 		if (intCxt.pageChangeCount == InvalidOPageChangeCount)
 			return find_page(context, key, keyType, level);
 
+		/*
+		 * The context without the path from the root would make
+		 * btree_find_context_mark_dirty() mark the whole tree.  Then the
+		 * next checkpoint couldn't skip any subtree.  So, record the path.
+		 */
+		if (context->chkpNum == 0 && btree_may_skip_subtrees(desc))
+			return find_page(context, key, keyType, level);
+
 		if (!O_TUPLE_IS_NULL(context->insertTuple))
 		{
 			OLockPageWithTupleResult result;
@@ -1456,6 +1484,30 @@ btree_find_context_lokey(OBTreeFindPageContext *context)
 	}
 }
 
+/*
+ * Makes checkpoints descend into the path to the page modified under the
+ * context instead of copying the on-disk images of the subtrees containing
+ * it.
+ *
+ * Pages taking over a part of the path due to concurrent splits or merges
+ * inherit the mark, but only for the checkpoints running or expected at that
+ * moment.  So, if a checkpoint has completed since the path was started (or
+ * the context has no path from the root), mark all the subtrees of the tree
+ * instead.
+ */
+void
+btree_find_context_mark_dirty(OBTreeFindPageContext *context)
+{
+	uint32		chkpNum = btree_dirty_chkp_num();
+	int			i;
+
+	if (chkpNum != context->chkpNum)
+		btree_mark_subtrees_dirty(context->desc, chkpNum);
+
+	for (i = 0; i < context->index; i++)
+		btree_page_mark_subtree_dirty(context->items[i].blkno, chkpNum);
+}
+
 static Pointer
 set_page_ptr(OBTreeFindPageContext *context, bool parent)
 {
@@ -1598,7 +1650,6 @@ bool
 btree_page_search(BTreeDescr *desc, Page p, Pointer key, BTreeKeyType keyType,
 				  PartialPageState *partial, BTreePageItemLocator *locator)
 {
-	OffsetNumber chunkOffset;
 	bool		isLeaf = O_PAGE_IS(p, LEAF);
 
 	if (keyType == BTreeKeyPageHiKey && isLeaf)
@@ -1610,6 +1661,25 @@ btree_page_search(BTreeDescr *desc, Page p, Pointer key, BTreeKeyType keyType,
 		return true;
 	}
 
+	if (!btree_page_search_chunk(desc, p, key, keyType, partial, locator))
+		return false;
+
+	btree_page_search_items(desc, p, key, keyType, locator);
+
+	return true;
+}
+
+/*
+ * Finds the chunk containing the key and points the locator to it.  Returns
+ * false if failed to read the chunk of the partial page.
+ */
+bool
+btree_page_search_chunk(BTreeDescr *desc, Page p, Pointer key,
+						BTreeKeyType keyType, PartialPageState *partial,
+						BTreePageItemLocator *locator)
+{
+	OffsetNumber chunkOffset;
+
 	chunkOffset = btree_page_binary_search_chunks(desc, p, key, keyType);
 
 	if (partial && !partial_load_chunk(partial, p, chunkOffset, NULL))
@@ -1617,8 +1687,6 @@ btree_page_search(BTreeDescr *desc, Page p, Pointer key, BTreeKeyType keyType,
 
 	page_chunk_fill_locator(p, chunkOffset, locator);
 
-	btree_page_search_items(desc, p, key, keyType, locator);
-
 	return true;
 }
 
@@ -1678,7 +1746,10 @@ btree_page_binary_search_chunks(BTreeDescr *desc, Page p,
 	return low;
 }
 
-static void
+/*
+ * Search for the key within the chunk the locator points to.
+ */
+void
 btree_page_search_items(BTreeDescr *desc, Page p, Pointer key,
 						BTreeKeyType keyType, BTreePageItemLocator *locator)
 {
@@ -201,6 +201,7 @@ o_btree_finish_root_split_internal(BTreeDescr *desc,
 
 	left_page = O_GET_IN_MEMORY_PAGE(left_blkno);
 	init_new_btree_page(desc, left_blkno, O_BTREE_FLAG_LEFTMOST, PAGE_GET_LEVEL(p), false);
+	btree_inc_pages_in_memory(desc);
 
 	memcpy(left_page + O_PAGE_HEADER_SIZE,
 		   p + O_PAGE_HEADER_SIZE,
@@ -245,6 +246,9 @@ o_btree_finish_root_split_internal(BTreeDescr *desc,
 
 	MARK_DIRTY(desc, left_blkno);
 	MARK_DIRTY(desc, desc->rootInfo.rootPageBlkno);
+	if (!is_leaf)
+		btree_page_inherit_subtree_dirty(left_blkno,
+										 desc->rootInfo.rootPageBlkno);
 
 	O_GET_IN_MEMORY_PAGEDESC(insert_item->rightBlkno)->leftBlkno = left_blkno;
 	btree_split_mark_finished(insert_item->rightBlkno, false, true);
@@ -709,12 +713,12 @@ o_btree_insert_split(BTreeInsertStackItem *insert_item,
 	 * Move hikeyBlkno of split.  This change is atomic, no need to bother
 	 * about change count.
 	 */
-	if (checkpoint_state->stack[insert_item->level].hikeyBlkno == blkno)
-		checkpoint_state->stack[insert_item->level].hikeyBlkno = right_blkno;
+	checkpoint_move_hikey_blkno(insert_item->level, blkno, right_blkno);
 
 	perform_page_split(desc, blkno, right_blkno, items,
 					   left_count, split_key, split_key_len,
 					   csn, undoLocation);
+	btree_find_context_mark_dirty(curContext);
 
 	o_btree_insert_mark_split_finished_if_needed(insert_item);
 
@@ -935,6 +939,7 @@ o_btree_insert_item_with_waiters(BTreeInsertStackItem *insert_item,
 			if (!(tuple.formatFlags & O_TUPLE_FLAGS_FIXED_FORMAT))
 				header->chunkDesc[loc.chunkOffset].chunkKeysFixed = 0;
 			MARK_DIRTY(desc, blkno);
+			btree_find_context_mark_dirty(insert_item->context);
 			END_CRIT_SECTION();
 		}
 
@@ -1002,6 +1007,7 @@ o_btree_insert_item_with_waiters(BTreeInsertStackItem *insert_item,
 		START_CRIT_SECTION();
 		perform_page_compaction(desc, blkno, &newItems, needsUndo, csn);
 		MARK_DIRTY(desc, blkno);
+		btree_find_context_mark_dirty(insert_item->context);
 
 		if (waitersWakeupCount > 0)
 			mark_waiter_tuples_inserted(tupleWaiterProcnums,
@@ -1137,6 +1143,7 @@ o_btree_insert_item_no_waiters(BTreeInsertStackItem *insert_item,
 		page_split_chunk_if_needed(desc, p, &loc);
 
 		MARK_DIRTY(desc, blkno);
+		btree_find_context_mark_dirty(insert_item->context);
 
 		o_btree_insert_mark_split_finished_if_needed(insert_item);
 		unlock_page(blkno);
@@ -1188,6 +1195,7 @@ o_btree_insert_item_no_waiters(BTreeInsertStackItem *insert_item,
 		header->prevInsertOffset = offset;
 
 		MARK_DIRTY(desc, blkno);
+		btree_find_context_mark_dirty(insert_item->context);
 		o_btree_insert_mark_split_finished_if_needed(insert_item);
 		unlock_page(blkno);
 
@@ -1341,7 +1349,8 @@ o_btree_insert_item(BTreeInsertStackItem *insert_item, int reserve_kind)
 			 * We change a node that is under checkpoint and must mark it as
 			 * autonomous.
 			 */
-			backend_set_autonomous_level(checkpoint_state, insert_item->level);
+			backend_set_autonomous_level(tree_checkpoint_state(desc),
+										 insert_item->level);
 		}
 
 		if (insert_item->level == 0 && !insert_item->replace)
@@ -35,7 +35,10 @@
 #include "tableam/descr.h"
 #include "tableam/handler.h"
 #include "utils/compress.h"
+#include "utils/compress_queue.h"
+#include "utils/compressed_tier.h"
 #include "utils/elog.h"
+#include "utils/o_io_uring.h"
 #include "utils/page_pool.h"
 #include "utils/seq_buf.h"
 #include "utils/stopevent.h"
@@ -91,7 +94,8 @@ static bool get_free_disk_extent_copy_blkno(BTreeDescr *desc, off_t page_size,
 
 static bool write_page_to_disk(BTreeDescr *desc, FileExtent *extent,
 							   uint32 curChkpNum,
-							   Pointer page, off_t page_size);
+							   Pointer page, off_t page_size,
+							   uint64 compressDict);
 static void write_page(OBTreeFindPageContext *context,
 					   OInMemoryBlkno blkno, Page img,
 					   uint32 checkpoint_number,
@@ -100,6 +104,18 @@ static int	tree_offsets_cmp(const void *a, const void *b);
 static void writeback_put_extent(IOWriteBack *writeback, BTreeDescr *desc,
 								 uint64 downlink);
 static void perform_writeback(IOWriteBack *writeback);
+static void writeback_file_range(File file, off_t offset, off_t amount);
+static void writeback_flush_ranges(void);
+static bool btree_over_memory_quota(BTreeDescr *desc);
+
+/*
+ * Writeback ranges of the single file accumulated for the io_uring
+ * submission.
+ */
+#define WRITEBACK_REQUESTS_BATCH	(64)
+static OIORequest writebackRequests[WRITEBACK_REQUESTS_BATCH];
+static int	writebackRequestsNum = 0;
+static File writebackFile = -1;
 
 PG_FUNCTION_INFO_V1(orioledb_evict_pages);
 PG_FUNCTION_INFO_V1(orioledb_write_pages);
@@ -702,6 +718,31 @@ btree_smgr_read(BTreeDescr *desc, char *buffer, uint32 chkpNum,
 	return result;
 }
 
+/*
+ * Hints the OS that the given range of the data file will be read soon.
+ */
+void
+btree_smgr_prefetch(BTreeDescr *desc, uint32 chkpNum,
+					off_t offset, int amount)
+{
+	if (use_mmap || use_device || orioledb_s3_mode)
+		return;
+
+	while (amount > 0)
+	{
+		int			segno = offset / ORIOLEDB_SEGMENT_SIZE;
+		int			stepAmount = Min(amount,
+									 ORIOLEDB_SEGMENT_SIZE - offset % ORIOLEDB_SEGMENT_SIZE);
+		File		file;
+
+		file = btree_open_smgr_file(desc, segno, chkpNum, 0);
+		(void) FilePrefetch(file, offset % ORIOLEDB_SEGMENT_SIZE, stepAmount,
+							WAIT_EVENT_DATA_FILE_PREFETCH);
+		offset += stepAmount;
+		amount -= stepAmount;
+	}
+}
+
 void
 btree_smgr_writeback(BTreeDescr *desc, uint32 chkpNum,
 					 off_t offset, int amount)
@@ -849,6 +890,10 @@ btree_io_error_cleanup(void)
 {
 	if (io_in_progress)
 		io_finish();
+
+	/* Accumulated writeback ranges are just hints, forget them */
+	writebackRequestsNum = 0;
+	writebackFile = -1;
 }
 
 void
@@ -1106,10 +1151,7 @@ get_free_disk_extent_copy_blkno(BTreeDescr *desc, off_t page_size,
 	}
 
 	if ((desc->storageType == BTreeStoragePersistence || desc->storageType == BTreeStorageUnlogged) &&
-		checkpoint_state->treeType == desc->type &&
-		checkpoint_state->datoid == desc->oids.datoid &&
-		checkpoint_state->relnode == desc->oids.relnode &&
-		checkpoint_state->curKeyType != CurKeyFinished)
+		tree_checkpoint_in_progress(desc))
 	{
 		/*
 		 * We're writing to the next checkpoint, while current checkpoint is
@@ -1224,6 +1266,8 @@ read_page_from_disk(BTreeDescr *desc, Pointer img, uint64 downlink,
 			if (!err)
 			{
 				OrioleDBOndiskPageHeader ondisk_page_header;
+				OCompressDict *dict = NULL;
+				uint8		compress_version;
 
 				memcpy(&ondisk_page_header, buf, sizeof(OrioleDBOndiskPageHeader));
 
@@ -1239,53 +1283,70 @@ read_page_from_disk(BTreeDescr *desc, Pointer img, uint64 downlink,
 					elog(FATAL, "Page version %u of OrioleDB cluster is not among supported for conversion %u", ondisk_page_header.page_version, ORIOLEDB_PAGE_VERSION);
 				}
 
-				if (ondisk_page_header.compress_version != ORIOLEDB_COMPRESS_VERSION)
+				compress_version = O_COMPRESS_VERSION_GET(ondisk_page_header.compress_version);
+				if (compress_version < 1 ||
+					compress_version > ORIOLEDB_COMPRESS_VERSION)
 				{
 					/*
-					 * Now we have only one compress version (1). When we have
-					 * different versions we'll need to bump
-					 * ORIOLEDB_COMPRESS_VERSION and add on-the-fly conversion
-					 * function from all previous compress versions
-					 * before/during decompression.
+					 * Version 2 added compression dictionaries and codecs.
+					 * Version 1 pages have zero dictionary number and codec
+					 * bits, so they are decompressed without conversion.
 					 */
-					elog(FATAL, "Page version %u of OrioleDB cluster is not among supported for conversion %u", ondisk_page_header.page_version, ORIOLEDB_PAGE_VERSION);
+					elog(FATAL, "Compress version %u of OrioleDB cluster is not among supported for conversion %u", compress_version, ORIOLEDB_COMPRESS_VERSION);
 				}
 
-				o_decompress_page(buf + sizeof(OrioleDBOndiskPageHeader), ondisk_page_header.compress_page_size, img);
+				/*
+				 * Don't throw an error here: the caller restores the parent
+				 * downlink on failure.
+				 */
+				if (ondisk_page_header.compress_dict_num != 0)
+				{
+					dict = o_compress_get_dict(desc->oids.datoid,
+											   desc->oids.relnode,
+											   ondisk_page_header.compress_dict_num,
+											   ondisk_page_header.compress_dict_id);
+					err = (dict == NULL);
+				}
+				if (!err)
+					o_decompress_page(buf + sizeof(OrioleDBOndiskPageHeader),
+									  ondisk_page_header.compress_page_size,
+									  img,
+									  O_COMPRESS_VERSION_GET_CODEC(ondisk_page_header.compress_version),
+									  dict);
 			}
 		}
 		else
 		{
 			OrioleDBOndiskPageHeader ondisk_page_header;
+			size_t		skipped = offsetof(BTreePageHeader, undoLocation);
 
 			byte_offset = (off_t) offset * (off_t) ORIOLEDB_COMP_BLCKSZ;
-			read_size = sizeof(OrioleDBOndiskPageHeader);
+			read_size = sizeof(OrioleDBOndiskPageHeader) + ORIOLEDB_BLCKSZ - skipped;
 
-			/* details about writed image parts are in write_page_to_disk */
-			err = btree_smgr_read(desc, (Pointer) &ondisk_page_header, chkpNum, read_size, byte_offset) != read_size;
-			byte_offset += read_size;
+			/*
+			 * Details about written image parts are in write_page_to_disk().
+			 * Read both the header and the page data at once.
+			 */
+			err = btree_smgr_read(desc, buf, chkpNum, read_size, byte_offset) != read_size;
 
 			if (!err)
 			{
-				size_t		skipped = offsetof(BTreePageHeader, undoLocation);
 				BTreePageHeader *btree_page_header;
 
+				memcpy(&ondisk_page_header, buf, sizeof(OrioleDBOndiskPageHeader));
 				memset(img, 0, skipped);
-				read_size = ORIOLEDB_BLCKSZ - skipped;
-				err = btree_smgr_read(desc, img + skipped, chkpNum, read_size, byte_offset) != read_size;
+				memcpy(img + skipped, buf + sizeof(OrioleDBOndiskPageHeader),
+					   ORIOLEDB_BLCKSZ - skipped);
 
-				if (!err)
+				if (ondisk_page_header.page_version != ORIOLEDB_PAGE_VERSION)
 				{
-					if (ondisk_page_header.page_version != ORIOLEDB_PAGE_VERSION)
-					{
-						/*
-						 * Now we have only one page version (1). When we have
-						 * different versions we'll need to bump
-						 * ORIOLEDB_PAGE_VERSION and add on-the-fly conversion
-						 * function from all previous page versions here
-						 */
-						elog(FATAL, "Page version %u of OrioleDB cluster is not among supported for conversion %u", ondisk_page_header.page_version, ORIOLEDB_PAGE_VERSION);
-					}
+					/*
+					 * Now we have only one page version (1). When we have
+					 * different versions we'll need to bump
+					 * ORIOLEDB_PAGE_VERSION and add on-the-fly conversion
+					 * function from all previous page versions here
+					 */
+					elog(FATAL, "Page version %u of OrioleDB cluster is not among supported for conversion %u", ondisk_page_header.page_version, ORIOLEDB_PAGE_VERSION);
 				}
 				btree_page_header = (BTreePageHeader *) img;
 				btree_page_header->o_header.checkpointNum = ondisk_page_header.checkpointNum;
@@ -1296,12 +1357,96 @@ read_page_from_disk(BTreeDescr *desc, Pointer img, uint64 downlink,
 	return !err;
 }
 
+/*
+ * Returns the range of the data file occupied by the page referenced by the
+ * on-disk downlink.
+ */
+void
+btree_downlink_get_disk_range(BTreeDescr *desc, uint64 downlink,
+							  off_t *offset, int *amount)
+{
+	uint64		off = DOWNLINK_GET_DISK_OFF(downlink);
+	uint16		len = DOWNLINK_GET_DISK_LEN(downlink);
+
+	Assert(DOWNLINK_IS_ON_DISK(downlink));
+
+	if (!OCompressIsValid(desc->compress))
+	{
+		*offset = (off_t) off * (off_t) ORIOLEDB_BLCKSZ;
+		*amount = ORIOLEDB_BLCKSZ;
+	}
+	else
+	{
+		*offset = (off_t) off * (off_t) ORIOLEDB_COMP_BLCKSZ;
+		*amount = len * ORIOLEDB_COMP_BLCKSZ;
+	}
+}
+
+/*
+ * Issues prefetch of the page referenced by the on-disk downlink.  Allows to
+ * overlap reading of several pages, which are going to be loaded one by one
+ * by read_page_from_disk().
+ */
+void
+btree_prefetch_downlink(BTreeDescr *desc, uint64 downlink)
+{
+	off_t		offset;
+	int			amount;
+
+	btree_downlink_get_disk_range(desc, downlink, &offset, &amount);
+	btree_smgr_prefetch(desc, 0, offset, amount);
+}
+
+/*
+ * Copies the page referenced by the on-disk downlink to the new extent at the
+ * end of the data file, and marks the copy as written by the given
+ * checkpoint.  The image is copied as is without decompression.  Caller
+ * should replace the parent downlink with the IO downlink beforehand, which
+ * prevents concurrent loading of the page (and so rewriting it in place).
+ * Caller is responsible for freeing the old extent.
+ *
+ * Returns false if IO fails.  The on-disk downlink of the copy is returned
+ * in *new_downlink.
+ */
+bool
+btree_relocate_disk_page(BTreeDescr *desc, uint64 downlink, uint32 chkpNum,
+						 uint64 *new_downlink)
+{
+	BTreeMetaPage *metaPage = BTREE_GET_META(desc);
+	OrioleDBOndiskPageHeader *ondisk_page_header;
+	FileExtent	extent;
+	off_t		byte_offset;
+	int			amount;
+	char		buf[ORIOLEDB_BLCKSZ];
+
+	Assert(!orioledb_s3_mode && !use_device);
+	Assert(DOWNLINK_IS_ON_DISK(downlink));
+
+	btree_downlink_get_disk_range(desc, downlink, &byte_offset, &amount);
+	if (btree_smgr_read(desc, buf, 0, amount, byte_offset) != amount)
+		return false;
+
+	ondisk_page_header = (OrioleDBOndiskPageHeader *) buf;
+	ondisk_page_header->checkpointNum = chkpNum;
+
+	extent.len = DOWNLINK_GET_DISK_LEN(downlink);
+	extent.off = pg_atomic_fetch_add_u64(&metaPage->datafileLength[0],
+										 extent.len);
+	*new_downlink = MAKE_ON_DISK_DOWNLINK(extent);
+
+	o_compressed_tier_forget(desc->oids.datoid, desc->oids.relnode,
+							 extent.off);
+
+	btree_downlink_get_disk_range(desc, *new_downlink, &byte_offset, &amount);
+	return btree_smgr_write(desc, buf, 0, amount, byte_offset) == amount;
+}
+
 /*
  * Writes a page to the disk. An array of file offsets must be valid.
  */
 static bool
 write_page_to_disk(BTreeDescr *desc, FileExtent *extent, uint32 curChkpNum,
-				   Pointer page, off_t page_size)
+				   Pointer page, off_t page_size, uint64 compressDict)
 {
 
 	off_t		byte_offset,
@@ -1312,6 +1457,11 @@ write_page_to_disk(BTreeDescr *desc, FileExtent *extent, uint32 curChkpNum,
 
 	Assert(sizeof(OrioleDBOndiskPageHeader) == O_PAGE_HEADER_SIZE);
 	Assert(FileExtentOffIsValid(extent->off));
+
+	/* The extent might hold another page before, forget its image */
+	o_compressed_tier_forget(desc->oids.datoid, desc->oids.relnode,
+							 extent->off);
+
 	if (!OCompressIsValid(desc->compress))
 	{
 		OrioleDBOndiskPageHeader *ondisk_page_header;
@@ -1360,33 +1510,37 @@ write_page_to_disk(BTreeDescr *desc, FileExtent *extent, uint32 curChkpNum,
 		Assert(sizeof(((OrioleDBOndiskPageHeader *) 0)->compress_page_size) == sizeof(uint16));
 		Assert(ORIOLEDB_BLCKSZ < UINT16_MAX);
 
-		/* we need to write header first */
+		/*
+		 * The header is followed by the page data.  Both are assembled in
+		 * the single buffer to be written with one I/O operation.
+		 */
 		ondisk_page_header.compress_page_size = page_size;
 		ondisk_page_header.checkpointNum = curChkpNum;
-		ondisk_page_header.compress_version = ORIOLEDB_COMPRESS_VERSION;
+		ondisk_page_header.compress_version = O_COMPRESS_VERSION_MAKE(O_COMPRESS_CODEC(desc->compress));
 		ondisk_page_header.page_version = ORIOLEDB_PAGE_VERSION;
-
-		write_size = sizeof(OrioleDBOndiskPageHeader);
-		err = btree_smgr_write(desc, (char *) &ondisk_page_header, chkpNum, write_size, byte_offset) != write_size;
-		byte_offset += write_size;
-
-		if (err)
-			return false;
+		ondisk_page_header.compress_dict_num = O_COMPRESS_DICT_GET_NUM(compressDict);
+		ondisk_page_header.compress_dict_id = O_COMPRESS_DICT_GET_ID(compressDict);
+		memcpy(buf, &ondisk_page_header, sizeof(OrioleDBOndiskPageHeader));
 
 		if (page_size != ORIOLEDB_BLCKSZ)
 		{
-			write_size = extent->len * ORIOLEDB_COMP_BLCKSZ - sizeof(OrioleDBOndiskPageHeader);
-			err = btree_smgr_write(desc, page, chkpNum, write_size, byte_offset) != write_size;
+			write_size = extent->len * ORIOLEDB_COMP_BLCKSZ;
+			Assert(write_size <= ORIOLEDB_BLCKSZ);
+			memcpy(&buf[sizeof(OrioleDBOndiskPageHeader)], page,
+				   write_size - sizeof(OrioleDBOndiskPageHeader));
 		}
 		else
 		{
 			size_t		skipped = offsetof(BTreePageHeader, undoLocation);
 
 			/* Skipping chkpNum because it is present in BTreePageHeader */
-			page += skipped;
-			write_size = ORIOLEDB_BLCKSZ - skipped;
-			err = btree_smgr_write(desc, page, chkpNum, write_size, byte_offset) != write_size;
+			StaticAssertStmt(sizeof(OrioleDBOndiskPageHeader) <= offsetof(BTreePageHeader, undoLocation),
+							 "on-disk header must fit into the skipped part of the page");
+			write_size = sizeof(OrioleDBOndiskPageHeader) + ORIOLEDB_BLCKSZ - skipped;
+			memcpy(&buf[sizeof(OrioleDBOndiskPageHeader)], page + skipped,
+				   ORIOLEDB_BLCKSZ - skipped);
 		}
+		err = btree_smgr_write(desc, buf, chkpNum, write_size, byte_offset) != write_size;
 	}
 
 	return !err;
@@ -1453,6 +1607,9 @@ load_page(OBTreeFindPageContext *context)
 
 	unlock_page(parent_blkno);
 
+	/* Bulk reader evicts its own leaf instead of others' pages */
+	ppool_ring_recycle(desc->ppool);
+
 	/* Prepare new page metaPage-data */
 	ppool_reserve_pages(desc->ppool, PPOOL_RESERVE_FIND, 1);
 	blkno = ppool_get_page(desc->ppool, PPOOL_RESERVE_FIND);
@@ -1467,7 +1624,13 @@ load_page(OBTreeFindPageContext *context)
 	page_desc->flags = 0;
 
 	/* Read page data and put it to the page */
-	if (!read_page_from_disk(desc, buf, downlink, &page_desc->fileExtent))
+	if (o_compressed_tier_take(desc->oids.datoid, desc->oids.relnode,
+							   downlink, buf))
+	{
+		page_desc->fileExtent.off = DOWNLINK_GET_DISK_OFF(downlink);
+		page_desc->fileExtent.len = DOWNLINK_GET_DISK_LEN(downlink);
+	}
+	else if (!read_page_from_disk(desc, buf, downlink, &page_desc->fileExtent))
 	{
 		int_hdr->downlink = downlink;
 		PAGE_INC_N_ONDISK(parent_page);
@@ -1483,9 +1646,14 @@ load_page(OBTreeFindPageContext *context)
 
 	put_page_image(blkno, buf);
 	page_change_usage_count(&desc->ppool->ucm, blkno,
-							(pg_atomic_read_u32(desc->ppool->ucm.epoch) + 2) % UCM_USAGE_LEVELS);
+							ucm_load_usage_count(&desc->ppool->ucm,
+												 btree_over_memory_quota(desc)));
+	btree_inc_pages_in_memory(desc);
+	btree_count_event(desc, BTreeEventLoad);
 	page_desc->type = parent_page_desc->type;
 	page_desc->oids = parent_page_desc->oids;
+	if (O_PAGE_IS(page, LEAF))
+		ppool_ring_add(blkno);
 
 	Assert(O_PAGE_IS(page, LEAF) ||
 		   (PAGE_GET_N_ONDISK(page) == BTREE_PAGE_ITEMS_COUNT(page)));
@@ -1612,16 +1780,56 @@ load_page(OBTreeFindPageContext *context)
 }
 
 /*
- * Returns pointer to writable image. It compresses page if needed.
+ * Returns the current compression dictionary of the tree.
+ */
+static inline uint64
+get_compress_dict(BTreeDescr *desc)
+{
+	if (!OCompressIsLZ4(desc->compress) && OMetaPageIsValid(desc))
+		return pg_atomic_read_u64(&BTREE_GET_META(desc)->compressDict);
+	return 0;
+}
+
+/*
+ * Returns pointer to writable image. It compresses page if needed using the
+ * current dictionary of the tree, which is returned in `compressDict`.  If
+ * `blkno` is valid, the image compressed by background writers is used when
+ * available.
  */
 static inline Pointer
-get_write_img(BTreeDescr *desc, Page page, size_t *size)
+get_write_img(BTreeDescr *desc, OInMemoryBlkno blkno, Page page, size_t *size,
+			  uint64 *compressDict)
 {
 	Pointer		result;
 
+	*compressDict = 0;
 	if (OCompressIsValid(desc->compress))
 	{
-		result = o_compress_page(page, size, desc->compress);
+		*compressDict = get_compress_dict(desc);
+
+		result = NULL;
+		if (OInMemoryBlknoIsValid(blkno))
+			result = o_compress_queue_take(blkno, desc->oids.datoid,
+										   desc->oids.relnode, page,
+										   desc->compress, *compressDict,
+										   size);
+
+		if (result == NULL)
+		{
+			OCompressDict *dict = NULL;
+
+			/* Write without the dictionary if it can't be loaded */
+			if (*compressDict != 0)
+			{
+				dict = o_compress_get_dict(desc->oids.datoid, desc->oids.relnode,
+										   O_COMPRESS_DICT_GET_NUM(*compressDict),
+										   O_COMPRESS_DICT_GET_ID(*compressDict));
+				if (!dict)
+					*compressDict = 0;
+			}
+			result = o_compress_page(page, size, desc->compress, dict);
+		}
+
 		if (*size > (ORIOLEDB_BLCKSZ - ORIOLEDB_COMP_BLCKSZ - sizeof(OrioleDBOndiskPageHeader)))
 		{
 			/*
@@ -1629,6 +1837,7 @@ get_write_img(BTreeDescr *desc, Page page, size_t *size)
 			 */
 			result = page;
 			*size = ORIOLEDB_BLCKSZ;
+			*compressDict = 0;
 		}
 	}
 	else
@@ -1639,6 +1848,51 @@ get_write_img(BTreeDescr *desc, Page page, size_t *size)
 	return result;
 }
 
+/*
+ * Puts the images of the given dirty in-memory leaves to the queue for the
+ * compression by background writers.  Busy, clean or already evicted pages
+ * are skipped.  perform_page_io() takes the compressed images unless the
+ * pages are modified in between.
+ */
+void
+btree_offload_compression(BTreeDescr *desc, uint32 chkpNum,
+						  uint64 *downlinks, int count)
+{
+	uint64		compressDict = get_compress_dict(desc);
+	bool		queued = false;
+	int			i;
+
+	Assert(OCompressIsValid(desc->compress));
+
+	for (i = 0; i < count; i++)
+	{
+		OInMemoryBlkno blkno = DOWNLINK_GET_IN_MEMORY_BLKNO(downlinks[i]);
+		Page		page = O_GET_IN_MEMORY_PAGE(blkno);
+		bool		full = false;
+
+		if (!try_lock_page(blkno))
+			continue;
+
+		if (O_PAGE_GET_CHANGE_COUNT(page) == DOWNLINK_GET_IN_MEMORY_CHANGECOUNT(downlinks[i]) &&
+			O_PAGE_IS(page, LEAF) && IS_DIRTY(blkno))
+		{
+			if (o_compress_queue_put(blkno, desc->oids.datoid,
+									 desc->oids.relnode, desc->compress,
+									 compressDict, page, chkpNum))
+				queued = true;
+			else
+				full = true;
+		}
+		unlock_page(blkno);
+
+		if (full)
+			break;
+	}
+
+	if (queued)
+		o_compress_queue_wakeup();
+}
+
 #ifdef USE_ASSERT_CHECKING
 static void
 prewrite_image_check(Page p)
@@ -1670,6 +1924,7 @@ perform_page_io(BTreeDescr *desc, OInMemoryBlkno blkno,
 	OrioleDBPageDesc *page_desc = O_GET_IN_MEMORY_PAGEDESC(blkno);
 	Pointer		write_img;
 	size_t		write_size;
+	uint64		compressDict;
 	int			chkp_index;
 	bool		less_num,
 				err = false;
@@ -1703,7 +1958,7 @@ perform_page_io(BTreeDescr *desc, OInMemoryBlkno blkno,
 		Assert(header->o_header.checkpointNum == checkpoint_number);
 	}
 
-	write_img = get_write_img(desc, img, &write_size);
+	write_img = get_write_img(desc, blkno, img, &write_size, &compressDict);
 
 	/*
 	 * Determine the file position to write this page.
@@ -1853,7 +2108,8 @@ perform_page_io(BTreeDescr *desc, OInMemoryBlkno blkno,
 
 	Assert(FileExtentIsValid(page_desc->fileExtent));
 
-	if (!write_page_to_disk(desc, &page_desc->fileExtent, checkpoint_number, write_img, write_size))
+	if (!write_page_to_disk(desc, &page_desc->fileExtent, checkpoint_number, write_img, write_size,
+							compressDict))
 	{
 		ereport(PANIC, (errcode_for_file_access(),
 						errmsg("could not write page %d to file %s with offset %lu: %m",
@@ -1878,12 +2134,14 @@ perform_page_io_autonomous(BTreeDescr *desc, uint32 chkpNum, Page img, FileExten
 {
 	Pointer		write_img;
 	size_t		write_size;
+	uint64		compressDict;
 
 #ifdef USE_ASSERT_CHECKING
 	prewrite_image_check(img);
 #endif
 
-	write_img = get_write_img(desc, img, &write_size);
+	write_img = get_write_img(desc, OInvalidInMemoryBlkno, img, &write_size,
+							  &compressDict);
 
 	if (!get_free_disk_extent(desc, chkpNum, write_size, extent))
 	{
@@ -1896,7 +2154,8 @@ perform_page_io_autonomous(BTreeDescr *desc, uint32 chkpNum, Page img, FileExten
 
 	Assert(FileExtentIsValid(*extent));
 
-	if (!write_page_to_disk(desc, extent, chkpNum, write_img, write_size))
+	if (!write_page_to_disk(desc, extent, chkpNum, write_img, write_size,
+							compressDict))
 	{
 		uint64		offset;
 
@@ -1934,6 +2193,7 @@ perform_page_io_build(BTreeDescr *desc, Page img,
 {
 	Pointer		write_img;
 	size_t		write_size;
+	uint64		compressDict;
 	uint32		chkpNum;
 
 	btree_page_update_max_key_len(desc, img);
@@ -1942,7 +2202,8 @@ perform_page_io_build(BTreeDescr *desc, Page img,
 	prewrite_image_check(img);
 #endif
 
-	write_img = get_write_img(desc, img, &write_size);
+	write_img = get_write_img(desc, OInvalidInMemoryBlkno, img, &write_size,
+							  &compressDict);
 
 	if (orioledb_s3_mode)
 		chkpNum = checkpoint_state->lastCheckpointNumber;
@@ -1997,7 +2258,8 @@ perform_page_io_build(BTreeDescr *desc, Page img,
 
 	Assert(FileExtentIsValid(*extent));
 
-	if (!write_page_to_disk(desc, extent, 0, write_img, write_size))
+	if (!write_page_to_disk(desc, extent, 0, write_img, write_size,
+							compressDict))
 	{
 		ereport(PANIC, (errcode_for_file_access(),
 						errmsg("could not write autonomous page to file %s with offset %lu: %m",
@@ -2114,6 +2376,14 @@ write_page(OBTreeFindPageContext *context, OInMemoryBlkno blkno, Page img,
 		 * disk.  Then we just have to change downlink in the parent.
 		 */
 		Assert(FileExtentIsValid(page_desc->fileExtent));
+
+		/*
+		 * Keep the image in the compressed tier.  That should be done before
+		 * the downlink is published: once the page is loaded again, its
+		 * extent might be freed and reused.
+		 */
+		o_compressed_tier_put(desc->oids.datoid, desc->oids.relnode,
+							  MAKE_ON_DISK_DOWNLINK(page_desc->fileExtent), p);
 		int_hdr->downlink = MAKE_ON_DISK_DOWNLINK(page_desc->fileExtent);
 		PAGE_INC_N_ONDISK(parent_page);
 
@@ -2264,7 +2534,11 @@ write_page(OBTreeFindPageContext *context, OInMemoryBlkno blkno, Page img,
 		unlock_page(parent_blkno);
 
 	if (evict)
+	{
 		ppool_free_page(desc->ppool, blkno, NULL);
+		btree_dec_pages_in_memory(desc);
+		btree_count_event(desc, BTreeEventEviction);
+	}
 
 	perform_writeback(&io_writeback);
 }
@@ -2360,6 +2634,8 @@ evict_btree(BTreeDescr *desc, uint32 checkpoint_number)
 	uint32		chkpNum = 0;
 	bool		notModified;
 	bool		hasMetaLock = LWLockHeldByMe(&checkpoint_state->oTablesMetaLock);
+	FileExtent	cachedExtents[EXTENT_CACHE_MAX_LEN * EXTENT_CACHE_SLOTS];
+	int			numCachedExtents;
 
 	Assert(ORootPageIsValid(desc) && OMetaPageIsValid(desc) &&
 		   O_PAGE_STATE_IS_LOCKED(pg_atomic_read_u64(&(O_PAGE_HEADER(rootPageBlkno)->state))));
@@ -2448,6 +2724,9 @@ evict_btree(BTreeDescr *desc, uint32 checkpoint_number)
 	if (!orioledb_s3_mode || desc->storageType == BTreeStorageTemporary)
 		btree_finalize_private_seq_bufs(desc, &evicted_tree_data, notModified);
 
+	/* Free extents cached in the meta page go back to the B-trees */
+	numCachedExtents = free_extents_cache_drain(desc, cachedExtents);
+
 	ppool_free_page(desc->ppool, desc->rootInfo.metaPageBlkno, NULL);
 
 	desc->rootInfo.rootPageBlkno = OInvalidInMemoryBlkno;
@@ -2455,6 +2734,8 @@ evict_btree(BTreeDescr *desc, uint32 checkpoint_number)
 
 	perform_writeback(&io_writeback);
 
+	free_extents_cache_return(desc, cachedExtents, numCachedExtents);
+
 	/*
 	 * Check if we can skip the evicted data if tree has no modification after
 	 * writing the last *.map file.
@@ -2576,6 +2857,35 @@ release_evict_btree_locks(ORelOids oids, EvictBtreeLocksState *state)
 		o_tables_rel_unlock_extended(&state->tableOids, AccessExclusiveLock, true);
 }
 
+/*
+ * Check if the tree has more pages in memory than its memory quota allows.
+ */
+static bool
+btree_over_memory_quota(BTreeDescr *desc)
+{
+	return desc->memoryQuota > 0 &&
+		TREE_NUM_PAGES_IN_MEMORY(desc) >= desc->memoryQuota;
+}
+
+/*
+ * Check if the tree pages should be protected from eviction.  Pinned tree
+ * stays protected within its memory quota (or a half of the pool if there is
+ * no quota), but not when the pool runs out of free pages: otherwise,
+ * backends waiting for a free page could loop forever.
+ */
+static bool
+btree_memory_pinned(BTreeDescr *desc)
+{
+	OInMemoryBlkno limit;
+
+	if (!desc->memoryPin)
+		return false;
+
+	limit = desc->memoryQuota > 0 ? desc->memoryQuota : desc->ppool->size / 2;
+	return TREE_NUM_PAGES_IN_MEMORY(desc) < limit &&
+		ppool_free_pages_count(desc->ppool) > 0;
+}
+
 /*
  * Examine single page and evict it if possible.
  */
@@ -2652,6 +2962,14 @@ retry:
 		return OWalkPageSkipped;
 	}
 
+	/* Give the pages of pinned trees another round of the clock */
+	if (evict && btree_memory_pinned(desc))
+	{
+		ucm_protect_page(&desc->ppool->ucm, blkno);
+		unlock_page(blkno);
+		return OWalkPageSkipped;
+	}
+
 	if (O_PAGE_IS(p, PRE_CLEANUP))
 	{
 		unlock_page(blkno);
@@ -3044,6 +3362,63 @@ writeback_put_extent(IOWriteBack *writeback, BTreeDescr *desc,
 	}
 }
 
+/*
+ * Issues writeback of the file range.  With io_uring ranges are accumulated
+ * and then submitted together by writeback_flush_ranges(), which must be
+ * called before the file is closed.
+ */
+static void
+writeback_file_range(File file, off_t offset, off_t amount)
+{
+	OIORequest *request;
+
+	if (!o_io_uring_enabled())
+	{
+		FileWriteback(file, offset, amount, WAIT_EVENT_DATA_FILE_FLUSH);
+		return;
+	}
+
+	if (!enableFsync || amount <= 0)
+		return;
+
+	if (writebackRequestsNum >= WRITEBACK_REQUESTS_BATCH ||
+		(writebackRequestsNum > 0 && file != writebackFile))
+		writeback_flush_ranges();
+
+	writebackFile = file;
+	request = &writebackRequests[writebackRequestsNum++];
+	request->amount = amount;
+	request->offset = offset;
+}
+
+static void
+writeback_flush_ranges(void)
+{
+	int			fd,
+				i;
+
+	if (writebackRequestsNum == 0)
+		return;
+
+	/*
+	 * The virtual file descriptor might have been closed by the LRU of fd.c
+	 * since the ranges were accumulated.  FileSize() reopens it, and nothing
+	 * can close it again before the submission.
+	 */
+	if (FileSize(writebackFile) >= 0)
+	{
+		fd = FileGetRawDesc(writebackFile);
+		for (i = 0; i < writebackRequestsNum; i++)
+			writebackRequests[i].fd = fd;
+
+		/* Writeback is only a hint, so its errors are ignored like in fd.c */
+		(void) o_io_uring_writeback(writebackRequests, writebackRequestsNum,
+									WAIT_EVENT_DATA_FILE_FLUSH);
+	}
+	writebackRequestsNum = 0;
+	writebackFile = -1;
+}
+
 static void
 perform_writeback(IOWriteBack *writeback)
 {
@@ -3089,10 +3464,10 @@ perform_writeback(IOWriteBack *writeback)
 			{
 				if (len > 0)
 				{
-					FileWriteback(file, (off_t) offset * blcksz,
-								  (off_t) len * blcksz,
-								  WAIT_EVENT_DATA_FILE_FLUSH);
+					writeback_file_range(file, (off_t) offset * blcksz,
+												 (off_t) len * blcksz);
 				}
+				writeback_flush_ranges();
 				if (file >= 0)
 					FileClose(file);
 			}
@@ -3128,9 +3503,8 @@ perform_writeback(IOWriteBack *writeback)
 				if (use_mmap)
 					msync(mmap_data + (off_t) segno * ORIOLEDB_SEGMENT_SIZE + (off_t) offset * blcksz, (off_t) len * blcksz, MS_ASYNC);
 				else
-					FileWriteback(file, (off_t) offset * blcksz,
-								  (off_t) len * blcksz,
-								  WAIT_EVENT_DATA_FILE_FLUSH);
+					writeback_file_range(file, (off_t) offset * blcksz,
+												 (off_t) len * blcksz);
 				offset = cur.fileExtent.off;
 				len = cur.fileExtent.len;
 			}
@@ -3143,11 +3517,11 @@ perform_writeback(IOWriteBack *writeback)
 		if (use_mmap)
 			msync(mmap_data + (off_t) segno * ORIOLEDB_SEGMENT_SIZE + (off_t) offset * blcksz, (off_t) len * blcksz, MS_ASYNC);
 		else
-			FileWriteback(file, (off_t) offset * blcksz,
-						  (off_t) len * blcksz,
-						  WAIT_EVENT_DATA_FILE_FLUSH);
+			writeback_file_range(file, (off_t) offset * blcksz,
+										 (off_t) len * blcksz);
 	}
 
+	writeback_flush_ranges();
 	if (!use_mmap && file >= 0)
 		FileClose(file);
 
@@ -3191,7 +3565,7 @@ iterate_relnode_files(Oid datoid, Oid relnode, RelnodeFileCallback callback,
 		if ((sscanf(file->d_name, "%10u-%10u.%4s",
 					&file_relnode, &file_chkp, file_ext) == 3 &&
 			 (!strcmp(file_ext, "tmp") || !strcmp(file_ext, "map") ||
-			  !strcmp(file_ext, "evt")) &&
+			  !strcmp(file_ext, "evt") || !strcmp(file_ext, "dict")) &&
 			 (file_ext_p = file_ext)) ||
 			sscanf(file->d_name, "%10u.%10u",
 				   &file_relnode, &file_segno) == 2 ||
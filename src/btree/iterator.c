@@ -15,8 +15,10 @@
 
 #include "orioledb.h"
 
+#include "btree/adaptive_hash.h"
 #include "btree/btree.h"
 #include "btree/find.h"
+#include "btree/io.h"
 #include "btree/iterator.h"
 #include "btree/page_chunks.h"
 #include "btree/undo.h"
@@ -106,6 +108,25 @@ static void undo_it_find_internal(UndoIterator *undoIt, void *key, BTreeKeyType
 			BTREE_PAGE_LOCATOR_PREV((undoIt)->image, (loc)); \
 	} while (0); \
 
+/*
+ * Checks if the leaf page image found by find_page() or refind_page()
+ * contains the key.
+ */
+static bool
+leaf_image_contains_key(OBTreeFindPageContext *context, void *key,
+						BTreeKeyType kind)
+{
+	BTreePageItemLocator *loc = &context->items[context->index].locator;
+	OTuple		curTuple;
+
+	if (!BTREE_PAGE_LOCATOR_IS_VALID(context->img, loc))
+		return false;
+
+	BTREE_PAGE_READ_LEAF_TUPLE(curTuple, context->img, loc);
+	return o_btree_cmp(context->desc, key, kind,
+					   &curTuple, BTreeKeyLeafTuple) == 0;
+}
+
 /*
  * Fetches tuple from the tree with given CSN snapshot.  Tuple is allocated
  * in the given context.  Leaf page is found using the given hint (if provided).
@@ -127,6 +148,8 @@ o_btree_find_tuple_by_key_cb(BTreeDescr *desc, void *key,
 	bool		combinedResult = false;
 	OTuple		result;
 	OFindPageResult findResult PG_USED_FOR_ASSERTS_ONLY;
+	BTreeLocationHint ahiHint;
+	uint32		ahiHash;
 
 	if (COMMITSEQNO_IS_NORMAL(read_o_snapshot->csn))
 		combinedResult = !have_current_undo(desc->undoType);
@@ -137,9 +160,35 @@ o_btree_find_tuple_by_key_cb(BTreeDescr *desc, void *key,
 
 	/* Use page location hint if provided */
 	if (hint && OInMemoryBlknoIsValid(hint->blkno))
+	{
 		findResult = refind_page(&context, key, kind, 0, hint->blkno, hint->pageChangeCount);
+	}
+	else if (btree_ahi_lookup(desc, key, kind, &ahiHash, &ahiHint))
+	{
+		bool		hit = false;
+
+		/*
+		 * The adaptive hash index entry might be a hash collision, so the
+		 * leaf is only trusted if it contains the key.
+		 */
+		if (OInMemoryBlknoIsValid(ahiHint.blkno))
+		{
+			findResult = refind_page(&context, key, kind, 0,
+									 ahiHint.blkno, ahiHint.pageChangeCount);
+			hit = leaf_image_contains_key(&context, key, kind);
+		}
+		if (!hit)
+			findResult = find_page(&context, key, kind, 0);
+
+		btree_ahi_update(desc, ahiHash, hit,
+						 hit || leaf_image_contains_key(&context, key, kind),
+						 context.items[context.index].blkno,
+						 context.items[context.index].pageChangeCount);
+	}
 	else
+	{
 		findResult = find_page(&context, key, kind, 0);
+	}
 
 	Assert(findResult == OFindPageResultSuccess);
 
@@ -232,6 +281,142 @@ o_btree_find_tuple_by_key(BTreeDescr *desc, void *key, BTreeKeyType kind,
 }
 
 
+/*
+ * Locates the downlink for the given key in the parent page image previously
+ * found by find_page().  Returns false if the page was concurrently changed.
+ */
+static bool
+batch_find_downlink(OBTreeFindPageContext *pcontext, void *key,
+					BTreeKeyType kind, uint64 *downlink)
+{
+	BTreePageItemLocator loc;
+	BTreeNonLeafTuphdr *tuphdr;
+	Page		img = pcontext->img;
+
+	if (!partial_load_hikeys_chunk(&pcontext->partial, img))
+		return false;
+
+	if (!btree_page_search(pcontext->desc, img, key, kind,
+						   &pcontext->partial, &loc))
+		return false;
+
+	BTREE_PAGE_LOCATOR_PREV(img, &loc);
+	if (!partial_load_chunk(&pcontext->partial, img, loc.chunkOffset, NULL))
+		return false;
+
+	tuphdr = (BTreeNonLeafTuphdr *) BTREE_PAGE_LOCATOR_GET_ITEM(img, &loc);
+	*downlink = tuphdr->downlink;
+	return true;
+}
+
+/*
+ * Finds tuples for the array of keys sorted in the ascending order.  The
+ * result is the same as o_btree_find_tuple_by_key() called for each key, but
+ * the descent is shared between keys.  The parent of leaves is found once for
+ * the group of keys falling into it, then leaves are read directly by their
+ * downlinks.  On-disk leaves required by the group are prefetched together
+ * before the first of them is loaded.
+ *
+ * out_csns may be NULL.
+ */
+void
+o_btree_find_tuples_by_keys(BTreeDescr *desc, void **keys, int nkeys,
+							BTreeKeyType kind, OSnapshot *read_o_snapshot,
+							MemoryContext mcxt, OTuple *results,
+							CommitSeqNo *out_csns)
+{
+	OBTreeFindPageContext *pcontext = NULL;
+	OFixedKey	parentHikey;
+	bool		parentValid = false;
+	bool		parentRightmost = false;
+	int			prefetchedUpTo = 0;
+	int			i;
+
+	if (nkeys > 1 &&
+		PAGE_GET_LEVEL(O_GET_IN_MEMORY_PAGE(desc->rootInfo.rootPageBlkno)) > 0)
+	{
+		pcontext = (OBTreeFindPageContext *) palloc(sizeof(OBTreeFindPageContext));
+		init_page_find_context(pcontext, desc, COMMITSEQNO_INPROGRESS,
+							   BTREE_PAGE_FIND_FETCH);
+	}
+
+	for (i = 0; i < nkeys; i++)
+	{
+		BTreeLocationHint hint = {OInvalidInMemoryBlkno, 0};
+		uint64		downlink;
+
+		Assert(i == 0 || o_btree_cmp(desc, keys[i - 1], kind,
+									 keys[i], kind) <= 0);
+
+		if (pcontext && parentValid && !parentRightmost &&
+			o_btree_cmp(desc, keys[i], kind,
+						&parentHikey.tuple, BTreeKeyNonLeafKey) >= 0)
+			parentValid = false;
+
+		if (pcontext && !parentValid &&
+			find_page(pcontext, keys[i], kind, 1) == OFindPageResultSuccess &&
+			PAGE_GET_LEVEL(pcontext->img) == 1 &&
+			partial_load_hikeys_chunk(&pcontext->partial, pcontext->img))
+		{
+			parentValid = true;
+			parentRightmost = O_PAGE_IS(pcontext->img, RIGHTMOST);
+			if (!parentRightmost)
+				copy_fixed_hikey(desc, &parentHikey, pcontext->img);
+		}
+
+		if (parentValid && !batch_find_downlink(pcontext, keys[i], kind,
+												&downlink))
+			parentValid = false;
+
+		if (parentValid)
+		{
+			/*
+			 * Issue prefetch for on-disk leaves of the following keys under
+			 * the same parent.
+			 */
+			if (DOWNLINK_IS_ON_DISK(downlink) && prefetchedUpTo <= i)
+			{
+				int			j;
+				uint64		prevDownlink = InvalidDiskDownlink;
+
+				for (j = i; j < nkeys; j++)
+				{
+					uint64		nextDownlink;
+
+					if (!parentRightmost &&
+						o_btree_cmp(desc, keys[j], kind,
+									&parentHikey.tuple, BTreeKeyNonLeafKey) >= 0)
+						break;
+
+					if (!batch_find_downlink(pcontext, keys[j], kind,
+											 &nextDownlink))
+						break;
+
+					if (DOWNLINK_IS_ON_DISK(nextDownlink) &&
+						nextDownlink != prevDownlink)
+						btree_prefetch_downlink(desc, nextDownlink);
+					prevDownlink = nextDownlink;
+				}
+				prefetchedUpTo = j;
+			}
+
+			if (DOWNLINK_IS_IN_MEMORY(downlink))
+			{
+				hint.blkno = DOWNLINK_GET_IN_MEMORY_BLKNO(downlink);
+				hint.pageChangeCount = DOWNLINK_GET_IN_MEMORY_CHANGECOUNT(downlink);
+			}
+		}
+
+		results[i] = o_btree_find_tuple_by_key(desc, keys[i], kind,
+											   read_o_snapshot,
+											   out_csns ? &out_csns[i] : NULL,
+											   mcxt, &hint);
+	}
+
+	if (pcontext)
+		pfree(pcontext);
+}
+
 /*
  * Finds appropriate tuple version in the undo chain.
  */
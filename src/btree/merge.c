@@ -156,6 +156,8 @@ btree_try_merge_pages(BTreeDescr *desc,
 	merge_pages(desc, left_blkno, right, csn);
 	btree_page_update_max_key_len(desc, left);
 	MARK_DIRTY_EXTENDED(desc, left_blkno, checkpoint);
+	if (level > 0)
+		btree_page_inherit_subtree_dirty(left_blkno, right_blkno);
 
 	/* the right page can not be found in B-Tree after this line */
 
@@ -168,9 +170,8 @@ btree_try_merge_pages(BTreeDescr *desc,
 	pg_write_barrier();
 	left_header->csn = csn;
 
-	Assert(checkpoint_state->stack[level].hikeyBlkno != left_blkno);
-	if (checkpoint_state->stack[level].hikeyBlkno == right_blkno)
-		checkpoint_state->stack[level].hikeyBlkno = left_blkno;
+	Assert(!checkpoint_has_hikey_blkno(level, left_blkno));
+	checkpoint_move_hikey_blkno(level, right_blkno, left_blkno);
 	unlock_page(left_blkno);
 	left_blkno = OInvalidInMemoryBlkno;
 
@@ -181,6 +182,8 @@ btree_try_merge_pages(BTreeDescr *desc,
 	O_PAGE_CHANGE_COUNT_INC(right);
 
 	ppool_free_page(desc->ppool, right_blkno, true);
+	btree_dec_pages_in_memory(desc);
+	btree_count_event(desc, BTreeEventMerge);
 
 	if (O_PAGE_IS(left, LEAF))
 		pg_atomic_fetch_sub_u32(&BTREE_GET_META(desc)->leafPagesNum, 1);
@@ -393,6 +396,7 @@ btree_try_merge_and_unlock(BTreeDescr *desc, OInMemoryBlkno blkno,
 					!page_is_under_checkpoint(desc, right_blkno, true) &&
 					io_num < 0)
 				{
+					btree_find_context_mark_dirty(&find_context);
 					merged = btree_try_merge_pages(desc, parent_blkno, &key,
 												   &merge_parent, target_blkno,
 												   right_loc, right_blkno,
@@ -466,6 +470,7 @@ btree_try_merge_and_unlock(BTreeDescr *desc, OInMemoryBlkno blkno,
 					!page_is_under_checkpoint(desc, left_blkno, true) &&
 					io_num < 0)
 				{
+					btree_find_context_mark_dirty(&find_context);
 					merged = btree_try_merge_pages(desc, parent_blkno,
 												   &key, &merge_parent,
 												   left_blkno,
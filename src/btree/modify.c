@@ -99,6 +99,7 @@ static OBTreeModifyResult o_btree_normal_modify(BTreeDescr *desc,
 												CommitSeqNo opCsn,
 												RowLockMode lockMode,
 												BTreeLocationHint *hint,
+												BTreeLocationHint *leafHint,
 												BTreeLeafTupleDeletedStatus deleted,
 												BTreeModifyCallbackInfo *callbackInfo);
 
@@ -513,6 +514,7 @@ o_btree_modify_handle_conflicts(BTreeModifyInternalContext *context)
 										context->conflictUndoLocation))
 					context->cmp = -1;
 				MARK_DIRTY(desc, blkno);
+				btree_find_context_mark_dirty(context->pageFindContext);
 				END_CRIT_SECTION();
 			}
 			else if (COMMITSEQNO_IS_NORMAL(csn) || COMMITSEQNO_IS_FROZEN(csn))
@@ -676,6 +678,7 @@ o_btree_modify_item_rollback(BTreeModifyInternalContext *context)
 									 &context->conflictTupHdr,
 									 context->conflictUndoLocation);
 	MARK_DIRTY(desc, blkno);
+	btree_find_context_mark_dirty(context->pageFindContext);
 	END_CRIT_SECTION();
 
 	if (!applyResult)
@@ -868,6 +871,7 @@ o_btree_modify_delete(BTreeModifyInternalContext *context)
 						   MAXALIGN(o_btree_len(desc, curTuple, OTupleLength)));
 
 	MARK_DIRTY(desc, blkno);
+	btree_find_context_mark_dirty(context->pageFindContext);
 
 	END_CRIT_SECTION();
 
@@ -943,6 +947,7 @@ o_btree_modify_lock(BTreeModifyInternalContext *context)
 	tuphdr->deleted = BTreeLeafTupleNonDeleted;
 
 	MARK_DIRTY(desc, blkno);
+	btree_find_context_mark_dirty(context->pageFindContext);
 	END_CRIT_SECTION();
 	unlock_release(context, true);
 
@@ -988,6 +993,7 @@ o_btree_normal_modify(BTreeDescr *desc, BTreeOperationType action,
 					  Pointer key, BTreeKeyType keyType,
 					  OXid opOxid, CommitSeqNo opCsn,
 					  RowLockMode lockMode, BTreeLocationHint *hint,
+					  BTreeLocationHint *leafHint,
 					  BTreeLeafTupleDeletedStatus deleted,
 					  BTreeModifyCallbackInfo *callbackInfo)
 {
@@ -1051,6 +1057,12 @@ o_btree_normal_modify(BTreeDescr *desc, BTreeOperationType action,
 	}
 	Assert(findResult == OFindPageResultSuccess);
 
+	if (leafHint)
+	{
+		leafHint->blkno = pageFindContext.items[pageFindContext.index].blkno;
+		leafHint->pageChangeCount = pageFindContext.items[pageFindContext.index].pageChangeCount;
+	}
+
 	return o_btree_modify_internal(&pageFindContext, action, tuple, tupleType,
 								   key, keyType, opOxid, opCsn,
 								   lockMode, deleted, pageReserveKind,
@@ -1391,7 +1403,27 @@ o_btree_modify(BTreeDescr *desc, BTreeOperationType action,
 {
 	return o_btree_normal_modify(desc, action, tuple, tupleType,
 								 key, keyType, oxid, csn, lockMode,
-								 hint, BTreeLeafTupleNonDeleted, callbackInfo);
+								 hint, NULL, BTreeLeafTupleNonDeleted, callbackInfo);
+}
+
+/*
+ * Inserts the leaf tuple, which is a part of the batch sorted by key.  The
+ * location of the leaf page is saved to the *hint, so the next tuple of the
+ * batch (which isn't less than this one) can be inserted without descending
+ * from the root.  Stale hints are handled by refind_page().
+ */
+OBTreeModifyResult
+o_btree_insert_sorted(BTreeDescr *desc, OTuple tuple,
+					  Pointer key, BTreeKeyType keyType,
+					  OXid oxid, CommitSeqNo csn,
+					  BTreeLocationHint *hint,
+					  BTreeModifyCallbackInfo *callbackInfo)
+{
+	return o_btree_normal_modify(desc, BTreeOperationInsert,
+								 tuple, BTreeKeyLeafTuple,
+								 key, keyType, oxid, csn, RowLockUpdate,
+								 hint, hint, BTreeLeafTupleNonDeleted,
+								 callbackInfo);
 }
 
 OBTreeModifyResult
@@ -1408,7 +1440,7 @@ o_btree_delete_moved_partitions(BTreeDescr *desc, Pointer key,
 	return o_btree_normal_modify(desc, BTreeOperationDelete,
 								 nullTup, BTreeKeyNone,
 								 key, keyType, oxid, csn, RowLockUpdate,
-								 hint, BTreeLeafTupleMovedPartitions,
+								 hint, NULL, BTreeLeafTupleMovedPartitions,
 								 callbackInfo);
 }
 
@@ -1426,7 +1458,7 @@ o_btree_delete_pk_changed(BTreeDescr *desc, Pointer key,
 	return o_btree_normal_modify(desc, BTreeOperationDelete,
 								 nullTup, BTreeKeyNone,
 								 key, keyType, oxid, csn, RowLockUpdate,
-								 hint, BTreeLeafTuplePKChanged,
+								 hint, NULL, BTreeLeafTuplePKChanged,
 								 callbackInfo);
 }
 
@@ -1447,7 +1479,7 @@ o_btree_autonomous_insert(BTreeDescr *desc, OTuple tuple)
 										   get_current_oxid(),
 										   COMMITSEQNO_INPROGRESS,
 										   RowLockUpdate,
-										   NULL, BTreeLeafTupleNonDeleted,
+										   NULL, NULL, BTreeLeafTupleNonDeleted,
 										   &nullCallbackInfo);
 			o_wal_insert(desc, tuple);
 		}
@@ -1467,7 +1499,7 @@ o_btree_autonomous_insert(BTreeDescr *desc, OTuple tuple)
 									   InvalidOXid,
 									   COMMITSEQNO_INPROGRESS,
 									   RowLockUpdate,
-									   NULL, BTreeLeafTupleNonDeleted,
+									   NULL, NULL, BTreeLeafTupleNonDeleted,
 									   &nullCallbackInfo);
 	}
 
@@ -1493,7 +1525,7 @@ o_btree_autonomous_delete(BTreeDescr *desc, OTuple key, BTreeKeyType keyType,
 										   NULL, BTreeKeyNone,
 										   get_current_oxid(), COMMITSEQNO_INPROGRESS,
 										   RowLockUpdate,
-										   hint, BTreeLeafTupleNonDeleted,
+										   hint, NULL, BTreeLeafTupleNonDeleted,
 										   &nullCallbackInfo);
 			if (keyType == BTreeKeyLeafTuple)
 				o_wal_delete(desc, key);
@@ -1515,7 +1547,7 @@ o_btree_autonomous_delete(BTreeDescr *desc, OTuple key, BTreeKeyType keyType,
 									   NULL, BTreeKeyNone,
 									   InvalidOXid, COMMITSEQNO_INPROGRESS,
 									   RowLockUpdate,
-									   hint, BTreeLeafTupleNonDeleted,
+									   hint, NULL, BTreeLeafTupleNonDeleted,
 									   &nullCallbackInfo);
 	}
 
@@ -18,6 +18,7 @@
 #include "btree/find.h"
 #include "btree/page_chunks.h"
 #include "btree/undo.h"
+#include "catalog/sys_trees.h"
 #include "recovery/recovery.h"
 #include "tableam/descr.h"
 #include "transam/oxid.h"
@@ -32,6 +33,7 @@
 #include "storage/proclist.h"
 #include "storage/s_lock.h"
 #include "utils/memdebug.h"
+#include "utils/timestamp.h"
 
 /*
  * Navigates and reads the page image from undo log according to `key` of
@@ -318,6 +320,114 @@ o_btree_try_read_page(BTreeDescr *desc, OInMemoryBlkno blkno, uint32 pageChangeC
 	return ReadPageResultOK;
 }
 
+/*
+ * Account a tree page (besides the root) taken into the page pool.
+ */
+void
+btree_inc_pages_in_memory(BTreeDescr *desc)
+{
+	pg_atomic_fetch_add_u32(&BTREE_GET_META(desc)->numPagesInMemory, 1);
+}
+
+/*
+ * Account a tree page (besides the root) leaving the page pool.  Never goes
+ * below zero: the counter lives in the meta page and starts from zero each
+ * time the tree is loaded.
+ */
+void
+btree_dec_pages_in_memory(BTreeDescr *desc)
+{
+	pg_atomic_uint32 *counter = &BTREE_GET_META(desc)->numPagesInMemory;
+	uint32		value = pg_atomic_read_u32(counter);
+
+	while (value > 0 &&
+		   !pg_atomic_compare_exchange_u32(counter, &value, value - 1))
+		;
+}
+
+/*
+ * Counts the page churn event of the tree for orioledb_tree_stats.
+ */
+void
+btree_count_event(BTreeDescr *desc, BTreeEventType type)
+{
+	pg_atomic_fetch_add_u64(&BTREE_GET_META(desc)->numEvents[type], 1);
+}
+
+static inline void
+dirty_chkp_num_advance(pg_atomic_uint32 *dirtyChkpNum, uint32 chkpNum)
+{
+	uint32		value = pg_atomic_read_u32(dirtyChkpNum);
+
+	while (value < chkpNum &&
+		   !pg_atomic_compare_exchange_u32(dirtyChkpNum, &value, chkpNum))
+		;
+}
+
+/*
+ * Returns the last checkpoint number, which has to visit the page modified
+ * right now.  The checkpoint following the last completed one might be
+ * already in progress and past the page, so the next one has to visit it.
+ */
+uint32
+btree_dirty_chkp_num(void)
+{
+	/* pairs with the barrier in checkpoint_try_skip_subtree() */
+	pg_memory_barrier();
+	return checkpoint_state->lastCheckpointNumber + 2;
+}
+
+/*
+ * Makes checkpoints up to chkpNum descend into the subtree of the given
+ * non-leaf page instead of copying its on-disk downlink.
+ */
+void
+btree_page_mark_subtree_dirty(OInMemoryBlkno blkno, uint32 chkpNum)
+{
+	dirty_chkp_num_advance(&O_GET_IN_MEMORY_PAGEDESC(blkno)->dirtyChkpNum,
+						   chkpNum);
+}
+
+/*
+ * The non-leaf page takes over (a part of) the children of srcBlkno on split
+ * or merge.  Modifiers might still hold the paths through srcBlkno.  So,
+ * checkpoints have to descend into the page as long as into srcBlkno, and not
+ * shorter than into the page modified right now.
+ */
+void
+btree_page_inherit_subtree_dirty(OInMemoryBlkno blkno, OInMemoryBlkno srcBlkno)
+{
+	uint32		chkpNum = btree_dirty_chkp_num();
+
+	chkpNum = Max(chkpNum,
+				  pg_atomic_read_u32(&O_GET_IN_MEMORY_PAGEDESC(srcBlkno)->dirtyChkpNum));
+	btree_page_mark_subtree_dirty(blkno, chkpNum);
+}
+
+/*
+ * Returns true if checkpoints may skip the unmodified subtrees of the tree.
+ * That is limited to WAL-logged trees, whose concurrent modifications will be
+ * replayed.
+ */
+bool
+btree_may_skip_subtrees(BTreeDescr *desc)
+{
+	return skip_unmodified_subtrees &&
+		desc->storageType == BTreeStoragePersistence &&
+		!IS_SYS_TREE_OIDS(desc->oids);
+}
+
+/*
+ * Makes checkpoints up to chkpNum descend into every in-memory subtree of the
+ * tree.  It's a fallback for the modifications, whose path from the root
+ * might be outdated.
+ */
+void
+btree_mark_subtrees_dirty(BTreeDescr *desc, uint32 chkpNum)
+{
+	dirty_chkp_num_advance(&BTREE_GET_META(desc)->dirtyChkpNum, chkpNum);
+}
+
 void
 init_new_btree_page(BTreeDescr *desc, OInMemoryBlkno blkno, uint16 flags,
 					uint16 level, bool noLock)
@@ -376,8 +486,19 @@ init_meta_page(OInMemoryBlkno blkno, uint32 leafPagesNum)
 	pg_atomic_init_u64(&metaPage->numFreeBlocks, 0);
 	pg_atomic_init_u64(&metaPage->datafileLength[0], 0);
 	pg_atomic_init_u64(&metaPage->datafileLength[1], 0);
+	for (i = 0; i < EXTENT_CACHE_MAX_LEN; i++)
+		for (j = 0; j < EXTENT_CACHE_SLOTS; j++)
+			pg_atomic_init_u64(&metaPage->freeExtentSlots[i][j], 0);
+	pg_atomic_init_u64(&metaPage->lastExtentEnd, 0);
 	pg_atomic_init_u64(&metaPage->ctid, 0);
 	pg_atomic_init_u64(&metaPage->bridge_ctid, 0);
+	pg_atomic_init_u64(&metaPage->compressDict, 0);
+	pg_atomic_init_u32(&metaPage->numPagesInMemory, 0);
+	pg_atomic_init_u32(&metaPage->dirtyChkpNum, 0);
+	pg_atomic_init_u32(&metaPage->compactRequest, 0);
+	for (i = 0; i < BTreeEventsCount; i++)
+		pg_atomic_init_u64(&metaPage->numEvents[i], 0);
+	metaPage->statsSince = GetCurrentTimestamp();
 	for (i = 0; i < NUM_SEQ_SCANS_ARRAY_SIZE; i++)
 		pg_atomic_init_u32(&metaPage->numSeqScans[i], 0);
 
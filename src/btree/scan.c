@@ -54,6 +54,7 @@
 #include "tuple/slot.h"
 #include "utils/sampling.h"
 #include "utils/stopevent.h"
+#include "utils/ucm.h"
 
 #include "miscadmin.h"
 #include "utils/wait_event.h"
@@ -104,6 +105,8 @@ struct BTreeSeqScan
 	int64		downlinksCount;
 	int64		downlinkIndex;
 	int64		allocatedDownlinks;
+	/* Index of the next on-disk downlink to be prefetched */
+	int64		prefetchIndex;
 
 	BTreeIterator *iter;
 	OTuple		iterEnd;
@@ -142,6 +145,8 @@ struct BTreeSeqScan
 
 static dlist_head listOfScans = DLIST_STATIC_INIT(listOfScans);
 
+int			seqscan_readahead = 32;
+
 static void scan_make_iterator(BTreeSeqScan *scan, OTuple startKey, OTuple keyRangeHigh);
 static void get_next_key(BTreeSeqScan *scan, BTreePageItemLocator *intLoc, OFixedKey *nextKey, Page page);
 
@@ -391,8 +396,8 @@ add_on_disk_downlink(BTreeSeqScan *scan, uint64 downlink, CommitSeqNo csn)
 static int
 cmp_downlinks(const void *p1, const void *p2)
 {
-	uint64		d1 = ((BTreeSeqScanDiskDownlink *) p1)->downlink;
-	uint64		d2 = ((BTreeSeqScanDiskDownlink *) p2)->downlink;
+	uint64		d1 = DOWNLINK_GET_DISK_OFF(((BTreeSeqScanDiskDownlink *) p1)->downlink);
+	uint64		d2 = DOWNLINK_GET_DISK_OFF(((BTreeSeqScanDiskDownlink *) p2)->downlink);
 
 	if (d1 < d2)
 		return -1;
@@ -956,6 +961,51 @@ iterate_internal_page(BTreeSeqScan *scan)
 	return false;
 }
 
+/*
+ * Issues prefetch of the on-disk leaves following the `index` one within the
+ * read-ahead window.  The window is refilled once it's half consumed, so
+ * the pages are prefetched in batches, where extents adjacent on disk are
+ * coalesced into a single request.
+ */
+static void
+prefetch_disk_leaf_pages(BTreeSeqScan *scan,
+						 BTreeSeqScanDiskDownlink *downlinks,
+						 int64 index, int64 count)
+{
+	int64		i,
+				end;
+	off_t		rangeOffset = 0;
+	int			rangeAmount = 0;
+
+	if (seqscan_readahead <= 0 ||
+		scan->prefetchIndex - index > seqscan_readahead / 2)
+		return;
+
+	end = Min(index + 1 + seqscan_readahead, count);
+	for (i = Max(scan->prefetchIndex, index + 1); i < end; i++)
+	{
+		off_t		offset;
+		int			amount;
+
+		btree_downlink_get_disk_range(scan->desc, downlinks[i].downlink,
+									  &offset, &amount);
+		if (rangeAmount > 0 && offset == rangeOffset + rangeAmount)
+		{
+			rangeAmount += amount;
+			continue;
+		}
+
+		if (rangeAmount > 0)
+			btree_smgr_prefetch(scan->desc, 0, rangeOffset, rangeAmount);
+		rangeOffset = offset;
+		rangeAmount = amount;
+	}
+	if (rangeAmount > 0)
+		btree_smgr_prefetch(scan->desc, 0, rangeOffset, rangeAmount);
+
+	scan->prefetchIndex = Max(scan->prefetchIndex, end);
+}
+
 static bool
 load_next_disk_leaf_page(BTreeSeqScan *scan)
 {
@@ -971,6 +1021,8 @@ load_next_disk_leaf_page(BTreeSeqScan *scan)
 			return false;
 
 		downlink = scan->diskDownlinks[scan->downlinkIndex];
+		prefetch_disk_leaf_pages(scan, scan->diskDownlinks,
+								 scan->downlinkIndex, scan->downlinksCount);
 	}
 	else
 	{
@@ -989,6 +1041,9 @@ load_next_disk_leaf_page(BTreeSeqScan *scan)
 			return false;
 		}
 		downlink = ((BTreeSeqScanDiskDownlink *) dsm_segment_address(scan->dsmSeg))[index];
+		prefetch_disk_leaf_pages(scan,
+								 (BTreeSeqScanDiskDownlink *) dsm_segment_address(scan->dsmSeg),
+								 index, poscan->downlinksCount);
 	}
 
 	success = read_page_from_disk(scan->desc,
@@ -1162,6 +1217,7 @@ make_btree_seq_scan_internal(BTreeDescr *desc, OSnapshot *oSnapshot,
 	scan->allocatedDownlinks = 16;
 	scan->downlinksCount = 0;
 	scan->downlinkIndex = 0;
+	scan->prefetchIndex = 0;
 	scan->diskDownlinks = (BTreeSeqScanDiskDownlink *) palloc(sizeof(scan->diskDownlinks[0]) * scan->allocatedDownlinks);
 	scan->mctx = CurrentMemoryContext;
 	scan->iter = NULL;
@@ -1534,6 +1590,7 @@ btree_seq_scan_getnext(BTreeSeqScan *scan, MemoryContext mctx,
 	OTuple		tuple;
 
 	Assert(scan);
+	set_ucm_scan_mode();
 	if (!scan->initialized)
 		init_btree_seq_scan(scan);
 
@@ -1543,8 +1600,12 @@ btree_seq_scan_getnext(BTreeSeqScan *scan, MemoryContext mctx,
 		tuple = btree_seq_scan_getnext_internal(scan, mctx, tupleCsn, hint);
 
 		if (!O_TUPLE_IS_NULL(tuple))
+		{
+			unset_ucm_scan_mode();
 			return tuple;
+		}
 	}
+	unset_ucm_scan_mode();
 	Assert(scan->status == BTreeSeqScanFinished);
 
 	O_TUPLE_SET_NULL(tuple);
@@ -1645,6 +1706,7 @@ btree_seq_scan_getnext_raw(BTreeSeqScan *scan, MemoryContext mctx,
 {
 	OTuple		tuple;
 
+	set_ucm_scan_mode();
 	if (!scan->initialized)
 		init_btree_seq_scan(scan);
 
@@ -1655,10 +1717,12 @@ btree_seq_scan_getnext_raw(BTreeSeqScan *scan, MemoryContext mctx,
 		if (scan->status == BTreeSeqScanInMemory ||
 			scan->status == BTreeSeqScanDisk)
 		{
+			unset_ucm_scan_mode();
 			*end = false;
 			return tuple;
 		}
 	}
+	unset_ucm_scan_mode();
 	Assert(scan->status == BTreeSeqScanFinished);
 
 	O_TUPLE_SET_NULL(tuple);
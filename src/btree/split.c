@@ -373,6 +373,8 @@ perform_page_split(BTreeDescr *desc, OInMemoryBlkno blkno,
 	init_new_btree_page(desc, new_blkno,
 						left_header->flags & ~(O_BTREE_FLAG_LEFTMOST),
 						PAGE_GET_LEVEL(left_page), false);
+	btree_inc_pages_in_memory(desc);
+	btree_count_event(desc, BTreeEventSplit);
 
 #ifdef ORIOLEDB_CUT_FIRST_KEY
 	if (!leaf)
@@ -428,4 +430,6 @@ perform_page_split(BTreeDescr *desc, OInMemoryBlkno blkno,
 
 	MARK_DIRTY(desc, blkno);
 	MARK_DIRTY(desc, new_blkno);
+	if (!leaf)
+		btree_page_inherit_subtree_dirty(new_blkno, blkno);
 }
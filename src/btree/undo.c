@@ -539,6 +539,7 @@ modify_undo_callback(UndoLogType undoType, UndoLocation location,
 	}
 
 	MARK_DIRTY(desc, blkno);
+	btree_find_context_mark_dirty(&context);
 	if (blkno != desc->rootInfo.rootPageBlkno && is_page_too_sparse(desc, p))
 	{
 		/* We can try to merge this page */
@@ -662,6 +663,7 @@ lock_undo_callback(UndoLogType undoType, UndoLocation location,
 				page_tuphdr->chainHasLocks = prev_tuphdr.chainHasLocks;
 				tuphdr = *page_tuphdr;
 				MARK_DIRTY(desc, blkno);
+				btree_find_context_mark_dirty(&context);
 			}
 			else
 			{
@@ -1708,6 +1708,50 @@ ATColumnChangeRequiresRewrite(OTableField *old_field, OTableField *field,
 	return rewrite;
 }
 
+/*
+ * Converts "memory_quota" reloption value in megabytes to the number of pages.
+ */
+static inline int32
+memory_quota_pages(ORelOptions *options)
+{
+	if (!options)
+		return 0;
+	return options->memory_quota * (1024 * 1024 / ORIOLEDB_BLCKSZ);
+}
+
+/*
+ * Propagates the table memory options to the trees besides primary, which is
+ * handled by o_tables_after_update().  That also invalidates the TOAST tree.
+ */
+static void
+update_memory_options(OTable *o_table, OXid oxid, CommitSeqNo csn)
+{
+	OIndexNumber ix,
+				ctid_idx_off = o_table->has_primary ? 0 : 1;
+
+	for (ix = PrimaryIndexNumber + 1;
+		 ix < o_table->nindices + ctid_idx_off;
+		 ix++)
+	{
+		ORelOids	ixOids = o_table->indices[ix - ctid_idx_off].oids;
+
+		o_indices_update(o_table, ix, oxid, csn);
+		o_add_invalidate_undo_item(ixOids, O_INVALIDATE_OIDS_ON_ABORT);
+		o_invalidate_oids(ixOids);
+	}
+
+	if (ORelOidsIsValid(o_table->toast_oids))
+		o_indices_update(o_table, TOASTIndexNumber, oxid, csn);
+
+	if (ORelOidsIsValid(o_table->bridge_oids))
+	{
+		o_indices_update(o_table, BridgeIndexNumber, oxid, csn);
+		o_add_invalidate_undo_item(o_table->bridge_oids,
+								   O_INVALIDATE_OIDS_ON_ABORT);
+		o_invalidate_oids(o_table->bridge_oids);
+	}
+}
+
 static void
 set_toast_oids_and_options(Relation rel, Relation toast_rel, bool only_fillfactor, bool index_bridging)
 {
@@ -1721,6 +1765,9 @@ set_toast_oids_and_options(Relation rel, Relation toast_rel, bool only_fillfacto
 				primary_compress = default_primary_compress,
 				toast_compress = default_toast_compress;
 	uint8		fillfactor = BTREE_DEFAULT_FILLFACTOR;
+	int32		memory_quota = memory_quota_pages(options);
+	bool		memory_pin = options ? options->memory_pin : false;
+	bool		memory_changed;
 	OXid		oxid = InvalidOXid;
 	OSnapshot	oSnapshot;
 	bool		is_temp;
@@ -1812,12 +1859,18 @@ set_toast_oids_and_options(Relation rel, Relation toast_rel, bool only_fillfacto
 		}
 	}
 	o_table->fillfactor = fillfactor;
+	memory_changed = o_table->memory_quota != memory_quota ||
+		o_table->memory_pin != memory_pin;
+	o_table->memory_quota = memory_quota;
+	o_table->memory_pin = memory_pin;
 
 	fill_current_oxid_osnapshot(&oxid, &oSnapshot);
 
 	o_tables_rel_meta_lock(rel);
 	o_tables_update(o_table, oxid, oSnapshot.csn);
 	o_tables_after_update(o_table, oxid, oSnapshot.csn);
+	if (memory_changed)
+		update_memory_options(o_table, oxid, oSnapshot.csn);
 
 	treeOids = o_table_make_index_oids(o_table, &numTreeOids);
 	is_temp = o_table->persistence == RELPERSISTENCE_TEMP;
@@ -3600,7 +3653,9 @@ orioledb_object_access_hook(ObjectAccessType access, Oid classId, Oid objectId,
 							else
 								elog(ERROR, "cannot disable 'index_bridging' for a table with bridged indices");
 						}
-						if (GET_PRIMARY(descr)->fillfactor != new_fillfactor)
+						if (GET_PRIMARY(descr)->fillfactor != new_fillfactor ||
+							GET_PRIMARY(descr)->desc.memoryQuota != memory_quota_pages(options) ||
+							GET_PRIMARY(descr)->desc.memoryPin != (options ? options->memory_pin : false))
 							set_toast_oids_and_options(tbl, rel, true, false);
 					}
 				}
@@ -3984,6 +4039,8 @@ o_parse_compress(const char *value)
 			result = O_COMPRESS_DEFAULT;
 		else if (strcmp(value, "off") == 0)
 			result = InvalidOCompress;
+		else if (strcmp(value, "lz4") == 0)
+			result = O_COMPRESS_LZ4;
 		else
 			ereport(ERROR, (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
 							errmsg("invalid compression value: \"%s\"",
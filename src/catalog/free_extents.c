@@ -14,6 +14,16 @@
  * is reset after reboot of the database engine and the state must
  * be restored after it.
  *
+ * Compressed page images usually take a few ORIOLEDB_COMP_BLCKSZ blocks, and
+ * every write of such a page needs a new extent.  In order to avoid B-tree
+ * modifications on each of them, extents up to EXTENT_CACHE_MAX_LEN blocks
+ * long are kept in a front cache in the tree meta page: a fixed number of
+ * slots per extent length, which are filled and emptied by compare-and-swap.
+ * When several slots are available get_extent() takes the extent nearest to
+ * the previous one given to the tree.  Cached extents are still counted in
+ * numFreeBlocks, reported by foreach_free_extent() (so checkpoint saves them
+ * in the *.map file), and returned to the B-trees on tree eviction.
+ *
  * Copyright (c) 2021-2025, Oriole DB Inc.
  * Copyright (c) 2025, Supabase Inc.
  *
@@ -46,6 +56,102 @@
 								 (ex1).datoid == (ex2).datoid && \
 								 (ex1).relnode == (ex2).relnode)
 
+#define EXTENT_DISTANCE(off, hint) ((off) > (hint) ? (off) - (hint) : (hint) - (off))
+
+static void free_extent_to_trees(BTreeDescr *desc, FileExtent extent);
+
+/*
+ * Takes an extent of given length from the front cache.  Prefers the extent
+ * nearest to the end of the previous extent given to the tree.
+ */
+static bool
+extent_cache_get(BTreeMetaPage *metaPage, uint16 len, FileExtent *result)
+{
+	pg_atomic_uint64 *slots;
+	uint64		hint,
+				value,
+				best;
+	int			i,
+				bestIndex;
+
+	if (len == 0 || len > EXTENT_CACHE_MAX_LEN)
+		return false;
+
+	slots = metaPage->freeExtentSlots[len - 1];
+	hint = pg_atomic_read_u64(&metaPage->lastExtentEnd);
+
+	while (true)
+	{
+		bestIndex = -1;
+		best = 0;
+		for (i = 0; i < EXTENT_CACHE_SLOTS; i++)
+		{
+			value = pg_atomic_read_u64(&slots[i]);
+			if (value == 0)
+				continue;
+			if (bestIndex < 0 ||
+				EXTENT_DISTANCE(value - 1, hint) < EXTENT_DISTANCE(best - 1, hint))
+			{
+				bestIndex = i;
+				best = value;
+			}
+		}
+
+		if (bestIndex < 0)
+			return false;
+
+		/* somebody could take the extent concurrently, then retry */
+		if (pg_atomic_compare_exchange_u64(&slots[bestIndex], &best, 0))
+		{
+			result->off = best - 1;
+			result->len = len;
+			return true;
+		}
+	}
+}
+
+/*
+ * Puts the extent into the front cache.  Returns false if there is no empty
+ * slot for it.
+ */
+static bool
+extent_cache_put(BTreeMetaPage *metaPage, FileExtent extent)
+{
+	pg_atomic_uint64 *slots;
+	uint64		expected;
+	int			i;
+
+	if (extent.len > EXTENT_CACHE_MAX_LEN)
+		return false;
+
+	slots = metaPage->freeExtentSlots[extent.len - 1];
+	for (i = 0; i < EXTENT_CACHE_SLOTS; i++)
+	{
+		expected = 0;
+		if (pg_atomic_read_u64(&slots[i]) == 0 &&
+			pg_atomic_compare_exchange_u64(&slots[i], &expected,
+										   (uint64) extent.off + 1))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Returns a new extent at the end of the data file.
+ */
+static FileExtent
+extend_file(BTreeDescr *desc, BTreeMetaPage *metaPage, uint16 len)
+{
+	FileExtent	result;
+
+	result.len = len;
+	if (use_device)
+		result.off = orioledb_device_alloc(desc, len * ORIOLEDB_COMP_BLCKSZ) / ORIOLEDB_COMP_BLCKSZ;
+	else
+		result.off = pg_atomic_fetch_add_u64(&metaPage->datafileLength[0], len);
+	return result;
+}
+
 /*
  * Returns free file extent with length = len.
  *
@@ -94,11 +200,15 @@ get_extent(BTreeDescr *desc, uint16 len)
 	if (pg_atomic_read_u64(&metaPage->numFreeBlocks) < len)
 	{
 		/* free extent can not be founded, increase file length */
-		result.len = len;
-		if (use_device)
-			result.off = orioledb_device_alloc(desc, len * ORIOLEDB_COMP_BLCKSZ) / ORIOLEDB_COMP_BLCKSZ;
-		else
-			result.off = pg_atomic_fetch_add_u64(&metaPage->datafileLength[0], len);
+		result = extend_file(desc, metaPage, len);
+		pg_atomic_write_u64(&metaPage->lastExtentEnd, result.off + len);
+		return result;
+	}
+
+	if (extent_cache_get(metaPage, len, &result))
+	{
+		pg_atomic_fetch_sub_u64(&metaPage->numFreeBlocks, (uint64) len);
+		pg_atomic_write_u64(&metaPage->lastExtentEnd, result.off + len);
 		return result;
 	}
 
@@ -178,11 +288,8 @@ get_extent(BTreeDescr *desc, uint16 len)
 	if (!found)
 	{
 		/* free extent not founded, increase file length */
-		result.len = len;
-		if (use_device)
-			result.off = orioledb_device_alloc(desc, len * ORIOLEDB_COMP_BLCKSZ) / ORIOLEDB_COMP_BLCKSZ;
-		else
-			result.off = pg_atomic_fetch_add_u64(&metaPage->datafileLength[0], len);
+		result = extend_file(desc, metaPage, len);
+		pg_atomic_write_u64(&metaPage->lastExtentEnd, result.off + len);
 		enable_stopevents = old_enable_stopevents;
 		return result;
 	}
@@ -206,6 +313,7 @@ get_extent(BTreeDescr *desc, uint16 len)
 	deleted_tup = *cur_tup;
 
 	MARK_DIRTY(len_off_tree, context.items[context.index].blkno);
+	btree_find_context_mark_dirty(&context);
 
 	if (is_page_too_sparse(len_off_tree, p))
 		(void) btree_try_merge_and_unlock(len_off_tree,
@@ -260,17 +368,33 @@ get_extent(BTreeDescr *desc, uint16 len)
 
 	result.off = deleted_tup.extent.offset;
 	result.len = len;
+	pg_atomic_write_u64(&metaPage->lastExtentEnd, result.off + len);
 
 	enable_stopevents = old_enable_stopevents;
 	return result;
 }
 
 /*
- * Adds the extent to a free extents list.
+ * Adds the extent to a free extents list.  Short extents go to the front
+ * cache if it has room for them.
+ */
+void
+free_extent(BTreeDescr *desc, FileExtent extent)
+{
+	Assert(FileExtentIsValid(extent));
+
+	if (extent_cache_put(BTREE_GET_META(desc), extent))
+		return;
+
+	free_extent_to_trees(desc, extent);
+}
+
+/*
+ * Adds the extent to the free extents B-trees.
  *
  * See description of the get_extent() function.
  *
- * free_extent() algorithm:
+ * free_extent_to_trees() algorithm:
  *
  * 1. Find neighbors tuples of the extent in the (off, len) B-tree.
  * 2. Remove neighbors from (len, off) and (off, len) B-trees. If remove from
@@ -279,8 +403,8 @@ get_extent(BTreeDescr *desc, uint16 len)
  *
  * TODO: add hints support
  */
-void
-free_extent(BTreeDescr *desc, FileExtent extent)
+static void
+free_extent_to_trees(BTreeDescr *desc, FileExtent extent)
 {
 	BTreeIterator *it = NULL;
 	FreeTreeTuple tup,
@@ -473,6 +597,46 @@ free_extent(BTreeDescr *desc, FileExtent extent)
 	enable_stopevents = old_enable_stopevents;
 }
 
+/*
+ * Moves all the extents from the front cache to the array, which should have
+ * room for EXTENT_CACHE_MAX_LEN * EXTENT_CACHE_SLOTS items.  Returns number of
+ * extents moved.  Used on tree eviction, the meta page goes away after this,
+ * so the caller returns extents to the B-trees using
+ * free_extents_cache_return().
+ */
+int
+free_extents_cache_drain(BTreeDescr *desc, FileExtent *extents)
+{
+	BTreeMetaPage *metaPage = BTREE_GET_META(desc);
+	uint64		value;
+	int			i,
+				j,
+				num = 0;
+
+	for (i = 0; i < EXTENT_CACHE_MAX_LEN; i++)
+	{
+		for (j = 0; j < EXTENT_CACHE_SLOTS; j++)
+		{
+			value = pg_atomic_exchange_u64(&metaPage->freeExtentSlots[i][j], 0);
+			if (value == 0)
+				continue;
+			extents[num].off = value - 1;
+			extents[num].len = i + 1;
+			num++;
+		}
+	}
+	return num;
+}
+
+void
+free_extents_cache_return(BTreeDescr *desc, FileExtent *extents, int num)
+{
+	int			i;
+
+	for (i = 0; i < num; i++)
+		free_extent_to_trees(desc, extents[i]);
+}
+
 /*
  * Calls the callback for each free file extent for a BTree on given csn.
  *
@@ -488,9 +652,13 @@ foreach_free_extent(BTreeDescr *desc, ForEachExtentCallback callback, void *arg)
 	FileExtent	cur_extent;
 	bool		old_enable_stopevents = enable_stopevents;
 	BTreeDescr *off_len_tree = get_sys_tree(SYS_TREES_EXTENTS_OFF_LEN);
+	BTreeMetaPage *metaPage = BTREE_GET_META(desc);
 	OTuple		tmpTup;
 	OTuple		toTup;
 	OTuple		fromTup;
+	uint64		value;
+	int			i,
+				j;
 
 	enable_stopevents = false;
 
@@ -542,6 +710,20 @@ foreach_free_extent(BTreeDescr *desc, ForEachExtentCallback callback, void *arg)
 
 	btree_iterator_free(it);
 	enable_stopevents = old_enable_stopevents;
+
+	/* extents from the front cache */
+	for (i = 0; i < EXTENT_CACHE_MAX_LEN; i++)
+	{
+		for (j = 0; j < EXTENT_CACHE_SLOTS; j++)
+		{
+			value = pg_atomic_read_u64(&metaPage->freeExtentSlots[i][j]);
+			if (value == 0)
+				continue;
+			cur_extent.off = value - 1;
+			cur_extent.len = i + 1;
+			callback(desc, cur_extent, arg);
+		}
+	}
 }
 
 /*
@@ -656,6 +656,9 @@ serialize_o_index(OIndex *o_index, int *size)
 	o_serialize_node((Node *) o_index->duplicates, &str);
 
 	appendBinaryStringInfo(&str, (Pointer) &o_index->tablespace, sizeof(Oid));
+	appendBinaryStringInfo(&str, (Pointer) &o_index->memoryQuota,
+						   sizeof(int32));
+	appendBinaryStringInfo(&str, (Pointer) &o_index->memoryPin, sizeof(bool));
 
 	*size = str.len;
 	return str.data;
@@ -711,6 +714,19 @@ deserialize_o_index(OIndexChunkKey *key, Pointer data, Size length)
 	else
 		oIndex->tablespace = DEFAULTTABLESPACE_OID;
 
+	/* Memory options are absent in the indices created before them */
+	if ((ptr - data) < length)
+	{
+		len = sizeof(int32);
+		Assert((ptr - data) + len <= length);
+		memcpy(&oIndex->memoryQuota, ptr, len);
+		ptr += len;
+		len = sizeof(bool);
+		Assert((ptr - data) + len <= length);
+		memcpy(&oIndex->memoryPin, ptr, len);
+		ptr += len;
+	}
+
 	Assert((ptr - data) == length);
 
 	return oIndex;
@@ -751,6 +767,8 @@ make_o_index(OTable *table, OIndexNumber ixNum)
 		index = make_secondary_o_index(table, tableIndex);
 	}
 
+	index->memoryQuota = table->memory_quota;
+	index->memoryPin = table->memory_pin;
 	index->data_version = ORIOLEDB_DATA_VERSION;
 	return index;
 }
@@ -1077,6 +1095,8 @@ o_index_fill_descr(OIndexDescr *descr, OIndex *oIndex, OTable *oTable)
 		   oIndex->primaryFieldsAttnums,
 		   descr->nPrimaryFields * sizeof(descr->primaryFieldsAttnums[0]));
 	descr->compress = oIndex->compress;
+	descr->desc.memoryQuota = oIndex->memoryQuota;
+	descr->desc.memoryPin = oIndex->memoryPin;
 	if (oIndex->fillfactor > 0 && oIndex->fillfactor < 100)
 		descr->fillfactor = oIndex->fillfactor;
 	else if (oIndex->indexType == oIndexToast)
@@ -1360,6 +1360,17 @@ o_get_type_name(Oid typid, int32 typmod)
 								FORMAT_TYPE_ALLOW_INVALID);
 }
 
+/*
+ * Formats the compression value the way reloptions accept it.
+ */
+static char *
+compress_to_string(OCompress compress)
+{
+	if (OCompressIsLZ4(compress))
+		return "lz4";
+	return psprintf("%d", compress);
+}
+
 static text *
 describe_table(ORelOids oids)
 {
@@ -1400,10 +1411,10 @@ describe_table(ORelOids oids)
 	}
 
 	initStringInfo(&title);
-	appendStringInfo(&title, "Compress = %d, Primary compress = %d, TOAST compress = %d\n",
-					 table->default_compress,
-					 table->primary_compress,
-					 table->toast_compress);
+	appendStringInfo(&title, "Compress = %s, Primary compress = %s, TOAST compress = %s\n",
+					 compress_to_string(table->default_compress),
+					 compress_to_string(table->primary_compress),
+					 compress_to_string(table->toast_compress));
 	appendStringInfo(&title, " %%%ds | %%%ds | %%%ds | Nullable | Droped ",
 					 max_column_str,
 					 max_type_str,
@@ -1719,6 +1730,9 @@ serialize_o_table(OTable *o_table, int *size)
 	}
 
 	appendBinaryStringInfo(&str, (Pointer) &o_table->tablespace, sizeof(Oid));
+	appendBinaryStringInfo(&str, (Pointer) &o_table->memory_quota,
+						   sizeof(int32));
+	appendBinaryStringInfo(&str, (Pointer) &o_table->memory_pin, sizeof(bool));
 
 	*size = str.len;
 	return str.data;
@@ -1813,6 +1827,24 @@ deserialize_o_table(Pointer data, Size length)
 	else
 		o_table->tablespace = DEFAULTTABLESPACE_OID;
 
+	/* Memory options are absent in the tables created before them */
+	if ((ptr - data) < length)
+	{
+		len = sizeof(int32);
+		Assert((ptr - data) + len <= length);
+		memcpy(&o_table->memory_quota, ptr, len);
+		ptr += len;
+		len = sizeof(bool);
+		Assert((ptr - data) + len <= length);
+		memcpy(&o_table->memory_pin, ptr, len);
+		ptr += len;
+	}
+	else
+	{
+		o_table->memory_quota = 0;
+		o_table->memory_pin = false;
+	}
+
 	Assert(ptr - data == length);
 	return o_table;
 }
@@ -771,6 +771,8 @@ sys_tree_init(int i, bool init_shmem)
 
 	descr->compress = InvalidOCompress;
 	descr->fillfactor = BTREE_DEFAULT_FILLFACTOR;
+	descr->memoryQuota = 0;
+	descr->memoryPin = false;
 	descr->ppool = pool;
 	descr->undoType = meta->undoLogType;
 	descr->storageType = meta->storageType;
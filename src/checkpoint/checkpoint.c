@@ -44,6 +44,8 @@
 #include "tableam/toast.h"
 #include "transam/oxid.h"
 #include "transam/undo.h"
+#include "utils/compress.h"
+#include "utils/compress_queue.h"
 #include "utils/page_pool.h"
 #include "utils/seq_buf.h"
 #include "utils/stopevent.h"
@@ -55,12 +57,19 @@
 #include "common/hashfn.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "postmaster/bgworker.h"
 #include "postmaster/bgwriter.h"
+#include "postmaster/interrupt.h"
 #include "storage/bufmgr.h"
+#include "storage/latch.h"
 #include "storage/proc.h"
+#include "storage/sinvaladt.h"
 #include "utils/memdebug.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/syscache.h"
+#include "utils/timeout.h"
+#include "utils/timestamp.h"
 
 /*
  * Single action in B-tree checkpoint loop.
@@ -129,8 +138,36 @@ typedef struct
 {
 	List	   *postProcessList;
 	int			flags;
+	/* trees are passed to the checkpoint workers */
+	bool		parallel;
 } CheckpointTablesArg;
 
+typedef enum
+{
+	CheckpointJobIdle,
+	CheckpointJobAssigned,
+	CheckpointJobStarted,
+	CheckpointJobDone,
+	CheckpointJobFailed
+} CheckpointJobStatus;
+
+/*
+ * The tree passed by checkpointer to the checkpoint worker and the result of
+ * its checkpointing.
+ */
+typedef struct
+{
+	/* Process number of the worker, -1 if not running */
+	int			procno;
+	pg_atomic_uint32 status;
+	OIndexType	type;
+	ORelOids	treeOids;
+	int			flags;
+	/* post-processing after the checkpoint is needed for the tree */
+	bool		hasItem;
+	IndexIdItem item;
+} CheckpointJob;
+
 typedef struct
 {
 	FileExtent *extents;
@@ -157,12 +194,49 @@ typedef struct
 CheckpointState *checkpoint_state = NULL;
 MemoryContext chkp_main_context = NULL;
 MemoryContext chkp_tree_context = NULL;
+bool		IsCheckpointWorker = false;
+
+/*
+ * Each checkpoint worker walks its tree using own CheckpointState.  Only the
+ * fields describing the tree under checkpoint are used there, the rest is
+ * taken from checkpoint_state.
+ */
+#define CHECKPOINT_WORKER_STATE_SIZE \
+	CACHELINEALIGN(offsetof(CheckpointState, xidRecQueue))
+
+static CheckpointJob *checkpoint_jobs = NULL;
+static Pointer checkpoint_worker_states = NULL;
+
+static inline CheckpointState *
+checkpoint_worker_state(int num)
+{
+	return (CheckpointState *) (checkpoint_worker_states +
+								CHECKPOINT_WORKER_STATE_SIZE * num);
+}
 
 static char *xidFilename = NULL;
 static uint32 xidFileCheckpointnum = 0;
 static File xidFile = -1;
 static S3TaskLocation maxLocation = 0;
 
+/* Part of level 1 page, which leaves were put to the compression queue */
+static OInMemoryBlkno offloadBlkno = OInvalidInMemoryBlkno;
+static uint32 offloadChangeCount = InvalidOPageChangeCount;
+static int	offloadOffset = 0;
+
+/*
+ * Bounds of the writeback batch size (in blocks) and the longest single sleep
+ * of the adaptive checkpoint pacing.
+ */
+#define CHECKPOINT_PACING_MIN_BATCH		16
+#define CHECKPOINT_PACING_MAX_BATCH		1024
+#define CHECKPOINT_PACING_MAX_SLEEP_MS	100
+
+/* Per-process state of the adaptive pacing, see checkpoint_pacing_delay() */
+static TimestampTz pacingStartTime = 0;
+static TimestampTz pacingLastTime = 0;
+static double pacingCredit = 0.0;
+
 static void init_writeback(CheckpointWriteBack *writeback, int flags, bool isCompressed);
 static void writeback_put_extent(CheckpointWriteBack *writeback, FileExtent *extent);
 static void perform_writeback(BTreeDescr *desc, CheckpointWriteBack *writeback);
@@ -170,6 +244,7 @@ static void free_writeback(CheckpointWriteBack *writeback);
 
 static uint64 append_file_contents(File target, char *source_filename, uint64 offset);
 static uint64 finalize_chkp_map(File chkp_file, uint64 len,
+								Oid datoid, Oid relnode,
 								char *input_filename, uint64 input_offset,
 								uint32 input_num);
 static int	uint32_offsets_cmp(const void *a, const void *b);
@@ -181,8 +256,10 @@ static void sort_checkpoint_map_file(BTreeDescr *descr, int cur_chkp_index);
 static void sort_checkpoint_tmp_file(BTreeDescr *descr, int cur_chkp_index);
 static inline void checkpoint_ix_init_state(CheckpointState *state, BTreeDescr *descr);
 static void checkpoint_init_new_seq_bufs(BTreeDescr *descr, int chkpNum);
-static void checkpoint_temporary_tree(int flags, BTreeDescr *descr);
-static bool checkpoint_ix(int flags, BTreeDescr *descr);
+static void checkpoint_temporary_tree(CheckpointState *state, int flags,
+									  BTreeDescr *descr);
+static bool checkpoint_ix(CheckpointState *state, int flags,
+						  BTreeDescr *descr);
 static uint64 checkpoint_btree(BTreeDescr **descrPtr, CheckpointState *state,
 							   CheckpointWriteBack *writeback);
 static Jsonb *prepare_checkpoint_step_params(BTreeDescr *descr,
@@ -196,11 +273,16 @@ static void checkpoint_internal_pass(BTreeDescr *descr, CheckpointState *state,
 									 CheckpointWriteBack *writeback,
 									 int level, WalkMessage *message);
 static void prepare_leaf_page(BTreeDescr *descr, CheckpointState *state);
+static int	checkpoint_collect_offload_downlinks(OInMemoryBlkno blkno, Page page,
+												 BTreePageItemLocator *loc,
+												 uint64 **downlinks);
 static void checkpoint_lock_page(BTreeDescr *descr, CheckpointState *state,
 								 OInMemoryBlkno *blkno, uint32 page_chage_count,
 								 int level);
 static void checkpoint_tables_callback(OIndexType type, ORelOids treeOids,
 									   ORelOids tableOids, void *arg);
+static void checkpoint_reset_jobs(void);
+static void checkpoint_finish_jobs(CheckpointTablesArg *tbl_arg);
 static inline void init_seq_buf_pages(BTreeDescr *desc, SeqBufDescShared *shared);
 static inline void free_seq_buf_pages(BTreeDescr *desc, SeqBufDescShared *shared);
 static FileExtentsArray *file_extents_array_init(void);
@@ -228,7 +310,7 @@ checkpoint_reset_stack(CheckpointState *state)
 		Assert(state->stack[i].nextkeyType == NextKeyNone);
 	}
 
-	pg_atomic_write_u32(&checkpoint_state->autonomousLevel, ORIOLEDB_MAX_DEPTH);
+	pg_atomic_write_u32(&state->autonomousLevel, ORIOLEDB_MAX_DEPTH);
 
 	chkp_inc_changecount_after(state);
 }
@@ -240,14 +322,28 @@ checkpoint_shmem_size(void)
 
 	size = offsetof(CheckpointState, xidRecQueue);
 	size = add_size(size, mul_size(sizeof(XidFileRec), XID_RECS_QUEUE_SIZE));
+	size = CACHELINEALIGN(size);
+	size = add_size(size, CACHELINEALIGN(mul_size(sizeof(CheckpointJob),
+												  checkpoint_num_workers)));
+	size = add_size(size, mul_size(CHECKPOINT_WORKER_STATE_SIZE,
+								   checkpoint_num_workers));
 
-	return CACHELINEALIGN(size);
+	return size;
 }
 
 void
 checkpoint_shmem_init(Pointer ptr, bool found)
 {
+	Size		size;
+
 	checkpoint_state = (CheckpointState *) ptr;
+	size = offsetof(CheckpointState, xidRecQueue);
+	size = add_size(size, mul_size(sizeof(XidFileRec), XID_RECS_QUEUE_SIZE));
+	ptr += CACHELINEALIGN(size);
+	checkpoint_jobs = (CheckpointJob *) ptr;
+	ptr += CACHELINEALIGN(mul_size(sizeof(CheckpointJob),
+								   checkpoint_num_workers));
+	checkpoint_worker_states = ptr;
 
 	if (!found)
 	{
@@ -258,8 +354,28 @@ checkpoint_shmem_init(Pointer ptr, bool found)
 		checkpoint_state->curKeyType = CurKeyFinished;
 		checkpoint_state->pid = InvalidPid;
 		pg_atomic_init_u64(&checkpoint_state->mmapDataLength, 0);
+		pg_atomic_init_u64(&checkpoint_state->pagesWritten, 0);
+		pg_atomic_init_u64(&checkpoint_state->pacingTargetRate, 0);
+		pg_atomic_init_u64(&checkpoint_state->pacingLatency, 0);
+		pg_atomic_init_u32(&checkpoint_state->pacingBatch,
+						   CHECKPOINT_PACING_MAX_BATCH);
+		pg_atomic_init_u64(&checkpoint_state->skippedSubtrees, 0);
 		pg_atomic_init_u32(&checkpoint_state->autonomousLevel, ORIOLEDB_MAX_DEPTH);
 
+		for (i = 0; i < checkpoint_num_workers; i++)
+		{
+			CheckpointState *state = checkpoint_worker_state(i);
+
+			memset(state, 0, offsetof(CheckpointState, xidRecQueue));
+			state->curKeyType = CurKeyFinished;
+			state->pid = InvalidPid;
+			pg_atomic_init_u32(&state->autonomousLevel, ORIOLEDB_MAX_DEPTH);
+			checkpoint_reset_stack(state);
+
+			checkpoint_jobs[i].procno = -1;
+			pg_atomic_init_u32(&checkpoint_jobs[i].status, CheckpointJobIdle);
+		}
+
 		for (i = 0; i < (int) UndoLogsCount; i++)
 		{
 			UndoMeta   *undo_meta = get_undo_meta_by_type((UndoLogType) i);
@@ -415,6 +531,207 @@ writeback_put_extent(CheckpointWriteBack *writeback, FileExtent *extent)
 	writeback->extentsNumber++;
 }
 
+/*
+ * Throttles the writes of checkpoint worker.  Follows the same schedule as
+ * CheckpointWriteDelay() does for checkpointer: the worker sleeps while the
+ * checkpoint progress is ahead of both the elapsed time and the WAL written
+ * since the checkpoint start.
+ */
+static void
+checkpoint_worker_write_delay(int flags, double progress)
+{
+	double		elapsed;
+
+	/* Don't delay the postmaster shutdown */
+	if ((flags & CHECKPOINT_IMMEDIATE) || ShutdownRequestPending)
+		return;
+
+	progress *= CheckPointCompletionTarget;
+
+	if (!RecoveryInProgress())
+	{
+		elapsed = (double) (GetXLogInsertRecPtr() - checkpoint_state->replayStartPtr) /
+			wal_segment_size / CheckPointSegments;
+		if (progress < elapsed)
+			return;
+	}
+
+	elapsed = (double) (GetCurrentTimestamp() - checkpoint_state->startTime) /
+		USECS_PER_SEC / CheckPointTimeout;
+	if (progress < elapsed)
+		return;
+
+	(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+					 100, WAIT_EVENT_CHECKPOINT_WRITE_DELAY);
+	ResetLatch(MyLatch);
+	CHECK_FOR_INTERRUPTS();
+}
+
+/*
+ * Returns the write rate (pages per second) needed to finish the checkpoint
+ * in time, or zero if the checkpoint writes shouldn't be throttled.
+ *
+ * The rate is the number of the pages left to write divided by the time left
+ * till the nearest of two deadlines.  The first one follows the time-based
+ * schedule of the checkpoint.  The second one is the moment when the WAL
+ * written since the checkpoint start reaches its share of max_wal_size given
+ * the WAL insertion rate observed so far.  So, a burst of WAL speeds up the
+ * checkpoint before it falls behind the WAL-based schedule rather than
+ * after that.
+ */
+static double
+checkpoint_pacing_target_rate(TimestampTz now, uint64 pagesWritten)
+{
+	double		elapsed,
+				remaining,
+				deadline,
+				rate = 0.0;
+
+	elapsed = (double) (now - checkpoint_state->startTime) / USECS_PER_SEC;
+	remaining = checkpoint_state->dirtyPagesEstimate - (double) pagesWritten;
+	deadline = (double) CheckPointTimeout * CheckPointCompletionTarget *
+		o_checkpoint_completion_ratio - elapsed;
+
+	if (!RecoveryInProgress() && elapsed > 0.0)
+	{
+		double		walUsed,
+					walBudget;
+
+		walUsed = (double) (GetXLogInsertRecPtr() - checkpoint_state->replayStartPtr);
+		walBudget = (double) wal_segment_size * CheckPointSegments *
+			CheckPointCompletionTarget * o_checkpoint_completion_ratio;
+		if (walUsed > 0.0)
+			deadline = Min(deadline, (walBudget - walUsed) * elapsed / walUsed);
+	}
+
+	/* Unthrottled when the estimate is exceeded or the checkpoint is late */
+	if (remaining > 0.0 && deadline > 0.0)
+		rate = remaining / deadline;
+
+	pg_atomic_write_u64(&checkpoint_state->pacingTargetRate, (uint64) rate);
+	return rate;
+}
+
+/*
+ * Throttles the checkpoint writes to the target rate given by
+ * checkpoint_pacing_target_rate().  The rate is shared by all the processes
+ * writing the checkpoint.  Checkpoint workers sleep for the time they're
+ * ahead of their share of the rate, but no longer than
+ * CHECKPOINT_PACING_MAX_SLEEP_MS at once, so their writes are spread evenly.
+ *
+ * The checkpointer itself sleeps only within CheckpointWriteDelay(), once it
+ * is ahead by the whole CHECKPOINT_PACING_MAX_SLEEP_MS.  That function skips
+ * the sleep on the immediate checkpoint request, which is only visible to it,
+ * so the rest of the checkpoint is written at full speed then.  Other wakeups
+ * of the checkpointer latch don't affect the pacing.
+ */
+static void
+checkpoint_pacing_delay(int flags, uint64 pagesWritten, int pages)
+{
+	TimestampTz now;
+	double		rate;
+	long		sleepMs;
+
+	/*
+	 * Let checkpointer absorb fsync requests and process barriers.  Zero
+	 * progress is never ahead of the schedule, so CheckpointWriteDelay()
+	 * doesn't sleep here.
+	 */
+	if (!IsCheckpointWorker)
+		CheckpointWriteDelay(flags, 0.0);
+
+	now = GetCurrentTimestamp();
+	if (pacingStartTime != checkpoint_state->startTime)
+	{
+		pacingStartTime = checkpoint_state->startTime;
+		pacingLastTime = now;
+		pacingCredit = 0.0;
+	}
+
+	/* Don't delay the postmaster shutdown */
+	if ((flags & CHECKPOINT_IMMEDIATE) || ShutdownRequestPending)
+		return;
+
+	rate = checkpoint_pacing_target_rate(now, pagesWritten) /
+		Max(checkpoint_state->pacingWriters, 1);
+	if (rate <= 0.0)
+	{
+		pacingCredit = 0.0;
+		pacingLastTime = now;
+		return;
+	}
+
+	/* Allow bursts no longer than a single sleep */
+	pacingCredit += rate * (double) (now - pacingLastTime) / USECS_PER_SEC - pages;
+	pacingCredit = Min(pacingCredit, rate * CHECKPOINT_PACING_MAX_SLEEP_MS / 1000.0);
+	pacingLastTime = now;
+	if (pacingCredit >= 0.0)
+		return;
+
+	if (!IsCheckpointWorker)
+	{
+		/*
+		 * The progress of 1.0 is on the schedule unless the checkpoint is
+		 * late, so CheckpointWriteDelay() sleeps unless the checkpoint is
+		 * requested to finish immediately.  The time actually slept is
+		 * accounted by the credit on the next call.
+		 */
+		if (pacingCredit <= -rate * CHECKPOINT_PACING_MAX_SLEEP_MS / 1000.0)
+			CheckpointWriteDelay(flags, 1.0);
+		return;
+	}
+
+	sleepMs = Min((long) (-pacingCredit * 1000.0 / rate) + 1,
+				  CHECKPOINT_PACING_MAX_SLEEP_MS);
+	(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+					 sleepMs, WAIT_EVENT_CHECKPOINT_WRITE_DELAY);
+	ResetLatch(MyLatch);
+	CHECK_FOR_INTERRUPTS();
+}
+
+/*
+ * Issues the writeback of the range of the data file.  With the adaptive
+ * pacing the call latency is measured: it grows when the device queue is
+ * congested.  The writeback batch is halved when the latency exceeds
+ * orioledb.checkpoint_writeback_latency, and grows linearly otherwise.
+ */
+static void
+checkpoint_writeback_range(BTreeDescr *desc, uint32 chkpNum,
+						   uint64 offset, int len, uint blcksz)
+{
+	TimestampTz start;
+	uint64		latency,
+				avgLatency;
+	uint32		batch;
+
+	if (!checkpoint_adaptive_pacing)
+	{
+		btree_smgr_writeback(desc, chkpNum,
+							 (off_t) offset * (off_t) blcksz,
+							 (off_t) len * (off_t) blcksz);
+		return;
+	}
+
+	start = GetCurrentTimestamp();
+	btree_smgr_writeback(desc, chkpNum,
+						 (off_t) offset * (off_t) blcksz,
+						 (off_t) len * (off_t) blcksz);
+	latency = (uint64) Max(GetCurrentTimestamp() - start, 0);
+
+	/* Races between the writers only make the average less precise */
+	avgLatency = pg_atomic_read_u64(&checkpoint_state->pacingLatency);
+	pg_atomic_write_u64(&checkpoint_state->pacingLatency,
+						(avgLatency * 7 + latency) / 8);
+
+	batch = pg_atomic_read_u32(&checkpoint_state->pacingBatch);
+	if (latency > (uint64) checkpoint_writeback_latency * 1000)
+		batch = Max(batch / 2, CHECKPOINT_PACING_MIN_BATCH);
+	else
+		batch = Min(batch + CHECKPOINT_PACING_MIN_BATCH,
+					CHECKPOINT_PACING_MAX_BATCH);
+	pg_atomic_write_u32(&checkpoint_state->pacingBatch, batch);
+}
+
 static void
 perform_writeback(BTreeDescr *desc, CheckpointWriteBack *writeback)
 {
@@ -424,6 +741,7 @@ perform_writeback(BTreeDescr *desc, CheckpointWriteBack *writeback)
 	double		progress = 0.0;
 	uint		blcksz = (writeback->isCompressed || use_mmap) ? ORIOLEDB_COMP_BLCKSZ : ORIOLEDB_BLCKSZ;
 	uint32		chkpNum = checkpoint_state->lastCheckpointNumber + 1;
+	int			maxLen = CHECKPOINT_PACING_MAX_BATCH;
 
 	if (use_device && !use_mmap)
 	{
@@ -434,6 +752,9 @@ perform_writeback(BTreeDescr *desc, CheckpointWriteBack *writeback)
 	pg_qsort(writeback->extents, writeback->extentsNumber,
 			 sizeof(FileExtent), file_extents_writeback_cmp);
 
+	if (checkpoint_adaptive_pacing)
+		maxLen = pg_atomic_read_u32(&checkpoint_state->pacingBatch);
+
 	for (i = 0; i < writeback->extentsNumber; i++)
 	{
 		if (i > 0 && writeback->extents[i].off == writeback->extents[i - 1].off)
@@ -442,37 +763,46 @@ perform_writeback(BTreeDescr *desc, CheckpointWriteBack *writeback)
 			continue;
 		}
 
-		if (writeback->extents[i].off == offset + len && len < 1024)
+		if (writeback->extents[i].off == offset + len && len < maxLen)
 		{
 			len += writeback->extents[i].len;
 		}
 		else
 		{
 			if (len > 0)
-				btree_smgr_writeback(desc, chkpNum,
-									 (off_t) offset * (off_t) blcksz,
-									 (off_t) len * (off_t) blcksz);
+			{
+				checkpoint_writeback_range(desc, chkpNum, offset, len, blcksz);
+				if (checkpoint_adaptive_pacing)
+					maxLen = pg_atomic_read_u32(&checkpoint_state->pacingBatch);
+			}
 			offset = writeback->extents[i].off;
 			len = writeback->extents[i].len;
 		}
 
-		if (progress < 1.0)
+		if (checkpoint_adaptive_pacing)
+			checkpoint_pacing_delay(writeback->checkpointFlags,
+									pg_atomic_read_u64(&checkpoint_state->pagesWritten) + (uint64) i,
+									1);
+		else if (progress < 1.0)
 		{
-			progress = (double) (checkpoint_state->pagesWritten + (uint64) i)
+			progress = (double) (pg_atomic_read_u64(&checkpoint_state->pagesWritten) + (uint64) i)
 				/ (double) checkpoint_state->dirtyPagesEstimate;
 			if (progress < 1.0)
 			{
 				progress *= o_checkpoint_completion_ratio;
-				CheckpointWriteDelay(writeback->checkpointFlags, progress);
+				if (IsCheckpointWorker)
+					checkpoint_worker_write_delay(writeback->checkpointFlags,
+												  progress);
+				else
+					CheckpointWriteDelay(writeback->checkpointFlags, progress);
 			}
 		}
 	}
 
 	if (len > 0)
-		btree_smgr_writeback(desc, chkpNum,
-							 (off_t) offset * (off_t) blcksz,
-							 (off_t) len * (off_t) blcksz);
-	checkpoint_state->pagesWritten += writeback->extentsNumber;
+		checkpoint_writeback_range(desc, chkpNum, offset, len, blcksz);
+	pg_atomic_fetch_add_u64(&checkpoint_state->pagesWritten,
+							writeback->extentsNumber);
 	writeback->extentsNumber = 0;
 }
 
@@ -522,17 +852,16 @@ free_writeback(CheckpointWriteBack *writeback)
 	pfree(writeback->extents);
 }
 
-static inline List *
-add_index_id_item(List *list, BTreeDescr *desc)
+/*
+ * Fills the post-processing item for the checkpointed tree.  Returns true if
+ * there is something to do after the checkpoint.
+ */
+static bool
+fill_index_id_item(IndexIdItem *item, BTreeDescr *desc)
 {
-	IndexIdItem *item;
-	MemoryContext old_context;
-
 	Assert(!orioledb_s3_mode);
 	Assert(desc->storageType == BTreeStoragePersistence ||
 		   desc->storageType == BTreeStorageUnlogged);
-	old_context = MemoryContextSwitchTo(chkp_main_context);
-	item = palloc(sizeof(IndexIdItem));
 	item->oids = desc->oids;
 	item->type = desc->type;
 	item->chkpNum = checkpoint_state->lastCheckpointNumber;
@@ -556,15 +885,35 @@ add_index_id_item(List *list, BTreeDescr *desc)
 		}
 	}
 
-	if (item->cleanupMap || item->freeExtents || item->punchHoles)
-		list = lappend(list, item);
-	else
-		pfree(item);
+	return item->cleanupMap || item->freeExtents || item->punchHoles;
+}
+
+static inline List *
+lappend_index_id_item(List *list, IndexIdItem *item)
+{
+	IndexIdItem *copy;
+	MemoryContext old_context;
+
+	old_context = MemoryContextSwitchTo(chkp_main_context);
+	copy = palloc(sizeof(IndexIdItem));
+	*copy = *item;
+	list = lappend(list, copy);
 	MemoryContextSwitchTo(old_context);
 
 	return list;
 }
 
+static inline List *
+add_index_id_item(List *list, BTreeDescr *desc)
+{
+	IndexIdItem item;
+
+	if (fill_index_id_item(&item, desc))
+		list = lappend_index_id_item(list, &item);
+
+	return list;
+}
+
 /*
  * Wait all the committing transactions to finish completely.  Ensures all the
  * transactions finished afterwards will have greater WAL position than given
@@ -941,7 +1290,7 @@ checkpoint_sys_trees(int flags, uint32 cur_chkp_num,
 		if (desc->storageType == BTreeStoragePersistence ||
 			desc->storageType == BTreeStorageUnlogged)
 		{
-			success = checkpoint_ix(flags, desc);
+			success = checkpoint_ix(checkpoint_state, flags, desc);
 			/* System trees can't be concurrently deleted */
 			Assert(success);
 			if (!orioledb_s3_mode)
@@ -954,7 +1303,7 @@ checkpoint_sys_trees(int flags, uint32 cur_chkp_num,
 		}
 		else
 		{
-			checkpoint_temporary_tree(flags, desc);
+			checkpoint_temporary_tree(checkpoint_state, flags, desc);
 			if (!orioledb_s3_mode)
 				sort_checkpoint_tmp_file(desc, cur_chkp_num % 2);
 		}
@@ -973,7 +1322,7 @@ checkpoint_chkp_nums(int flags, uint32 cur_chkp_num,
 	checkpoint_ix_init_state(checkpoint_state, desc);
 	checkpoint_init_new_seq_bufs(desc, cur_chkp_num);
 
-	success = checkpoint_ix(flags, desc);
+	success = checkpoint_ix(checkpoint_state, flags, desc);
 
 	/* System trees can't be concurrently deleted */
 	Assert(success);
@@ -1183,10 +1532,24 @@ o_perform_checkpoint(XLogRecPtr redo_pos, int flags)
 	chkp_tbl_arg.postProcessList = NIL;
 	chkp_tbl_arg.flags = flags;
 
+	/*
+	 * Checkpoint workers are stopped before the shutdown checkpoint.  S3 mode
+	 * tracks the locations of the scheduled writes in checkpointer.
+	 */
+	chkp_tbl_arg.parallel = checkpoint_num_workers > 0 &&
+		!(flags & CHECKPOINT_IS_SHUTDOWN) &&
+		IsPostmasterEnvironment && !orioledb_s3_mode;
+	if (chkp_tbl_arg.parallel)
+		checkpoint_state->checkpointerLatch = MyLatch;
+
 	checkpoint_state->dirtyPagesEstimate = get_dirty_pages_count_sum();
 	checkpoint_state->dirtyPagesEstimate *= (1.0 + CheckPointCompletionTarget
 											 * o_checkpoint_completion_ratio);
-	checkpoint_state->pagesWritten = 0;
+	pg_atomic_write_u64(&checkpoint_state->pagesWritten, 0);
+	checkpoint_state->startTime = GetCurrentTimestamp();
+	checkpoint_state->pacingWriters = chkp_tbl_arg.parallel ?
+		checkpoint_num_workers + 1 : 1;
+	pg_atomic_write_u64(&checkpoint_state->pacingTargetRate, 0);
 	checkpoint_state->toastConsistentPtr = InvalidXLogRecPtr;
 
 	old_enable_stopevents = enable_stopevents;
@@ -1240,6 +1603,9 @@ o_perform_checkpoint(XLogRecPtr redo_pos, int flags)
 
 	LWLockRelease(&checkpoint_state->oTablesMetaLock);
 
+	if (chkp_tbl_arg.parallel)
+		checkpoint_finish_jobs(&chkp_tbl_arg);
+
 	checkpoint_chkp_nums(flags, cur_chkp_num, &chkp_tbl_arg);
 
 	/*
@@ -1544,7 +1910,8 @@ checkpoint_init_new_seq_bufs(BTreeDescr *descr, int chkpNum)
  * Make checkpoint of an temporary index.
  */
 static void
-checkpoint_temporary_tree(int flags, BTreeDescr *descr)
+checkpoint_temporary_tree(CheckpointState *state, int flags,
+						  BTreeDescr *descr)
 {
 	BTreeMetaPage *meta_page;
 	uint32		chkp_num = checkpoint_state->lastCheckpointNumber + 1;
@@ -1560,12 +1927,12 @@ checkpoint_temporary_tree(int flags, BTreeDescr *descr)
 
 	/* Make checkpoint of the tree itself */
 	init_writeback(&writeback, flags, false);
-	(void) checkpoint_btree(&descr, checkpoint_state, &writeback);
+	(void) checkpoint_btree(&descr, state, &writeback);
 	(void) perform_writeback_and_relock(descr, &writeback,
-										checkpoint_state, NULL, 0);
+										state, NULL, 0);
 	free_writeback(&writeback);
 
-	Assert(checkpoint_state->curKeyType == CurKeyGreatest);
+	Assert(state->curKeyType == CurKeyGreatest);
 
 	STOPEVENT(STOPEVENT_BEFORE_BLKNO_LOCK, NULL);
 
@@ -1575,9 +1942,9 @@ checkpoint_temporary_tree(int flags, BTreeDescr *descr)
 	 * details.
 	 */
 	LWLockAcquire(&meta_page->copyBlknoLock, LW_EXCLUSIVE);
-	chkp_inc_changecount_before(checkpoint_state);
-	checkpoint_state->curKeyType = CurKeyFinished;
-	chkp_inc_changecount_after(checkpoint_state);
+	chkp_inc_changecount_before(state);
+	state->curKeyType = CurKeyFinished;
+	chkp_inc_changecount_after(state);
 	LWLockRelease(&meta_page->copyBlknoLock);
 
 	if (!orioledb_s3_mode)
@@ -1587,9 +1954,9 @@ checkpoint_temporary_tree(int flags, BTreeDescr *descr)
 		free_seq_buf_pages(descr, descr->tmpBuf[cur_chkp_index].shared);
 	}
 
-	chkp_inc_changecount_before(checkpoint_state);
-	checkpoint_state->completed = true;
-	chkp_inc_changecount_after(checkpoint_state);
+	chkp_inc_changecount_before(state);
+	state->completed = true;
+	chkp_inc_changecount_after(state);
 }
 
 /*
@@ -1743,8 +2110,8 @@ append_file_contents(File target, char *source_filename, uint64 offset)
 }
 
 static uint64
-finalize_chkp_map(File chkp_file, uint64 len, char *input_filename,
-				  uint64 input_offset, uint32 input_num)
+finalize_chkp_map(File chkp_file, uint64 len, Oid datoid, Oid relnode,
+				  char *input_filename, uint64 input_offset, uint32 input_num)
 {
 	SeqBufTag	tmp_tag;
 
@@ -1761,8 +2128,8 @@ finalize_chkp_map(File chkp_file, uint64 len, char *input_filename,
 	{
 		char	   *tmp_filename;
 
-		tmp_tag.datoid = checkpoint_state->datoid;
-		tmp_tag.relnode = checkpoint_state->relnode;
+		tmp_tag.datoid = datoid;
+		tmp_tag.relnode = relnode;
 		tmp_tag.num = input_num;
 		tmp_tag.type = 't';
 		if (seq_buf_file_exist(&tmp_tag))
@@ -1992,14 +2359,15 @@ sort_checkpoint_tmp_file(BTreeDescr *descr, int cur_chkp_index)
 static inline void
 checkpoint_ix_init_state(CheckpointState *state, BTreeDescr *descr)
 {
-	chkp_inc_changecount_before(checkpoint_state);
-	checkpoint_state->treeType = descr->type;
-	checkpoint_state->datoid = descr->oids.datoid;
-	checkpoint_state->reloid = descr->oids.reloid;
-	checkpoint_state->relnode = descr->oids.relnode;
-	checkpoint_state->completed = false;
-	checkpoint_state->curKeyType = CurKeyLeast;
-	chkp_inc_changecount_after(checkpoint_state);
+	chkp_inc_changecount_before(state);
+	state->treeType = descr->type;
+	state->datoid = descr->oids.datoid;
+	state->reloid = descr->oids.reloid;
+	state->relnode = descr->oids.relnode;
+	state->completed = false;
+	state->curKeyType = CurKeyLeast;
+	state->compactRequest = 0;
+	chkp_inc_changecount_after(state);
 }
 
 /*
@@ -2052,12 +2420,61 @@ free_extent_for_checkpoint(BTreeDescr *desc, FileExtent *extent, uint32 chkp_num
 }
 
 /*
- * Returns true if page with given page number is under in-progress
- * checkpointing.
+ * Checkpoint workers process the trees assigned by checkpointer using their
+ * own states, while checkpoint_state keeps the last assigned tree.  The trees
+ * are assigned in the checkpoint order under the change count of
+ * checkpoint_state.  Thus, the tree is either under the worker state, or
+ * checkpoint_state tells whether the tree is already passed.
+ *
+ * Returns the state the given tree should be checked against.  Caller should
+ * recheck the change count of checkpoint_state afterwards.
  */
-bool
-page_is_under_checkpoint(BTreeDescr *desc, OInMemoryBlkno blkno,
-						 bool includingHikeyBlkno)
+static CheckpointState *
+checkpoint_state_for_tree(OIndexType type, Oid datoid, Oid relnode,
+						  uint32 *changecount)
+{
+	CheckpointState *result;
+	uint32		after_changecount;
+	int			i;
+
+	while (true)
+	{
+		chkp_save_changecount_before(checkpoint_state, *changecount);
+		if ((*changecount & 1) != 0)
+			continue;
+
+		result = checkpoint_state;
+		for (i = 0; i < checkpoint_num_workers; i++)
+		{
+			CheckpointState *state = checkpoint_worker_state(i);
+
+			if (state->treeType == type &&
+				state->datoid == datoid &&
+				state->relnode == relnode)
+			{
+				result = state;
+				break;
+			}
+		}
+
+		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		if (*changecount == after_changecount)
+			return result;
+	}
+}
+
+static inline bool
+checkpoint_state_recheck(uint32 changecount)
+{
+	uint32		after_changecount;
+
+	chkp_save_changecount_after(checkpoint_state, after_changecount);
+	return changecount == after_changecount;
+}
+
+static bool
+page_is_under_checkpoint_state(CheckpointState *state, BTreeDescr *desc,
+							   OInMemoryBlkno blkno, bool includingHikeyBlkno)
 {
 	Page		p = O_GET_IN_MEMORY_PAGE(blkno);
 	Oid			datoid,
@@ -2073,18 +2490,18 @@ page_is_under_checkpoint(BTreeDescr *desc, OInMemoryBlkno blkno,
 
 	while (true)
 	{
-		chkp_save_changecount_before(checkpoint_state, before_changecount);
+		chkp_save_changecount_before(state, before_changecount);
 		if (before_changecount & 1)
 			continue;
 
-		type = checkpoint_state->treeType;
-		datoid = checkpoint_state->datoid;
-		relnode = checkpoint_state->relnode;
-		blkno_on_checkpoint = checkpoint_state->stack[level].blkno;
-		hikey_blkno_on_checkpoint = checkpoint_state->stack[level].hikeyBlkno;
-		cur_key = checkpoint_state->curKeyType;
+		type = state->treeType;
+		datoid = state->datoid;
+		relnode = state->relnode;
+		blkno_on_checkpoint = state->stack[level].blkno;
+		hikey_blkno_on_checkpoint = state->stack[level].hikeyBlkno;
+		cur_key = state->curKeyType;
 
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount != after_changecount)
 			continue;
 
@@ -2118,7 +2535,7 @@ page_is_under_checkpoint(BTreeDescr *desc, OInMemoryBlkno blkno,
 			result = false;
 		}
 
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount != after_changecount)
 			continue;
 
@@ -2127,10 +2544,34 @@ page_is_under_checkpoint(BTreeDescr *desc, OInMemoryBlkno blkno,
 }
 
 /*
- * Returns true if btree is under in-progress checkpointing.
+ * Returns true if page with given page number is under in-progress
+ * checkpointing.
  */
 bool
-tree_is_under_checkpoint(BTreeDescr *desc)
+page_is_under_checkpoint(BTreeDescr *desc, OInMemoryBlkno blkno,
+						 bool includingHikeyBlkno)
+{
+	CheckpointState *state;
+	uint32		changecount;
+	bool		result;
+
+	if (checkpoint_num_workers == 0)
+		return page_is_under_checkpoint_state(checkpoint_state, desc, blkno,
+											  includingHikeyBlkno);
+
+	do
+	{
+		state = checkpoint_state_for_tree(desc->type, desc->oids.datoid,
+										  desc->oids.relnode, &changecount);
+		result = page_is_under_checkpoint_state(state, desc, blkno,
+												includingHikeyBlkno);
+	} while (!checkpoint_state_recheck(changecount));
+
+	return result;
+}
+
+static bool
+tree_is_under_checkpoint_state(CheckpointState *state, BTreeDescr *desc)
 {
 	Oid			datoid,
 				relnode;
@@ -2141,15 +2582,15 @@ tree_is_under_checkpoint(BTreeDescr *desc)
 
 	while (true)
 	{
-		chkp_save_changecount_before(checkpoint_state, before_changecount);
+		chkp_save_changecount_before(state, before_changecount);
 		if (before_changecount & 1)
 			continue;
 
-		type = checkpoint_state->treeType;
-		datoid = checkpoint_state->datoid;
-		relnode = checkpoint_state->relnode;
+		type = state->treeType;
+		datoid = state->datoid;
+		relnode = state->relnode;
 
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount != after_changecount)
 			continue;
 
@@ -2165,7 +2606,7 @@ tree_is_under_checkpoint(BTreeDescr *desc)
 			result = true;
 		}
 
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount != after_changecount)
 			continue;
 
@@ -2174,56 +2615,159 @@ tree_is_under_checkpoint(BTreeDescr *desc)
 }
 
 /*
- * Returns -1 if page must be evicted to current in progress checkpoint.
- * Returns 1 if page must be evicted to next checkpoint.
- * Return 0 if page can not be evicted.
- *
- * We can't evict page if its hikey is in range [cur_key, lvl_hikey]:
- *
- * If we evict it to the current checkpoint (last_checkpoint_number + 1),
- * we may lost the page offset on concurrent split case.
- *
- * If we evict it to the next checkpoint (last_checkpoint_number + 2)
- * a page offset will be marked as free for current checkpoint,
- * than if we add downlink with the offset to an autonomous page, and restart
- * we will have the offset both free and busy for the current checkpoint.
+ * Returns true if btree is under in-progress checkpointing.
  */
-static inline int
-side_of_checkpoint_bound(BTreeDescr *descr, Page page,
-						 OTuple cur_key, CurKeyType cur_key_type,
-						 OTuple lvl_hikey, CheckpointBound bound)
+bool
+tree_is_under_checkpoint(BTreeDescr *desc)
 {
-	int			cmp;
-	OTuple		hikey;
-	bool		page_is_rightmost = O_PAGE_IS(page, RIGHTMOST);
-
-	Assert(cur_key_type == CurKeyValue || cur_key_type == CurKeyGreatest);
+	CheckpointState *state;
+	uint32		changecount;
+	bool		result;
 
-	/* fast checks, helps to exclusive rightmost case */
+	if (checkpoint_num_workers == 0)
+		return tree_is_under_checkpoint_state(checkpoint_state, desc);
 
-	if (cur_key_type == CurKeyGreatest)
+	do
 	{
-		/* left bound on rightmost pages */
-		if (page_is_rightmost)
-			return 0;
-		return 1;
-	}
+		state = checkpoint_state_for_tree(desc->type, desc->oids.datoid,
+										  desc->oids.relnode, &changecount);
+		result = tree_is_under_checkpoint_state(state, desc);
+	} while (!checkpoint_state_recheck(changecount));
 
-	Assert(cur_key_type == CurKeyValue);
-	if (page_is_rightmost)
-	{
-		/* case for rightmost page (no hikey to compare) */
-		if (bound == CheckpointBoundRightmost)
-			return 0;
-		return -1;
-	}
+	return result;
+}
 
-	/*
-	 * left bound comparison
-	 */
-	Assert(!page_is_rightmost && cur_key_type == CurKeyValue);
-	BTREE_PAGE_GET_HIKEY(hikey, page);
-	cmp = o_btree_cmp(descr, &hikey, BTreeKeyNonLeafKey, &cur_key, BTreeKeyNonLeafKey);
+/*
+ * Returns true if the tree is being walked by the checkpointer or the
+ * checkpoint worker.  Caller should hold copyBlknoLock of the tree, so the
+ * checkpoint of the tree can't be finished concurrently.
+ */
+bool
+tree_checkpoint_in_progress(BTreeDescr *desc)
+{
+	CheckpointState *state;
+	uint32		changecount;
+	bool		result;
+
+	do
+	{
+		state = checkpoint_state_for_tree(desc->type, desc->oids.datoid,
+										  desc->oids.relnode, &changecount);
+		result = state->treeType == desc->type &&
+			state->datoid == desc->oids.datoid &&
+			state->relnode == desc->oids.relnode &&
+			state->curKeyType != CurKeyFinished;
+	} while (!checkpoint_state_recheck(changecount));
+
+	return result;
+}
+
+/*
+ * Returns the state of the checkpoint processing the given tree.
+ */
+CheckpointState *
+tree_checkpoint_state(BTreeDescr *desc)
+{
+	uint32		changecount;
+
+	return checkpoint_state_for_tree(desc->type, desc->oids.datoid,
+									 desc->oids.relnode, &changecount);
+}
+
+/*
+ * Moves hikeyBlkno of the checkpoint stack on split or merge.  This change is
+ * atomic, no need to bother about change count.  In-memory block numbers are
+ * unique across the trees, so all the states can be checked.
+ */
+void
+checkpoint_move_hikey_blkno(int level, OInMemoryBlkno blkno,
+							OInMemoryBlkno newBlkno)
+{
+	int			i;
+
+	if (checkpoint_state->stack[level].hikeyBlkno == blkno)
+		checkpoint_state->stack[level].hikeyBlkno = newBlkno;
+
+	for (i = 0; i < checkpoint_num_workers; i++)
+	{
+		CheckpointState *state = checkpoint_worker_state(i);
+
+		if (state->stack[level].hikeyBlkno == blkno)
+			state->stack[level].hikeyBlkno = newBlkno;
+	}
+}
+
+/*
+ * Checks if the block is hikeyBlkno of the checkpoint stack level in any of
+ * the states.
+ */
+bool
+checkpoint_has_hikey_blkno(int level, OInMemoryBlkno blkno)
+{
+	int			i;
+
+	if (checkpoint_state->stack[level].hikeyBlkno == blkno)
+		return true;
+
+	for (i = 0; i < checkpoint_num_workers; i++)
+	{
+		if (checkpoint_worker_state(i)->stack[level].hikeyBlkno == blkno)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Returns -1 if page must be evicted to current in progress checkpoint.
+ * Returns 1 if page must be evicted to next checkpoint.
+ * Return 0 if page can not be evicted.
+ *
+ * We can't evict page if its hikey is in range [cur_key, lvl_hikey]:
+ *
+ * If we evict it to the current checkpoint (last_checkpoint_number + 1),
+ * we may lost the page offset on concurrent split case.
+ *
+ * If we evict it to the next checkpoint (last_checkpoint_number + 2)
+ * a page offset will be marked as free for current checkpoint,
+ * than if we add downlink with the offset to an autonomous page, and restart
+ * we will have the offset both free and busy for the current checkpoint.
+ */
+static inline int
+side_of_checkpoint_bound(BTreeDescr *descr, Page page,
+						 OTuple cur_key, CurKeyType cur_key_type,
+						 OTuple lvl_hikey, CheckpointBound bound)
+{
+	int			cmp;
+	OTuple		hikey;
+	bool		page_is_rightmost = O_PAGE_IS(page, RIGHTMOST);
+
+	Assert(cur_key_type == CurKeyValue || cur_key_type == CurKeyGreatest);
+
+	/* fast checks, helps to exclusive rightmost case */
+
+	if (cur_key_type == CurKeyGreatest)
+	{
+		/* left bound on rightmost pages */
+		if (page_is_rightmost)
+			return 0;
+		return 1;
+	}
+
+	Assert(cur_key_type == CurKeyValue);
+	if (page_is_rightmost)
+	{
+		/* case for rightmost page (no hikey to compare) */
+		if (bound == CheckpointBoundRightmost)
+			return 0;
+		return -1;
+	}
+
+	/*
+	 * left bound comparison
+	 */
+	Assert(!page_is_rightmost && cur_key_type == CurKeyValue);
+	BTREE_PAGE_GET_HIKEY(hikey, page);
+	cmp = o_btree_cmp(descr, &hikey, BTreeKeyNonLeafKey, &cur_key, BTreeKeyNonLeafKey);
 
 	if (cmp == 0)
 		return 0;
@@ -2286,12 +2830,10 @@ chkp_ordering_cmp(OIndexType type1, Oid datoid1, Oid relnode1,
 	return 0;
 }
 
-/*
- * Determine which checkpoint `blkno` should be written to.
- */
-bool
-get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno,
-					  uint32 *checkpoint_number, bool *copy_blkno)
+static bool
+get_checkpoint_number_state(CheckpointState *state, BTreeDescr *desc,
+							OInMemoryBlkno blkno, uint32 *checkpoint_number,
+							bool *copy_blkno)
 {
 	CheckpointBound bound;
 	CurKeyType	cur_key_type;
@@ -2312,20 +2854,20 @@ get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno,
 
 	while (true)
 	{
-		chkp_save_changecount_before(checkpoint_state, before_changecount);
+		chkp_save_changecount_before(state, before_changecount);
 		if ((before_changecount & 1) != 0)
 			continue;
 
-		last_checkpoint_number = checkpoint_state->lastCheckpointNumber;
-		type = checkpoint_state->treeType;
-		datoid = checkpoint_state->datoid;
-		relnode = checkpoint_state->relnode;
-		chkp_lvl_blkno = checkpoint_state->stack[level].blkno;
-		chkp_lvl_hikey_blkno = checkpoint_state->stack[level].hikeyBlkno;
-		bound = checkpoint_state->stack[level].bound;
-		cur_key_type = checkpoint_state->curKeyType;
+		last_checkpoint_number = state->lastCheckpointNumber;
+		type = state->treeType;
+		datoid = state->datoid;
+		relnode = state->relnode;
+		chkp_lvl_blkno = state->stack[level].blkno;
+		chkp_lvl_hikey_blkno = state->stack[level].hikeyBlkno;
+		bound = state->stack[level].bound;
+		cur_key_type = state->curKeyType;
 
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount != after_changecount)
 			continue;
 
@@ -2349,7 +2891,7 @@ get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno,
 				*copy_blkno = false;
 			}
 
-			chkp_save_changecount_after(checkpoint_state, after_changecount);
+			chkp_save_changecount_after(state, after_changecount);
 			if (before_changecount != after_changecount)
 				continue;
 
@@ -2374,7 +2916,7 @@ get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno,
 		 */
 		if (under_checkpoint)
 		{
-			chkp_save_changecount_after(checkpoint_state, after_changecount);
+			chkp_save_changecount_after(state, after_changecount);
 			if (before_changecount != after_changecount)
 				continue;
 			return false;
@@ -2389,7 +2931,7 @@ get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno,
 				*checkpoint_number = last_checkpoint_number + 2;
 			*copy_blkno = false;
 
-			chkp_save_changecount_after(checkpoint_state, after_changecount);
+			chkp_save_changecount_after(state, after_changecount);
 			if (before_changecount != after_changecount)
 				continue;
 
@@ -2397,19 +2939,19 @@ get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno,
 		}
 
 		if (cur_key_type == CurKeyValue)
-			copy_from_fixed_shmem_key(&cur_key, &checkpoint_state->curKeyValue);
+			copy_from_fixed_shmem_key(&cur_key, &state->curKeyValue);
 
 		if (bound == CheckpointBoundHikey)
-			copy_from_fixed_shmem_key(&lvl_hikey, &checkpoint_state->stack[level].hikey);
+			copy_from_fixed_shmem_key(&lvl_hikey, &state->stack[level].hikey);
 
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount != after_changecount)
 			continue;
 
 		cmp = side_of_checkpoint_bound(desc, page, cur_key.tuple, cur_key_type,
 									   lvl_hikey.tuple, bound);
 
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount != after_changecount)
 			continue;
 
@@ -2430,6 +2972,32 @@ get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno,
 	}
 }
 
+/*
+ * Determine which checkpoint `blkno` should be written to.
+ */
+bool
+get_checkpoint_number(BTreeDescr *desc, OInMemoryBlkno blkno,
+					  uint32 *checkpoint_number, bool *copy_blkno)
+{
+	CheckpointState *state;
+	uint32		changecount;
+	bool		result;
+
+	if (checkpoint_num_workers == 0)
+		return get_checkpoint_number_state(checkpoint_state, desc, blkno,
+										   checkpoint_number, copy_blkno);
+
+	do
+	{
+		state = checkpoint_state_for_tree(desc->type, desc->oids.datoid,
+										  desc->oids.relnode, &changecount);
+		result = get_checkpoint_number_state(state, desc, blkno,
+											 checkpoint_number, copy_blkno);
+	} while (!checkpoint_state_recheck(changecount));
+
+	return result;
+}
+
 /*
  * Sets the autonomous level by backend. It should not be called for leafs.
  */
@@ -2458,7 +3026,7 @@ backend_set_autonomous_level(CheckpointState *state, uint32 level)
  * Make checkpoint of an index.
  */
 static bool
-checkpoint_ix(int flags, BTreeDescr *descr)
+checkpoint_ix(CheckpointState *state, int flags, BTreeDescr *descr)
 {
 	FileExtentsArray *free_extents = NULL;
 	char	   *filename,
@@ -2482,21 +3050,36 @@ checkpoint_ix(int flags, BTreeDescr *descr)
 	meta_page = BTREE_GET_META(descr);
 	meta_page->dirtyFlag1 = false;
 
+	if (descr->storageType == BTreeStoragePersistence &&
+		!orioledb_s3_mode && !use_device)
+		state->compactRequest = pg_atomic_read_u32(&meta_page->compactRequest);
+	else
+		state->compactRequest = 0;
+	state->compactPages = 0;
+	state->compactPrevEnd = InvalidFileExtentOff;
+
 	/* Make checkpoint of the tree itself */
 	init_writeback(&writeback, flags, is_compressed);
-	root_downlink = checkpoint_btree(&descr, checkpoint_state, &writeback);
+	root_downlink = checkpoint_btree(&descr, state, &writeback);
 	if (!DiskDownlinkIsValid(root_downlink))
 	{
 		free_writeback(&writeback);
 		return false;
 	}
 	descr = perform_writeback_and_relock(descr, &writeback,
-										 checkpoint_state, NULL, 0);
+										 state, NULL, 0);
 	free_writeback(&writeback);
 	if (!descr)
 		return false;
 
-	Assert(checkpoint_state->curKeyType == CurKeyGreatest);
+	/* The whole tree is passed within the limit, the request is served */
+	if (state->compactRequest != 0 &&
+		state->compactPages < compaction_pages_per_checkpoint)
+		pg_atomic_compare_exchange_u32(&BTREE_GET_META(descr)->compactRequest,
+									   &state->compactRequest, 0);
+	state->compactRequest = 0;
+
+	Assert(state->curKeyType == CurKeyGreatest);
 	Assert(DiskDownlinkIsValid(root_downlink));
 
 	if (!use_device)
@@ -2532,9 +3115,9 @@ checkpoint_ix(int flags, BTreeDescr *descr)
 	 */
 	LWLockAcquire(&meta_page->copyBlknoLock, LW_EXCLUSIVE);
 
-	chkp_inc_changecount_before(checkpoint_state);
-	checkpoint_state->curKeyType = CurKeyFinished;
-	chkp_inc_changecount_after(checkpoint_state);
+	chkp_inc_changecount_before(state);
+	state->curKeyType = CurKeyFinished;
+	chkp_inc_changecount_after(state);
 
 	/* Make header for the map file... */
 	header.rootDownlink = root_downlink;
@@ -2722,7 +3305,8 @@ checkpoint_ix(int flags, BTreeDescr *descr)
 		finalize_filename = seq_buf_file_exist(&free_buf_tag)
 			? get_seq_buf_filename(&free_buf_tag)
 			: NULL;
-		map_len = finalize_chkp_map(file, map_len, finalize_filename, offset,
+		map_len = finalize_chkp_map(file, map_len, datoid, relnode,
+									finalize_filename, offset,
 									free_buf_tag.num);
 		if (finalize_filename)
 			pfree(finalize_filename);
@@ -2762,10 +3346,10 @@ checkpoint_ix(int flags, BTreeDescr *descr)
 		maxLocation = Max(maxLocation, location);
 	}
 
-	chkp_inc_changecount_before(checkpoint_state);
-	checkpoint_state->completed = true;
+	chkp_inc_changecount_before(state);
+	state->completed = true;
 	BTREE_GET_META(descr)->dirtyFlag2 = false;
-	chkp_inc_changecount_after(checkpoint_state);
+	chkp_inc_changecount_after(state);
 
 	if (!IS_SYS_TREE_OIDS(descr->oids))
 		o_update_latest_chkp_num(descr->oids.datoid,
@@ -2791,6 +3375,14 @@ checkpoint_btree(BTreeDescr **descrPtr, CheckpointState *state,
 										ALLOCSET_DEFAULT_SIZES);
 	prev_context = MemoryContextSwitchTo(tmp_context);
 
+	/*
+	 * Forget the jobs left by the previous tree, if any.  The compression
+	 * queue has the only producer, so checkpoint workers don't use it.
+	 */
+	if (!IsCheckpointWorker)
+		o_compress_queue_reset();
+	offloadBlkno = OInvalidInMemoryBlkno;
+
 	set_skip_ucm();
 	/* Walk the tree recursively starting from rootPageBlkno */
 	root_downlink = checkpoint_btree_loop(descrPtr,
@@ -2799,6 +3391,9 @@ checkpoint_btree(BTreeDescr **descrPtr, CheckpointState *state,
 										  tmp_context);
 	unset_skip_ucm();
 
+	if (!IsCheckpointWorker)
+		o_compress_queue_reset();
+
 	checkpoint_reset_stack(state);
 
 	MemoryContextSwitchTo(prev_context);
@@ -4082,6 +4677,248 @@ autonomous_stack_flush_to_disk(BTreeDescr *descr, CheckpointState *state,
 }
 
 
+/*
+ * Advances the checkpoint current key past the downlink at the given location
+ * of the internal page.  Caller is responsible for the change count.
+ */
+static void
+checkpoint_advance_cur_key(BTreeDescr *descr, CheckpointState *state,
+						   int level, Page page, BTreePageItemLocator *loc)
+{
+	BTreePageItemLocator nextLoc = *loc;
+
+	BTREE_PAGE_LOCATOR_NEXT(page, &nextLoc);
+	if (BTREE_PAGE_LOCATOR_IS_VALID(page, &nextLoc) || !O_PAGE_IS(page, RIGHTMOST))
+	{
+		state->curKeyType = CurKeyValue;
+		if (BTREE_PAGE_LOCATOR_IS_VALID(page, &nextLoc))
+			copy_fixed_shmem_page_key(descr, &state->curKeyValue, page,
+									  &nextLoc);
+		else
+			copy_fixed_shmem_hikey(descr, &state->curKeyValue, page);
+
+		update_lowest_level_hikey(descr, state, level,
+								  fixed_shmem_key_get_tuple(&state->curKeyValue));
+	}
+	else
+	{
+		OTuple		nullTup;
+
+		state->curKeyType = CurKeyGreatest;
+
+		O_TUPLE_SET_NULL(nullTup);
+		update_lowest_level_hikey(descr, state, level, nullTup);
+	}
+}
+
+/*
+ * Tries to copy the on-disk downlink of the in-memory child at the location
+ * of the internal page instead of descending into the child.  That is
+ * possible if the child is a clean non-leaf page, and none of its descendants
+ * was modified since the previous checkpoint has passed them (see
+ * btree_find_context_mark_dirty()).  The modifications made after this check
+ * belong to the checkpoint being taken, but they will be replayed from WAL.
+ *
+ * On success, sets *downlink to the on-disk downlink and advances the current
+ * key past the child.  That is done within the same change count section
+ * with the checks.  So, concurrent writes of the child descendants either
+ * have already marked the child or relocate the pages for the next
+ * checkpoint, leaving the extents referenced by the child image intact.
+ */
+static bool
+checkpoint_try_skip_subtree(BTreeDescr *descr, CheckpointState *state,
+							int level, Page page, BTreePageItemLocator *loc,
+							uint64 *downlink)
+{
+	OInMemoryBlkno blkno = DOWNLINK_GET_IN_MEMORY_BLKNO(*downlink);
+	OrioleDBPageDesc *page_desc = O_GET_IN_MEMORY_PAGEDESC(blkno);
+	uint32		chkpNum = state->lastCheckpointNumber + 1;
+	bool		result;
+
+	/*
+	 * Only WAL-logged trees, whose concurrent modifications will be replayed.
+	 * Lower levels of the stack shouldn't have autonomous images to flush.
+	 */
+	if (!btree_may_skip_subtrees(descr) || level < 2 ||
+		state->compactRequest != 0 ||
+		BTREE_PAGE_ITEMS_COUNT(state->stack[level - 1].image) > 0)
+		return false;
+
+	chkp_inc_changecount_before(state);
+
+	/* pairs with the barrier in btree_dirty_chkp_num() */
+	pg_memory_barrier();
+
+	result = !IS_DIRTY(blkno) &&
+		page_desc->ionum < 0 &&
+		FileExtentIsValid(page_desc->fileExtent) &&
+		pg_atomic_read_u32(&page_desc->dirtyChkpNum) < chkpNum &&
+		pg_atomic_read_u32(&BTREE_GET_META(descr)->dirtyChkpNum) < chkpNum;
+
+	if (result)
+	{
+		Assert(PAGE_GET_LEVEL(O_GET_IN_MEMORY_PAGE(blkno)) == level - 1);
+		*downlink = MAKE_ON_DISK_DOWNLINK(page_desc->fileExtent);
+		checkpoint_advance_cur_key(descr, state, level, page, loc);
+	}
+
+	chkp_inc_changecount_after(state);
+
+	if (result)
+		pg_atomic_fetch_add_u64(&checkpoint_state->skippedSubtrees, 1);
+
+	return result;
+}
+
+/*
+ * Serves the leaves compaction request of orioledb_tbl_compact() for the
+ * on-disk leaf at the location of the locked level 1 page.  Leaves, which
+ * don't closely follow the previous on-disk leaf in the data file, are copied
+ * to the end of the file.  So, after the pass the leaves are laid out in the
+ * key order.  The old extent is freed as if the leaf was rewritten by this
+ * checkpoint, and the parent is marked dirty to be written with the new
+ * downlink.
+ *
+ * The copy is done the same way as load_page() does: the downlink is
+ * replaced with the IO downlink, and the IO is performed with the parent
+ * page unlocked.  Then the parent is re-found and gets the new downlink.  In
+ * this case the page is left unlocked, and we return true with the walk
+ * message set to continue from the same downlink.
+ *
+ * At most compaction_pages_per_checkpoint leaves are copied by a checkpoint.
+ * The next checkpoint skips the leaves already in order and resumes from the
+ * first leaf out of order.
+ */
+static bool
+checkpoint_compact_leaf(BTreeDescr *descr, CheckpointState *state,
+						CheckpointWriteBack *writeback, int level,
+						BTreePageItemLocator *loc, uint32 chkpNum,
+						WalkMessage *message)
+{
+	OInMemoryBlkno blkno = state->stack[level].blkno;
+	Page		page = O_GET_IN_MEMORY_PAGE(blkno);
+	OBTreeFindPageContext context;
+	BTreeNonLeafTuphdr *tuphdr;
+	BTreePageItemLocator nextLoc;
+	OFixedKey	targetHikey;
+	FileExtent	oldExtent,
+				newExtent;
+	OffsetNumber offset;
+	OFindPageResult result PG_USED_FOR_ASSERTS_ONLY;
+	uint64		downlink,
+				newDownlink = InvalidDiskDownlink,
+				maxGap;
+	uint32		pageChangeCount;
+	int			ionum;
+	bool		relocated;
+
+	tuphdr = (BTreeNonLeafTuphdr *) BTREE_PAGE_LOCATOR_GET_ITEM(page, loc);
+	downlink = tuphdr->downlink;
+	Assert(DOWNLINK_IS_ON_DISK(downlink));
+	oldExtent.off = DOWNLINK_GET_DISK_OFF(downlink);
+	oldExtent.len = DOWNLINK_GET_DISK_LEN(downlink);
+
+	/*
+	 * Leave some room for the pages written concurrently.  Otherwise a single
+	 * write in between would make us relocate all the following leaves again.
+	 */
+	maxGap = 8 * (OCompressIsValid(descr->compress) ?
+				  ORIOLEDB_BLCKSZ / ORIOLEDB_COMP_BLCKSZ : 1);
+	if (state->compactPrevEnd == InvalidFileExtentOff ||
+		(oldExtent.off >= state->compactPrevEnd &&
+		 oldExtent.off - state->compactPrevEnd <= maxGap))
+	{
+		state->compactPrevEnd = oldExtent.off + oldExtent.len;
+		return false;
+	}
+
+	if (state->compactPages >= compaction_pages_per_checkpoint)
+		return false;
+
+	/* Indicate that IO is in-progress */
+	offset = BTREE_PAGE_LOCATOR_GET_OFFSET(page, loc);
+	ionum = assign_io_num(blkno, offset);
+	page_block_reads(blkno);
+	tuphdr->downlink = MAKE_IO_DOWNLINK(ionum);
+	Assert(PAGE_GET_N_ONDISK(page) > 0);
+	PAGE_DEC_N_ONDISK(page);
+
+	nextLoc = *loc;
+	BTREE_PAGE_LOCATOR_NEXT(page, &nextLoc);
+	if (BTREE_PAGE_LOCATOR_IS_VALID(page, &nextLoc))
+		copy_fixed_page_key(descr, &targetHikey, page, &nextLoc);
+	else if (!O_PAGE_IS(page, RIGHTMOST))
+		copy_fixed_hikey(descr, &targetHikey, page);
+	else
+		clear_fixed_key(&targetHikey);
+	pageChangeCount = O_PAGE_GET_CHANGE_COUNT(page);
+
+	/* Save the key we need to continue from */
+	if (offset == 0)
+	{
+		state->stack[level].nextkeyType = NextKeyNone;
+	}
+	else
+	{
+		state->stack[level].nextkeyType = NextKeyValue;
+		copy_fixed_shmem_page_key(descr, &state->stack[level].nextkey,
+								  page, loc);
+	}
+	message->action = WalkContinue;
+	state->stack[level].offset = offset;
+
+	unlock_page(blkno);
+
+	relocated = btree_relocate_disk_page(descr, downlink, chkpNum,
+										 &newDownlink);
+
+	/* Re-find the parent page, it might be changed concurrently */
+	init_page_find_context(&context, descr, COMMITSEQNO_INPROGRESS,
+						   BTREE_PAGE_FIND_MODIFY |
+						   BTREE_PAGE_FIND_DOWNLINK_LOCATION);
+	if (O_TUPLE_IS_NULL(targetHikey.tuple))
+		result = refind_page(&context, NULL, BTreeKeyRightmost, level,
+							 blkno, pageChangeCount);
+	else
+		result = refind_page(&context, &targetHikey.tuple, BTreeKeyPageHiKey,
+							 level, blkno, pageChangeCount);
+	Assert(result == OFindPageResultSuccess);
+
+	blkno = context.items[context.index].blkno;
+	page = O_GET_IN_MEMORY_PAGE(blkno);
+	page_block_reads(blkno);
+	tuphdr = (BTreeNonLeafTuphdr *) BTREE_PAGE_LOCATOR_GET_ITEM(page,
+																 &context.items[context.index].locator);
+	Assert(tuphdr->downlink == MAKE_IO_DOWNLINK(ionum));
+	tuphdr->downlink = relocated ? newDownlink : downlink;
+	PAGE_INC_N_ONDISK(page);
+
+	/* the parent is written by this checkpoint, no need to mark the tree */
+	if (relocated)
+		MARK_DIRTY_EXTENDED(descr, blkno, true);
+	unlock_page(blkno);
+	unlock_io(ionum);
+
+	if (!relocated)
+		ereport(ERROR, (errcode_for_file_access(),
+						errmsg("could not relocate page with file offset " UINT64_FORMAT " in %s: %m",
+							   DOWNLINK_GET_DISK_OFF(downlink),
+							   btree_smgr_filename(descr, DOWNLINK_GET_DISK_OFF(downlink), 0))));
+
+	newExtent.off = DOWNLINK_GET_DISK_OFF(newDownlink);
+	newExtent.len = DOWNLINK_GET_DISK_LEN(newDownlink);
+	free_extent_for_checkpoint(descr, &oldExtent, chkpNum);
+	writeback_put_extent(writeback, &newExtent);
+
+	/*
+	 * The walk meets the new downlink again, so point to its start to let it
+	 * pass as the one in order.
+	 */
+	state->compactPages++;
+	state->compactPrevEnd = newExtent.off;
+	return true;
+}
+
 static void
 checkpoint_internal_pass(BTreeDescr *descr, CheckpointState *state,
 						 CheckpointWriteBack *writeback,
@@ -4100,7 +4937,8 @@ checkpoint_internal_pass(BTreeDescr *descr, CheckpointState *state,
 				write_img,
 				write_rightmost,
 				prev_less = false,
-				tuple_processed;
+				tuple_processed,
+				skipped;
 	BTreePageItemLocator loc;
 	uint32		chkpNum = state->lastCheckpointNumber + 1;
 
@@ -4297,9 +5135,15 @@ checkpoint_internal_pass(BTreeDescr *descr, CheckpointState *state,
 			state->stack[level].autonomousTupleExist = false;
 		}
 
+		skipped = DOWNLINK_IS_IN_MEMORY(downlink) &&
+			checkpoint_try_skip_subtree(descr, state, level, page, &loc,
+										&downlink);
+
 		if (DOWNLINK_IS_IN_MEMORY(downlink))
 		{
 			BTreePageItemLocator nextLoc = loc;
+			uint64	   *offloadDownlinks = NULL;
+			int			offloadCount = 0;
 
 			BTREE_PAGE_LOCATOR_NEXT(page, &nextLoc);
 			if (BTREE_PAGE_LOCATOR_IS_VALID(page, &nextLoc))
@@ -4339,7 +5183,21 @@ checkpoint_internal_pass(BTreeDescr *descr, CheckpointState *state,
 									page, &loc);
 			}
 
+			if (level == 1 && OCompressIsValid(descr->compress))
+				offloadCount = checkpoint_collect_offload_downlinks(blkno, page,
+																	&nextLoc,
+																	&offloadDownlinks);
+
 			unlock_page(blkno);
+
+			/*
+			 * Let background writers compress the next leaves while we're
+			 * writing this one.
+			 */
+			if (offloadCount > 0)
+				btree_offload_compression(descr, chkpNum, offloadDownlinks,
+										  offloadCount);
+
 			message->action = WalkDownwards;
 			message->content.downwards.blkno = DOWNLINK_GET_IN_MEMORY_BLKNO(downlink);
 			message->content.downwards.pageChangeCount = DOWNLINK_GET_IN_MEMORY_CHANGECOUNT(downlink);
@@ -4350,14 +5208,24 @@ checkpoint_internal_pass(BTreeDescr *descr, CheckpointState *state,
 		}
 		else if (DOWNLINK_IS_ON_DISK(downlink))
 		{
-			BTreePageItemLocator nextLoc,
-						imgLastLoc;
+			BTreePageItemLocator imgLastLoc;
+
+			if (state->compactRequest != 0 && level == 1 && !autonomous &&
+				BTREE_PAGE_ITEMS_COUNT(state->stack[level - 1].image) == 0 &&
+				checkpoint_compact_leaf(descr, state, writeback, level, &loc,
+										chkpNum, message))
+				return;
 
 			/* copy internal header with downlink */
 			BTREE_PAGE_LOCATOR_LAST(img, &imgLastLoc);
 			memcpy(BTREE_PAGE_LOCATOR_GET_ITEM(img, &imgLastLoc),
 				   BTREE_PAGE_LOCATOR_GET_ITEM(page, &loc),
 				   BTreeNonLeafTuphdrSize);
+			if (skipped)
+			{
+				tuphdr = (BTreeNonLeafTuphdr *) BTREE_PAGE_LOCATOR_GET_ITEM(img, &imgLastLoc);
+				tuphdr->downlink = downlink;
+			}
 
 			if (BTREE_PAGE_ITEMS_COUNT(state->stack[level - 1].image) > 0)
 			{
@@ -4398,33 +5266,12 @@ checkpoint_internal_pass(BTreeDescr *descr, CheckpointState *state,
 
 			/*
 			 * Page is already on the disk, but we have to advance current key
-			 * ourselves...
+			 * ourselves...  Skipped subtree has it already advanced.
 			 */
-			nextLoc = loc;
-			BTREE_PAGE_LOCATOR_NEXT(page, &nextLoc);
-			if (BTREE_PAGE_LOCATOR_IS_VALID(page, &nextLoc) || !O_PAGE_IS(page, RIGHTMOST))
+			if (!skipped)
 			{
 				chkp_inc_changecount_before(state);
-				state->curKeyType = CurKeyValue;
-				if (BTREE_PAGE_LOCATOR_IS_VALID(page, &nextLoc))
-					copy_fixed_shmem_page_key(descr, &state->curKeyValue, page,
-											  &nextLoc);
-				else
-					copy_fixed_shmem_hikey(descr, &state->curKeyValue, page);
-
-				update_lowest_level_hikey(descr, state, level,
-										  fixed_shmem_key_get_tuple(&state->curKeyValue));
-				chkp_inc_changecount_after(state);
-			}
-			else
-			{
-				OTuple		nullTup;
-
-				chkp_inc_changecount_before(state);
-				state->curKeyType = CurKeyGreatest;
-
-				O_TUPLE_SET_NULL(nullTup);
-				update_lowest_level_hikey(descr, state, level, nullTup);
+				checkpoint_advance_cur_key(descr, state, level, page, &loc);
 				chkp_inc_changecount_after(state);
 			}
 
@@ -4739,6 +5586,60 @@ prepare_leaf_page(BTreeDescr *descr, CheckpointState *state)
 	unlock_page(blkno);
 }
 
+/*
+ * Collects the downlinks to the dirty in-memory leaves starting from the given
+ * location of the level 1 page.  Their images are put to the compression
+ * queue.  The window of compress_offload_pages downlinks is refilled once the
+ * half of it is passed.  Should be called with the page locked.  Returns the
+ * number of collected downlinks.
+ */
+static int
+checkpoint_collect_offload_downlinks(OInMemoryBlkno blkno, Page page,
+									 BTreePageItemLocator *loc,
+									 uint64 **downlinks)
+{
+	BTreePageItemLocator offloadLoc;
+	int			offset,
+				end,
+				count = 0;
+
+	if (IsCheckpointWorker ||
+		!BTREE_PAGE_LOCATOR_IS_VALID(page, loc) ||
+		o_compress_queue_free_slots() <= 0)
+		return 0;
+
+	offset = BTREE_PAGE_LOCATOR_GET_OFFSET(page, loc);
+	end = offset + compress_offload_pages;
+
+	if (blkno == offloadBlkno &&
+		O_PAGE_GET_CHANGE_COUNT(page) == offloadChangeCount &&
+		offloadOffset > offset)
+	{
+		if (offloadOffset - offset > compress_offload_pages / 2)
+			return 0;
+		offset = offloadOffset;
+	}
+	offloadBlkno = blkno;
+	offloadChangeCount = O_PAGE_GET_CHANGE_COUNT(page);
+	offloadOffset = end;
+
+	*downlinks = (uint64 *) palloc(sizeof(uint64) * compress_offload_pages);
+	BTREE_PAGE_OFFSET_GET_LOCATOR(page, offset, &offloadLoc);
+	while (BTREE_PAGE_LOCATOR_IS_VALID(page, &offloadLoc) &&
+		   BTREE_PAGE_LOCATOR_GET_OFFSET(page, &offloadLoc) < end)
+	{
+		BTreeNonLeafTuphdr *tuphdr;
+
+		tuphdr = (BTreeNonLeafTuphdr *) BTREE_PAGE_LOCATOR_GET_ITEM(page, &offloadLoc);
+		if (DOWNLINK_IS_IN_MEMORY(tuphdr->downlink) &&
+			IS_DIRTY(DOWNLINK_GET_IN_MEMORY_BLKNO(tuphdr->downlink)))
+			(*downlinks)[count++] = tuphdr->downlink;
+		BTREE_PAGE_LOCATOR_NEXT(page, &offloadLoc);
+	}
+
+	return count;
+}
+
 /*
  * Check if tree needs to be passed during checkpointing.  Is should be
  * presented in SYS_TREES_SHARED_ROOT_INFO or in SYS_TREES_EVICTED_DATA.  That
@@ -4800,19 +5701,290 @@ check_tree_needs_checkpointing(OIndexType type, ORelOids treeOids)
 	return true;
 }
 
+/*
+ * Makes checkpoint of the loaded tree using the given state.  The tree is
+ * unlocked afterwards.  Returns true and fills `item` if the tree needs
+ * post-processing after the checkpoint.
+ */
+static bool
+checkpoint_loaded_tree(CheckpointState *state, int flags, BTreeDescr *td,
+					   IndexIdItem *item)
+{
+	ORelOids	treeOids = td->oids;
+	BTreeMetaPage *meta = BTREE_GET_META(td);
+	uint32		chkpNum = (checkpoint_state->lastCheckpointNumber + 1);
+	int			cur_chkp_index = chkpNum % 2;
+	bool		skip = false;
+	bool		result = false;
+
+	if (STOPEVENTS_ENABLED())
+	{
+		Jsonb	   *params = prepare_checkpoint_tree_start_params(td);
+
+		STOPEVENT(STOPEVENT_CHECKPOINT_INDEX_START, params);
+	}
+
+	checkpoint_ix_init_state(state, td);
+	checkpoint_init_new_seq_bufs(td, chkpNum);
+
+	/* Unmodified tree is still passed to serve the compaction request */
+	if (!meta->dirtyFlag1 && !meta->dirtyFlag2 &&
+		pg_atomic_read_u32(&meta->compactRequest) == 0)
+	{
+		chkp_inc_changecount_before(state);
+		if (!meta->dirtyFlag1 && !meta->dirtyFlag2)
+		{
+			state->treeType = td->type;
+			state->datoid = td->oids.datoid;
+			state->reloid = td->oids.reloid;
+			state->relnode = td->oids.relnode;
+			state->completed = true;
+			state->curKeyType = CurKeyFinished;
+			skip = true;
+		}
+		chkp_inc_changecount_after(state);
+	}
+
+	if (skip)
+	{
+		if (!orioledb_s3_mode)
+		{
+			if (td->storageType == BTreeStoragePersistence ||
+				td->storageType == BTreeStorageUnlogged)
+			{
+				free_seq_buf_pages(td, td->nextChkp[cur_chkp_index].shared);
+				seq_buf_close_file(&td->nextChkp[cur_chkp_index]);
+			}
+			free_seq_buf_pages(td, td->tmpBuf[cur_chkp_index].shared);
+			seq_buf_close_file(&td->tmpBuf[cur_chkp_index]);
+		}
+		o_tables_rel_unlock_extended(&treeOids, AccessShareLock, true);
+	}
+	else if (td->storageType == BTreeStoragePersistence ||
+			 td->storageType == BTreeStorageUnlogged)
+	{
+		if (checkpoint_ix(state, flags, td))
+		{
+			if (!orioledb_s3_mode)
+			{
+				sort_checkpoint_map_file(td, cur_chkp_index);
+				sort_checkpoint_tmp_file(td, cur_chkp_index);
+				result = fill_index_id_item(item, td);
+			}
+			o_tables_rel_unlock_extended(&treeOids, AccessShareLock, true);
+		}
+	}
+	else
+	{
+		checkpoint_temporary_tree(state, flags, td);
+		if (!orioledb_s3_mode)
+			sort_checkpoint_tmp_file(td, cur_chkp_index);
+		o_tables_rel_unlock_extended(&treeOids, AccessShareLock, true);
+	}
+
+	return result;
+}
+
+/*
+ * Makes checkpoint of the tree assigned to the checkpoint worker using the
+ * worker state.
+ */
+static void
+checkpoint_job_tree(CheckpointState *state, CheckpointJob *job)
+{
+	OIndexDescr *descr;
+	bool		loaded = false;
+
+	job->hasItem = false;
+	descr = o_fetch_index_descr(job->treeOids, job->type, true, NULL);
+	if (descr != NULL)
+		loaded = o_btree_load_shmem_checkpoint(&descr->desc);
+	if (loaded)
+		job->hasItem = checkpoint_loaded_tree(state, job->flags,
+											  &descr->desc, &job->item);
+	else if (descr != NULL)
+		o_tables_rel_unlock_extended(&job->treeOids, AccessShareLock, true);
+
+	/* The tree might be concurrently deleted, the state is not needed anyway */
+	if (!state->completed || state->curKeyType != CurKeyFinished)
+	{
+		chkp_inc_changecount_before(state);
+		state->completed = true;
+		state->curKeyType = CurKeyFinished;
+		chkp_inc_changecount_after(state);
+	}
+}
+
+/*
+ * Passes the loaded tree to the checkpoint worker.  The tree is installed to
+ * the worker state and checkpoint_state is moved to the tree at once.  So,
+ * concurrent processes find the tree either in the worker state or behind
+ * checkpoint_state.
+ */
+static void
+checkpoint_assign_job(int num, int flags, BTreeDescr *td)
+{
+	CheckpointJob *job = &checkpoint_jobs[num];
+	CheckpointState *state = checkpoint_worker_state(num);
+	int			procno;
+
+	chkp_inc_changecount_before(checkpoint_state);
+	state->lastCheckpointNumber = checkpoint_state->lastCheckpointNumber;
+	checkpoint_ix_init_state(state, td);
+	checkpoint_state->treeType = td->type;
+	checkpoint_state->datoid = td->oids.datoid;
+	checkpoint_state->reloid = td->oids.reloid;
+	checkpoint_state->relnode = td->oids.relnode;
+	checkpoint_state->completed = true;
+	checkpoint_state->curKeyType = CurKeyFinished;
+	chkp_inc_changecount_after(checkpoint_state);
+
+	job->type = td->type;
+	job->treeOids = td->oids;
+	job->flags = flags;
+	job->hasItem = false;
+	pg_write_barrier();
+	pg_atomic_write_u32(&job->status, CheckpointJobAssigned);
+
+	procno = job->procno;
+	if (procno >= 0)
+		SetLatch(&GetPGProcByNumber(procno)->procLatch);
+}
+
+/*
+ * Collects the results of the checkpoint workers.  If `all` is true, waits
+ * for all the assigned trees to be done.  Otherwise, waits for an idle worker
+ * and returns its number, or returns -1 if no worker is running.
+ * oTablesMetaLock is released while waiting.
+ *
+ * If a worker failed to checkpoint its tree, waits for the rest of the
+ * workers and fails the checkpoint with an error, the same way as an error
+ * of checkpointing the tree by checkpointer itself does.
+ */
+static int
+checkpoint_wait_jobs(CheckpointTablesArg *tbl_arg, bool all)
+{
+	bool		locked = LWLockHeldByMe(&checkpoint_state->oTablesMetaLock);
+	bool		unlocked = false;
+	int			failed = -1;
+	int			result;
+
+	while (true)
+	{
+		bool		busy = false;
+		int			i;
+
+		ResetLatch(MyLatch);
+
+		result = -1;
+		for (i = 0; i < checkpoint_num_workers; i++)
+		{
+			CheckpointJob *job = &checkpoint_jobs[i];
+			uint32		status = pg_atomic_read_u32(&job->status);
+
+			if (status == CheckpointJobAssigned && job->procno < 0 &&
+				failed < 0)
+			{
+				/* The worker exited before taking the tree, do it ourselves */
+				if (pg_atomic_compare_exchange_u32(&job->status, &status,
+												   CheckpointJobStarted))
+				{
+					if (locked && !unlocked)
+					{
+						LWLockRelease(&checkpoint_state->oTablesMetaLock);
+						unlocked = true;
+					}
+					checkpoint_job_tree(checkpoint_worker_state(i), job);
+					status = CheckpointJobDone;
+				}
+			}
+
+			if (status == CheckpointJobDone)
+			{
+				pg_read_barrier();
+				if (job->hasItem && failed < 0)
+					tbl_arg->postProcessList = lappend_index_id_item(tbl_arg->postProcessList,
+																	 &job->item);
+				pg_atomic_write_u32(&job->status, CheckpointJobIdle);
+				status = CheckpointJobIdle;
+			}
+
+			/* The worker exited on FATAL in the middle of the tree */
+			if ((status == CheckpointJobStarted || status == CheckpointJobAssigned) &&
+				job->procno < 0)
+			{
+				pg_read_barrier();
+				if (pg_atomic_compare_exchange_u32(&job->status, &status,
+												   CheckpointJobFailed))
+					status = CheckpointJobFailed;
+			}
+
+			if (status == CheckpointJobFailed)
+			{
+				pg_atomic_write_u32(&job->status, CheckpointJobIdle);
+				status = CheckpointJobIdle;
+				if (failed < 0)
+					failed = i;
+			}
+
+			if (status != CheckpointJobIdle)
+				busy = true;
+			else if (result < 0 && job->procno >= 0)
+				result = i;
+		}
+
+		if (!busy || (!all && result >= 0 && failed < 0))
+			break;
+
+		if (locked && !unlocked)
+		{
+			LWLockRelease(&checkpoint_state->oTablesMetaLock);
+			unlocked = true;
+		}
+
+		(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 100, WAIT_EVENT_CHECKPOINT_WRITE_DELAY);
+		if (AmCheckpointerProcess())
+			AbsorbSyncRequests();
+	}
+
+	if (failed >= 0)
+	{
+		checkpoint_reset_jobs();
+		ereport(ERROR,
+				(errmsg("orioledb checkpoint worker %d failed to checkpoint the tree", failed)));
+	}
+
+	if (unlocked)
+		LWLockAcquire(&checkpoint_state->oTablesMetaLock, LW_EXCLUSIVE);
+
+	return result;
+}
+
 static void
 checkpoint_tables_callback(OIndexType type, ORelOids treeOids,
 						   ORelOids tableOids, void *arg)
 {
 	CheckpointTablesArg *tbl_arg = (CheckpointTablesArg *) arg;
 	OIndexDescr *descr;
-	uint32		chkpNum = (checkpoint_state->lastCheckpointNumber + 1);
-	int			cur_chkp_index = chkpNum % 2;
 	MemoryContext prev_context;
 	bool		loaded = false;
+	int			jobNum = -1;
 
 	prev_context = MemoryContextSwitchTo(chkp_tree_context);
 
+	if (tbl_arg->parallel)
+	{
+		/*
+		 * Secondary indices are replayed from toastConsistentPtr.  So, all
+		 * the primary and TOAST trees should be written before we get it.
+		 */
+		if (type >= oIndexUnique &&
+			XLogRecPtrIsInvalid(checkpoint_state->toastConsistentPtr))
+			(void) checkpoint_wait_jobs(tbl_arg, true);
+		jobNum = checkpoint_wait_jobs(tbl_arg, false);
+	}
+
 	if (!check_tree_needs_checkpointing(type, treeOids))
 	{
 		MemoryContextSwitchTo(prev_context);
@@ -4833,9 +6005,7 @@ checkpoint_tables_callback(OIndexType type, ORelOids treeOids,
 	if (loaded)
 	{
 		BTreeDescr *td = &descr->desc;
-		BTreeMetaPage *meta = BTREE_GET_META(td);
-		bool		success;
-		bool		skip = false;
+		IndexIdItem item;
 
 		elog(DEBUG3, "CHKP %u, (%u, %u, %u) => (%u, %u, %u)",
 			 type, treeOids.datoid, treeOids.reloid, treeOids.relnode,
@@ -4850,75 +6020,22 @@ checkpoint_tables_callback(OIndexType type, ORelOids treeOids,
 			checkpoint_state->toastConsistentPtr = GetXLogInsertRecPtr();
 		}
 
-		LWLockRelease(&checkpoint_state->oTablesMetaLock);
-
-		if (STOPEVENTS_ENABLED())
-		{
-			Jsonb	   *params = prepare_checkpoint_tree_start_params(td);
-
-			STOPEVENT(STOPEVENT_CHECKPOINT_INDEX_START, params);
-		}
-
-		checkpoint_ix_init_state(checkpoint_state, td);
-		checkpoint_init_new_seq_bufs(td, chkpNum);
-
-		if (!meta->dirtyFlag1 && !meta->dirtyFlag2)
-		{
-			chkp_inc_changecount_before(checkpoint_state);
-			if (!meta->dirtyFlag1 && !meta->dirtyFlag2)
-			{
-				checkpoint_state->treeType = td->type;
-				checkpoint_state->datoid = td->oids.datoid;
-				checkpoint_state->reloid = td->oids.reloid;
-				checkpoint_state->relnode = td->oids.relnode;
-				checkpoint_state->completed = true;
-				checkpoint_state->curKeyType = CurKeyFinished;
-				skip = true;
-			}
-			chkp_inc_changecount_after(checkpoint_state);
-		}
-
-		if (skip)
+		if (jobNum >= 0)
 		{
-			if (!orioledb_s3_mode)
-			{
-				if (td->storageType == BTreeStoragePersistence ||
-					td->storageType == BTreeStorageUnlogged)
-				{
-					free_seq_buf_pages(td, td->nextChkp[cur_chkp_index].shared);
-					seq_buf_close_file(&td->nextChkp[cur_chkp_index]);
-				}
-				free_seq_buf_pages(td, td->tmpBuf[cur_chkp_index].shared);
-				seq_buf_close_file(&td->tmpBuf[cur_chkp_index]);
-			}
+			checkpoint_assign_job(jobNum, tbl_arg->flags, td);
 			o_tables_rel_unlock_extended(&treeOids, AccessShareLock, true);
 		}
-		else if (td->storageType == BTreeStoragePersistence ||
-				 td->storageType == BTreeStorageUnlogged)
-		{
-			success = checkpoint_ix(tbl_arg->flags, td);
-
-			if (success)
-			{
-				if (!orioledb_s3_mode)
-				{
-					sort_checkpoint_map_file(td, cur_chkp_index);
-					sort_checkpoint_tmp_file(td, cur_chkp_index);
-					tbl_arg->postProcessList = add_index_id_item(tbl_arg->postProcessList, td);
-				}
-				o_tables_rel_unlock_extended(&treeOids, AccessShareLock, true);
-			}
-		}
 		else
 		{
-			checkpoint_temporary_tree(tbl_arg->flags, td);
-			if (!orioledb_s3_mode)
-				sort_checkpoint_tmp_file(td, cur_chkp_index);
-			o_tables_rel_unlock_extended(&treeOids, AccessShareLock, true);
-		}
+			LWLockRelease(&checkpoint_state->oTablesMetaLock);
 
+			if (checkpoint_loaded_tree(checkpoint_state, tbl_arg->flags, td,
+									   &item))
+				tbl_arg->postProcessList = lappend_index_id_item(tbl_arg->postProcessList,
+																 &item);
 
-		LWLockAcquire(&checkpoint_state->oTablesMetaLock, LW_EXCLUSIVE);
+			LWLockAcquire(&checkpoint_state->oTablesMetaLock, LW_EXCLUSIVE);
+		}
 	}
 	else if (descr != NULL)
 	{
@@ -4930,11 +6047,167 @@ checkpoint_tables_callback(OIndexType type, ORelOids treeOids,
 }
 
 /*
- * Returns actual lastCheckpointNumber for current tree.
+ * Forgets the trees passed to the checkpoint workers.
  */
-uint32
-get_cur_checkpoint_number(ORelOids *oids, OIndexType type,
-						  bool *checkpoint_concurrent)
+static void
+checkpoint_reset_jobs(void)
+{
+	int			i;
+
+	chkp_inc_changecount_before(checkpoint_state);
+	for (i = 0; i < checkpoint_num_workers; i++)
+	{
+		CheckpointState *state = checkpoint_worker_state(i);
+
+		chkp_inc_changecount_before(state);
+		state->treeType = oIndexInvalid;
+		state->datoid = InvalidOid;
+		state->reloid = InvalidOid;
+		state->relnode = InvalidOid;
+		chkp_inc_changecount_after(state);
+	}
+	chkp_inc_changecount_after(checkpoint_state);
+}
+
+/*
+ * Waits for the trees passed to the checkpoint workers and forgets them.
+ */
+static void
+checkpoint_finish_jobs(CheckpointTablesArg *tbl_arg)
+{
+	(void) checkpoint_wait_jobs(tbl_arg, true);
+	checkpoint_reset_jobs();
+}
+
+void
+register_checkpoint_worker(int num)
+{
+	BackgroundWorker worker;
+
+	/* Set up background worker parameters */
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = 0;
+	worker.bgw_main_arg = Int32GetDatum(num);
+	strcpy(worker.bgw_library_name, "orioledb");
+	strcpy(worker.bgw_function_name, "checkpoint_worker_main");
+	strcpy(worker.bgw_name, "orioledb checkpoint worker");
+	strcpy(worker.bgw_type, "orioledb checkpoint worker");
+	RegisterBackgroundWorker(&worker);
+}
+
+static void
+checkpoint_worker_exit(int code, Datum arg)
+{
+	checkpoint_jobs[DatumGetInt32(arg)].procno = -1;
+	pg_memory_barrier();
+	if (checkpoint_state->checkpointerLatch)
+		SetLatch(checkpoint_state->checkpointerLatch);
+}
+
+void
+checkpoint_worker_main(Datum main_arg)
+{
+	int			num = DatumGetInt32(main_arg);
+	CheckpointJob *job = &checkpoint_jobs[num];
+	CheckpointState *state = checkpoint_worker_state(num);
+
+	/* enable timeout for relation lock */
+	RegisterTimeout(DEADLOCK_TIMEOUT, CheckDeadLockAlert);
+
+	/* enable relation cache invalidation (remove old OTableDescr) */
+	RelationCacheInitialize();
+	InitCatalogCache();
+	SharedInvalBackendInit(false);
+
+	SetProcessingMode(NormalProcessing);
+
+	/* finish the assigned tree before exit */
+	pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+	BackgroundWorkerUnblockSignals();
+
+	elog(LOG, "orioledb checkpoint worker %d started", num);
+	IsCheckpointWorker = true;
+
+	chkp_main_context = AllocSetContextCreate(TopMemoryContext,
+											  "OrioleDB checkpoint context",
+											  ALLOCSET_DEFAULT_SIZES);
+	chkp_tree_context = AllocSetContextCreate(chkp_main_context,
+											  "OrioleDB single tree context",
+											  ALLOCSET_DEFAULT_SIZES);
+	CurTransactionContext = AllocSetContextCreate(TopMemoryContext,
+												  "orioledb checkpoint worker current transaction context",
+												  ALLOCSET_DEFAULT_SIZES);
+	TopTransactionContext = AllocSetContextCreate(TopMemoryContext,
+												  "orioledb checkpoint worker top transaction context",
+												  ALLOCSET_DEFAULT_SIZES);
+
+	job->procno = MYPROCNUMBER;
+	on_shmem_exit(checkpoint_worker_exit, Int32GetDatum(num));
+
+	PG_TRY();
+	{
+		MemoryContextSwitchTo(chkp_tree_context);
+		while (!ShutdownRequestPending)
+		{
+			uint32		status = CheckpointJobAssigned;
+			int			rc;
+
+			if (pg_atomic_compare_exchange_u32(&job->status, &status,
+											   CheckpointJobStarted))
+			{
+				o_set_syscache_hooks();
+				o_database_cache_set_database_encoding();
+#if PG_VERSION_NUM >= 170000
+				o_database_cache_set_default_locale_provider();
+#endif
+				o_database_cache_set_lc_collate();
+
+				checkpoint_job_tree(state, job);
+
+				o_unset_syscache_hooks();
+
+				pg_write_barrier();
+				pg_atomic_write_u32(&job->status, CheckpointJobDone);
+				if (checkpoint_state->checkpointerLatch)
+					SetLatch(checkpoint_state->checkpointerLatch);
+
+				MemoryContextResetOnly(chkp_tree_context);
+				MemoryContextReset(CurTransactionContext);
+				MemoryContextReset(TopTransactionContext);
+				continue;
+			}
+
+			rc = WaitLatch(MyLatch, WL_LATCH_SET | WL_POSTMASTER_DEATH, -1,
+						   WAIT_EVENT_CHECKPOINTER_MAIN);
+			if (rc & WL_POSTMASTER_DEATH)
+				ShutdownRequestPending = true;
+			ResetLatch(MyLatch);
+		}
+		elog(LOG, "orioledb checkpoint worker %d is shut down", num);
+	}
+	PG_CATCH();
+	{
+		uint32		status = CheckpointJobStarted;
+
+		/*
+		 * Let checkpointer fail the checkpoint with an error instead of
+		 * waiting for the tree.  The worker exits and gets restarted.
+		 */
+		if (pg_atomic_compare_exchange_u32(&job->status, &status,
+										   CheckpointJobFailed) &&
+			checkpoint_state->checkpointerLatch)
+			SetLatch(checkpoint_state->checkpointerLatch);
+		LockReleaseSession(DEFAULT_LOCKMETHOD);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+}
+
+static uint32
+get_cur_checkpoint_number_state(CheckpointState *state, ORelOids *oids,
+								OIndexType type, bool *checkpoint_concurrent)
 {
 	OIndexType	chkp_tree_type = oIndexInvalid;
 	Oid			datoid = InvalidOid,
@@ -4946,17 +6219,17 @@ get_cur_checkpoint_number(ORelOids *oids, OIndexType type,
 
 	do
 	{
-		chkp_save_changecount_before(checkpoint_state, before_changecount);
+		chkp_save_changecount_before(state, before_changecount);
 		if ((before_changecount & 1) != 0)
 			continue;
 
-		chkp_tree_type = checkpoint_state->treeType;
-		datoid = checkpoint_state->datoid;
-		relnode = checkpoint_state->relnode;
-		result = checkpoint_state->lastCheckpointNumber;
-		completed = checkpoint_state->completed;
+		chkp_tree_type = state->treeType;
+		datoid = state->datoid;
+		relnode = state->relnode;
+		result = state->lastCheckpointNumber;
+		completed = state->completed;
 
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount != after_changecount)
 			continue;
 
@@ -4983,7 +6256,7 @@ get_cur_checkpoint_number(ORelOids *oids, OIndexType type,
 			*checkpoint_concurrent = false;
 		}
 		/* else checkpoint is not in progress */
-		chkp_save_changecount_after(checkpoint_state, after_changecount);
+		chkp_save_changecount_after(state, after_changecount);
 		if (before_changecount == after_changecount)
 			break;
 	} while (true);
@@ -4991,6 +6264,32 @@ get_cur_checkpoint_number(ORelOids *oids, OIndexType type,
 	return result;
 }
 
+/*
+ * Returns actual lastCheckpointNumber for current tree.
+ */
+uint32
+get_cur_checkpoint_number(ORelOids *oids, OIndexType type,
+						  bool *checkpoint_concurrent)
+{
+	CheckpointState *state;
+	uint32		changecount;
+	uint32		result;
+
+	if (checkpoint_num_workers == 0)
+		return get_cur_checkpoint_number_state(checkpoint_state, oids, type,
+											   checkpoint_concurrent);
+
+	do
+	{
+		state = checkpoint_state_for_tree(type, oids->datoid, oids->relnode,
+										  &changecount);
+		result = get_cur_checkpoint_number_state(state, oids, type,
+												 checkpoint_concurrent);
+	} while (!checkpoint_state_recheck(changecount));
+
+	return result;
+}
+
 /*
  * Check if we can already re-use space freed in given checkpoint.
  */
@@ -5246,6 +6545,10 @@ evictable_tree_init_meta(BTreeDescr *desc, EvictedTreeData **evicted_data,
 	pg_atomic_write_u32(&meta_page->leafPagesNum, file_header.leafPagesNum);
 	pg_atomic_write_u64(&meta_page->ctid, file_header.ctid);
 	pg_atomic_write_u64(&meta_page->bridge_ctid, file_header.bridgeCtid);
+	if (OCompressIsValid(desc->compress) && !orioledb_s3_mode)
+		pg_atomic_write_u64(&meta_page->compressDict,
+							o_compress_find_latest_dict(desc->oids.datoid,
+														desc->oids.relnode));
 
 	if (*evicted_data)
 	{
@@ -16,8 +16,12 @@
 
 #include "orioledb.h"
 
+#include "btree/adaptive_hash.h"
+#include "btree/fastpath.h"
 #include "btree/find.h"
 #include "btree/io.h"
+#include "btree/page_contents.h"
+#include "btree/page_state.h"
 #include "btree/scan.h"
 #include "catalog/o_tables.h"
 #include "catalog/o_sys_cache.h"
@@ -34,6 +38,7 @@
 #include "s3/requests.h"
 #include "s3/worker.h"
 #include "storage/standby.h"
+#include "tableam/descr.h"
 #include "tableam/handler.h"
 #include "tableam/scan.h"
 #include "tableam/toast.h"
@@ -41,19 +46,26 @@
 #include "transam/undo.h"
 #include "tuple/toast.h"
 #include "utils/compress.h"
+#include "utils/compress_queue.h"
+#include "utils/compressed_tier.h"
 #include "utils/dsa.h"
 #include "utils/guc.h"
 #include "utils/memdebug.h"
+#include "utils/o_io_uring.h"
+#include "utils/o_mem_region.h"
+#include "utils/o_numa.h"
 #include "utils/page_pool.h"
 #include "utils/stopevent.h"
 #include "utils/ucm.h"
 #include "workers/bgwriter.h"
+#include "workers/prewarm.h"
 #include "rewind/rewind.h"
 
 #include "access/heapam.h"
 #include "access/table.h"
 #include "access/xlog_internal.h"
 #include "catalog/pg_enum.h"
+#include "catalog/pg_type.h"
 #include "executor/execExpr.h"
 #include "funcapi.h"
 #include "libpq/auth.h"
@@ -69,12 +81,15 @@
 #include "storage/ipc.h"
 #include "storage/lwlock.h"
 #include "storage/proclist.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/hsearch.h"
 #include "utils/inval.h"
 #include "utils/rangetypes.h"
 #include "utils/pg_locale.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
+#include "utils/timestamp.h"
 
 #include <dirent.h>
 #include <sys/stat.h>
@@ -115,6 +130,7 @@ Size		rewind_circular_buffer_size;
 uint32		rewind_buffers_count;
 bool		remove_old_checkpoint_files = true;
 bool		skip_unmodified_trees = true;
+bool		skip_unmodified_subtrees = true;
 bool		debug_disable_bgwriter = false;
 bool		use_mmap = false;
 bool		use_device = false;
@@ -126,6 +142,10 @@ int			device_length_guc = 0;
 Size		device_length = 0;
 double		o_checkpoint_completion_ratio;
 int			bgwriter_num_workers = 1;
+int			checkpoint_num_workers = 0;
+int			compaction_pages_per_checkpoint = 1000;
+bool		checkpoint_adaptive_pacing = true;
+int			checkpoint_writeback_latency = 10;
 int			max_io_concurrency = 0;
 ODBProcData *oProcData;
 int			default_compress = InvalidOCompress;
@@ -207,7 +227,11 @@ static ShmemItem shmemItems[] = {
 	{s3_queue_shmem_needs, s3_queue_init_shmem},
 	{s3_workers_shmem_needs, s3_workers_init_shmem},
 	{s3_headers_shmem_needs, s3_headers_shmem_init},
-	{rewind_shmem_needs, rewind_init_shmem}
+	{rewind_shmem_needs, rewind_init_shmem},
+	{o_compress_queue_shmem_needs, o_compress_queue_shmem_init},
+	{o_compressed_tier_shmem_needs, o_compressed_tier_shmem_init},
+	{bgwriter_shmem_needs, bgwriter_shmem_init},
+	{prewarm_shmem_needs, prewarm_shmem_init}
 };
 
 
@@ -228,12 +252,31 @@ static bool check_debug_max_bridge_ctid(char **newval, void **extra, GucSource s
 static void assign_debug_max_bridge_ctid(const char *newval, void *extra);
 
 PG_FUNCTION_INFO_V1(orioledb_page_stats);
+PG_FUNCTION_INFO_V1(orioledb_checkpoint_pacing);
+PG_FUNCTION_INFO_V1(orioledb_checkpoint_skipped_subtrees);
+PG_FUNCTION_INFO_V1(orioledb_compressed_tier_stats);
+PG_FUNCTION_INFO_V1(orioledb_get_tree_stats);
 PG_FUNCTION_INFO_V1(orioledb_version);
 PG_FUNCTION_INFO_V1(orioledb_commit_hash);
 PG_FUNCTION_INFO_V1(orioledb_ucm_check);
 PG_FUNCTION_INFO_V1(orioledb_parallel_debug_start);
 PG_FUNCTION_INFO_V1(orioledb_parallel_debug_stop);
 
+static const struct config_enum_entry io_method_options[] = {
+	{"sync", OIOMethodSync, false},
+#ifdef ORIOLEDB_USE_IO_URING
+	{"io_uring", OIOMethodIoUring, false},
+#endif
+	{NULL, 0, false}
+};
+
+static const struct config_enum_entry huge_pages_options[] = {
+	{"off", OHugePagesOff, false},
+	{"try", OHugePagesTry, false},
+	{"on", OHugePagesOn, false},
+	{NULL, 0, false}
+};
+
 static void
 orioledb_rm_desc(StringInfo buf, XLogReaderState *record)
 {
@@ -449,6 +492,17 @@ _PG_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("orioledb.skip_unmodified_subtrees",
+							 "Skip traversal of unmodified in-memory subtrees during checkpointing.",
+							 NULL,
+							 &skip_unmodified_subtrees,
+							 true,
+							 PGC_SIGHUP,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("orioledb.debug_disable_bgwriter",
 							 "Disables bgwriter for debug.",
 							 NULL,
@@ -559,6 +613,119 @@ _PG_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable("orioledb.checkpoint_workers",
+							"Number of workers checkpointing the trees in parallel.",
+							"If set to zero, checkpointer processes all the trees itself.",
+							&checkpoint_num_workers,
+							0,
+							0,
+							MAX_BACKENDS,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("orioledb.checkpoint_adaptive_pacing",
+							 "Paces the checkpoint writes by the WAL insertion rate and the writeback latency.",
+							 "If disabled, the checkpoint progress is paced linearly by orioledb.checkpoint_completion_ratio.",
+							 &checkpoint_adaptive_pacing,
+							 true,
+							 PGC_SIGHUP,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("orioledb.checkpoint_writeback_latency",
+							"Target latency of the checkpoint writeback requests.",
+							"The writeback batch shrinks when the latency exceeds this value.",
+							&checkpoint_writeback_latency,
+							10,
+							1,
+							10000,
+							PGC_SIGHUP,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("orioledb.compaction_pages_per_checkpoint",
+							"Maximum number of leaf pages relocated by a checkpoint for the tree compaction.",
+							"See orioledb_tbl_compact().",
+							&compaction_pages_per_checkpoint,
+							1000,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("orioledb.compressed_buffers",
+							"Size of the compressed in-memory tier for the pages evicted from main buffers.",
+							NULL,
+							&compressed_buffers_guc,
+							0,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_UNIT_BLOCKS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("orioledb.prewarm",
+							 "Saves the main buffers working set and loads it on startup.",
+							 NULL,
+							 &prewarm_enabled,
+							 false,
+							 PGC_POSTMASTER,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("orioledb.prewarm_interval",
+							"Sets the interval between saves of the main buffers working set.",
+							"If set to zero, the working set is saved only on shutdown.",
+							&prewarm_interval,
+							300,
+							0,
+							INT_MAX / 1000,
+							PGC_POSTMASTER,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("orioledb.prewarm_workers",
+							"Number of workers loading the saved working set on startup.",
+							NULL,
+							&prewarm_num_workers,
+							2,
+							1,
+							MAX_BACKENDS,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("orioledb.compress_offload_pages",
+							"Number of page images checkpointer may queue for compression by background writers.",
+							NULL,
+							&compress_offload_pages,
+							64,
+							0,
+							1024,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomIntVariable("orioledb.max_io_concurrency",
 							"Number of maximum concurrent IO operations.",
 							NULL,
@@ -572,6 +739,89 @@ _PG_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomEnumVariable("orioledb.io_method",
+							 "Method used to issue batched writeback of data files.",
+							 "\"io_uring\" submits writeback ranges of a file in batches.  It is only available when built with USE_IO_URING=1.",
+							 &orioledb_io_method,
+							 OIOMethodSync,
+							 io_method_options,
+							 PGC_POSTMASTER,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomEnumVariable("orioledb.huge_pages",
+							 "Use of huge pages for page pools and undo buffers.",
+							 "When not \"off\", the buffers are mapped separately from the main shared memory segment.",
+							 &orioledb_huge_pages,
+							 OHugePagesOff,
+							 huge_pages_options,
+							 PGC_POSTMASTER,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("orioledb.huge_page_size",
+							"The size of huge pages for page pools and undo buffers.",
+							"Zero means the size used for the main shared memory segment.",
+							&orioledb_huge_page_size,
+							0,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("orioledb.prefault_buffers",
+							 "Faults in page pools and undo buffers memory at startup.",
+							 "The buffers are mapped separately from the main shared memory segment.",
+							 &orioledb_prefault_buffers,
+							 false,
+							 PGC_POSTMASTER,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("orioledb.numa_aware_pools",
+							 "Splits page pools into per-NUMA-node partitions.",
+							 "Only effective when built with USE_NUMA=1.",
+							 &numa_aware_pools,
+							 false,
+							 PGC_POSTMASTER,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("orioledb.scan_resistant_eviction",
+							 "Makes pages read by sequential scans the first candidates for eviction.",
+							 NULL,
+							 &scan_resistant_eviction,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("orioledb.seqscan_readahead",
+							"Number of on-disk leaf pages prefetched ahead by sequential scans.",
+							NULL,
+							&seqscan_readahead,
+							32,
+							0,
+							1024,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable("orioledb.use_mmap",
 							 "Store data in the mmap'ed file.",
 							 NULL,
@@ -856,6 +1106,19 @@ _PG_init(void)
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable("orioledb.adaptive_hash_max_entries",
+							"Maximal number of entries in the adaptive hash index of each B-tree.",
+							"Zero disables the adaptive hash index.",
+							&adaptive_hash_max_entries,
+							0,
+							0,
+							1024 * 1024,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable("orioledb.strict_mode",
 							 "Always throw an explicit error when a feature is not supported.",
 							 NULL,
@@ -963,7 +1226,18 @@ _PG_init(void)
 
 	/* Register background writers */
 	for (i = 0; i < bgwriter_num_workers; i++)
-		register_bgwriter();
+		register_bgwriter(i);
+
+	/* Register workers taking the trees from checkpointer */
+	for (i = 0; i < checkpoint_num_workers; i++)
+		register_checkpoint_worker(i);
+
+	/* Register workers loading the saved working set */
+	if (prewarm_enabled)
+	{
+		for (i = 0; i < prewarm_num_workers; i++)
+			register_prewarm_worker(i);
+	}
 
 	if (enable_rewind)
 		register_rewind_worker();
@@ -994,6 +1268,7 @@ _PG_init(void)
 
 	o_tableam_descr_init();
 	o_compress_init();
+	fastpath_init_array_search();
 	o_sys_caches_init();
 	RegisterCustomScanMethods(&o_scan_methods);
 
@@ -1123,7 +1398,8 @@ ppools_shmem_needs(void)
 
 	for (i = 0; i < OPagePoolTypesCount; i++)
 		size = add_size(size, page_pools_size[i]);
-	size = add_size(size, orioledb_buffers_size);
+	if (!o_mem_region_enabled())
+		size = add_size(size, orioledb_buffers_size);
 	size = add_size(size, page_descs_size);
 	return size;
 }
@@ -1139,8 +1415,15 @@ ppools_shmem_init(Pointer ptr, bool found)
 		page_pools_ptr[i] = ptr;
 		ptr += page_pools_size[i];
 	}
-	o_shared_buffers = ptr;
-	ptr += orioledb_buffers_size;
+	if (o_mem_region_enabled())
+	{
+		o_shared_buffers = o_mem_region_get(OMemRegionPagePools);
+	}
+	else
+	{
+		o_shared_buffers = ptr;
+		ptr += orioledb_buffers_size;
+	}
 	page_descs = (OrioleDBPageDesc *) ptr;
 
 	for (i = 0; i < OPagePoolTypesCount; i++)
@@ -1167,6 +1450,7 @@ ppools_shmem_init(Pointer ptr, bool found)
 			page_descs[i].ionum = -1;
 			page_descs[i].type = 0;
 			page_descs[i].flags = 0;
+			pg_atomic_init_u32(&page_descs[i].dirtyChkpNum, 0);
 		}
 	}
 }
@@ -1238,12 +1522,24 @@ orioledb_shmem_startup(void)
 									 &found);
 	ptr = shared_segment;
 
+	if (!found && o_mem_region_enabled())
+	{
+		Size		regionSizes[OMemRegionItemsCount];
+
+		regionSizes[OMemRegionPagePools] = orioledb_buffers_size;
+		regionSizes[OMemRegionUndo] = undo_circular_buffers_size();
+		o_mem_region_map(regionSizes);
+	}
+
 	for (i = 0; i < count; i++)
 	{
 		shmemItems[i].shmem_init(ptr, found);
 		ptr += CACHELINEALIGN(shmemItems[i].shmem_size());
 	}
 
+	if (!found)
+		o_mem_region_prefault();
+
 	init_btree_io_lwlocks();
 	o_btree_init_unique_lwlocks();
 
@@ -1465,8 +1761,8 @@ pg_mkdir_p(char *path, int omode)
 Datum
 orioledb_page_stats(PG_FUNCTION_ARGS)
 {
-	Datum		values[5];
-	bool		nulls[5];
+	Datum		values[7];
+	bool		nulls[7];
 	int			i;
 	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
 	TupleDesc	tupdesc;
@@ -1512,12 +1808,280 @@ orioledb_page_stats(PG_FUNCTION_ARGS)
 		values[2] = Int64GetDatum(num_free_pages);
 		values[3] = Int64GetDatum((int64) ppool_dirty_pages_count(&page_pools[i]));
 		values[4] = Int64GetDatum(total_num_pages);
+
+		/*
+		 * Size of memory pages backing the pool and the number of TLB
+		 * entries needed to cover it.  Unknown when the pool is within the
+		 * main shared memory segment.
+		 */
+		if (o_mem_region_enabled())
+		{
+			Size		pageSize = o_mem_region_page_size();
+			Size		poolSize = (Size) total_num_pages * ORIOLEDB_BLCKSZ;
+
+			values[5] = Int64GetDatum((int64) pageSize);
+			values[6] = Int64GetDatum((int64) ((poolSize + pageSize - 1) / pageSize));
+			nulls[5] = nulls[6] = false;
+		}
+		else
+			nulls[5] = nulls[6] = true;
 		tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
 	}
 
 	return (Datum) 0;
 }
 
+/*
+ * Returns the state of the adaptive checkpoint pacing: the target write rate
+ * in pages per second last computed by the checkpoint writers (zero if
+ * unthrottled), the writeback batch size in blocks and the average writeback
+ * latency in milliseconds.
+ */
+Datum
+orioledb_checkpoint_pacing(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[3];
+	bool		nulls[3] = {false};
+
+	orioledb_check_shmem();
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	values[0] = Float8GetDatum((double) pg_atomic_read_u64(&checkpoint_state->pacingTargetRate));
+	values[1] = Int32GetDatum((int32) pg_atomic_read_u32(&checkpoint_state->pacingBatch));
+	values[2] = Float8GetDatum((double) pg_atomic_read_u64(&checkpoint_state->pacingLatency) / 1000.0);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * Returns the number of in-memory subtrees checkpoints skipped instead of
+ * walking them since the startup.
+ */
+Datum
+orioledb_checkpoint_skipped_subtrees(PG_FUNCTION_ARGS)
+{
+	orioledb_check_shmem();
+
+	PG_RETURN_INT64((int64) pg_atomic_read_u64(&checkpoint_state->skippedSubtrees));
+}
+
+/*
+ * Returns the number of page images put to the compressed tier, and the
+ * number of page loads served from the tier or missed it.
+ */
+Datum
+orioledb_compressed_tier_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[3];
+	bool		nulls[3] = {false};
+	uint64		puts,
+				hits,
+				misses;
+
+	orioledb_check_shmem();
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	o_compressed_tier_get_stats(&puts, &hits, &misses);
+	values[0] = Int64GetDatum((int64) puts);
+	values[1] = Int64GetDatum((int64) hits);
+	values[2] = Int64GetDatum((int64) misses);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+typedef struct
+{
+	ORelOids	oids;
+	int64		pages;
+	int64		dirtyPages;
+	int64		usageSum;
+	int			maxLevel;
+	int64		levelPages[ORIOLEDB_MAX_DEPTH];
+} OTreeStats;
+
+/*
+ * Reads the page churn counters from the meta page of the tree.  Returns
+ * false if the tree isn't loaded into the shared memory.  The meta page might
+ * be concurrently freed and reused, so the counters are accepted only if the
+ * root page still belongs to the same tree after reading them.
+ */
+static bool
+get_tree_events(ORelOids oids, uint64 *events, TimestampTz *since)
+{
+	SharedRootInfoKey key;
+	SharedRootInfo *shared;
+	BTreeMetaPage *meta;
+	OrioleDBPageDesc *root_desc;
+	bool		result = false;
+	int			i;
+
+	key.datoid = oids.datoid;
+	key.relnode = oids.relnode;
+	shared = o_find_shared_root_info(&key);
+	if (shared == NULL)
+		return false;
+
+	if (!shared->placeholder)
+	{
+		root_desc = O_GET_IN_MEMORY_PAGEDESC(shared->rootInfo.rootPageBlkno);
+		if (ORelOidsIsEqual(root_desc->oids, oids))
+		{
+			meta = (BTreeMetaPage *) O_GET_IN_MEMORY_PAGE(shared->rootInfo.metaPageBlkno);
+			for (i = 0; i < BTreeEventsCount; i++)
+				events[i] = pg_atomic_read_u64(&meta->numEvents[i]);
+			*since = meta->statsSince;
+			pg_read_barrier();
+			result = ORelOidsIsEqual(root_desc->oids, oids);
+		}
+	}
+	pfree(shared);
+
+	return result;
+}
+
+/*
+ * Returns the residency of each tree in the main page pool together with its
+ * page churn statistics.
+ */
+Datum
+orioledb_get_tree_stats(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	OPagePool  *pool = get_ppool(OPagePoolMain);
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	HASHCTL		ctl;
+	HTAB	   *trees;
+	HASH_SEQ_STATUS status;
+	OTreeStats *entry;
+	OInMemoryBlkno blkno;
+	TimestampTz now;
+	uint32		epoch;
+
+	orioledb_check_shmem();
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(ORelOids);
+	ctl.entrysize = sizeof(OTreeStats);
+	ctl.hcxt = CurrentMemoryContext;
+	trees = hash_create("orioledb tree stats", 64, &ctl,
+						HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	epoch = pg_atomic_read_u32(pool->ucm.epoch);
+	for (blkno = pool->offset; blkno < pool->offset + pool->size; blkno++)
+	{
+		OrioleDBPageDesc *page_desc = O_GET_IN_MEMORY_PAGEDESC(blkno);
+		ORelOids	oids = *((volatile ORelOids *) &page_desc->oids);
+		Page		p = O_GET_IN_MEMORY_PAGE(blkno);
+		uint32		usageCount;
+		int			level;
+		bool		found;
+
+		if (!ORelOidsIsValid(oids))
+			continue;
+
+		entry = (OTreeStats *) hash_search(trees, &oids, HASH_ENTER, &found);
+		if (!found)
+		{
+			entry->pages = 0;
+			entry->dirtyPages = 0;
+			entry->usageSum = 0;
+			entry->maxLevel = 0;
+			memset(entry->levelPages, 0, sizeof(entry->levelPages));
+		}
+		entry->pages++;
+		if (IS_DIRTY(blkno))
+			entry->dirtyPages++;
+
+		/* Page header is read without lock, so sanitize the values */
+		level = PAGE_GET_LEVEL(p);
+		level = Min(Max(level, 0), ORIOLEDB_MAX_DEPTH - 1);
+		entry->levelPages[level]++;
+		entry->maxLevel = Max(entry->maxLevel, level);
+
+		usageCount = O_PAGE_STATE_GET_USAGE_COUNT(pg_atomic_read_u64(&O_PAGE_HEADER(p)->state));
+		if (usageCount < UCM_USAGE_LEVELS)
+			entry->usageSum += (usageCount + UCM_USAGE_LEVELS - epoch) % UCM_USAGE_LEVELS;
+	}
+
+	now = GetCurrentTimestamp();
+	hash_seq_init(&status, trees);
+	while ((entry = (OTreeStats *) hash_seq_search(&status)) != NULL)
+	{
+		Datum		values[13];
+		bool		nulls[13] = {false};
+		Datum		levels[ORIOLEDB_MAX_DEPTH];
+		uint64		events[BTreeEventsCount];
+		TimestampTz since;
+		int			i;
+
+		values[0] = ObjectIdGetDatum(entry->oids.datoid);
+		values[1] = ObjectIdGetDatum(entry->oids.reloid);
+		values[2] = ObjectIdGetDatum(entry->oids.relnode);
+		values[3] = Int64GetDatum(entry->pages);
+		for (i = 0; i <= entry->maxLevel; i++)
+			levels[i] = Int64GetDatum(entry->levelPages[i]);
+		values[4] = PointerGetDatum(construct_array(levels, entry->maxLevel + 1,
+													INT8OID, sizeof(int64),
+													FLOAT8PASSBYVAL,
+													TYPALIGN_DOUBLE));
+		values[5] = Int64GetDatum(entry->dirtyPages);
+		values[6] = Float8GetDatum((double) entry->usageSum / entry->pages);
+
+		if (get_tree_events(entry->oids, events, &since))
+		{
+			double		secs = (double) (now - since) / USECS_PER_SEC;
+
+			values[7] = Int64GetDatum((int64) events[BTreeEventLoad]);
+			values[8] = Int64GetDatum((int64) events[BTreeEventEviction]);
+			values[9] = Int64GetDatum((int64) events[BTreeEventSplit]);
+			values[10] = Int64GetDatum((int64) events[BTreeEventMerge]);
+			if (secs > 0)
+			{
+				values[11] = Float8GetDatum(events[BTreeEventLoad] / secs);
+				values[12] = Float8GetDatum(events[BTreeEventEviction] / secs);
+			}
+			else
+				nulls[11] = nulls[12] = true;
+		}
+		else
+		{
+			for (i = 7; i < 13; i++)
+				nulls[i] = true;
+		}
+
+		tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc,
+							 values, nulls);
+	}
+	hash_destroy(trees);
+
+	return (Datum) 0;
+}
+
 Datum
 orioledb_ucm_check(PG_FUNCTION_ARGS)
 {
@@ -1695,6 +2259,8 @@ orioledb_error_cleanup_hook(void)
 		release_undo_size((UndoLogType) i);
 	btree_mark_incomplete_splits();
 	unset_skip_ucm();
+	unset_ucm_scan_mode();
+	ppool_ring_reset();
 	btree_io_error_cleanup();
 	o_reset_syscache_hooks();
 	o_ddl_cleanup();
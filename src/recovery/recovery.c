@@ -1772,6 +1772,7 @@ replay_erase_bridge_item(OIndexDescr *bridge, ItemPointer iptr)
 	page_block_reads(item->blkno);
 	page_locator_delete_item(p, &item->locator);
 	MARK_DIRTY(&bridge->desc, item->blkno);
+	btree_find_context_mark_dirty(&context);
 	END_CRIT_SECTION();
 	unlock_page(context.items[context.index].blkno);
 }
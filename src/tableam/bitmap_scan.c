@@ -54,6 +54,16 @@ typedef struct OBitmapScan
 	BitmapSeqScanArg arg;
 } OBitmapScan;
 
+/* Number of primary tuples fetched at once by a bitmap index scan */
+#define O_BITMAP_PRIMARY_BATCH_SIZE 64
+
+typedef struct OBitmapPrimaryBatch
+{
+	int			n;
+	OTuple		tuples[O_BITMAP_PRIMARY_BATCH_SIZE];
+	OBTreeKeyBound bounds[O_BITMAP_PRIMARY_BATCH_SIZE];
+} OBitmapPrimaryBatch;
+
 static bool o_bitmap_is_range_valid(OTuple low, OTuple high, void *arg);
 static bool o_bitmap_get_next_key(OFixedKey *key, bool inclusive, void *arg);
 
@@ -170,6 +180,66 @@ primary_tuple_get_data(OTuple tuple, OIndexDescr *primary, bool onlyPkey)
 	return val_get_uint64(val, attr->atttypid);
 }
 
+static int
+o_bitmap_primary_bound_cmp(const void *a, const void *b, void *arg)
+{
+	BTreeDescr *desc = (BTreeDescr *) arg;
+
+	return o_btree_cmp(desc, *((void **) a), BTreeKeyBound,
+					   *((void **) b), BTreeKeyBound);
+}
+
+/*
+ * Fetches primary tuples for the batch of secondary index tuples and adds
+ * their bridge ctids to the bitmap.  Keys are sorted first, so the lookups
+ * share the descent in o_btree_find_tuples_by_keys().
+ */
+static void
+o_bitmap_fetch_primary_batch(OTableDescr *descr, OSnapshot *oSnapshot,
+							 MemoryContext mcxt, OBitmapPrimaryBatch *batch,
+							 TIDBitmap *tbm_result)
+{
+	OIndexDescr *primary = GET_PRIMARY(descr);
+	TupleDesc	tupdesc = primary->leafTupdesc;
+	OTupleFixedFormatSpec *spec = &primary->leafSpec;
+	AttrNumber	attnum = primary->primaryIsCtid ? 2 : 1;
+	void	   *keys[O_BITMAP_PRIMARY_BATCH_SIZE];
+	OTuple		results[O_BITMAP_PRIMARY_BATCH_SIZE];
+	int			i;
+
+	for (i = 0; i < batch->n; i++)
+		keys[i] = &batch->bounds[i];
+	qsort_arg(keys, batch->n, sizeof(void *),
+			  o_bitmap_primary_bound_cmp, &primary->desc);
+
+	o_btree_load_shmem(&primary->desc);
+	o_btree_find_tuples_by_keys(&primary->desc, keys, batch->n,
+								BTreeKeyBound, oSnapshot, mcxt,
+								results, NULL);
+
+	for (i = 0; i < batch->n; i++)
+	{
+		Datum		val;
+		bool		is_null;
+
+		/*
+		 * in concurrent DELETE/UPDATE it might happen, we should to try fetch
+		 * next tuple
+		 */
+		if (O_TUPLE_IS_NULL(results[i]))
+			continue;
+
+		val = o_toast_nocachegetattr(results[i], attnum, tupdesc, spec, &is_null);
+		Assert(!is_null);
+		tbm_add_tuples(tbm_result, DatumGetItemPointer(val), 1, false);
+		pfree(results[i].data);
+	}
+
+	for (i = 0; i < batch->n; i++)
+		pfree(batch->tuples[i].data);
+	batch->n = 0;
+}
+
 static double
 o_index_getbitmap(OBitmapHeapPlanState *bitmap_state,
 				  BitmapIndexScanState *node,
@@ -187,6 +257,7 @@ o_index_getbitmap(OBitmapHeapPlanState *bitmap_state,
 	MemoryContext mcxt = bitmap_state->scan->ss->ss_ScanTupleSlot->tts_mcxt;
 	double		nTuples = 0;
 	OEACallsCounters *prev_ea_counters = ea_counters;
+	OBitmapPrimaryBatch *batch = NULL;
 
 	bitmap_state->o_plan_state.plan_state = &node->ss.ps;
 
@@ -277,39 +348,18 @@ o_index_getbitmap(OBitmapHeapPlanState *bitmap_state,
 			{
 				if (indexDescr->desc.type != oIndexPrimary)
 				{
-					OBTreeKeyBound bound;
-					OTuple		ptup;
-					OIndexDescr *primary = GET_PRIMARY(descr);
-					AttrNumber	attnum;
-					Datum		val;
-					bool		is_null;
-					TupleDesc	tupdesc = primary->leafTupdesc;
-					OTupleFixedFormatSpec *spec = &primary->leafSpec;
-					ItemPointer bridge_iptr;
-
-					/* fetch primary index key from tuple and search raw tuple */
-					o_fill_pindex_tuple_key_bound(&indexDescr->desc, tuple, &bound);
-
-					o_btree_load_shmem(&primary->desc);
-					ptup = o_btree_find_tuple_by_key(&primary->desc,
-													 (Pointer) &bound, BTreeKeyBound,
-													 &ostate.oSnapshot, NULL,
-													 mcxt, NULL);
-
 					/*
-					 * in concurrent DELETE/UPDATE it might happen, we should
-					 * to try fetch next tuple
+					 * Primary tuples are fetched in batches sorted by primary
+					 * key, see o_bitmap_fetch_primary_batch().
 					 */
-					if (!O_TUPLE_IS_NULL(ptup))
-					{
-						attnum = primary->primaryIsCtid ? 2 : 1;
-						val = o_toast_nocachegetattr(ptup, attnum, tupdesc, spec, &is_null);
-						Assert(!is_null);
-						bridge_iptr = DatumGetItemPointer(val);
-						tbm_add_tuples(tbm_result, bridge_iptr, 1, false);
-						pfree(tuple.data);
-						tuple = ptup;
-					}
+					if (!batch)
+						batch = (OBitmapPrimaryBatch *) palloc(sizeof(OBitmapPrimaryBatch));
+					o_fill_pindex_tuple_key_bound(&indexDescr->desc, tuple,
+												  &batch->bounds[batch->n]);
+					batch->tuples[batch->n++] = tuple;
+					if (batch->n == O_BITMAP_PRIMARY_BATCH_SIZE)
+						o_bitmap_fetch_primary_batch(descr, &ostate.oSnapshot,
+													 mcxt, batch, tbm_result);
 				}
 				else
 				{
@@ -320,6 +370,14 @@ o_index_getbitmap(OBitmapHeapPlanState *bitmap_state,
 		}
 	} while (!O_TUPLE_IS_NULL(tuple));
 
+	if (batch)
+	{
+		if (batch->n > 0)
+			o_bitmap_fetch_primary_batch(descr, &ostate.oSnapshot, mcxt,
+										 batch, tbm_result);
+		pfree(batch);
+	}
+
 	if (ostate.iterator)
 		btree_iterator_free(ostate.iterator);
 	MemoryContextReset(ostate.cxt);
@@ -15,6 +15,7 @@
 
 #include "orioledb.h"
 
+#include "btree/adaptive_hash.h"
 #include "btree/io.h"
 #include "btree/iterator.h"
 #include "btree/modify.h"
@@ -68,6 +69,7 @@ static void recreate_index_descr(OIndexDescr *descr);
 
 PG_FUNCTION_INFO_V1(orioledb_get_table_descrs);
 PG_FUNCTION_INFO_V1(orioledb_get_index_descrs);
+PG_FUNCTION_INFO_V1(orioledb_get_adaptive_hash_stats);
 PG_FUNCTION_INFO_V1(orioledb_get_evicted_trees);
 
 struct OComparatorKey
@@ -90,6 +92,12 @@ struct OComparator
 	MemoryContext ssup_cxt;
 	void	   *ssup_extra;
 	int			(*ssup_comparator) (Datum x, Datum y, SortSupport ssup);
+
+	/* Filled when haveAbbrev == true */
+	bool		haveAbbrev;
+	void	   *abbrev_extra;
+	Datum		(*abbrev_converter) (Datum original, SortSupport ssup);
+	int			(*abbrev_comparator) (Datum x, Datum y, SortSupport ssup);
 };
 
 static HTAB *oTableDescrHash;
@@ -521,6 +529,7 @@ index_descr_free(OIndexDescr *tree)
 	{
 		MemoryContextDelete(tree->index_mctx);
 	}
+	btree_ahi_free(&tree->desc);
 	checkpointable_tree_free(&tree->desc);
 }
 
@@ -1286,6 +1295,33 @@ o_find_opclass_comparator(OOpclass *opclass, Oid collation)
 			comparator.ssup_extra = ssup.ssup_extra;
 			comparator.ssup_comparator = ssup.comparator;
 		}
+
+		/*
+		 * Also ask for abbreviated keys.  They are order-preserving prefixes
+		 * of the values, which the non-leaf pages search compares instead of
+		 * calling the full comparator.  See fastpath_prefix_search_items().
+		 */
+		if (comparator.haveSortSupport)
+		{
+			MemoryContext mcxt;
+
+			memset(&ssup, 0, sizeof(ssup));
+			ssup.ssup_cxt = descrCxt;
+			ssup.ssup_collation = collation;
+			ssup.abbreviate = true;
+
+			mcxt = MemoryContextSwitchTo(descrCxt);
+			FunctionCall1(&finfo, PointerGetDatum(&ssup));
+			MemoryContextSwitchTo(mcxt);
+
+			if (ssup.abbrev_converter != NULL)
+			{
+				comparator.haveAbbrev = true;
+				comparator.abbrev_extra = ssup.ssup_extra;
+				comparator.abbrev_converter = ssup.abbrev_converter;
+				comparator.abbrev_comparator = ssup.comparator;
+			}
+		}
 	}
 
 	/*
@@ -1440,6 +1476,55 @@ o_call_comparator(OComparator *comparator, Datum left, Datum right)
 	return ret;
 }
 
+bool
+o_comparator_can_abbreviate(OComparator *comparator)
+{
+	return comparator->haveAbbrev;
+}
+
+/*
+ * Converts the value into the abbreviated key.  Abbreviated keys compare the
+ * same way as the original values unless they are equal.
+ */
+Datum
+o_call_abbrev_converter(OComparator *comparator, Datum value)
+{
+	SortSupportData ssup;
+	MemoryContext mcxt;
+	Datum		result;
+
+	Assert(comparator->haveAbbrev);
+	memset(&ssup, 0, sizeof(ssup));
+	ASAN_UNPOISON_MEMORY_REGION(&ssup, sizeof(ssup));
+	ssup.ssup_cxt = comparator->ssup_cxt;
+	ssup.ssup_collation = comparator->key.collation;
+	ssup.ssup_extra = comparator->abbrev_extra;
+	ssup.abbreviate = true;
+
+	/* The converter may grow its buffers, keep them in the long-lived context */
+	mcxt = MemoryContextSwitchTo(comparator->ssup_cxt);
+	result = comparator->abbrev_converter(value, &ssup);
+	MemoryContextSwitchTo(mcxt);
+
+	return result;
+}
+
+int
+o_call_abbrev_comparator(OComparator *comparator, Datum left, Datum right)
+{
+	SortSupportData ssup;
+
+	Assert(comparator->haveAbbrev);
+	memset(&ssup, 0, sizeof(ssup));
+	ASAN_UNPOISON_MEMORY_REGION(&ssup, sizeof(ssup));
+	ssup.ssup_cxt = comparator->ssup_cxt;
+	ssup.ssup_collation = comparator->key.collation;
+	ssup.ssup_extra = comparator->abbrev_extra;
+	ssup.abbreviate = true;
+
+	return comparator->abbrev_comparator(left, right, &ssup);
+}
+
 /* Info needed to use an old-style comparison function as a sort comparator */
 typedef struct
 {
@@ -1679,6 +1764,59 @@ orioledb_get_index_descrs(PG_FUNCTION_ARGS)
 	return (Datum) 0;
 }
 
+/*
+ * Returns the statistics of adaptive hash indexes of the current backend.
+ */
+Datum
+orioledb_get_adaptive_hash_stats(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	HASH_SEQ_STATUS scan_status;
+	OIndexDescr *indexDescr;
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	hash_seq_init(&scan_status, oIndexDescrHash);
+	while ((indexDescr = (OIndexDescr *) hash_seq_search(&scan_status)) != NULL)
+	{
+		Datum		values[6];
+		bool		nulls[6] = {false};
+		uint32		nentries;
+		uint64		hits;
+		uint64		misses;
+
+		if (!indexDescr->desc.ahi)
+			continue;
+
+		btree_ahi_get_stats(&indexDescr->desc, &nentries, &hits, &misses);
+		values[0] = indexDescr->oids.datoid;
+		values[1] = indexDescr->oids.reloid;
+		values[2] = indexDescr->oids.relnode;
+		values[3] = Int32GetDatum(nentries);
+		values[4] = Int64GetDatum(hits);
+		values[5] = Int64GetDatum(misses);
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	return (Datum) 0;
+}
+
 void
 o_invalidate_undo_item_callback(UndoLogType undoType, UndoLocation location,
 								UndoStackItem *baseItem,
@@ -21,6 +21,7 @@
 #include "btree/io.h"
 #include "btree/iterator.h"
 #include "btree/page_chunks.h"
+#include "btree/page_contents.h"
 #include "catalog/indices.h"
 #include "tableam/descr.h"
 #include "tableam/handler.h"
@@ -50,6 +51,9 @@ PG_FUNCTION_INFO_V1(orioledb_tbl_bin_structure);
 PG_FUNCTION_INFO_V1(orioledb_tbl_check);
 PG_FUNCTION_INFO_V1(orioledb_compression_max_level);
 PG_FUNCTION_INFO_V1(orioledb_tbl_compression_check);
+PG_FUNCTION_INFO_V1(orioledb_tbl_train_compress_dict);
+PG_FUNCTION_INFO_V1(orioledb_tbl_compact);
+PG_FUNCTION_INFO_V1(orioledb_tbl_compact_pending);
 PG_FUNCTION_INFO_V1(orioledb_tbl_indices);
 PG_FUNCTION_INFO_V1(orioledb_relation_size);
 PG_FUNCTION_INFO_V1(orioledb_tbl_are_indices_equal);
@@ -1418,6 +1422,240 @@ index_description(StringInfo buf, OIndexDescr *ct, bool primary, bool oids)
 	appendStringInfo(buf, "\n");
 }
 
+/* Total size of the samples used to train the compression dictionary */
+#define COMPRESS_DICT_SAMPLES_SIZE	(100 * O_COMPRESS_DICT_MAX_SIZE)
+
+/*
+ * Trains the new compression dictionary on the tuples of the tree.  Tuples
+ * are grouped into samples of the page size, so that the dictionary learns
+ * the contents of the typical page.  Returns false if the tree doesn't have
+ * enough data for training.
+ */
+static bool
+train_tree_compress_dict(BTreeDescr *desc)
+{
+	BTreeIterator *iter;
+	Pointer		samples,
+				dict;
+	size_t	   *sampleSizes;
+	size_t		samplesSize = 0,
+				dictSize = 0;
+	int			nsamples = 0,
+				maxSamples = COMPRESS_DICT_SAMPLES_SIZE / ORIOLEDB_BLCKSZ;
+	uint64		curDict,
+				newDict;
+
+	o_btree_load_shmem(desc);
+
+	samples = palloc(COMPRESS_DICT_SAMPLES_SIZE);
+	sampleSizes = palloc0(sizeof(size_t) * maxSamples);
+
+	iter = o_btree_iterator_create(desc, NULL, BTreeKeyNone,
+								   &o_in_progress_snapshot,
+								   ForwardScanDirection);
+	while (nsamples < maxSamples)
+	{
+		OTuple		tuple;
+		int			len;
+
+		tuple = o_btree_iterator_fetch(iter, NULL, NULL, BTreeKeyNone,
+									   true, NULL);
+		if (O_TUPLE_IS_NULL(tuple))
+			break;
+
+		len = Min(o_btree_len(desc, tuple, OTupleLength), ORIOLEDB_BLCKSZ);
+		if (sampleSizes[nsamples] + len > ORIOLEDB_BLCKSZ)
+			nsamples++;
+		if (nsamples < maxSamples)
+		{
+			memcpy(samples + samplesSize, tuple.data, len);
+			samplesSize += len;
+			sampleSizes[nsamples] += len;
+		}
+		pfree(tuple.data);
+	}
+	if (nsamples < maxSamples && sampleSizes[nsamples] > 0)
+		nsamples++;
+	btree_iterator_free(iter);
+
+	dict = palloc(O_COMPRESS_DICT_MAX_SIZE);
+	if (nsamples > 0)
+		dictSize = o_compress_train_dict(samples, sampleSizes, nsamples,
+										 dict, O_COMPRESS_DICT_MAX_SIZE);
+	pfree(samples);
+	pfree(sampleSizes);
+
+	if (dictSize == 0)
+	{
+		pfree(dict);
+		return false;
+	}
+
+	/*
+	 * The dictionary file is durable before it's published, so pages
+	 * referencing it can't be written earlier.
+	 */
+	curDict = pg_atomic_read_u64(&BTREE_GET_META(desc)->compressDict);
+	newDict = o_compress_save_dict(desc->oids.datoid, desc->oids.relnode,
+								   O_COMPRESS_DICT_GET_NUM(curDict) + 1,
+								   dict, dictSize);
+	o_btree_load_shmem(desc);
+	pg_atomic_write_u64(&BTREE_GET_META(desc)->compressDict, newDict);
+	pfree(dict);
+
+	return true;
+}
+
+/*
+ * Trains new compression dictionaries for the compressed trees of the table.
+ * Pages written after that are compressed using the new dictionaries.
+ * Returns the number of trees, which got the new dictionary.
+ */
+Datum
+orioledb_tbl_train_compress_dict(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	Relation	rel;
+	OTableDescr *descr;
+	int			i,
+				result = 0;
+
+	orioledb_check_shmem();
+
+	if (orioledb_s3_mode)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("compression dictionaries are not supported in S3 mode")));
+
+	/* Prevents concurrent training of the same table */
+	rel = relation_open(relid, ShareUpdateExclusiveLock);
+	descr = relation_get_descr(rel);
+
+	if (!descr)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("relation oid %u is not orioledb", relid)));
+
+	for (i = 0; i <= descr->nIndices; i++)
+	{
+		BTreeDescr *td;
+
+		if (i < descr->nIndices)
+			td = &descr->indices[i]->desc;
+		else
+			td = &descr->toast->desc;
+
+		/* LZ4 doesn't use dictionaries */
+		if (OCompressIsValid(td->compress) && !OCompressIsLZ4(td->compress) &&
+			train_tree_compress_dict(td))
+			result++;
+	}
+	relation_close(rel, ShareUpdateExclusiveLock);
+
+	PG_RETURN_INT32(result);
+}
+
+/*
+ * Requests compaction of the table trees: subsequent checkpoints copy the
+ * on-disk leaves to the end of the data file in the key order, at most
+ * orioledb.compaction_pages_per_checkpoint leaves per checkpoint.  The request
+ * is held in the tree meta page, so it's lost once the tree is evicted.
+ * Returns the number of trees requested.
+ */
+Datum
+orioledb_tbl_compact(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	Relation	rel;
+	OTableDescr *descr;
+	int			i,
+				result = 0;
+
+	orioledb_check_shmem();
+
+	if (orioledb_s3_mode || use_device)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("compaction is not supported in S3 and device modes")));
+
+	rel = relation_open(relid, AccessShareLock);
+	descr = relation_get_descr(rel);
+
+	if (!descr)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("relation oid %u is not orioledb", relid)));
+
+	for (i = 0; i <= descr->nIndices; i++)
+	{
+		BTreeDescr *td;
+		BTreeMetaPage *meta;
+
+		if (i < descr->nIndices)
+			td = &descr->indices[i]->desc;
+		else
+			td = &descr->toast->desc;
+
+		if (td->storageType != BTreeStoragePersistence)
+			continue;
+
+		o_btree_load_shmem(td);
+		meta = BTREE_GET_META(td);
+
+		/* zero means no request */
+		if (pg_atomic_add_fetch_u32(&meta->compactRequest, 1) == 0)
+			pg_atomic_add_fetch_u32(&meta->compactRequest, 1);
+		result++;
+	}
+	relation_close(rel, AccessShareLock);
+
+	PG_RETURN_INT32(result);
+}
+
+/*
+ * Returns the number of the relation trees, which have the compaction request
+ * not yet served by checkpoints.
+ */
+Datum
+orioledb_tbl_compact_pending(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	Relation	rel;
+	OTableDescr *descr;
+	int			i,
+				result = 0;
+
+	orioledb_check_shmem();
+
+	rel = relation_open(relid, AccessShareLock);
+	descr = relation_get_descr(rel);
+
+	if (!descr)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("relation oid %u is not orioledb", relid)));
+
+	for (i = 0; i <= descr->nIndices; i++)
+	{
+		BTreeDescr *td;
+
+		if (i < descr->nIndices)
+			td = &descr->indices[i]->desc;
+		else
+			td = &descr->toast->desc;
+
+		if (td->storageType != BTreeStoragePersistence)
+			continue;
+
+		o_btree_load_shmem(td);
+		if (pg_atomic_read_u32(&BTREE_GET_META(td)->compactRequest) != 0)
+			result++;
+	}
+	relation_close(rel, AccessShareLock);
+
+	PG_RETURN_INT32(result);
+}
+
 Datum
 orioledb_tbl_indices(PG_FUNCTION_ARGS)
 {
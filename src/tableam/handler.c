@@ -1660,10 +1660,18 @@ static void
 orioledb_multi_insert(Relation relation, TupleTableSlot **slots, int ntuples,
 					  CommandId cid, int options, BulkInsertState bistate)
 {
-	int			i;
+	OTableDescr *descr;
+	OSnapshot	oSnapshot;
+	OXid		oxid;
+
+	if (OidIsValid(relation->rd_rel->relrewrite))
+		return;
+
+	o_set_current_command(cid);
 
-	for (i = 0; i < ntuples; i++)
-		orioledb_tuple_insert(relation, slots[i], cid, options, bistate);
+	descr = relation_get_descr(relation);
+	fill_current_oxid_osnapshot(&oxid, &oSnapshot);
+	o_tbl_multi_insert(descr, relation, slots, ntuples, oxid, oSnapshot.csn);
 }
 
 static void
@@ -2156,6 +2164,17 @@ orioledb_default_reloptions(Datum reloptions, bool validate, relopt_kind kind)
 								 false,
 								 offsetof(ORelOptions,
 										  index_bridging));
+		add_local_int_reloption(&relopts, "memory_quota",
+								"Soft limit of the main page pool memory "
+								"used by each table tree, in megabytes, "
+								"or 0 for no limit",
+								0, 0, INT_MAX / 1024,
+								offsetof(ORelOptions, memory_quota));
+		add_local_bool_reloption(&relopts, "memory_pin",
+								 "Protects the table pages from eviction "
+								 "within the memory quota",
+								 false,
+								 offsetof(ORelOptions, memory_pin));
 		MemoryContextSwitchTo(oldcxt);
 		relopts_set = true;
 	}
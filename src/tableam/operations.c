@@ -61,6 +61,13 @@ static OTableModifyResult o_tbl_indices_delete(OTableDescr *descr,
 											   OXid oxid, CommitSeqNo csn,
 											   BTreeLocationHint *hint,
 											   OModifyCallbackArg *arg);
+static OBTreeModifyResult o_tbl_index_insert_hinted(OTableDescr *descr,
+													OIndexDescr *id,
+													OTuple *own_tup,
+													TupleTableSlot *slot,
+													OXid oxid, CommitSeqNo csn,
+													BTreeModifyCallbackInfo *callbackInfo,
+													BTreeLocationHint *hint);
 static void o_toast_insert_values(Relation rel, OTableDescr *descr,
 								  TupleTableSlot *slot, OXid oxid, CommitSeqNo csn);
 static inline bool o_callback_is_modified(OXid oxid, CommitSeqNo csn, OTupleXactInfo xactInfo);
@@ -266,9 +273,10 @@ delete_old_bridge_index_ctid(OTableDescr *descr, Relation relation,
 							   tss_orioledb_print_idx_key(bridge_slot, descr->bridge))));
 }
 
-TupleTableSlot *
-o_tbl_insert(OTableDescr *descr, Relation relation,
-			 TupleTableSlot *slot, OXid oxid, CommitSeqNo csn)
+static TupleTableSlot *
+o_tbl_insert_internal(OTableDescr *descr, Relation relation,
+					  TupleTableSlot *slot, OXid oxid, CommitSeqNo csn,
+					  BTreeLocationHint *hint)
 {
 	OTableModifyResult mres;
 	OTuple		tup;
@@ -309,8 +317,9 @@ o_tbl_insert(OTableDescr *descr, Relation relation,
 								RelationGetRelationName(relation),
 								false);
 
-	mres.success = (o_tbl_index_insert(descr, descr->indices[0], NULL, slot,
-									   oxid, csn, &callbackInfo) == OBTreeModifyResultInserted);
+	mres.success = (o_tbl_index_insert_hinted(descr, descr->indices[0], NULL,
+											  slot, oxid, csn, &callbackInfo,
+											  hint) == OBTreeModifyResultInserted);
 	if (!mres.success)
 	{
 		mres.failedIxNum = 0;
@@ -332,6 +341,84 @@ o_tbl_insert(OTableDescr *descr, Relation relation,
 	return slot;
 }
 
+TupleTableSlot *
+o_tbl_insert(OTableDescr *descr, Relation relation,
+			 TupleTableSlot *slot, OXid oxid, CommitSeqNo csn)
+{
+	return o_tbl_insert_internal(descr, relation, slot, oxid, csn, NULL);
+}
+
+typedef struct
+{
+	TupleTableSlot *slot;
+	int			index;
+	OBTreeKeyBound key;
+} OMultiInsertItem;
+
+static int
+o_multi_insert_item_cmp(const void *a, const void *b, void *arg)
+{
+	const OMultiInsertItem *item1 = (const OMultiInsertItem *) a;
+	const OMultiInsertItem *item2 = (const OMultiInsertItem *) b;
+	int			cmp;
+
+	cmp = o_btree_cmp((BTreeDescr *) arg,
+					  (Pointer) &item1->key, BTreeKeyBound,
+					  (Pointer) &item2->key, BTreeKeyBound);
+	if (cmp != 0)
+		return cmp;
+
+	/* Keep the original order of the duplicates */
+	return (item1->index < item2->index) ? -1 :
+		((item1->index > item2->index) ? 1 : 0);
+}
+
+/*
+ * Inserts the batch of tuples into the table.  Tuples are inserted in the
+ * primary key order, so that consecutive tuples usually fall into the same
+ * leaf page, and the location of this page is passed from one insertion to
+ * the next instead of descending from the root each time.
+ *
+ * Tables with ctid primary key get monotonically increasing ctids, so the
+ * original order is already the key order there.
+ */
+void
+o_tbl_multi_insert(OTableDescr *descr, Relation relation,
+				   TupleTableSlot **slots, int ntuples,
+				   OXid oxid, CommitSeqNo csn)
+{
+	OIndexDescr *primary = GET_PRIMARY(descr);
+	BTreeLocationHint hint = {OInvalidInMemoryBlkno, InvalidOPageChangeCount};
+	int			i;
+
+	if (ntuples > 1 && !primary->primaryIsCtid)
+	{
+		OMultiInsertItem *items;
+
+		items = (OMultiInsertItem *) palloc(sizeof(OMultiInsertItem) * ntuples);
+		for (i = 0; i < ntuples; i++)
+		{
+			items[i].slot = slots[i];
+			items[i].index = i;
+			tts_orioledb_fill_key_bound(slots[i], primary, &items[i].key);
+		}
+
+		o_btree_load_shmem(&primary->desc);
+		qsort_arg(items, ntuples, sizeof(OMultiInsertItem),
+				  o_multi_insert_item_cmp, &primary->desc);
+
+		for (i = 0; i < ntuples; i++)
+			o_tbl_insert_internal(descr, relation, items[i].slot,
+								  oxid, csn, &hint);
+		pfree(items);
+	}
+	else
+	{
+		for (i = 0; i < ntuples; i++)
+			o_tbl_insert_internal(descr, relation, slots[i], oxid, csn, &hint);
+	}
+}
+
 static RowLockMode
 tuple_lock_mode_to_row_lock_mode(LockTupleMode mode)
 {
@@ -1381,6 +1468,24 @@ o_tbl_index_insert(OTableDescr *descr,
 				   TupleTableSlot *slot,
 				   OXid oxid, CommitSeqNo csn,
 				   BTreeModifyCallbackInfo *callbackInfo)
+{
+	return o_tbl_index_insert_hinted(descr, id, own_tup, slot, oxid, csn,
+									 callbackInfo, NULL);
+}
+
+/*
+ * Same as o_tbl_index_insert(), but for the primary index takes the location
+ * hint of the leaf page used by the previous tuple of the sorted batch and
+ * updates it for the next one.
+ */
+static OBTreeModifyResult
+o_tbl_index_insert_hinted(OTableDescr *descr,
+						  OIndexDescr *id,
+						  OTuple *own_tup,
+						  TupleTableSlot *slot,
+						  OXid oxid, CommitSeqNo csn,
+						  BTreeModifyCallbackInfo *callbackInfo,
+						  BTreeLocationHint *hint)
 {
 	BTreeDescr *bd = &id->desc;
 	OTuple		tup;
@@ -1411,7 +1516,10 @@ o_tbl_index_insert(OTableDescr *descr,
 	}
 
 	o_btree_load_shmem(bd);
-	if (primary || !id->unique ||
+	if (primary && hint)
+		result = o_btree_insert_sorted(bd, tup, (Pointer) &knew, BTreeKeyBound,
+									   oxid, csn, hint, callbackInfo);
+	else if (primary || !id->unique ||
 		(!id->nulls_not_distinct && o_has_nulls(tup)))
 		result = o_btree_modify(bd, BTreeOperationInsert,
 								tup, BTreeKeyLeafTuple,
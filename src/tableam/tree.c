@@ -38,6 +38,8 @@
 static uint32 o_idx_hash(BTreeDescr *desc, OTuple tuple, BTreeKeyType kind);
 static uint32 o_toast_hash(BTreeDescr *desc, OTuple tuple, BTreeKeyType kind);
 static uint32 o_idx_unique_hash(BTreeDescr *desc, OTuple tuple);
+static bool o_idx_key_hash(BTreeDescr *desc, void *key, BTreeKeyType keyType,
+						   uint32 *hash);
 static int	o_idx_len(BTreeDescr *desc, OTuple tuple, OLengthType type);
 static JsonbValue *o_key_to_jsonb(BTreeDescr *desc, OTuple key,
 								  JsonbParseState **state);
@@ -61,7 +63,8 @@ static BTreeOps primaryOps = {
 	.needs_undo = pk_needs_undo,
 	.cmp = o_idx_cmp,
 	.hash = o_idx_hash,
-	.unique_hash = o_idx_unique_hash
+	.unique_hash = o_idx_unique_hash,
+	.key_hash = o_idx_key_hash
 },
 
 			secondaryOps = {
@@ -123,6 +126,7 @@ index_btree_desc_init(BTreeDescr *desc, OCompress compress, int fillfactor,
 		desc->storageType = BTreeStoragePersistence;
 	desc->undoType = UndoLogRegular;
 	desc->createOxid = createOxid;
+	desc->ahi = NULL;
 }
 
 static inline OIndexDescr *
@@ -417,6 +421,64 @@ o_toast_hash(BTreeDescr *desc, OTuple tuple, BTreeKeyType kind)
 		return 0;				/* keep compiler quiet */
 }
 
+/*
+ * Hashes the bound of all the key columns for the adaptive hash index.  Only
+ * exact values of the column types are hashed, other bounds are not used
+ * for point lookups.
+ */
+static bool
+o_idx_key_hash(BTreeDescr *desc, void *key, BTreeKeyType keyType,
+			   uint32 *hash)
+{
+	OIndexDescr *id = (OIndexDescr *) desc->arg;
+	OBTreeKeyBound *bound = (OBTreeKeyBound *) key;
+	TupleDesc	tupdesc = id->nonLeafTupdesc;
+	register uint32 result = HASH_INITIAL;
+	int			i;
+
+	if (keyType != BTreeKeyBound || bound->nkeys != tupdesc->natts)
+		return false;
+
+	for (i = 0; i < bound->nkeys; i++)
+	{
+		OBTreeValueBound *vb = &bound->keys[i];
+		Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+
+		if ((vb->flags & (O_VALUE_BOUND_NO_VALUE | O_VALUE_BOUND_DIRECTIONS)) !=
+			O_VALUE_BOUND_LOWER ||
+			!(vb->flags & O_VALUE_BOUND_INCLUSIVE) ||
+			vb->type != att->atttypid)
+			return false;
+
+		if (att->attbyval)
+		{
+			result = hash_combine_mix((Pointer) &vb->value, sizeof(Datum),
+									  result);
+		}
+		else if (att->attlen > 0)
+		{
+			result = hash_combine_mix(DatumGetPointer(vb->value), att->attlen,
+									  result);
+		}
+		else if (att->attlen == -1)
+		{
+			Pointer		val = DatumGetPointer(vb->value);
+
+			if (VARATT_IS_EXTERNAL(val) || VARATT_IS_COMPRESSED(val))
+				return false;
+			result = hash_combine_mix(VARDATA_ANY(val),
+									  VARSIZE_ANY_EXHDR(val), result);
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	*hash = hash_final(result);
+	return true;
+}
+
 /*
  * Provide hash for unique index insert.  It mixes tree oids with unique
  * fields.
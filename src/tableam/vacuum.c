@@ -891,6 +891,7 @@ lazy_vacuum_brige_index(LVRelState *vacrel)
 			page_block_reads(item->blkno);
 			page_locator_delete_item(p, &item->locator);
 			MARK_DIRTY(&bridge->desc, item->blkno);
+			btree_find_context_mark_dirty(&context);
 			END_CRIT_SECTION();
 			Assert(walBufferIndex < BTREE_PAGE_MAX_ITEMS);
 			walBuffer[walBufferIndex++] = iptr;
@@ -1330,9 +1331,13 @@ orioledb_vacuum_bridged_indexes(Relation rel, OTableDescr *descr,
 
 	/*
 	 * Call lazy_scan_heap to perform all required heap pruning, index
-	 * vacuuming, and heap vacuuming (plus related processing)
+	 * vacuuming, and heap vacuuming (plus related processing).  The bridge
+	 * index leaves are loaded through the ring, so VACUUM doesn't push the
+	 * working set out of the main pool.
 	 */
+	ppool_ring_begin();
 	lazy_scan_bridge_index(vacrel);
+	ppool_ring_end();
 
 	if (!local_wal_is_empty())
 		flush_local_wal(false, false);
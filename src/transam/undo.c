@@ -30,6 +30,7 @@
 #include "transam/oxid.h"
 #include "transam/undo.h"
 #include "utils/o_buffers.h"
+#include "utils/o_mem_region.h"
 #include "utils/page_pool.h"
 #include "utils/snapshot.h"
 #include "utils/stopevent.h"
@@ -230,14 +231,29 @@ undo_shmem_needs(void)
 
 	size = CACHELINEALIGN(sizeof(UndoMeta) * (int) UndoLogsCount);
 	size = add_size(size, CACHELINEALIGN(sizeof(PendingTruncatesMeta)));
-	size = add_size(size, o_undo_circular_sizes[UndoLogRegular]);
-	size = add_size(size, o_undo_circular_sizes[UndoLogRegularPageLevel]);
-	size = add_size(size, o_undo_circular_sizes[UndoLogSystem]);
+	if (!o_mem_region_enabled())
+		size = add_size(size, undo_circular_buffers_size());
 	size = add_size(size, o_buffers_shmem_needs(&undoBuffersDesc));
 
 	return size;
 }
 
+/*
+ * Returns the total size of undo circular buffers.  Valid after
+ * undo_shmem_needs() is called.
+ */
+Size
+undo_circular_buffers_size(void)
+{
+	Size		size = 0;
+	int			i;
+
+	for (i = 0; i < (int) UndoLogsCount; i++)
+		size = add_size(size, o_undo_circular_sizes[i]);
+
+	return size;
+}
+
 void
 undo_shmem_init(Pointer buf, bool found)
 {
@@ -250,12 +266,25 @@ undo_shmem_init(Pointer buf, bool found)
 	pending_truncates_meta = (PendingTruncatesMeta *) ptr;
 	ptr += CACHELINEALIGN(sizeof(PendingTruncatesMeta));
 
-	o_undo_buffers[UndoLogRegular] = ptr;
-	ptr += o_undo_circular_sizes[UndoLogRegular];
-	o_undo_buffers[UndoLogRegularPageLevel] = ptr;
-	ptr += o_undo_circular_sizes[UndoLogRegularPageLevel];
-	o_undo_buffers[UndoLogSystem] = ptr;
-	ptr += o_undo_circular_sizes[UndoLogSystem];
+	if (o_mem_region_enabled())
+	{
+		Pointer		regionPtr = o_mem_region_get(OMemRegionUndo);
+
+		for (i = 0; i < (int) UndoLogsCount; i++)
+		{
+			o_undo_buffers[i] = regionPtr;
+			regionPtr += o_undo_circular_sizes[i];
+		}
+	}
+	else
+	{
+		o_undo_buffers[UndoLogRegular] = ptr;
+		ptr += o_undo_circular_sizes[UndoLogRegular];
+		o_undo_buffers[UndoLogRegularPageLevel] = ptr;
+		ptr += o_undo_circular_sizes[UndoLogRegularPageLevel];
+		o_undo_buffers[UndoLogSystem] = ptr;
+		ptr += o_undo_circular_sizes[UndoLogSystem];
+	}
 
 	for (i = 0; i < (int) UndoLogsCount; i++)
 		init_undo_meta(&undo_metas[i], found);
@@ -1573,7 +1602,10 @@ undo_xact_callback(XactEvent event, void *arg)
 	ea_counters = NULL;
 
 	if (event == XACT_EVENT_COMMIT || event == XACT_EVENT_ABORT)
+	{
 		seq_scans_cleanup();
+		ppool_flush_caches();
+	}
 
 	if (enable_rewind && event == XACT_EVENT_PRE_COMMIT)
 	{
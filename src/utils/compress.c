@@ -1,7 +1,18 @@
 /*-------------------------------------------------------------------------
  *
  * compress.c
- *		Compression functions for BTree pages. Wrapper for libzstd.
+ *		Compression functions for BTree pages. Wrapper for libzstd and liblz4.
+ *
+ *	zstd is the default codec.  LZ4 gives worse ratio, but much faster
+ *	decompression, which matters when the working set barely exceeds the
+ *	main buffers.  LZ4 is available when PostgreSQL is built with lz4.
+ *
+ *	Compressed trees might have the dictionaries trained on their contents.
+ *	Dictionaries are stored in "<relnode>-<num>.dict" files next to the data
+ *	files and never change once written.  Page header contains the number of
+ *	dictionary used for the page, so retraining doesn't affect the existing
+ *	pages.  The dictionary with the highest number is used for the new page
+ *	images.
  *
  * Copyright (c) 2021-2025, Oriole DB Inc.
  * Copyright (c) 2025, Supabase Inc.
@@ -15,17 +26,48 @@
 
 #include "orioledb.h"
 
+#include "catalog/o_sys_cache.h"
 #include "utils/compress.h"
 
+#include "storage/fd.h"
 #include "utils/elog.h"
+#include "utils/hsearch.h"
 #include "utils/memdebug.h"
+#include "utils/memutils.h"
 
+#include <sys/stat.h>
+#include <unistd.h>
 #include <zstd.h>
+#include <zdict.h>
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+typedef struct
+{
+	Oid			datoid;
+	Oid			relnode;
+	uint32		num;
+} OCompressDictKey;
+
+struct OCompressDict
+{
+	OCompressDictKey key;
+	uint32		id;
+	Pointer		data;
+	size_t		size;
+	ZSTD_DDict *ddict;
+
+	/* Dictionary digested for compression with the given level */
+	ZSTD_CDict *cdict;
+	OCompress	cdictLevel;
+};
 
 static ZSTD_CCtx *zstd_cctx = NULL;
 static ZSTD_DCtx *zstd_dctx = NULL;
 static size_t zstd_dst_size;
 static Pointer zstd_dst = NULL;
+static HTAB *compressDicts = NULL;
 
 /*
  * Initializes compression context.
@@ -36,6 +78,9 @@ o_compress_init(void)
 	zstd_cctx = ZSTD_createCCtx();
 	zstd_dctx = ZSTD_createDCtx();
 	zstd_dst_size = ZSTD_compressBound(ORIOLEDB_BLCKSZ);
+#ifdef USE_LZ4
+	zstd_dst_size = Max(zstd_dst_size, LZ4_compressBound(ORIOLEDB_BLCKSZ));
+#endif
 	zstd_dst = malloc(zstd_dst_size);
 
 	/*
@@ -50,16 +95,53 @@ o_compress_init(void)
 }
 
 /*
- * Compresses a BTree page.
+ * Compresses a BTree page using the dictionary if given.  The dictionary is
+ * ignored by LZ4.
  */
 Pointer
-o_compress_page(Pointer page, size_t *size, OCompress lvl)
+o_compress_page(Pointer page, size_t *size, OCompress lvl, OCompressDict *dict)
 {
 	VALGRIND_CHECK_MEM_IS_DEFINED(page, ORIOLEDB_BLCKSZ);
-	*size = ZSTD_compressCCtx(zstd_cctx,
-							  zstd_dst, zstd_dst_size,
-							  page, ORIOLEDB_BLCKSZ,
-							  lvl);
+	if (OCompressIsLZ4(lvl))
+	{
+#ifdef USE_LZ4
+		int			result;
+
+		result = LZ4_compress_default(page, zstd_dst,
+									  ORIOLEDB_BLCKSZ, (int) zstd_dst_size);
+		if (result <= 0)
+			elog(PANIC, "Unable to compress page with LZ4");
+		*size = result;
+		VALGRIND_MAKE_MEM_DEFINED(zstd_dst, *size);
+		return zstd_dst;
+#else
+		elog(PANIC, "LZ4 compression is not supported by this build");
+#endif
+	}
+
+	if (dict)
+	{
+		if (!dict->cdict || dict->cdictLevel != lvl)
+		{
+			if (dict->cdict)
+				ZSTD_freeCDict(dict->cdict);
+			dict->cdict = ZSTD_createCDict(dict->data, dict->size, lvl);
+			if (!dict->cdict)
+				elog(PANIC, "Unable to create compression dictionary");
+			dict->cdictLevel = lvl;
+		}
+		*size = ZSTD_compress_usingCDict(zstd_cctx,
+										 zstd_dst, zstd_dst_size,
+										 page, ORIOLEDB_BLCKSZ,
+										 dict->cdict);
+	}
+	else
+	{
+		*size = ZSTD_compressCCtx(zstd_cctx,
+								  zstd_dst, zstd_dst_size,
+								  page, ORIOLEDB_BLCKSZ,
+								  lvl);
+	}
 	VALGRIND_MAKE_MEM_DEFINED(zstd_dst, *size);
 	if (ZSTD_isError(*size))
 	{
@@ -71,16 +153,41 @@ o_compress_page(Pointer page, size_t *size, OCompress lvl)
 }
 
 /*
- * Decompresses a BTree page.
+ * Decompresses a BTree page using the dictionary if given.
  */
 void
-o_decompress_page(Pointer src, size_t size, Pointer page)
+o_decompress_page(Pointer src, size_t size, Pointer page,
+				  OCompressCodec codec, OCompressDict *dict)
 {
 	size_t		result;
 
-	result = ZSTD_decompressDCtx(zstd_dctx,
-								 page, ORIOLEDB_BLCKSZ,
-								 src, size);
+	if (codec == OCompressCodecLZ4)
+	{
+#ifdef USE_LZ4
+		int			lz4Result;
+
+		lz4Result = LZ4_decompress_safe(src, page, size, ORIOLEDB_BLCKSZ);
+		if (lz4Result != ORIOLEDB_BLCKSZ)
+			elog(PANIC, "Unable to decompress LZ4 page");
+		return;
+#else
+		elog(PANIC, "LZ4 compression is not supported by this build");
+#endif
+	}
+	else if (codec != OCompressCodecZstd)
+	{
+		elog(PANIC, "Unknown page compression codec %d", codec);
+	}
+
+	if (dict)
+		result = ZSTD_decompress_usingDDict(zstd_dctx,
+											page, ORIOLEDB_BLCKSZ,
+											src, size,
+											dict->ddict);
+	else
+		result = ZSTD_decompressDCtx(zstd_dctx,
+									 page, ORIOLEDB_BLCKSZ,
+									 src, size);
 	if (ZSTD_isError(result))
 	{
 		elog(PANIC,
@@ -90,6 +197,269 @@ o_decompress_page(Pointer src, size_t size, Pointer page)
 	Assert(result == ORIOLEDB_BLCKSZ);
 }
 
+static char *
+dict_filename(Oid datoid, Oid relnode, uint32 num)
+{
+	char	   *db_prefix;
+	char	   *result;
+
+	o_get_prefixes_for_relnode(datoid, relnode, NULL, &db_prefix);
+	result = psprintf("%s/%u-%u.dict", db_prefix, relnode, num);
+	pfree(db_prefix);
+
+	return result;
+}
+
+static void
+dict_forget(OCompressDictKey *key)
+{
+	OCompressDict *dict;
+
+	if (!compressDicts)
+		return;
+
+	dict = (OCompressDict *) hash_search(compressDicts, key, HASH_FIND, NULL);
+	if (!dict)
+		return;
+
+	if (dict->cdict)
+		ZSTD_freeCDict(dict->cdict);
+	ZSTD_freeDDict(dict->ddict);
+	pfree(dict->data);
+	(void) hash_search(compressDicts, key, HASH_REMOVE, NULL);
+}
+
+/*
+ * Returns the dictionary of the tree.  The dictionary is loaded from the file
+ * unless it's already cached by the backend with the same ID.  Zero `id`
+ * means any cached dictionary with the given number fits.
+ *
+ * Returns NULL with a warning if the dictionary can't be loaded.  Callers
+ * might hold page locks or have IO in progress, so they must handle the
+ * failure by themselves rather than by error.
+ */
+OCompressDict *
+o_compress_get_dict(Oid datoid, Oid relnode, uint32 num, uint32 id)
+{
+	OCompressDictKey key;
+	OCompressDict *dict;
+	char	   *filename;
+	Pointer		data = NULL;
+	struct stat st;
+	int			fd;
+	uint32		fileId;
+	ZSTD_DDict *ddict;
+
+	Assert(num != 0);
+
+	memset(&key, 0, sizeof(key));
+	key.datoid = datoid;
+	key.relnode = relnode;
+	key.num = num;
+
+	if (!compressDicts)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(OCompressDictKey);
+		ctl.entrysize = sizeof(OCompressDict);
+		ctl.hcxt = TopMemoryContext;
+		compressDicts = hash_create("orioledb compression dictionaries", 16,
+									&ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	dict = (OCompressDict *) hash_search(compressDicts, &key, HASH_FIND, NULL);
+	if (dict && (id == 0 || dict->id == id))
+		return dict;
+	dict_forget(&key);
+
+	filename = dict_filename(datoid, relnode, num);
+	fd = OpenTransientFile(filename, O_RDONLY | PG_BINARY);
+	if (fd < 0)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", filename)));
+		goto fail;
+	}
+	if (fstat(fd, &st) < 0)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not stat file \"%s\": %m", filename)));
+		CloseTransientFile(fd);
+		goto fail;
+	}
+
+	data = MemoryContextAlloc(TopMemoryContext, st.st_size);
+	if (read(fd, data, st.st_size) != st.st_size)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not read file \"%s\": %m", filename)));
+		CloseTransientFile(fd);
+		goto fail;
+	}
+	CloseTransientFile(fd);
+
+	fileId = ZDICT_getDictID(data, st.st_size);
+	if (id != 0 && fileId != id)
+	{
+		ereport(WARNING,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("compression dictionary \"%s\" has ID %u, expected %u",
+						filename, fileId, id)));
+		goto fail;
+	}
+
+	ddict = ZSTD_createDDict(data, st.st_size);
+	if (!ddict)
+	{
+		ereport(WARNING,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("could not load compression dictionary \"%s\"",
+						filename)));
+		goto fail;
+	}
+	pfree(filename);
+
+	dict = (OCompressDict *) hash_search(compressDicts, &key, HASH_ENTER, NULL);
+	dict->id = fileId;
+	dict->data = data;
+	dict->size = st.st_size;
+	dict->ddict = ddict;
+	dict->cdict = NULL;
+	dict->cdictLevel = InvalidOCompress;
+
+	return dict;
+
+fail:
+	if (data)
+		pfree(data);
+	pfree(filename);
+	return NULL;
+}
+
+/*
+ * Finds the latest dictionary of the tree.  Dictionaries are numbered
+ * sequentially, so it's enough to probe the files one by one.  Returns the
+ * dictionary packed by O_COMPRESS_DICT_MAKE() or zero if there is none.
+ */
+uint64
+o_compress_find_latest_dict(Oid datoid, Oid relnode)
+{
+	OCompressDictKey key;
+	OCompressDict *dict;
+	uint32		num = 0;
+
+	while (true)
+	{
+		char	   *filename = dict_filename(datoid, relnode, num + 1);
+		struct stat st;
+		bool		exists;
+
+		exists = (stat(filename, &st) == 0);
+		pfree(filename);
+		if (!exists)
+			break;
+		num++;
+	}
+
+	if (num == 0)
+		return 0;
+
+	/* The cached dictionary might belong to the dropped relnode */
+	memset(&key, 0, sizeof(key));
+	key.datoid = datoid;
+	key.relnode = relnode;
+	key.num = num;
+	dict_forget(&key);
+
+	/* Pages are written without the dictionary if it can't be loaded */
+	dict = o_compress_get_dict(datoid, relnode, num, 0);
+	if (!dict)
+		return 0;
+	return O_COMPRESS_DICT_MAKE(num, dict->id);
+}
+
+/*
+ * Trains the dictionary on the given samples.  Returns the dictionary size or
+ * zero if samples aren't sufficient for training.
+ */
+size_t
+o_compress_train_dict(Pointer samples, size_t *sampleSizes, int nsamples,
+					  Pointer dict, size_t capacity)
+{
+	size_t		result;
+
+	result = ZDICT_trainFromBuffer(dict, capacity, samples, sampleSizes,
+								   nsamples);
+	if (ZDICT_isError(result))
+	{
+		elog(DEBUG1, "unable to train compression dictionary, reason: %s",
+			 ZDICT_getErrorName(result));
+		return 0;
+	}
+	return result;
+}
+
+/*
+ * Durably saves the dictionary of the tree.  Returns the dictionary packed by
+ * O_COMPRESS_DICT_MAKE().
+ */
+uint64
+o_compress_save_dict(Oid datoid, Oid relnode, uint32 num,
+					 Pointer data, size_t size)
+{
+	char	   *prefix;
+	char	   *db_prefix;
+	char	   *filename;
+	char	   *tmpFilename;
+	int			fd;
+
+	o_get_prefixes_for_relnode(datoid, relnode, &prefix, &db_prefix);
+	o_verify_dir_exists_or_create(prefix, NULL, NULL);
+	o_verify_dir_exists_or_create(db_prefix, NULL, NULL);
+	pfree(prefix);
+	pfree(db_prefix);
+
+	filename = dict_filename(datoid, relnode, num);
+	tmpFilename = psprintf("%s.tmp", filename);
+
+	fd = OpenTransientFile(tmpFilename, O_RDWR | O_CREAT | O_TRUNC | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", tmpFilename)));
+
+	errno = 0;
+	if (write(fd, data, size) != size)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", tmpFilename)));
+	}
+	if (pg_fsync(fd) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not fsync file \"%s\": %m", tmpFilename)));
+	if (CloseTransientFile(fd) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", tmpFilename)));
+
+	(void) durable_rename(tmpFilename, filename, ERROR);
+
+	pfree(tmpFilename);
+	pfree(filename);
+
+	return O_COMPRESS_DICT_MAKE(num, ZDICT_getDictID(data, size));
+}
+
 /*
  * Returns max orioledb compression level.
  */
@@ -104,6 +474,17 @@ validate_compress(OCompress compress, char *prefix)
 {
 	OCompress	max_compress = o_compress_max_lvl();
 
+	if (OCompressIsLZ4(compress))
+	{
+#ifndef USE_LZ4
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("%s compression \"lz4\" is not supported by this build",
+						prefix)));
+#endif
+		return;
+	}
+
 	if (compress < -1 || compress > max_compress)
 	{
 		elog(ERROR, "%s compression level must be between %d and %d",
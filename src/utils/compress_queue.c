@@ -0,0 +1,438 @@
+/*-------------------------------------------------------------------------
+ *
+ * compress_queue.c
+ *		Queue of page images compressed by background writers.
+ *
+ *	Checkpointer walks the tree and writes the pages one by one.  For
+ *	compressed trees it would spend most of the time compressing the leaves,
+ *	while other cores are idle.  So, checkpointer puts the images of the
+ *	dirty leaves it's going to write soon to the shared queue, and the
+ *	background writers compress them in parallel.  When the checkpointer
+ *	reaches the leaf, it takes the compressed image from the queue if the leaf
+ *	wasn't modified in between.  Otherwise, page is compressed inline as
+ *	usual, so the queue never affects what is written.
+ *
+ *	Each job has a fixed slot in the shared memory.  Job transitions are:
+ *	Free -> Filling -> Pending -> InProgress -> Done -> Free.  Pending and Done
+ *	jobs might be also freed by the reset or by the process writing the page.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/src/utils/compress_queue.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "orioledb.h"
+
+#include "utils/compress.h"
+#include "utils/compress_queue.h"
+#include "workers/bgwriter.h"
+
+#include "storage/condition_variable.h"
+#include "storage/ipc.h"
+#include "storage/spin.h"
+#include "utils/wait_event.h"
+
+typedef enum
+{
+	OCompressJobFree = 0,
+	OCompressJobFilling,
+	OCompressJobPending,
+	OCompressJobInProgress,
+	OCompressJobDone
+} OCompressJobState;
+
+typedef struct
+{
+	slock_t		lock;
+	OCompressJobState state;
+	/* Result of in-progress job isn't needed anymore */
+	bool		cancelled;
+	OInMemoryBlkno blkno;
+	Oid			datoid;
+	Oid			relnode;
+	OCompress	compress;
+	uint64		compressDict;
+	/* Compressed size, valid for done jobs */
+	size_t		size;
+	char		src[ORIOLEDB_BLCKSZ];
+	char		dst[ORIOLEDB_BLCKSZ];
+} OCompressJob;
+
+typedef struct
+{
+	/* Number of non-free jobs */
+	pg_atomic_uint32 nqueued;
+	ConditionVariable jobDoneCV;
+} OCompressQueueMeta;
+
+/*
+ * Checkpointer compares images starting from checkpointNum.  The rest of
+ * OrioleDBPageHeader is overwritten on page load.  See put_page_image().
+ */
+#define JOB_CMP_OFFSET	offsetof(OrioleDBPageHeader, checkpointNum)
+
+#define JOB_MATCHES(job) \
+	((job)->blkno == blkno && (job)->datoid == datoid && \
+	 (job)->relnode == relnode)
+
+int			compress_offload_pages = 64;
+
+static OCompressQueueMeta *compress_queue_meta = NULL;
+static OCompressJob *compress_queue_jobs = NULL;
+static int	processingJob = -1;
+static char takeBuffer[ORIOLEDB_BLCKSZ];
+
+Size
+o_compress_queue_shmem_needs(void)
+{
+	Size		size = 0;
+
+	if (compress_offload_pages == 0)
+		return size;
+
+	size = add_size(size, CACHELINEALIGN(sizeof(OCompressQueueMeta)));
+	size = add_size(size, mul_size(sizeof(OCompressJob), compress_offload_pages));
+
+	return size;
+}
+
+void
+o_compress_queue_shmem_init(Pointer ptr, bool found)
+{
+	int			i;
+
+	if (compress_offload_pages == 0)
+		return;
+
+	compress_queue_meta = (OCompressQueueMeta *) ptr;
+	ptr += CACHELINEALIGN(sizeof(OCompressQueueMeta));
+	compress_queue_jobs = (OCompressJob *) ptr;
+
+	if (!found)
+	{
+		pg_atomic_init_u32(&compress_queue_meta->nqueued, 0);
+		ConditionVariableInit(&compress_queue_meta->jobDoneCV);
+
+		for (i = 0; i < compress_offload_pages; i++)
+		{
+			SpinLockInit(&compress_queue_jobs[i].lock);
+			compress_queue_jobs[i].state = OCompressJobFree;
+			compress_queue_jobs[i].cancelled = false;
+			compress_queue_jobs[i].blkno = OInvalidInMemoryBlkno;
+		}
+	}
+}
+
+static void
+free_job(OCompressJob *job)
+{
+	job->state = OCompressJobFree;
+	job->blkno = OInvalidInMemoryBlkno;
+	pg_atomic_fetch_sub_u32(&compress_queue_meta->nqueued, 1);
+}
+
+/*
+ * Returns the number of jobs, which can be put to the queue.  Returns zero
+ * if there are no background writers to process them.
+ */
+int
+o_compress_queue_free_slots(void)
+{
+	if (!compress_queue_meta || !bgwriter_is_running())
+		return 0;
+
+	return compress_offload_pages -
+		(int) pg_atomic_read_u32(&compress_queue_meta->nqueued);
+}
+
+/*
+ * Puts the copy of the page image to the queue.  Should be called with the
+ * page locked.  Image is stored with the checkpoint number it's going to be
+ * written with.  Returns false if the queue is full.
+ */
+bool
+o_compress_queue_put(OInMemoryBlkno blkno, Oid datoid, Oid relnode,
+					 OCompress compress, uint64 compressDict,
+					 Page page, uint32 chkpNum)
+{
+	OCompressJob *job = NULL;
+	int			i;
+
+	Assert(compress_queue_meta);
+
+	for (i = 0; i < compress_offload_pages; i++)
+	{
+		OCompressJob *cur = &compress_queue_jobs[i];
+
+		/* Unlocked reads are just hints, recheck under the lock */
+		if (cur->state == OCompressJobFree)
+		{
+			if (job)
+				continue;
+			SpinLockAcquire(&cur->lock);
+			if (cur->state == OCompressJobFree)
+			{
+				cur->state = OCompressJobFilling;
+				job = cur;
+			}
+			SpinLockRelease(&cur->lock);
+		}
+		else if (cur->blkno == blkno && cur->datoid == datoid &&
+				 cur->relnode == relnode)
+		{
+			/* Already queued */
+			if (job)
+			{
+				SpinLockAcquire(&job->lock);
+				job->state = OCompressJobFree;
+				SpinLockRelease(&job->lock);
+			}
+			return true;
+		}
+	}
+
+	if (!job)
+		return false;
+
+	pg_atomic_fetch_add_u32(&compress_queue_meta->nqueued, 1);
+	job->cancelled = false;
+	job->datoid = datoid;
+	job->relnode = relnode;
+	job->compress = compress;
+	job->compressDict = compressDict;
+	job->size = 0;
+	memcpy(job->src, page, ORIOLEDB_BLCKSZ);
+	((OrioleDBPageHeader *) job->src)->checkpointNum = chkpNum;
+
+	SpinLockAcquire(&job->lock);
+	job->blkno = blkno;
+	job->state = OCompressJobPending;
+	SpinLockRelease(&job->lock);
+
+	return true;
+}
+
+/*
+ * Wakes up the background writers to process the queued jobs.
+ */
+void
+o_compress_queue_wakeup(void)
+{
+	bgwriter_wakeup_all();
+}
+
+/*
+ * Takes the compressed image of the page from the queue.  Returns NULL if
+ * there is no job for the page or it was compressed from the different image
+ * or with different parameters.  Waits for the job if it's in progress.
+ * Returned pointer is valid till the next call.
+ */
+Pointer
+o_compress_queue_take(OInMemoryBlkno blkno, Oid datoid, Oid relnode,
+					  Page page, OCompress compress, uint64 compressDict,
+					  size_t *size)
+{
+	OCompressJob *job = NULL;
+	Pointer		result = NULL;
+	bool		slept = false;
+	int			i;
+
+	if (!compress_queue_meta ||
+		pg_atomic_read_u32(&compress_queue_meta->nqueued) == 0)
+		return NULL;
+
+	for (i = 0; i < compress_offload_pages; i++)
+	{
+		OCompressJob *cur = &compress_queue_jobs[i];
+
+		if (cur->blkno == blkno && cur->datoid == datoid &&
+			cur->relnode == relnode)
+		{
+			job = cur;
+			break;
+		}
+	}
+
+	if (!job)
+		return NULL;
+
+	while (true)
+	{
+		SpinLockAcquire(&job->lock);
+		if (job->state != OCompressJobInProgress || !JOB_MATCHES(job))
+			break;
+		SpinLockRelease(&job->lock);
+		ConditionVariableSleep(&compress_queue_meta->jobDoneCV,
+							   PG_WAIT_EXTENSION);
+		slept = true;
+	}
+
+	/* The job might be already reused for another page */
+	if (!JOB_MATCHES(job))
+	{
+		SpinLockRelease(&job->lock);
+		job = NULL;
+	}
+	else if (job->state == OCompressJobPending)
+	{
+		/* It's faster to compress the page by ourselves */
+		free_job(job);
+	}
+	else if (job->state == OCompressJobDone)
+	{
+		job->state = OCompressJobFilling;
+		SpinLockRelease(&job->lock);
+
+		if (job->compress == compress &&
+			job->compressDict == compressDict &&
+			memcmp(job->src + JOB_CMP_OFFSET, page + JOB_CMP_OFFSET,
+				   ORIOLEDB_BLCKSZ - JOB_CMP_OFFSET) == 0)
+		{
+			/* Oversized result is going to be rejected by caller anyway */
+			*size = job->size;
+			if (job->size <= ORIOLEDB_BLCKSZ)
+				memcpy(takeBuffer, job->dst, job->size);
+			result = takeBuffer;
+		}
+
+		SpinLockAcquire(&job->lock);
+		free_job(job);
+	}
+	if (job)
+		SpinLockRelease(&job->lock);
+
+	if (slept)
+		ConditionVariableCancelSleep();
+
+	return result;
+}
+
+/*
+ * Forgets all the queued jobs.  In-progress jobs are freed on completion.
+ */
+void
+o_compress_queue_reset(void)
+{
+	int			i;
+
+	if (!compress_queue_meta ||
+		pg_atomic_read_u32(&compress_queue_meta->nqueued) == 0)
+		return;
+
+	for (i = 0; i < compress_offload_pages; i++)
+	{
+		OCompressJob *job = &compress_queue_jobs[i];
+
+		SpinLockAcquire(&job->lock);
+		if (job->state == OCompressJobPending ||
+			job->state == OCompressJobDone)
+			free_job(job);
+		else if (job->state == OCompressJobInProgress)
+			job->cancelled = true;
+		SpinLockRelease(&job->lock);
+	}
+}
+
+static void
+finish_job(OCompressJob *job, bool success)
+{
+	SpinLockAcquire(&job->lock);
+	Assert(job->state == OCompressJobInProgress);
+	if (job->cancelled || !success)
+		free_job(job);
+	else
+		job->state = OCompressJobDone;
+	SpinLockRelease(&job->lock);
+	ConditionVariableBroadcast(&compress_queue_meta->jobDoneCV);
+}
+
+static void
+o_compress_queue_worker_exit(int code, Datum arg)
+{
+	/* Don't leave waiters of our job forever */
+	if (processingJob >= 0)
+	{
+		finish_job(&compress_queue_jobs[processingJob], false);
+		processingJob = -1;
+	}
+}
+
+/*
+ * Registers the background writer as the queue worker.  Background writers
+ * are woken up via their registry, see bgwriter_wakeup_all().
+ */
+void
+o_compress_queue_register_worker(void)
+{
+	if (!compress_queue_meta)
+		return;
+
+	on_shmem_exit(o_compress_queue_worker_exit, (Datum) 0);
+}
+
+/*
+ * Compresses the pending jobs until the queue has no more of them.
+ */
+void
+o_compress_queue_process(void)
+{
+	bool		found = true;
+
+	if (!compress_queue_meta)
+		return;
+
+	while (found && pg_atomic_read_u32(&compress_queue_meta->nqueued) > 0)
+	{
+		int			i;
+
+		found = false;
+		for (i = 0; i < compress_offload_pages; i++)
+		{
+			OCompressJob *job = &compress_queue_jobs[i];
+			OCompressDict *dict = NULL;
+			Pointer		dst;
+			size_t		size;
+
+			if (job->state != OCompressJobPending)
+				continue;
+
+			SpinLockAcquire(&job->lock);
+			if (job->state != OCompressJobPending)
+			{
+				SpinLockRelease(&job->lock);
+				continue;
+			}
+			job->state = OCompressJobInProgress;
+			SpinLockRelease(&job->lock);
+
+			found = true;
+			processingJob = i;
+
+			/* Leave the page to be compressed inline by the writer */
+			if (job->compressDict != 0)
+			{
+				dict = o_compress_get_dict(job->datoid, job->relnode,
+										   O_COMPRESS_DICT_GET_NUM(job->compressDict),
+										   O_COMPRESS_DICT_GET_ID(job->compressDict));
+				if (!dict)
+				{
+					processingJob = -1;
+					finish_job(job, false);
+					continue;
+				}
+			}
+			dst = o_compress_page(job->src, &size, job->compress, dict);
+			job->size = size;
+			if (size <= ORIOLEDB_BLCKSZ)
+				memcpy(job->dst, dst, size);
+
+			processingJob = -1;
+			finish_job(job, true);
+		}
+	}
+}
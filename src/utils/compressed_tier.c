@@ -0,0 +1,355 @@
+/*-------------------------------------------------------------------------
+ *
+ * compressed_tier.c
+ *		Compressed in-memory tier of the pages evicted from the main pool.
+ *
+ *	When a clean page is evicted, its image is compressed and kept in the
+ *	shared arena.  When the page is loaded again, the image is taken from the
+ *	arena without any disk IO.  The arena is a circular buffer: images are
+ *	appended at the write position and the oldest ones are overwritten.  So,
+ *	no explicit eviction from the tier is needed.
+ *
+ *	Images are found by the tree and the on-disk location of the page using
+ *	set-associative table.  Each set has a few entries protected by a spinlock.
+ *	The entry is valid while its image isn't overwritten by the later ones.
+ *	Readers copy the image out of the arena, then recheck the write position.
+ *
+ *	Tier only holds the images of the clean pages, which are the same as
+ *	their on-disk images.  Every write of the page image to the disk forgets
+ *	the tier entry for the same location.  So, the datafile extent reused
+ *	for another page can't be read from the stale image.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/src/utils/compressed_tier.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "orioledb.h"
+
+#include "btree/page_contents.h"
+#include "utils/compress.h"
+#include "utils/compressed_tier.h"
+
+#include "common/hashfn.h"
+#include "storage/spin.h"
+
+/* Number of entries in the set of the table */
+#define TIER_SET_SIZE		(8)
+
+/* Expected size of the compressed image to estimate the number of sets */
+#define TIER_EXPECTED_IMAGE_SIZE	(ORIOLEDB_BLCKSZ / 4)
+
+/* Fast codec is preferred: the image is compressed on each eviction */
+#ifdef USE_LZ4
+#define TIER_COMPRESS		O_COMPRESS_LZ4
+#else
+#define TIER_COMPRESS		(1)
+#endif
+
+typedef struct
+{
+	Oid			datoid;
+	Oid			relnode;
+	/* On-disk downlink of the page, zero for the free entry */
+	uint64		downlink;
+	/* Position of the image in the arena */
+	uint64		pos;
+	uint16		size;
+	uint8		codec;
+} OCompressedTierEntry;
+
+typedef struct
+{
+	slock_t		lock;
+	OCompressedTierEntry entries[TIER_SET_SIZE];
+} OCompressedTierSet;
+
+typedef struct
+{
+	/* Arena position to write the next image, never wraps */
+	pg_atomic_uint64 writePos;
+	uint64		arenaSize;
+	uint32		nSets;
+	/* Statistics, see o_compressed_tier_get_stats() */
+	pg_atomic_uint64 puts;
+	pg_atomic_uint64 hits;
+	pg_atomic_uint64 misses;
+} OCompressedTierMeta;
+
+int			compressed_buffers_guc = 0;
+
+static OCompressedTierMeta *tier_meta = NULL;
+static OCompressedTierSet *tier_sets = NULL;
+static char *tier_arena = NULL;
+
+static Size
+tier_arena_size(void)
+{
+	return TYPEALIGN_DOWN(MAXIMUM_ALIGNOF,
+						  mul_size((Size) compressed_buffers_guc, BLCKSZ));
+}
+
+static uint32
+tier_sets_count(void)
+{
+	return Max(1, tier_arena_size() / TIER_EXPECTED_IMAGE_SIZE / TIER_SET_SIZE);
+}
+
+Size
+o_compressed_tier_shmem_needs(void)
+{
+	Size		size = 0;
+
+	if (compressed_buffers_guc == 0)
+		return size;
+
+	size = add_size(size, CACHELINEALIGN(sizeof(OCompressedTierMeta)));
+	size = add_size(size, CACHELINEALIGN(mul_size(sizeof(OCompressedTierSet),
+												  tier_sets_count())));
+	size = add_size(size, tier_arena_size());
+
+	return size;
+}
+
+void
+o_compressed_tier_shmem_init(Pointer ptr, bool found)
+{
+	uint32		i,
+				j;
+
+	if (compressed_buffers_guc == 0)
+		return;
+
+	tier_meta = (OCompressedTierMeta *) ptr;
+	ptr += CACHELINEALIGN(sizeof(OCompressedTierMeta));
+	tier_sets = (OCompressedTierSet *) ptr;
+	ptr += CACHELINEALIGN(mul_size(sizeof(OCompressedTierSet),
+								   tier_sets_count()));
+	tier_arena = ptr;
+
+	if (!found)
+	{
+		pg_atomic_init_u64(&tier_meta->writePos, 0);
+		pg_atomic_init_u64(&tier_meta->puts, 0);
+		pg_atomic_init_u64(&tier_meta->hits, 0);
+		pg_atomic_init_u64(&tier_meta->misses, 0);
+		tier_meta->arenaSize = tier_arena_size();
+		tier_meta->nSets = tier_sets_count();
+
+		for (i = 0; i < tier_meta->nSets; i++)
+		{
+			SpinLockInit(&tier_sets[i].lock);
+			for (j = 0; j < TIER_SET_SIZE; j++)
+				tier_sets[i].entries[j].downlink = 0;
+		}
+	}
+}
+
+static OCompressedTierSet *
+tier_get_set(Oid datoid, Oid relnode, uint64 offset)
+{
+	uint32		hash;
+
+	hash = hash_bytes_uint32(datoid);
+	hash = hash_combine(hash, hash_bytes_uint32(relnode));
+	hash = hash_combine(hash, hash_bytes((const unsigned char *) &offset,
+										 sizeof(offset)));
+	return &tier_sets[hash % tier_meta->nSets];
+}
+
+/*
+ * Checks if the image at the given position is not overwritten yet.
+ */
+static inline bool
+tier_image_is_valid(uint64 pos)
+{
+	return pg_atomic_read_u64(&tier_meta->writePos) <=
+		pos + tier_meta->arenaSize;
+}
+
+static void
+tier_arena_write(uint64 pos, Pointer data, Size size)
+{
+	uint64		off = pos % tier_meta->arenaSize;
+	Size		first = Min(size, tier_meta->arenaSize - off);
+
+	memcpy(tier_arena + off, data, first);
+	if (first < size)
+		memcpy(tier_arena, data + first, size - first);
+}
+
+static void
+tier_arena_read(uint64 pos, Pointer data, Size size)
+{
+	uint64		off = pos % tier_meta->arenaSize;
+	Size		first = Min(size, tier_meta->arenaSize - off);
+
+	memcpy(data, tier_arena + off, first);
+	if (first < size)
+		memcpy(data + first, tier_arena, size - first);
+}
+
+/*
+ * Puts the image of the clean page evicted from the given on-disk location.
+ */
+void
+o_compressed_tier_put(Oid datoid, Oid relnode, uint64 downlink, Page page)
+{
+	OCompressedTierSet *set;
+	OCompressedTierEntry *victim = NULL;
+	Pointer		image;
+	size_t		size;
+	uint64		pos;
+	int			i;
+
+	if (compressed_buffers_guc == 0)
+		return;
+
+	image = o_compress_page(page, &size, TIER_COMPRESS, NULL);
+
+	/* Incompressible images aren't worth the arena space */
+	if (size >= ORIOLEDB_BLCKSZ - ORIOLEDB_BLCKSZ / 8)
+		return;
+
+	pos = pg_atomic_fetch_add_u64(&tier_meta->writePos, MAXALIGN(size));
+	tier_arena_write(pos, image, size);
+	pg_write_barrier();
+
+	set = tier_get_set(datoid, relnode, DOWNLINK_GET_DISK_OFF(downlink));
+	SpinLockAcquire(&set->lock);
+	for (i = 0; i < TIER_SET_SIZE; i++)
+	{
+		OCompressedTierEntry *entry = &set->entries[i];
+
+		/* Replace the previous image of the same location */
+		if (entry->downlink != 0 &&
+			entry->datoid == datoid && entry->relnode == relnode &&
+			DOWNLINK_GET_DISK_OFF(entry->downlink) == DOWNLINK_GET_DISK_OFF(downlink))
+		{
+			victim = entry;
+			break;
+		}
+
+		/* Otherwise, take the free entry or the oldest one */
+		if (entry->downlink != 0 && !tier_image_is_valid(entry->pos))
+			entry->downlink = 0;
+		if (!victim ||
+			(victim->downlink != 0 &&
+			 (entry->downlink == 0 || entry->pos < victim->pos)))
+			victim = entry;
+	}
+	victim->datoid = datoid;
+	victim->relnode = relnode;
+	victim->downlink = downlink;
+	victim->pos = pos;
+	victim->size = size;
+	victim->codec = O_COMPRESS_CODEC(TIER_COMPRESS);
+	SpinLockRelease(&set->lock);
+
+	pg_atomic_fetch_add_u64(&tier_meta->puts, 1);
+}
+
+/*
+ * Takes the page image for the given on-disk location from the tier.
+ * Returns false if there is no image.
+ */
+bool
+o_compressed_tier_take(Oid datoid, Oid relnode, uint64 downlink, Page page)
+{
+	OCompressedTierSet *set;
+	OCompressedTierEntry found;
+	char		buf[ORIOLEDB_BLCKSZ];
+	bool		result = false;
+	int			i;
+
+	if (compressed_buffers_guc == 0)
+		return false;
+
+	set = tier_get_set(datoid, relnode, DOWNLINK_GET_DISK_OFF(downlink));
+	SpinLockAcquire(&set->lock);
+	for (i = 0; i < TIER_SET_SIZE; i++)
+	{
+		OCompressedTierEntry *entry = &set->entries[i];
+
+		if (entry->downlink == downlink &&
+			entry->datoid == datoid && entry->relnode == relnode)
+		{
+			/* The page is going to be in the main pool */
+			found = *entry;
+			entry->downlink = 0;
+			result = true;
+			break;
+		}
+	}
+	SpinLockRelease(&set->lock);
+
+	if (result && tier_image_is_valid(found.pos))
+	{
+		tier_arena_read(found.pos, buf, found.size);
+		pg_read_barrier();
+		result = tier_image_is_valid(found.pos);
+	}
+	else
+		result = false;
+
+	if (!result)
+	{
+		pg_atomic_fetch_add_u64(&tier_meta->misses, 1);
+		return false;
+	}
+
+	o_decompress_page(buf, found.size, page, (OCompressCodec) found.codec,
+					  NULL);
+	pg_atomic_fetch_add_u64(&tier_meta->hits, 1);
+	return true;
+}
+
+/*
+ * Forgets the image for the given on-disk location, which is going to be
+ * overwritten.
+ */
+void
+o_compressed_tier_forget(Oid datoid, Oid relnode, uint64 offset)
+{
+	OCompressedTierSet *set;
+	int			i;
+
+	if (compressed_buffers_guc == 0)
+		return;
+
+	set = tier_get_set(datoid, relnode, offset);
+	SpinLockAcquire(&set->lock);
+	for (i = 0; i < TIER_SET_SIZE; i++)
+	{
+		OCompressedTierEntry *entry = &set->entries[i];
+
+		if (entry->downlink != 0 &&
+			entry->datoid == datoid && entry->relnode == relnode &&
+			DOWNLINK_GET_DISK_OFF(entry->downlink) == offset)
+			entry->downlink = 0;
+	}
+	SpinLockRelease(&set->lock);
+}
+
+/*
+ * Returns the number of images put to the tier and the number of page loads
+ * served from the tier or missed it.  All zeros when the tier is disabled.
+ */
+void
+o_compressed_tier_get_stats(uint64 *puts, uint64 *hits, uint64 *misses)
+{
+	if (compressed_buffers_guc == 0)
+	{
+		*puts = *hits = *misses = 0;
+		return;
+	}
+
+	*puts = pg_atomic_read_u64(&tier_meta->puts);
+	*hits = pg_atomic_read_u64(&tier_meta->hits);
+	*misses = pg_atomic_read_u64(&tier_meta->misses);
+}
@@ -0,0 +1,278 @@
+/*-------------------------------------------------------------------------
+ *
+ * o_io_uring.c
+ * 		io_uring-based batched writeback of data file ranges.
+ *
+ *	Each backend lazily sets up its own ring on the first use.  Writeback
+ *	requests are submitted in batches of the ring depth and the caller waits
+ *	for all of them to complete.  If the ring can't be initialized, the
+ *	submission or the wait for completions fails, requests are performed
+ *	synchronously, so the caller never has to care about the I/O method in
+ *	use.
+ *
+ *	Only writeback is batched.  Page reads and writes stay synchronous: page
+ *	writes have to complete before the downlink is updated, and leaf reads
+ *	already overlap through the prefetch of scans and batched lookups.
+ *
+ *	io_uring support is only compiled in when building with USE_IO_URING=1.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/src/utils/o_io_uring.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <fcntl.h>
+
+#include "orioledb.h"
+
+#include "utils/o_io_uring.h"
+
+#include "pgstat.h"
+#include "storage/ipc.h"
+
+#ifdef ORIOLEDB_USE_IO_URING
+#include <liburing.h>
+#endif
+
+int			orioledb_io_method = OIOMethodSync;
+
+/*
+ * Performs the single writeback request synchronously.  Returns false on
+ * error with errno set.
+ */
+static bool
+o_io_perform_sync(OIORequest *request)
+{
+#if defined(HAVE_SYNC_FILE_RANGE)
+	int			rc;
+
+	do
+	{
+		rc = sync_file_range(request->fd, request->offset,
+							 request->amount, SYNC_FILE_RANGE_WRITE);
+	} while (rc < 0 && errno == EINTR);
+
+	return rc == 0;
+#else
+	return true;
+#endif
+}
+
+/*
+ * Performs the writeback requests synchronously.  Returns false with errno
+ * set if any of requests failed.
+ */
+static bool
+o_io_perform_sync_all(OIORequest *requests, int nrequests)
+{
+	bool		result = true;
+	int			save_errno = 0;
+	int			i;
+
+	for (i = 0; i < nrequests; i++)
+	{
+		if (!o_io_perform_sync(&requests[i]))
+		{
+			save_errno = errno;
+			result = false;
+		}
+	}
+
+	errno = save_errno;
+	return result;
+}
+
+#ifdef ORIOLEDB_USE_IO_URING
+
+static struct io_uring ring;
+static bool ringInitialized = false;
+static bool ringFailed = false;
+static int	ringDepth = 0;
+
+static void
+o_io_uring_shutdown(int code, Datum arg)
+{
+	if (ringInitialized)
+	{
+		io_uring_queue_exit(&ring);
+		ringInitialized = false;
+	}
+}
+
+static bool
+o_io_uring_init(void)
+{
+	int			rc;
+
+	if (ringInitialized)
+		return true;
+	if (ringFailed)
+		return false;
+
+	ringDepth = max_io_concurrency > 0 ? Min(Max(max_io_concurrency, 32), 256) : 32;
+	rc = io_uring_queue_init(ringDepth, &ring, 0);
+	if (rc < 0)
+	{
+		ringFailed = true;
+		elog(LOG, "orioledb: failed to initialize io_uring, falling back to synchronous I/O: %s",
+			 strerror(-rc));
+		return false;
+	}
+	ringInitialized = true;
+	on_proc_exit(o_io_uring_shutdown, (Datum) 0);
+	return true;
+}
+
+static void
+o_io_uring_fail(const char *action, int rc)
+{
+	io_uring_queue_exit(&ring);
+	ringInitialized = false;
+	ringFailed = true;
+	elog(LOG, "orioledb: io_uring %s failed, falling back to synchronous I/O: %s",
+		 action, strerror(-rc));
+}
+
+/*
+ * Submits the chunk of requests and waits for them.  Returns false with errno
+ * set if any of requests failed.
+ */
+static bool
+o_io_uring_perform_chunk(OIORequest *requests, int nrequests)
+{
+	bool		result = true;
+	int			save_errno = 0;
+	int			i;
+	int			rc;
+
+	for (i = 0; i < nrequests; i++)
+	{
+		struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+		OIORequest *request = &requests[i];
+
+		Assert(sqe != NULL);
+		io_uring_prep_sync_file_range(sqe, request->fd, request->amount,
+									  request->offset, SYNC_FILE_RANGE_WRITE);
+	}
+
+	do
+	{
+		rc = io_uring_submit_and_wait(&ring, nrequests);
+	} while (rc == -EINTR);
+
+	if (rc < 0)
+	{
+		o_io_uring_fail("submission", rc);
+		return o_io_perform_sync_all(requests, nrequests);
+	}
+
+	for (i = 0; i < nrequests; i++)
+	{
+		struct io_uring_cqe *cqe;
+		int			res;
+
+		do
+		{
+			rc = io_uring_wait_cqe(&ring, &cqe);
+		} while (rc == -EINTR);
+
+		/*
+		 * Completions don't follow the submission order, so we don't know
+		 * which requests are done.  Writeback is only a hint, so just repeat
+		 * them all synchronously.
+		 */
+		if (rc < 0)
+		{
+			o_io_uring_fail("completion wait", rc);
+			return o_io_perform_sync_all(requests, nrequests);
+		}
+
+		res = cqe->res;
+		io_uring_cqe_seen(&ring, cqe);
+
+		if (res < 0)
+		{
+			save_errno = -res;
+			result = false;
+		}
+	}
+
+	errno = save_errno;
+	return result;
+}
+
+bool
+o_io_uring_enabled(void)
+{
+	return orioledb_io_method == OIOMethodIoUring && !ringFailed;
+}
+
+/*
+ * Performs the given writeback requests.  Returns false with errno set if any
+ * of requests failed.
+ */
+bool
+o_io_uring_writeback(OIORequest *requests, int nrequests,
+					 uint32 wait_event_info)
+{
+	bool		result = true;
+	int			save_errno = 0;
+	int			i;
+
+	pgstat_report_wait_start(wait_event_info);
+	for (i = 0; i < nrequests;)
+	{
+		int			n;
+
+		if (!o_io_uring_init())
+		{
+			if (!o_io_perform_sync(&requests[i]))
+			{
+				save_errno = errno;
+				result = false;
+			}
+			i++;
+			continue;
+		}
+
+		n = Min(nrequests - i, ringDepth);
+		if (!o_io_uring_perform_chunk(&requests[i], n))
+		{
+			save_errno = errno;
+			result = false;
+		}
+		i += n;
+	}
+	pgstat_report_wait_end();
+
+	errno = save_errno;
+	return result;
+}
+
+#else							/* !ORIOLEDB_USE_IO_URING */
+
+bool
+o_io_uring_enabled(void)
+{
+	return false;
+}
+
+bool
+o_io_uring_writeback(OIORequest *requests, int nrequests,
+					 uint32 wait_event_info)
+{
+	bool		result;
+
+	pgstat_report_wait_start(wait_event_info);
+	result = o_io_perform_sync_all(requests, nrequests);
+	pgstat_report_wait_end();
+
+	return result;
+}
+
+#endif							/* ORIOLEDB_USE_IO_URING */
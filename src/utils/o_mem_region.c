@@ -0,0 +1,187 @@
+/*-------------------------------------------------------------------------
+ *
+ * o_mem_region.c
+ * 		Separately mapped region of OrioleDB buffers.
+ *
+ *	Page pools and undo circular buffers are the bulk of OrioleDB shared
+ *	memory.  When orioledb.huge_pages or orioledb.prefault_buffers is set,
+ *	they are placed into an anonymous shared mapping of their own instead of
+ *	the PostgreSQL main shared memory segment.  That allows choosing the huge
+ *	page size independently of the main segment and prefaulting the buffers
+ *	at startup, so that random page access doesn't pay for TLB misses over
+ *	4 kB pages and for first-touch page faults.
+ *
+ *	The region is mapped by postmaster and inherited by its children.  It's
+ *	kept mapped across shared memory reinitialization after a crash.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/src/utils/o_mem_region.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "orioledb.h"
+
+#include "utils/o_mem_region.h"
+
+#include "port/pg_bitutils.h"
+#include "storage/pg_shmem.h"
+
+int			orioledb_huge_pages = OHugePagesOff;
+int			orioledb_huge_page_size = 0;
+bool		orioledb_prefault_buffers = false;
+
+static Pointer regionPtr = NULL;
+static Size regionMappedSize = 0;
+static Size regionPageSize = 0;
+static Size regionOffsets[OMemRegionItemsCount + 1];
+
+/*
+ * Returns true if OrioleDB buffers are placed into the separate region.
+ */
+bool
+o_mem_region_enabled(void)
+{
+	return orioledb_huge_pages != OHugePagesOff || orioledb_prefault_buffers;
+}
+
+/*
+ * Maps the region to hold the items of given sizes.
+ */
+void
+o_mem_region_map(Size sizes[OMemRegionItemsCount])
+{
+	Pointer		ptr = MAP_FAILED;
+	Size		size = 0,
+				allocsize = 0;
+	int			i;
+
+	for (i = 0; i < (int) OMemRegionItemsCount; i++)
+	{
+		regionOffsets[i] = size;
+		size = add_size(size, CACHELINEALIGN(sizes[i]));
+	}
+	regionOffsets[OMemRegionItemsCount] = size;
+
+	/* Sizes depend on postmaster-level settings only */
+	if (regionPtr != NULL)
+	{
+		Assert(size <= regionMappedSize);
+		return;
+	}
+
+#ifdef MAP_HUGETLB
+	if (orioledb_huge_pages != OHugePagesOff)
+	{
+		Size		hugepagesize;
+		int			mmap_flags;
+
+		if (orioledb_huge_page_size != 0)
+		{
+			hugepagesize = (Size) orioledb_huge_page_size * 1024;
+			mmap_flags = MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+			mmap_flags |= pg_leftmost_one_pos64(hugepagesize) << MAP_HUGE_SHIFT;
+#endif
+		}
+		else
+			GetHugePageSize(&hugepagesize, &mmap_flags);
+
+		allocsize = TYPEALIGN(hugepagesize, size);
+		ptr = mmap(NULL, allocsize, PROT_READ | PROT_WRITE,
+				   MAP_SHARED | MAP_ANONYMOUS | mmap_flags, -1, 0);
+		if (ptr == MAP_FAILED)
+		{
+			if (orioledb_huge_pages == OHugePagesOn)
+				ereport(FATAL,
+						(errmsg("could not map OrioleDB buffers with huge pages of %zu kB: %m",
+								hugepagesize / 1024),
+						 errhint("Reserve enough huge pages of this size or set orioledb.huge_pages to \"try\".")));
+			elog(DEBUG1, "mmap(%zu) with MAP_HUGETLB failed, huge pages disabled for OrioleDB buffers: %m",
+				 allocsize);
+		}
+		else
+			regionPageSize = hugepagesize;
+	}
+#else
+	if (orioledb_huge_pages == OHugePagesOn)
+		ereport(FATAL,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("huge pages are not supported on this platform")));
+#endif
+
+	if (ptr == MAP_FAILED)
+	{
+		regionPageSize = (Size) sysconf(_SC_PAGESIZE);
+		allocsize = TYPEALIGN(regionPageSize, size);
+		ptr = mmap(NULL, allocsize, PROT_READ | PROT_WRITE,
+				   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			ereport(FATAL,
+					(errmsg("could not map OrioleDB buffers of %zu bytes: %m",
+							allocsize)));
+
+#ifdef MADV_HUGEPAGE
+		/* Fall back to transparent huge pages where the kernel allows */
+		if (orioledb_huge_pages == OHugePagesTry)
+			(void) madvise(ptr, allocsize, MADV_HUGEPAGE);
+#endif
+	}
+
+	regionPtr = ptr;
+	regionMappedSize = allocsize;
+}
+
+/*
+ * Returns the location of the item in the region.
+ */
+Pointer
+o_mem_region_get(OMemRegionItem item)
+{
+	Assert(regionPtr != NULL);
+	return regionPtr + regionOffsets[item];
+}
+
+/*
+ * Faults in all the pages of the region.  Must be called in postmaster
+ * after the region items are initialized: pages are rewritten in place.
+ */
+void
+o_mem_region_prefault(void)
+{
+	Size		offset;
+
+	if (!orioledb_prefault_buffers || regionPtr == NULL)
+		return;
+
+#ifdef MADV_POPULATE_WRITE
+	if (madvise(regionPtr, regionMappedSize, MADV_POPULATE_WRITE) == 0)
+		return;
+#endif
+
+	for (offset = 0; offset < regionMappedSize; offset += regionPageSize)
+	{
+		volatile char *p = (volatile char *) (regionPtr + offset);
+
+		*p = *p;
+	}
+}
+
+/*
+ * Returns the size of memory pages backing the region, or the system page
+ * size if the region isn't used.
+ */
+Size
+o_mem_region_page_size(void)
+{
+	if (regionPtr == NULL)
+		return (Size) sysconf(_SC_PAGESIZE);
+	return regionPageSize;
+}
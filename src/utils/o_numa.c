@@ -0,0 +1,104 @@
+/*-------------------------------------------------------------------------
+ *
+ * o_numa.c
+ * 		NUMA placement of the page pools.
+ *
+ *	When orioledb.numa_aware_pools is on, each page pool is split into one
+ *	partition per NUMA node.  Memory of a partition is placed on its node,
+ *	backends allocate and evict pages in the partition of the node they run
+ *	on, and background writers are bound to nodes.
+ *
+ *	NUMA support is only compiled in when building with USE_NUMA=1.  Without
+ *	it, or when the system has no NUMA support, there is a single node.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/src/utils/o_numa.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <unistd.h>
+
+#include "orioledb.h"
+
+#include "utils/o_mem_region.h"
+#include "utils/o_numa.h"
+
+#ifdef ORIOLEDB_USE_NUMA
+#include <numa.h>
+#include <sched.h>
+#endif
+
+bool		numa_aware_pools = false;
+
+/*
+ * Returns the number of NUMA nodes the page pools are split into.
+ */
+int
+o_numa_nodes_count(void)
+{
+#ifdef ORIOLEDB_USE_NUMA
+	if (!numa_aware_pools || numa_available() < 0)
+		return 1;
+	return numa_max_node() + 1;
+#else
+	return 1;
+#endif
+}
+
+/*
+ * Returns the NUMA node of the CPU the process currently runs on.
+ */
+int
+o_numa_current_node(void)
+{
+#ifdef ORIOLEDB_USE_NUMA
+	int			cpu,
+				node;
+
+	cpu = sched_getcpu();
+	if (cpu < 0)
+		return 0;
+	node = numa_node_of_cpu(cpu);
+	return Max(node, 0);
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Asks the kernel to place the given memory range on the NUMA node.  Should
+ * be called before the memory is touched for the first time.  Placement is
+ * a preference: when the node runs out of memory, other nodes are used.
+ */
+void
+o_numa_bind_memory(Pointer ptr, Size size, int node)
+{
+#ifdef ORIOLEDB_USE_NUMA
+	uintptr_t	pagesize = (uintptr_t) o_mem_region_page_size();
+	uintptr_t	start = TYPEALIGN(pagesize, (uintptr_t) ptr);
+	uintptr_t	end = TYPEALIGN_DOWN(pagesize, (uintptr_t) ptr + size);
+
+	if (end <= start)
+		return;
+
+	numa_set_bind_policy(0);
+	numa_tonode_memory((void *) start, end - start, node);
+#endif
+}
+
+/*
+ * Binds the current process to the CPUs of the NUMA node.
+ */
+void
+o_numa_run_on_node(int node)
+{
+#ifdef ORIOLEDB_USE_NUMA
+	if (numa_run_on_node(node) < 0)
+		elog(WARNING, "could not bind process to NUMA node %d: %m", node);
+#endif
+}
@@ -20,11 +20,89 @@
 #include "btree/undo.h"
 #include "checkpoint/checkpoint.h"
 #include "transam/undo.h"
+#include "utils/o_numa.h"
 #include "utils/page_pool.h"
 #include "utils/ucm.h"
+#include "workers/bgwriter.h"
 
+#include "storage/ipc.h"
 #include "utils/memdebug.h"
 
+/*
+ * Upper limit for the number of pages each backend keeps in its local cache
+ * of the pool.  The cache lets most of reservations and releases avoid
+ * touching the shared availablePagesCount.
+ */
+#define PPOOL_CACHE_MAX_BATCH	8
+
+/*
+ * Number of leaves a bulk reader keeps in the pool, see ppool_ring_begin().
+ * The same 256kB as PostgreSQL uses for its BAS_BULKREAD ring.
+ */
+#define PPOOL_RING_SIZE		(256 * 1024 / ORIOLEDB_BLCKSZ)
+
+/*
+ * Leaf loaded by the bulk reader.  The tree and the change count identify the
+ * page, which might be evicted and reused by others since.
+ */
+typedef struct
+{
+	OInMemoryBlkno blkno;
+	uint32		changeCount;
+	ORelOids	oids;
+	uint8		type;
+} PPoolRingItem;
+
+/* Leaves loaded by the bulk reader in the order of loading */
+static int	ringNesting = 0;
+static int	ringNext = 0;
+static PPoolRingItem ringPages[PPOOL_RING_SIZE];
+
+/* Whether ppool_cache_on_exit() is registered for this process */
+static bool cacheExitRegistered = false;
+
+static void ppool_cache_on_exit(int code, Datum arg);
+
+/*
+ * Makes sure the pages cached by this process are returned to the pools on
+ * exit.  Exit callbacks registered by the postmaster are reset in its
+ * children, so every process having a non-empty cache registers its own.
+ */
+static inline void
+ppool_cache_register_exit(OPagePool *pool)
+{
+	if (pool->numPagesCached == 0 || cacheExitRegistered || proc_exit_inprogress)
+		return;
+
+	before_shmem_exit(ppool_cache_on_exit, (Datum) 0);
+	cacheExitRegistered = true;
+}
+
+/*
+ * Returns the first page of the NUMA partition of the pool.
+ */
+static inline OInMemoryBlkno
+ppool_partition_start(OPagePool *pool, int partition)
+{
+	return pool->offset +
+		(OInMemoryBlkno) (((uint64) pool->size * partition) / pool->nPartitions);
+}
+
+/*
+ * Returns the first of NUMA partitions served by the background writer
+ * number `num`.  When there are at least as many workers as partitions,
+ * workers are spread over partitions round-robin.  Otherwise, every worker
+ * serves a contiguous range of partitions, so no partition is left without
+ * a worker.
+ */
+static inline int
+worker_first_partition(int num, int nworkers, int nPartitions)
+{
+	if (nworkers >= nPartitions)
+		return num % nPartitions;
+	return (int) (((int64) num * nPartitions) / nworkers);
+}
+
 /*
  * Calculates shared memory space needed for a page pool. Be careful,
  * it prepares local memory structures to initialize.
@@ -40,6 +118,8 @@ ppool_estimate_space(OPagePool *pool, OInMemoryBlkno offset, OInMemoryBlkno size
 	pool->offset = offset;
 	pool->size = size;
 
+	result += CACHELINEALIGN(sizeof(pg_atomic_uint64));
+	result += CACHELINEALIGN(sizeof(pg_atomic_uint32));
 	result += CACHELINEALIGN(sizeof(pg_atomic_uint64));
 	result += CACHELINEALIGN(sizeof(pg_atomic_uint32));
 
@@ -62,14 +142,55 @@ ppool_shmem_init(OPagePool *pool, Pointer ptr, bool found)
 	pool->dirtyPagesCount = (pg_atomic_uint32 *) ptr;
 	ptr += CACHELINEALIGN(sizeof(pg_atomic_uint32));
 
+	pool->allocatedPagesCount = (pg_atomic_uint64 *) ptr;
+	ptr += CACHELINEALIGN(sizeof(pg_atomic_uint64));
+
+	pool->targetFreePagesCount = (pg_atomic_uint32 *) ptr;
+	ptr += CACHELINEALIGN(sizeof(pg_atomic_uint32));
+
 	if (!found)
 	{
 		pg_atomic_init_u64(pool->availablePagesCount, pool->size);
 		pg_atomic_init_u32(pool->dirtyPagesCount, 0);
+		pg_atomic_init_u64(pool->allocatedPagesCount, 0);
+		pg_atomic_init_u32(pool->targetFreePagesCount, pool->size / 20);
 	}
 
 	init_ucm(&pool->ucm, ptr, found);
 
+	/*
+	 * Cached pages are invisible to other backends and to the eviction
+	 * trigger of background writers.  Limit their total number to a small
+	 * fraction of the pool, disabling the cache for small pools.
+	 */
+	pool->numPagesCached = 0;
+	pool->cacheBatch = Min(PPOOL_CACHE_MAX_BATCH,
+						   pool->size / ((OInMemoryBlkno) max_procs * 16));
+
+	/*
+	 * Split the pool into per-node partitions and place memory of each
+	 * partition on its node.  Pages aren't touched yet, so the kernel
+	 * allocates them according to the policy.
+	 */
+	pool->nPartitions = o_numa_nodes_count();
+	if (pool->size / pool->nPartitions < PPOOL_MIN_SIZE)
+		pool->nPartitions = 1;
+	pool->partition = 0;
+
+	if (!found && pool->nPartitions > 1)
+	{
+		int			i;
+
+		for (i = 0; i < pool->nPartitions; i++)
+		{
+			OInMemoryBlkno start = ppool_partition_start(pool, i),
+						end = ppool_partition_start(pool, i + 1);
+
+			o_numa_bind_memory(O_GET_IN_MEMORY_PAGE(start),
+							   (Size) (end - start) * ORIOLEDB_BLCKSZ, i);
+		}
+	}
+
 	pg_prng_seed(&pool->prngSeed, MyBackendId);
 	pool->location = pg_prng_uint64_range(&pool->prngSeed,
 										  pool->offset,
@@ -88,11 +209,17 @@ ppool_shmem_init(OPagePool *pool, Pointer ptr, bool found)
  *
  * This is why one should reserve enough amount of pages _before_ taking a page
  * lock, and then allocate them using ucm_occupy_free_page().
+ *
+ * Pages are taken from the backend-local cache first.  When the cache is
+ * exhausted, it's refilled from availablePagesCount in a batch, so the shared
+ * counter is touched once per several reservations.
  */
 void
 ppool_reserve_pages(OPagePool *pool, int kind, int count)
 {
 	uint64		val;
+	OInMemoryBlkno needed,
+				batch;
 
 	Assert(!have_locked_pages());
 
@@ -100,19 +227,53 @@ ppool_reserve_pages(OPagePool *pool, int kind, int count)
 	if (count <= 0)
 		return;
 
-	val = pg_atomic_sub_fetch_u64(pool->availablePagesCount, count);
+	if (pool->numPagesCached >= count)
+	{
+		pool->numPagesCached -= count;
+		pool->numPagesReserved[kind] += count;
+		return;
+	}
+
+	/* The process might have migrated to another node */
+	if (pool->nPartitions > 1)
+		pool->partition = o_numa_current_node() % pool->nPartitions;
+
+	needed = count - pool->numPagesCached;
+	batch = pool->cacheBatch;
+	val = pg_atomic_sub_fetch_u64(pool->availablePagesCount, needed + batch);
+	if ((val & (UINT64CONST(1) << 63)) ||
+		(batch > 0 && val < pool->size / 20))
+	{
+		/*
+		 * The pool is (nearly) exhausted.  Don't hoard pages in the local
+		 * cache: return the batch and take only what we need.
+		 */
+		if (batch > 0)
+			val = pg_atomic_add_fetch_u64(pool->availablePagesCount, batch);
+		batch = 0;
+	}
+	pg_atomic_fetch_add_u64(pool->allocatedPagesCount, needed + batch);
+
+	/* Let background writers catch up before we have to evict ourselves */
+	if ((val & (UINT64CONST(1) << 63)) ||
+		val < pg_atomic_read_u32(pool->targetFreePagesCount))
+		bgwriter_wakeup(pool);
+
 	while (val & (UINT64CONST(1) << 63))
 	{
 		ppool_run_clock(pool, true, NULL);
 		val = pg_atomic_read_u64(pool->availablePagesCount);
 	}
 
+	pool->numPagesCached = pool->numPagesCached + needed + batch - count;
 	pool->numPagesReserved[kind] += count;
+	ppool_cache_register_exit(pool);
 }
 
 /*
  * Release previously reserved pages according to mask (multiple kinds can be
- * released in one call).
+ * released in one call).  Released pages are kept in the backend-local cache
+ * up to twice the batch size, the excess is returned to the shared counter.
  */
 void
 ppool_release_reserved(OPagePool *pool, uint32 mask)
@@ -128,8 +289,17 @@ ppool_release_reserved(OPagePool *pool, uint32 mask)
 			pool->numPagesReserved[kind] = 0;
 		}
 	}
-	if (sum != 0)
+	if (sum == 0)
+		return;
+
+	pool->numPagesCached += sum;
+	if (pool->numPagesCached > 2 * pool->cacheBatch)
+	{
+		sum = pool->numPagesCached - pool->cacheBatch;
+		pool->numPagesCached = pool->cacheBatch;
 		pg_atomic_add_fetch_u64(pool->availablePagesCount, sum);
+	}
+	ppool_cache_register_exit(pool);
 }
 
 /*
@@ -148,6 +318,60 @@ ppool_release_all_pages(void)
 	}
 }
 
+/*
+ * Return pages cached by the backend to all the pools.  Called at the end of
+ * top-level transaction, so that idle backends don't hold cached pages, and on
+ * process exit, so that cached pages don't leak from availablePagesCount.
+ */
+void
+ppool_flush_caches(void)
+{
+	int			i;
+
+	for (i = 0; i < (int) OPagePoolTypesCount; i++)
+	{
+		OPagePool  *pool = get_ppool((OPagePoolType) i);
+
+		if (pool->numPagesCached > 0)
+		{
+			pg_atomic_add_fetch_u64(pool->availablePagesCount,
+									pool->numPagesCached);
+			pool->numPagesCached = 0;
+		}
+	}
+}
+
+static void
+ppool_cache_on_exit(int code, Datum arg)
+{
+	ppool_flush_caches();
+}
+
+/*
+ * Binds background writer number `num` to the NUMA node of the first
+ * partition it serves.  See ppool_worker_region().
+ */
+void
+ppool_bind_worker(int num)
+{
+	int			nodes = o_numa_nodes_count(),
+				node,
+				i;
+
+	if (nodes <= 1)
+		return;
+
+	node = worker_first_partition(num, bgwriter_num_workers, nodes);
+	o_numa_run_on_node(node);
+
+	for (i = 0; i < (int) OPagePoolTypesCount; i++)
+	{
+		OPagePool  *pool = get_ppool((OPagePoolType) i);
+
+		pool->partition = node % pool->nPartitions;
+	}
+}
+
 /*
  * Reserves and allocate page for metadata. Metadata pages are typically
  * allocated without holding any page locks.
@@ -172,7 +396,8 @@ ppool_get_page(OPagePool *pool, int kind)
 	Assert(pool->numPagesReserved[kind] > 0);
 	pool->numPagesReserved[kind]--;
 
-	result = ucm_occupy_free_page(&pool->ucm);
+	result = ucm_occupy_free_page(&pool->ucm,
+								  ppool_partition_start(pool, pool->partition));
 	Assert(pool->offset <= result && result < pool->offset + pool->size);
 
 	VALGRIND_CHECK_MEM_IS_DEFINED(O_GET_IN_MEMORY_PAGE(result), ORIOLEDB_BLCKSZ);
@@ -238,21 +463,23 @@ ppool_dirty_pages_count(OPagePool *pool)
 }
 
 /*
- * Run clock replacement algorithm until we evict at least one page.
+ * Undo reservations of the caller, saved while we evict pages.
  */
-void
-ppool_run_clock(OPagePool *pool, bool evict,
-				volatile sig_atomic_t *shutdown_requested)
+typedef struct
 {
-	uint64		blkno;
-	Size		undoRegularSize = get_reserved_undo_size(UndoLogRegularPageLevel);
-	Size		undoSystemSize = get_reserved_undo_size(UndoLogSystem);
-	bool		haveRetainRegularLoc = undo_type_has_retained_location(UndoLogRegularPageLevel);
-	bool		haveRetainSystemLoc = undo_type_has_retained_location(UndoLogSystem);
-
-	blkno = pg_prng_uint64_range(&pool->prngSeed,
-								 pool->offset,
-								 pool->offset + pool->size - 1);
+	Size		undoRegularSize;
+	Size		undoSystemSize;
+	bool		haveRetainRegularLoc;
+	bool		haveRetainSystemLoc;
+} EvictUndoState;
+
+static void
+evict_begin(EvictUndoState *state)
+{
+	state->undoRegularSize = get_reserved_undo_size(UndoLogRegularPageLevel);
+	state->undoSystemSize = get_reserved_undo_size(UndoLogSystem);
+	state->haveRetainRegularLoc = undo_type_has_retained_location(UndoLogRegularPageLevel);
+	state->haveRetainSystemLoc = undo_type_has_retained_location(UndoLogSystem);
 
 	/*
 	 * Shouldn't be called while holding a page lock: one should reserve the
@@ -264,9 +491,55 @@ ppool_run_clock(OPagePool *pool, bool evict,
 	reserve_undo_size(UndoLogRegularPageLevel, 2 * O_MERGE_UNDO_IMAGE_SIZE);
 	reserve_undo_size(UndoLogSystem, 2 * O_MERGE_UNDO_IMAGE_SIZE);
 
-	Assert(blkno >= pool->offset && blkno < pool->offset + pool->size);
 	/* Our attempts to evict pages shouldn't themselves affect UCM */
 	set_skip_ucm();
+}
+
+static void
+evict_end(EvictUndoState *state)
+{
+	unset_skip_ucm();
+
+	/*
+	 * The caller might have the undo location reserved.  We need to carefully
+	 * put the undo location back.
+	 */
+	if (state->undoRegularSize > 0)
+		reserve_undo_size(UndoLogRegularPageLevel, state->undoRegularSize);
+	else
+		release_undo_size(UndoLogRegularPageLevel);
+
+	if (state->undoSystemSize > 0)
+		reserve_undo_size(UndoLogSystem, state->undoSystemSize);
+	else
+		release_undo_size(UndoLogSystem);
+
+	if (!state->haveRetainRegularLoc)
+		free_retained_undo_location(UndoLogRegularPageLevel);
+	if (!state->haveRetainSystemLoc)
+		free_retained_undo_location(UndoLogSystem);
+}
+
+/*
+ * Runs clock replacement algorithm from `*hand` until we evict (or write) at
+ * least one page.  When the pool region [start, end) is given, the clock
+ * doesn't go outside it and gives up after the region is passed without
+ * result.  Returns true if a page was processed.
+ */
+static bool
+run_clock(OPagePool *pool, bool evict, OInMemoryBlkno start,
+		  OInMemoryBlkno end, uint64 *hand,
+		  volatile sig_atomic_t *shutdown_requested)
+{
+	uint64		blkno = *hand;
+	EvictUndoState undoState;
+	bool		bounded = start != pool->offset || end != pool->offset + pool->size;
+	bool		wrapped = false,
+				result = false;
+	uint64		steps = 0;
+
+	Assert(blkno >= start && blkno < end);
+	evict_begin(&undoState);
 
 	while (true)
 	{
@@ -276,35 +549,231 @@ ppool_run_clock(OPagePool *pool, bool evict,
 		blkno = ucm_next_blkno(&pool->ucm, blkno, 1);
 
 		Assert(blkno >= pool->offset && blkno < pool->offset + pool->size);
+		if (bounded && (blkno < start || blkno >= end ||
+						++steps > (uint64) (end - start)))
+		{
+			/* No candidates till the end of region, recheck its beginning */
+			if (wrapped)
+				break;
+			wrapped = true;
+			blkno = start;
+			continue;
+		}
+
 		if (walk_page(blkno, evict) != OWalkPageSkipped)
 		{
 			Assert(!have_locked_pages());
+			result = true;
 			break;
 		}
 		Assert(!have_locked_pages());
 		blkno++;
-		if (blkno >= pool->offset + pool->size)
-			blkno = pool->offset;
+		if (blkno >= end)
+			blkno = start;
 	}
 
-	unset_skip_ucm();
+	evict_end(&undoState);
 
-	/*
-	 * The caller might have the undo location reserved.  We need to carefully
-	 * put the undo location back.
-	 */
-	if (undoRegularSize > 0)
-		reserve_undo_size(UndoLogRegularPageLevel, undoRegularSize);
-	else
-		release_undo_size(UndoLogRegularPageLevel);
+	*hand = (blkno + 1 >= end) ? start : blkno + 1;
+	return result;
+}
 
-	if (undoSystemSize > 0)
-		reserve_undo_size(UndoLogSystem, undoSystemSize);
-	else
-		release_undo_size(UndoLogSystem);
+/*
+ * Run clock replacement algorithm until we evict at least one page.
+ */
+void
+ppool_run_clock(OPagePool *pool, bool evict,
+				volatile sig_atomic_t *shutdown_requested)
+{
+	uint64		blkno;
 
-	if (!haveRetainRegularLoc)
-		free_retained_undo_location(UndoLogRegularPageLevel);
-	if (!haveRetainSystemLoc)
-		free_retained_undo_location(UndoLogSystem);
+	/* Start the clock within the local partition */
+	blkno = pg_prng_uint64_range(&pool->prngSeed,
+								 ppool_partition_start(pool, pool->partition),
+								 ppool_partition_start(pool, pool->partition + 1) - 1);
+
+	(void) run_clock(pool, evict, pool->offset, pool->offset + pool->size,
+					 &blkno, shutdown_requested);
+}
+
+/*
+ * Runs the clock within the pool region owned by the background writer.
+ * The clock hand is kept between the calls.  Returns false if there is
+ * nothing to evict (or write) in the region.
+ */
+bool
+ppool_run_clock_region(OPagePool *pool, bool evict,
+					   OInMemoryBlkno start, OInMemoryBlkno end,
+					   volatile sig_atomic_t *shutdown_requested)
+{
+	uint64		hand = pool->location;
+	bool		result;
+
+	if (hand < start || hand >= end)
+		hand = start;
+
+	result = run_clock(pool, evict, start, end, &hand, shutdown_requested);
+	pool->location = hand;
+	return result;
+}
+
+/*
+ * Returns the pool region scanned by the background writer number `num`.
+ * Workers are distributed among NUMA partitions like ppool_bind_worker()
+ * does.  A partition shared by several workers is split evenly between
+ * them, a worker serving several partitions scans all of them.  So, workers
+ * never walk the same pages and every page has a worker.
+ */
+void
+ppool_worker_region(OPagePool *pool, int num, int nworkers,
+					OInMemoryBlkno *start, OInMemoryBlkno *end)
+{
+	int			partition = worker_first_partition(num, nworkers,
+												   pool->nPartitions),
+				index,
+				count;
+	OInMemoryBlkno partStart,
+				partSize;
+
+	Assert(num >= 0 && num < nworkers);
+
+	if (nworkers < pool->nPartitions)
+	{
+		*start = ppool_partition_start(pool, partition);
+		*end = ppool_partition_start(pool,
+									 worker_first_partition(num + 1, nworkers,
+															pool->nPartitions));
+		return;
+	}
+
+	index = num / pool->nPartitions;
+	count = (nworkers - partition + pool->nPartitions - 1) / pool->nPartitions;
+	partStart = ppool_partition_start(pool, partition);
+	partSize = ppool_partition_start(pool, partition + 1) - partStart;
+
+	Assert(count > 0);
+	*start = partStart + (OInMemoryBlkno) (((uint64) partSize * index) / count);
+	*end = partStart + (OInMemoryBlkno) (((uint64) partSize * (index + 1)) / count);
+}
+
+/*
+ * Returns the number of the background writer, which serves the partition of
+ * the pool local to the backend.  When the partition is split between
+ * several workers, returns the first of them.
+ */
+int
+ppool_partition_worker(OPagePool *pool, int nworkers)
+{
+	if (nworkers >= pool->nPartitions)
+		return pool->partition;
+	return (int) ((((int64) pool->partition + 1) * nworkers - 1) /
+				  pool->nPartitions);
+}
+
+/*
+ * Starts the bulk read.  Leaves loaded to the pool by the bulk reader are
+ * placed into a small ring.  When the ring is full, the next load evicts the
+ * oldest leaf of the ring.  So, the bulk reader doesn't push the working set
+ * out of the pool like PostgreSQL BufferAccessStrategy rings do.  Reads in
+ * the bulk read mode don't promote usage counts like sequential scans do.
+ */
+void
+ppool_ring_begin(void)
+{
+	int			i;
+
+	if (ringNesting++ > 0)
+		return;
+
+	for (i = 0; i < PPOOL_RING_SIZE; i++)
+		ringPages[i].blkno = OInvalidInMemoryBlkno;
+	ringNext = 0;
+	set_ucm_scan_mode();
+}
+
+void
+ppool_ring_end(void)
+{
+	Assert(ringNesting > 0);
+	if (--ringNesting == 0)
+		unset_ucm_scan_mode();
+}
+
+/*
+ * Resets the bulk read mode on error.
+ */
+void
+ppool_ring_reset(void)
+{
+	ringNesting = 0;
+}
+
+/*
+ * Remembers the leaf just loaded by the bulk reader.  Should be called with
+ * the page locked.
+ */
+void
+ppool_ring_add(OInMemoryBlkno blkno)
+{
+	OrioleDBPageDesc *page_desc = O_GET_IN_MEMORY_PAGEDESC(blkno);
+	PPoolRingItem *item;
+
+	if (ringNesting == 0)
+		return;
+
+	item = &ringPages[ringNext];
+	item->blkno = blkno;
+	item->changeCount = O_PAGE_GET_CHANGE_COUNT(O_GET_IN_MEMORY_PAGE(blkno));
+	item->oids = page_desc->oids;
+	item->type = page_desc->type;
+	ringNext = (ringNext + 1) % PPOOL_RING_SIZE;
+}
+
+/*
+ * Makes the room for the next leaf loaded by the bulk reader: evicts the
+ * oldest leaf of the ring.  The leaf is left in the pool if it was dirtied or
+ * promoted by others since, or if it was evicted and the block now holds
+ * another page.  Should be called without page locks.
+ */
+void
+ppool_ring_recycle(OPagePool *pool)
+{
+	EvictUndoState undoState;
+	PPoolRingItem *item;
+	OrioleDBPageDesc *page_desc;
+	OInMemoryBlkno blkno;
+	Page		p;
+	uint32		epoch,
+				usageCount,
+				loadCount;
+
+	if (ringNesting == 0)
+		return;
+
+	item = &ringPages[ringNext];
+	blkno = item->blkno;
+	item->blkno = OInvalidInMemoryBlkno;
+	if (!OInMemoryBlknoIsValid(blkno) ||
+		blkno < pool->offset || blkno >= pool->offset + pool->size ||
+		IS_DIRTY(blkno))
+		return;
+
+	p = O_GET_IN_MEMORY_PAGE(blkno);
+	page_desc = O_GET_IN_MEMORY_PAGEDESC(blkno);
+	if (O_PAGE_GET_CHANGE_COUNT(p) != item->changeCount ||
+		!ORelOidsIsEqual(page_desc->oids, item->oids) ||
+		page_desc->type != item->type)
+		return;
+
+	epoch = pg_atomic_read_u32(pool->ucm.epoch);
+	usageCount = O_PAGE_STATE_GET_USAGE_COUNT(pg_atomic_read_u64(&O_PAGE_HEADER(p)->state));
+	loadCount = ucm_load_usage_count(&pool->ucm, false);
+	if (usageCount >= UCM_USAGE_LEVELS ||
+		(usageCount + UCM_USAGE_LEVELS - epoch) % UCM_USAGE_LEVELS >
+		(loadCount + UCM_USAGE_LEVELS - epoch) % UCM_USAGE_LEVELS)
+		return;
+
+	evict_begin(&undoState);
+	(void) walk_page(blkno, true);
+	evict_end(&undoState);
 }
@@ -25,6 +25,13 @@
 #define UCM_LEVEL_MASK		0xF
 
 static bool skip_ucm = false;
+static bool ucm_scan_mode = false;
+
+/*
+ * Pages loaded or touched by sequential scans shouldn't push the working set
+ * of other queries out of the pool.
+ */
+bool		scan_resistant_eviction = true;
 
 static int	init_ucm_non_leaf_recursive(UsageCountMap *map, int i);
 static void ucm_inc_recursive(UsageCountMap *map, int i, int prev, int next);
@@ -254,7 +261,8 @@ page_inc_usage_count(UsageCountMap *map, OInMemoryBlkno blkno)
 
 	if (usageCount == UCM_INVALID_LEVEL ||
 		usageCount == UCM_FREE_PAGES_LEVEL ||
-		skip_ucm)
+		skip_ucm ||
+		(ucm_scan_mode && scan_resistant_eviction))
 		return;
 
 	page_inc_usage_count_internal(map, blkno, state);
@@ -277,6 +285,21 @@ page_change_usage_count(UsageCountMap *map, OInMemoryBlkno blkno, uint32 usageCo
 	ucm_inc(map, blkno - map->offset, O_PAGE_STATE_GET_USAGE_COUNT(state), usageCount);
 }
 
+/*
+ * Returns the usage count for the page just loaded to the pool.  Pages loaded
+ * by sequential scans and pages of the trees exceeding their memory quota
+ * (lowPriority) are placed one level lower than others.  So, they are evicted
+ * first unless accessed again by other queries.
+ */
+uint32
+ucm_load_usage_count(UsageCountMap *map, bool lowPriority)
+{
+	uint32		level = (lowPriority ||
+						 (ucm_scan_mode && scan_resistant_eviction)) ? 1 : 2;
+
+	return (pg_atomic_read_u32(map->epoch) + level) % UCM_USAGE_LEVELS;
+}
+
 static bool
 page_try_change_usage_count(UsageCountMap *map, OInMemoryBlkno blkno,
 							uint64 oldState, uint32 newUsageCount)
@@ -298,6 +321,25 @@ page_try_change_usage_count(UsageCountMap *map, OInMemoryBlkno blkno,
 	}
 }
 
+/*
+ * Moves the locked page to the highest usage level, so it isn't considered
+ * for eviction until the epoch makes almost a full circle.  Free and invalid
+ * pages are left as is.
+ */
+void
+ucm_protect_page(UsageCountMap *map, OInMemoryBlkno blkno)
+{
+	Page		p = O_GET_IN_MEMORY_PAGE(blkno);
+	uint64		state = pg_atomic_read_u64(&(O_PAGE_HEADER(p)->state));
+	uint32		epoch = pg_atomic_read_u32(map->epoch);
+
+	if (O_PAGE_STATE_GET_USAGE_COUNT(state) >= UCM_USAGE_LEVELS)
+		return;
+
+	(void) page_try_change_usage_count(map, blkno, state,
+									   (epoch + UCM_USAGE_LEVELS - 1) % UCM_USAGE_LEVELS);
+}
+
 static bool
 ucm_check_recursive(UsageCountMap *map, int i)
 {
@@ -524,8 +566,12 @@ retry:
 	}
 }
 
+/*
+ * Occupies a free page.  The search starts from `init_blkno`, so the page
+ * nearest to it in the map is taken.
+ */
 OInMemoryBlkno
-ucm_occupy_free_page(UsageCountMap *map)
+ucm_occupy_free_page(UsageCountMap *map, OInMemoryBlkno init_blkno)
 {
 	int64		location;
 	int64		i;
@@ -535,7 +581,7 @@ ucm_occupy_free_page(UsageCountMap *map)
 	uint32		mask;
 
 	mask = UCM_LEVEL_MASK << (UCM_FREE_PAGES_LEVEL * UCM_LEVEL_BITS);
-	location = 0;
+	location = init_blkno - map->offset;
 	factor = map->rootFactor;
 	base = 0;
 	num_iterations = 0;
@@ -604,3 +650,18 @@ unset_skip_ucm(void)
 {
 	skip_ucm = false;
 }
+
+/*
+ * Marks the following page accesses as made by a sequential scan.
+ */
+void
+set_ucm_scan_mode(void)
+{
+	ucm_scan_mode = true;
+}
+
+void
+unset_ucm_scan_mode(void)
+{
+	ucm_scan_mode = false;
+}
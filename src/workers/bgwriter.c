@@ -3,6 +3,14 @@
  * bgwriter.c
  *		Routines for background writer process.
  *
+ *	Background writers keep the free pages headroom in the page pools, so
+ *	that backends rarely have to evict pages themselves.  The headroom
+ *	follows the smoothed rate of page allocations like PostgreSQL
+ *	bgwriter does for shared buffers.  The deficit of free pages is split
+ *	between as many workers as needed, and each worker evicts pages only
+ *	from its own region of the pool.  Backends wake only the worker serving
+ *	their NUMA partition.
+ *
  * Copyright (c) 2021-2025, Oriole DB Inc.
  * Copyright (c) 2025, Supabase Inc.
  *
@@ -18,10 +26,12 @@
 #include "btree/undo.h"
 #include "s3/headers.h"
 #include "transam/undo.h"
+#include "utils/compress_queue.h"
 #include "utils/page_pool.h"
 #include "utils/ucm.h"
 #include "utils/stopevent.h"
 #include "workers/bgwriter.h"
+#include "workers/prewarm.h"
 
 #include "miscadmin.h"
 #include "postmaster/bgworker.h"
@@ -38,10 +48,217 @@
 
 #include "pgstat.h"
 
+/* Number of recent allocation samples the smoothed rate follows */
+#define BGWRITER_SMOOTHING_SAMPLES	16
+
+/* Minimal number of pages worth waking one more worker for */
+#define BGWRITER_MIN_WORKER_PAGES	16
+
+typedef struct
+{
+	/* Process numbers of the background writers, -1 if not running */
+	int			procnos[FLEXIBLE_ARRAY_MEMBER];
+} BGWriterMeta;
+
+/* Allocation rate estimate of the pool, local to the worker */
+typedef struct
+{
+	uint64		prevAllocated;
+	double		smoothedAlloc;
+} BGWriterPoolState;
+
 bool		IsBGWriter = false;
 
+static BGWriterMeta *bgwriter_meta = NULL;
+
+Size
+bgwriter_shmem_needs(void)
+{
+	return offsetof(BGWriterMeta, procnos) + sizeof(int) * bgwriter_num_workers;
+}
+
+void
+bgwriter_shmem_init(Pointer ptr, bool found)
+{
+	int			i;
+
+	bgwriter_meta = (BGWriterMeta *) ptr;
+	if (!found)
+	{
+		for (i = 0; i < bgwriter_num_workers; i++)
+			bgwriter_meta->procnos[i] = -1;
+	}
+}
+
+static void
+bgwriter_wakeup_worker(int num)
+{
+	int			procno = bgwriter_meta->procnos[num];
+
+	if (procno >= 0)
+		SetLatch(&GetPGProcByNumber(procno)->procLatch);
+}
+
+/*
+ * Wakes up the background writer serving the local partition of the pool.
+ * Called when the free pages drop below the target headroom.  The worker
+ * wakes up others sharing the partition when the deficit needs them.
+ */
 void
-register_bgwriter(void)
+bgwriter_wakeup(OPagePool *pool)
+{
+	if (!bgwriter_meta || bgwriter_num_workers == 0)
+		return;
+
+	bgwriter_wakeup_worker(ppool_partition_worker(pool, bgwriter_num_workers));
+}
+
+/*
+ * Wakes up all the background writers.
+ */
+void
+bgwriter_wakeup_all(void)
+{
+	int			i;
+
+	if (!bgwriter_meta)
+		return;
+
+	for (i = 0; i < bgwriter_num_workers; i++)
+		bgwriter_wakeup_worker(i);
+}
+
+/*
+ * Returns true if at least one background writer is running.
+ */
+bool
+bgwriter_is_running(void)
+{
+	int			i;
+
+	if (!bgwriter_meta)
+		return false;
+
+	for (i = 0; i < bgwriter_num_workers; i++)
+	{
+		if (bgwriter_meta->procnos[i] >= 0)
+			return true;
+	}
+	return false;
+}
+
+static void
+bgwriter_exit(int code, Datum arg)
+{
+	bgwriter_meta->procnos[DatumGetInt32(arg)] = -1;
+}
+
+/*
+ * Updates the allocation rate estimate and returns the number of free pages
+ * the pool should have.
+ */
+static OInMemoryBlkno
+bgwriter_target_free_pages(OPagePool *pool, BGWriterPoolState *state)
+{
+	uint64		allocated = pg_atomic_read_u64(pool->allocatedPagesCount);
+	double		recentAlloc = (double) (allocated - state->prevAllocated);
+	double		target;
+
+	state->prevAllocated = allocated;
+
+	/* Follow the rise immediately, decay slowly */
+	if (recentAlloc > state->smoothedAlloc)
+		state->smoothedAlloc = recentAlloc;
+	else
+		state->smoothedAlloc += (recentAlloc - state->smoothedAlloc) /
+			BGWRITER_SMOOTHING_SAMPLES;
+
+	target = state->smoothedAlloc * bgwriter_lru_multiplier;
+	target = Max(target, (double) (pool->size / 20));
+	target = Min(target, (double) (pool->size / 4));
+	return (OInMemoryBlkno) target;
+}
+
+/*
+ * Evicts and writes pages of the worker region of the pool.  Returns true if
+ * the worker couldn't reach the goal within its budget.
+ */
+static bool
+bgwriter_process_pool(OPagePool *pool, BGWriterPoolState *state, int num)
+{
+	OInMemoryBlkno target,
+				freePages,
+				deficit,
+				start,
+				end;
+	int			nActive,
+				share,
+				budget,
+				maxPages = Max(1, bgwriter_lru_maxpages * (BLCKSZ / ORIOLEDB_BLCKSZ)),
+				i;
+	bool		need_write,
+				behind = false;
+
+	target = bgwriter_target_free_pages(pool, state);
+	if (num == 0)
+		pg_atomic_write_u32(pool->targetFreePagesCount, target);
+
+	freePages = ppool_free_pages_count(pool);
+	deficit = freePages < target ? target - freePages : 0;
+
+	/* Wake as many workers as the deficit needs */
+	nActive = Min(bgwriter_num_workers,
+				  (deficit + BGWRITER_MIN_WORKER_PAGES - 1) / BGWRITER_MIN_WORKER_PAGES);
+	need_write = ppool_dirty_pages_count(pool) > pool->size / 2;
+
+	/*
+	 * Backends wake only the first worker of the partition, it wakes the
+	 * rest of active workers sharing the partition.
+	 */
+	if (num < pool->nPartitions)
+	{
+		for (i = num + pool->nPartitions; i < nActive; i += pool->nPartitions)
+			bgwriter_wakeup_worker(i);
+	}
+
+	if (num >= nActive && !need_write)
+		return false;
+
+	ppool_worker_region(pool, num, bgwriter_num_workers, &start, &end);
+
+	if (num < nActive)
+	{
+		share = (deficit + nActive - 1) / nActive;
+		budget = Min(share, maxPages);
+		for (i = 0; i < budget && !ShutdownRequestPending; i++)
+		{
+			if (!ppool_run_clock_region(pool, true, start, end,
+										&ShutdownRequestPending))
+				break;
+			o_compress_queue_process();
+		}
+
+		/* The region still has pages to evict, but the budget is over */
+		behind = (i == budget && budget < share);
+	}
+
+	for (i = 0; need_write && i < maxPages && !ShutdownRequestPending; i++)
+	{
+		if (!ppool_run_clock_region(pool, false, start, end,
+									&ShutdownRequestPending))
+			break;
+		o_compress_queue_process();
+		need_write = ppool_dirty_pages_count(pool) > pool->size / 2;
+	}
+
+	MemoryContextReset(CurTransactionContext);
+	MemoryContextReset(TopTransactionContext);
+
+	return behind;
+}
+
+void
+register_bgwriter(int num)
 {
 	BackgroundWorker worker;
 
@@ -50,6 +267,7 @@ register_bgwriter(void)
 	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
 	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
 	worker.bgw_restart_time = 0;
+	worker.bgw_main_arg = Int32GetDatum(num);
 	strcpy(worker.bgw_library_name, "orioledb");
 	strcpy(worker.bgw_function_name, "bgwriter_main");
 	strcpy(worker.bgw_name, "orioledb background writer");
@@ -61,10 +279,12 @@ void
 bgwriter_main(Datum main_arg)
 {
 	OPagePool  *pool;
+	BGWriterPoolState poolStates[OPagePoolTypesCount];
+	OPagePoolType poolType;
 	int			rc,
+				num = DatumGetInt32(main_arg),
 				wake_events = WL_LATCH_SET | WL_POSTMASTER_DEATH | WL_TIMEOUT;
-	bool		need_eviction,
-				need_write;
+	bool		behind = false;
 
 	/* enable timeout for relation lock */
 	RegisterTimeout(DEADLOCK_TIMEOUT, CheckDeadLockAlert);
@@ -94,6 +314,20 @@ bgwriter_main(Datum main_arg)
 		return;
 	}
 
+	bgwriter_meta->procnos[num] = MYPROCNUMBER;
+	on_shmem_exit(bgwriter_exit, Int32GetDatum(num));
+
+	/* Compress page images queued by checkpointer */
+	o_compress_queue_register_worker();
+
+	/* Run on the NUMA node whose pages we evict */
+	ppool_bind_worker(num);
+
+	memset(poolStates, 0, sizeof(poolStates));
+	for (poolType = 0; poolType < OPagePoolTypesCount; poolType++)
+		poolStates[poolType].prevAllocated =
+			pg_atomic_read_u64(get_ppool(poolType)->allocatedPagesCount);
+
 	CurTransactionContext = AllocSetContextCreate(TopMemoryContext,
 												  "orioledb bgwriter current transaction context",
 												  ALLOCSET_DEFAULT_SIZES);
@@ -108,7 +342,6 @@ bgwriter_main(Datum main_arg)
 		MemoryContextSwitchTo(CurTransactionContext);
 		while (true)
 		{
-			OPagePoolType poolType;
 			UndoLocation lastUsedLocation;
 			UndoLocation writeInProgressLocation;
 			int			j;
@@ -117,44 +350,29 @@ bgwriter_main(Datum main_arg)
 				break;
 
 			/*
-			 * Sleep until we are signaled or it's time for another
-			 * checkpoint.
+			 * Sleep until we are signaled or it's time for another round.
+			 * Don't sleep if we didn't catch up with allocations.
 			 */
-			rc = WaitLatch(MyLatch, wake_events,
-						   BgWriterDelay,
-						   WAIT_EVENT_BGWRITER_MAIN);
+			if (!behind)
+			{
+				rc = WaitLatch(MyLatch, wake_events,
+							   BgWriterDelay,
+							   WAIT_EVENT_BGWRITER_MAIN);
+
+				if (rc & WL_POSTMASTER_DEATH)
+					ShutdownRequestPending = true;
+			}
+			else
+				CHECK_FOR_INTERRUPTS();
 
-			if (rc & WL_POSTMASTER_DEATH)
-				ShutdownRequestPending = true;
+			o_compress_queue_process();
 
+			behind = false;
 			for (poolType = 0; poolType < OPagePoolTypesCount && !ShutdownRequestPending; poolType++)
 			{
 				pool = get_ppool(poolType);
-				need_eviction = ppool_free_pages_count(pool) < pool->size / 20;
-				need_write = ppool_dirty_pages_count(pool) > pool->size / 2;
-
-				if (need_eviction || need_write)
-				{
-					int			i = 0;
-
-					while (need_eviction || need_write)
-					{
-						ppool_run_clock(pool, need_eviction, &ShutdownRequestPending);
-						i++;
-
-						if (i >= bgwriter_lru_maxpages * (BLCKSZ / ORIOLEDB_BLCKSZ))
-							break;
-
-						if (ShutdownRequestPending)
-							break;
-
-						need_eviction = ppool_free_pages_count(pool) < pool->size / 20;
-						need_write = ppool_dirty_pages_count(pool) > pool->size / 2;
-					}
-
-					MemoryContextReset(CurTransactionContext);
-					MemoryContextReset(TopTransactionContext);
-				}
+				if (bgwriter_process_pool(pool, &poolStates[poolType], num))
+					behind = true;
 
 				if (!ShutdownRequestPending && ucm_epoch_needs_shift(&pool->ucm))
 				{
@@ -186,8 +404,15 @@ bgwriter_main(Datum main_arg)
 			if (orioledb_s3_mode)
 				s3_headers_try_eviction_cycle();
 
+			/* The first worker saves the working set for prewarm */
+			if (num == 0)
+				o_prewarm_dump_if_due();
+
 			ResetLatch(MyLatch);
 		}
+
+		if (num == 0)
+			o_prewarm_dump();
 		elog(LOG, "orioledb bgwriter is shut down");
 	}
 	PG_CATCH();
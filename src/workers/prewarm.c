@@ -0,0 +1,764 @@
+/*-------------------------------------------------------------------------
+ *
+ * prewarm.c
+ *		Routines for saving and restoring the working set of the main pool.
+ *
+ *	The first background writer periodically records the pages resident in
+ *	the main page pool.  Each page is recorded by its tree, level and hikey.
+ *	So, it can be found again by the regular tree descent regardless of how
+ *	the tree was checkpointed since then.  The on-disk offset of the page
+ *	image and the relative usage count of the page are recorded as well.
+ *	The pool is scanned in slices between the eviction rounds of the
+ *	background writer, and the records are written to the file in chunks.
+ *
+ *	On startup, prewarm workers read the list and load the pages from the
+ *	hottest to the coldest ones.  The list is read sequentially once per
+ *	usage level, never as a whole.  Pages are loaded in batches, and within
+ *	the batch they are sorted by tree and on-disk offset, so that reads are
+ *	mostly sequential.  Batches are distributed between workers in
+ *	round-robin.  Prewarm never evicts pages: it stops when the pool has no
+ *	free pages beyond the background writers headroom.
+ *
+ * Copyright (c) 2025, Oriole DB Inc.
+ * Copyright (c) 2025, Supabase Inc.
+ *
+ * IDENTIFICATION
+ *	  contrib/orioledb/src/workers/prewarm.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "orioledb.h"
+
+#include "btree/find.h"
+#include "btree/page_contents.h"
+#include "btree/page_state.h"
+#include "catalog/o_tables.h"
+#include "catalog/sys_trees.h"
+#include "tableam/descr.h"
+#include "utils/page_pool.h"
+#include "utils/ucm.h"
+#include "workers/prewarm.h"
+
+#include "miscadmin.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/lock.h"
+#include "storage/proc.h"
+#include "storage/sinvaladt.h"
+#include "utils/memutils.h"
+#include "utils/syscache.h"
+#include "utils/timeout.h"
+#include "utils/timestamp.h"
+
+#include "pgstat.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PREWARM_FILE_MAGIC	(0x4F505257)
+#define PREWARM_TMP_FILENAME	PREWARM_FILENAME ".tmp"
+
+/* Number of pages loaded in the locality order at once */
+#define PREWARM_BATCH_SIZE	(1024)
+
+/* Size of the buffer the list is written and read through */
+#define PREWARM_CHUNK_SIZE	(64 * ORIOLEDB_BLCKSZ)
+
+/* Number of pool pages recorded per background writer round */
+#define PREWARM_DUMP_SLICE	(16384)
+
+typedef struct
+{
+	uint32		magic;
+	uint32		count;
+} OPrewarmFileHeader;
+
+/* Page record in the file, followed by hikeyLen bytes of hikey */
+typedef struct
+{
+	ORelOids	oids;
+	uint8		type;
+	uint8		level;
+	/* Usage count relative to the UCM epoch */
+	uint8		usage;
+	uint8		hikeyFlags;
+	/* Zero for the rightmost page */
+	uint16		hikeyLen;
+	uint64		diskOff;
+} OPrewarmEntry;
+
+typedef struct
+{
+	OPrewarmEntry entry;
+	Pointer		hikey;
+} OPrewarmItem;
+
+/* State of the dump in progress */
+typedef struct
+{
+	/* Temporary file being written, -1 if there is no dump in progress */
+	int			fd;
+	/* Next page of the pool to be recorded */
+	OInMemoryBlkno next;
+	/* Number of pages recorded so far */
+	uint32		count;
+	/* Records not written to the file yet */
+	char	   *buf;
+	int			len;
+} OPrewarmDumpState;
+
+/* Sequential reader of the saved list */
+typedef struct
+{
+	int			fd;
+	uint32		count;
+	uint32		remaining;
+	off_t		fileOffset;
+	char	   *buf;
+	int			pos;
+	int			len;
+} OPrewarmReader;
+
+typedef struct
+{
+	/* Number of prewarm workers started and not finished yet */
+	pg_atomic_uint32 nWorkersRunning;
+} OPrewarmMeta;
+
+bool		prewarm_enabled = false;
+int			prewarm_interval = 300;
+int			prewarm_num_workers = 2;
+
+static OPrewarmMeta *prewarm_meta = NULL;
+static TimestampTz last_dump_time = 0;
+static OPrewarmDumpState dumpState = {-1, 0, 0, NULL, 0};
+
+Size
+prewarm_shmem_needs(void)
+{
+	return sizeof(OPrewarmMeta);
+}
+
+void
+prewarm_shmem_init(Pointer ptr, bool found)
+{
+	prewarm_meta = (OPrewarmMeta *) ptr;
+	if (!found)
+		pg_atomic_init_u32(&prewarm_meta->nWorkersRunning, 0);
+}
+
+static void
+prewarm_dump_abort(void)
+{
+	CloseTransientFile(dumpState.fd);
+	(void) unlink(PREWARM_TMP_FILENAME);
+	dumpState.fd = -1;
+}
+
+/*
+ * Writes out the accumulated part of the dump.  On failure the dump is
+ * abandoned.
+ */
+static bool
+prewarm_dump_flush(void)
+{
+	errno = 0;
+	if (write(dumpState.fd, dumpState.buf, dumpState.len) != dumpState.len)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", PREWARM_TMP_FILENAME)));
+		prewarm_dump_abort();
+		return false;
+	}
+	dumpState.len = 0;
+	return true;
+}
+
+static bool
+prewarm_dump_start(void)
+{
+	OPagePool  *pool = get_ppool(OPagePoolMain);
+	OPrewarmFileHeader header;
+
+	dumpState.fd = OpenTransientFile(PREWARM_TMP_FILENAME,
+									 O_RDWR | O_CREAT | O_TRUNC | PG_BINARY);
+	if (dumpState.fd < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", PREWARM_TMP_FILENAME)));
+		return false;
+	}
+
+	if (!dumpState.buf)
+		dumpState.buf = MemoryContextAlloc(TopMemoryContext,
+										   PREWARM_CHUNK_SIZE);
+
+	/* The count of pages is written when the dump is finished */
+	header.magic = PREWARM_FILE_MAGIC;
+	header.count = 0;
+	memcpy(dumpState.buf, &header, sizeof(header));
+	dumpState.len = sizeof(header);
+	dumpState.count = 0;
+	dumpState.next = pool->offset;
+	return true;
+}
+
+static void
+prewarm_dump_finish(void)
+{
+	OPrewarmFileHeader header;
+
+	if (dumpState.len > 0 && !prewarm_dump_flush())
+		return;
+
+	header.magic = PREWARM_FILE_MAGIC;
+	header.count = dumpState.count;
+	errno = 0;
+	if (pg_pwrite(dumpState.fd, (char *) &header, sizeof(header), 0) != sizeof(header))
+	{
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", PREWARM_TMP_FILENAME)));
+		prewarm_dump_abort();
+		return;
+	}
+	if (CloseTransientFile(dumpState.fd) != 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", PREWARM_TMP_FILENAME)));
+		dumpState.fd = -1;
+		return;
+	}
+	dumpState.fd = -1;
+
+	(void) durable_rename(PREWARM_TMP_FILENAME, PREWARM_FILENAME, LOG);
+	last_dump_time = GetCurrentTimestamp();
+}
+
+/*
+ * Records up to `maxPages` next pages of the main pool to the dump in
+ * progress.  Finishes the dump after the last page of the pool.
+ */
+static void
+prewarm_dump_step(OInMemoryBlkno maxPages)
+{
+	OPagePool  *pool = get_ppool(OPagePoolMain);
+	OInMemoryBlkno end = pool->offset + pool->size;
+	uint32		epoch;
+
+	epoch = pg_atomic_read_u32(pool->ucm.epoch);
+	end = Min(end, dumpState.next + maxPages);
+	for (; dumpState.next < end; dumpState.next++)
+	{
+		OInMemoryBlkno blkno = dumpState.next;
+		OrioleDBPageDesc *page_desc = O_GET_IN_MEMORY_PAGEDESC(blkno);
+		Page		p = O_GET_IN_MEMORY_PAGE(blkno);
+		OPrewarmEntry entry;
+		uint32		usageCount;
+		OTuple		hikey;
+
+		if (!ORelOidsIsValid(page_desc->oids) ||
+			page_desc->type == oIndexInvalid ||
+			IS_SYS_TREE_OIDS(page_desc->oids))
+			continue;
+
+		/* Don't write the file under the page lock */
+		if (dumpState.len + sizeof(entry) + ORIOLEDB_BLCKSZ > PREWARM_CHUNK_SIZE &&
+			!prewarm_dump_flush())
+			return;
+
+		/* Don't wait for the busy pages, they are hot anyway */
+		if (!try_lock_page(blkno))
+			continue;
+
+		if (!ORelOidsIsValid(page_desc->oids) ||
+			page_desc->type == oIndexInvalid ||
+			IS_SYS_TREE_OIDS(page_desc->oids))
+		{
+			unlock_page(blkno);
+			continue;
+		}
+
+		memset(&entry, 0, sizeof(entry));
+		entry.oids = page_desc->oids;
+		entry.type = page_desc->type;
+		entry.level = PAGE_GET_LEVEL(p);
+		usageCount = O_PAGE_STATE_GET_USAGE_COUNT(pg_atomic_read_u64(&O_PAGE_HEADER(p)->state));
+		if (usageCount < UCM_USAGE_LEVELS)
+			entry.usage = (usageCount + UCM_USAGE_LEVELS - epoch) % UCM_USAGE_LEVELS;
+		entry.diskOff = FileExtentIsValid(page_desc->fileExtent) ?
+			page_desc->fileExtent.off : InvalidFileExtentOff;
+
+		if (!O_PAGE_IS(p, RIGHTMOST))
+		{
+			BTREE_PAGE_GET_HIKEY(hikey, p);
+			entry.hikeyFlags = hikey.formatFlags;
+			entry.hikeyLen = BTREE_PAGE_GET_HIKEY_SIZE(p);
+			memcpy(dumpState.buf + dumpState.len, &entry, sizeof(entry));
+			memcpy(dumpState.buf + dumpState.len + sizeof(entry),
+				   hikey.data, entry.hikeyLen);
+		}
+		else
+		{
+			memcpy(dumpState.buf + dumpState.len, &entry, sizeof(entry));
+		}
+		unlock_page(blkno);
+		dumpState.len += sizeof(entry) + entry.hikeyLen;
+		dumpState.count++;
+	}
+
+	if (dumpState.next >= pool->offset + pool->size)
+		prewarm_dump_finish();
+}
+
+/*
+ * Records the pages resident in the main pool, finishing the dump in
+ * progress if any.  Skipped while prewarm workers are running: the previous
+ * list isn't loaded yet.
+ */
+void
+o_prewarm_dump(void)
+{
+	OPagePool  *pool = get_ppool(OPagePoolMain);
+
+	if (!prewarm_enabled)
+		return;
+
+	if (dumpState.fd < 0)
+	{
+		if (pg_atomic_read_u32(&prewarm_meta->nWorkersRunning) > 0 ||
+			!prewarm_dump_start())
+			return;
+	}
+
+	while (dumpState.fd >= 0)
+		prewarm_dump_step(pool->size);
+}
+
+/*
+ * Records the pages resident in the main pool if orioledb.prewarm_interval
+ * passed since the last time.  The dump is done in slices of
+ * PREWARM_DUMP_SLICE pages per call, so the background writer keeps evicting
+ * pages in between.
+ */
+void
+o_prewarm_dump_if_due(void)
+{
+	TimestampTz now;
+
+	if (!prewarm_enabled)
+		return;
+
+	if (dumpState.fd >= 0)
+	{
+		prewarm_dump_step(PREWARM_DUMP_SLICE);
+		return;
+	}
+
+	if (prewarm_interval == 0)
+		return;
+
+	now = GetCurrentTimestamp();
+	if (last_dump_time == 0)
+	{
+		/* Give the pool some time to fill after the startup */
+		last_dump_time = now;
+		return;
+	}
+
+	if (TimestampDifferenceExceeds(last_dump_time, now,
+								   prewarm_interval * 1000) &&
+		pg_atomic_read_u32(&prewarm_meta->nWorkersRunning) == 0 &&
+		prewarm_dump_start())
+		prewarm_dump_step(PREWARM_DUMP_SLICE);
+}
+
+/*
+ * Opens the saved list of pages.  Returns false if there is no valid list.
+ */
+static bool
+prewarm_reader_open(OPrewarmReader *reader)
+{
+	OPrewarmFileHeader header;
+	int			rc;
+
+	reader->fd = OpenTransientFile(PREWARM_FILENAME, O_RDONLY | PG_BINARY);
+	if (reader->fd < 0)
+	{
+		if (errno != ENOENT)
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\": %m", PREWARM_FILENAME)));
+		return false;
+	}
+
+	rc = read(reader->fd, &header, sizeof(header));
+	if (rc != sizeof(header))
+	{
+		if (rc < 0)
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m", PREWARM_FILENAME)));
+		CloseTransientFile(reader->fd);
+		return false;
+	}
+	if (header.magic != PREWARM_FILE_MAGIC)
+	{
+		ereport(LOG,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("invalid magic number in file \"%s\"", PREWARM_FILENAME)));
+		CloseTransientFile(reader->fd);
+		return false;
+	}
+
+	reader->count = header.count;
+	reader->buf = palloc(PREWARM_CHUNK_SIZE);
+	reader->fileOffset = sizeof(header);
+	reader->pos = 0;
+	reader->len = 0;
+	reader->remaining = reader->count;
+	return true;
+}
+
+/*
+ * Makes the reader start again from the first page of the list.
+ */
+static void
+prewarm_reader_rewind(OPrewarmReader *reader)
+{
+	reader->fileOffset = sizeof(OPrewarmFileHeader);
+	reader->pos = 0;
+	reader->len = 0;
+	reader->remaining = reader->count;
+}
+
+/*
+ * Makes at least `size` unread bytes available in the reader buffer.
+ * Returns false on the end of file or error.
+ */
+static bool
+prewarm_reader_fill(OPrewarmReader *reader, int size)
+{
+	int			rc;
+
+	if (reader->len - reader->pos >= size)
+		return true;
+
+	memmove(reader->buf, reader->buf + reader->pos, reader->len - reader->pos);
+	reader->len -= reader->pos;
+	reader->pos = 0;
+
+	while (reader->len < size)
+	{
+		rc = pg_pread(reader->fd, reader->buf + reader->len,
+					  PREWARM_CHUNK_SIZE - reader->len, reader->fileOffset);
+		if (rc < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m", PREWARM_FILENAME)));
+			return false;
+		}
+		if (rc == 0)
+			return false;
+		reader->len += rc;
+		reader->fileOffset += rc;
+	}
+	return true;
+}
+
+/*
+ * Reads the next page of the list.  The returned hikey points to the reader
+ * buffer and stays valid until the next call.
+ */
+static bool
+prewarm_reader_next(OPrewarmReader *reader, OPrewarmEntry *entry,
+					Pointer *hikey)
+{
+	if (reader->remaining == 0 ||
+		!prewarm_reader_fill(reader, sizeof(OPrewarmEntry)))
+		return false;
+	memcpy(entry, reader->buf + reader->pos, sizeof(OPrewarmEntry));
+	reader->pos += sizeof(OPrewarmEntry);
+
+	if (entry->hikeyLen > ORIOLEDB_BLCKSZ ||
+		!prewarm_reader_fill(reader, entry->hikeyLen))
+		return false;
+	*hikey = reader->buf + reader->pos;
+	reader->pos += entry->hikeyLen;
+	reader->remaining--;
+	return true;
+}
+
+static int
+prewarm_cmp_location(const OPrewarmItem *a, const OPrewarmItem *b)
+{
+	if (a->entry.oids.datoid != b->entry.oids.datoid)
+		return a->entry.oids.datoid < b->entry.oids.datoid ? -1 : 1;
+	if (a->entry.oids.reloid != b->entry.oids.reloid)
+		return a->entry.oids.reloid < b->entry.oids.reloid ? -1 : 1;
+	if (a->entry.oids.relnode != b->entry.oids.relnode)
+		return a->entry.oids.relnode < b->entry.oids.relnode ? -1 : 1;
+	if (a->entry.type != b->entry.type)
+		return a->entry.type < b->entry.type ? -1 : 1;
+	if (a->entry.diskOff != b->entry.diskOff)
+		return a->entry.diskOff < b->entry.diskOff ? -1 : 1;
+	return 0;
+}
+
+static int
+prewarm_cmp_location_qsort(const void *a, const void *b)
+{
+	return prewarm_cmp_location((const OPrewarmItem *) a,
+								(const OPrewarmItem *) b);
+}
+
+/*
+ * Checks if the pool has free pages beyond the background writers headroom.
+ */
+static bool
+prewarm_pool_has_room(OPagePool *pool)
+{
+	return ppool_free_pages_count(pool) >
+		pg_atomic_read_u32(pool->targetFreePagesCount);
+}
+
+/*
+ * Loads the page covering the recorded hikey at the recorded level together
+ * with its parents.  Restores the recorded usage count if the page is colder.
+ */
+static void
+prewarm_load_page(BTreeDescr *desc, OPrewarmItem *item)
+{
+	OBTreeFindPageContext context;
+	OInMemoryBlkno blkno;
+	Page		p;
+	uint32		epoch,
+				usageCount;
+
+	/* The root is loaded with the tree, skip the levels above the leaf */
+	p = O_GET_IN_MEMORY_PAGE(desc->rootInfo.rootPageBlkno);
+	if (item->entry.level >= PAGE_GET_LEVEL(p))
+		return;
+
+	init_page_find_context(&context, desc, COMMITSEQNO_INPROGRESS,
+						   BTREE_PAGE_FIND_MODIFY | BTREE_PAGE_FIND_NO_FIX_SPLIT);
+	if (item->entry.hikeyLen == 0)
+	{
+		(void) find_page(&context, NULL, BTreeKeyRightmost, item->entry.level);
+	}
+	else
+	{
+		OTuple		hikey;
+
+		hikey.formatFlags = item->entry.hikeyFlags;
+		hikey.data = item->hikey;
+		(void) find_page(&context, &hikey, BTreeKeyPageHiKey,
+						 item->entry.level);
+	}
+
+	blkno = context.items[context.index].blkno;
+	p = O_GET_IN_MEMORY_PAGE(blkno);
+	epoch = pg_atomic_read_u32(desc->ppool->ucm.epoch);
+	usageCount = O_PAGE_STATE_GET_USAGE_COUNT(pg_atomic_read_u64(&O_PAGE_HEADER(p)->state));
+	if (usageCount < UCM_USAGE_LEVELS &&
+		(usageCount + UCM_USAGE_LEVELS - epoch) % UCM_USAGE_LEVELS < item->entry.usage)
+		page_change_usage_count(&desc->ppool->ucm, blkno,
+								(epoch + item->entry.usage) % UCM_USAGE_LEVELS);
+	unlock_page(blkno);
+}
+
+static void
+prewarm_worker_exit(int code, Datum arg)
+{
+	pg_atomic_fetch_sub_u32(&prewarm_meta->nWorkersRunning, 1);
+}
+
+void
+register_prewarm_worker(int num)
+{
+	BackgroundWorker worker;
+
+	/* Set up background worker parameters */
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	worker.bgw_main_arg = Int32GetDatum(num);
+	strcpy(worker.bgw_library_name, "orioledb");
+	strcpy(worker.bgw_function_name, "prewarm_worker_main");
+	strcpy(worker.bgw_name, "orioledb prewarm worker");
+	strcpy(worker.bgw_type, "orioledb prewarm worker");
+	RegisterBackgroundWorker(&worker);
+}
+
+/*
+ * Loads the batch of pages in the locality order.  Returns false if loading
+ * should be stopped.
+ */
+static bool
+prewarm_load_batch(OPrewarmItem *items, uint32 count,
+				   OIndexDescr **indexDescr, ORelOids *lockedOids,
+				   uint32 *loaded)
+{
+	OPagePool  *pool = get_ppool(OPagePoolMain);
+	uint32		i;
+
+	qsort(items, count, sizeof(OPrewarmItem), prewarm_cmp_location_qsort);
+
+	for (i = 0; i < count; i++)
+	{
+		OPrewarmItem *item = &items[i];
+
+		if (ShutdownRequestPending || !prewarm_pool_has_room(pool))
+			return false;
+
+		if (!*indexDescr ||
+			!ORelOidsIsEqual(*lockedOids, item->entry.oids) ||
+			(*indexDescr)->desc.type != item->entry.type)
+		{
+			if (*indexDescr)
+				o_tables_rel_unlock_extended(lockedOids,
+											 AccessShareLock, true);
+			*lockedOids = item->entry.oids;
+			*indexDescr = o_fetch_index_descr(*lockedOids,
+											  (OIndexType) item->entry.type,
+											  true, NULL);
+
+			/* The tree is gone since the list was saved */
+			if (!*indexDescr)
+				continue;
+			o_btree_load_shmem(&(*indexDescr)->desc);
+		}
+
+		prewarm_load_page(&(*indexDescr)->desc, item);
+		(*loaded)++;
+	}
+	return true;
+}
+
+void
+prewarm_worker_main(Datum main_arg)
+{
+	OPrewarmReader reader;
+	OPrewarmItem *items;
+	OPrewarmEntry entry;
+	Pointer		hikey;
+	MemoryContext batchContext;
+	OIndexDescr *indexDescr = NULL;
+	ORelOids	lockedOids;
+	uint32		loaded = 0,
+				batchNum = 0,
+				batchSize = 0,
+				count = 0;
+	int			usage;
+	int			num = DatumGetInt32(main_arg);
+	bool		proceed = true;
+
+	ORelOidsSetInvalid(lockedOids);
+
+	/*
+	 * Count ourselves only once started: a worker, which failed to start,
+	 * must not block the dumps forever.
+	 */
+	pg_atomic_fetch_add_u32(&prewarm_meta->nWorkersRunning, 1);
+	on_shmem_exit(prewarm_worker_exit, (Datum) 0);
+
+	/* enable timeout for relation lock */
+	RegisterTimeout(DEADLOCK_TIMEOUT, CheckDeadLockAlert);
+
+	/* enable relation cache invalidation (remove old OTableDescr) */
+	RelationCacheInitialize();
+	InitCatalogCache();
+	SharedInvalBackendInit(false);
+
+	SetProcessingMode(NormalProcessing);
+
+	pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+	BackgroundWorkerUnblockSignals();
+
+	CurTransactionContext = AllocSetContextCreate(TopMemoryContext,
+												  "orioledb prewarm current transaction context",
+												  ALLOCSET_DEFAULT_SIZES);
+	TopTransactionContext = AllocSetContextCreate(TopMemoryContext,
+												  "orioledb prewarm top transaction context",
+												  ALLOCSET_DEFAULT_SIZES);
+	batchContext = AllocSetContextCreate(TopMemoryContext,
+										 "orioledb prewarm batch context",
+										 ALLOCSET_DEFAULT_SIZES);
+
+	if (!prewarm_reader_open(&reader))
+		proc_exit(0);
+
+	items = palloc(sizeof(OPrewarmItem) * PREWARM_BATCH_SIZE);
+
+	PG_TRY();
+	{
+		/*
+		 * Pages are taken from the hottest to the coldest ones: the list is
+		 * read once per usage level.  Every worker splits the list into the
+		 * same batches and loads only its own of them.
+		 */
+		for (usage = UCM_USAGE_LEVELS - 1; usage >= 0 && proceed; usage--)
+		{
+			prewarm_reader_rewind(&reader);
+			while (proceed && prewarm_reader_next(&reader, &entry, &hikey))
+			{
+				if (entry.usage != usage)
+					continue;
+
+				if (batchNum % prewarm_num_workers == num)
+				{
+					items[count].entry = entry;
+					items[count].hikey = MemoryContextAlloc(batchContext,
+															Max(entry.hikeyLen, 1));
+					memcpy(items[count].hikey, hikey, entry.hikeyLen);
+					count++;
+				}
+
+				if (++batchSize < PREWARM_BATCH_SIZE)
+					continue;
+
+				if (count > 0)
+					proceed = prewarm_load_batch(items, count, &indexDescr,
+												 &lockedOids, &loaded);
+				MemoryContextReset(batchContext);
+				MemoryContextReset(CurTransactionContext);
+				batchNum++;
+				batchSize = 0;
+				count = 0;
+			}
+		}
+
+		if (proceed && count > 0)
+			(void) prewarm_load_batch(items, count, &indexDescr,
+									  &lockedOids, &loaded);
+
+		if (indexDescr)
+			o_tables_rel_unlock_extended(&lockedOids, AccessShareLock, true);
+	}
+	PG_CATCH();
+	{
+		LockReleaseSession(DEFAULT_LOCKMETHOD);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	CloseTransientFile(reader.fd);
+	elog(LOG, "orioledb prewarm worker %d loaded %u pages", num, loaded);
+	proc_exit(0);
+}
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# coding: utf-8
+
+from .base_test import BaseTest
+
+
+class AdaptiveHashTest(BaseTest):
+
+	def ahi_stats(self, con):
+		return con.execute("""
+			SELECT coalesce(sum(hits), 0), coalesce(sum(misses), 0)
+			FROM orioledb_get_adaptive_hash_stats()
+			WHERE reloid = 'o_test'::regclass;
+		""")[0]
+
+	def test_adaptive_hash_point_lookups(self):
+		node = self.node
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id int NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT i, 'val' || i FROM generate_series(1, 50000) i;
+		""")
+
+		con = node.connect()
+		con.execute("SET orioledb.adaptive_hash_max_entries = 1024;")
+		con.execute("SET enable_seqscan = off;")
+		con.execute("SET enable_bitmapscan = off;")
+		con.execute("""
+			DO $$
+			DECLARE
+				i int;
+				v text;
+			BEGIN
+				FOR i IN 1..20000 LOOP
+					SELECT val INTO v FROM o_test WHERE id = (i % 100) * 500 + 1;
+					IF v IS DISTINCT FROM 'val' || ((i % 100) * 500 + 1) THEN
+						RAISE EXCEPTION 'wrong value % for %', v, i;
+					END IF;
+				END LOOP;
+			END $$;
+		""")
+		(hits, misses) = self.ahi_stats(con)
+		self.assertGreater(hits, 10000)
+		self.assertGreater(misses, 0)
+		con.commit()
+
+		# Entries must not return stale results after the tree changes
+		node.safe_psql(
+		    'postgres', """
+			DELETE FROM o_test WHERE id % 1000 = 1;
+			UPDATE o_test SET val = 'upd' || id WHERE id % 1000 = 501;
+			INSERT INTO o_test
+				SELECT i, 'val' || i FROM generate_series(50001, 100000) i;
+		""")
+		self.assertEqual(
+		    con.execute("""
+				SELECT count(*) FROM generate_series(0, 99) i,
+					LATERAL (SELECT val FROM o_test
+							 WHERE id = i * 500 + 1) v;
+			""")[0][0], 50)
+		self.assertEqual(
+		    con.execute("""
+				SELECT count(*) FROM generate_series(0, 99) i,
+					LATERAL (SELECT val FROM o_test
+							 WHERE id = i * 500 + 1) v
+				WHERE v.val = 'upd' || (i * 500 + 1);
+			""")[0][0], 50)
+		con.close()
+		node.stop()
+
+	def test_adaptive_hash_disabled(self):
+		node = self.node
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id int NOT NULL PRIMARY KEY
+			) USING orioledb;
+			INSERT INTO o_test SELECT generate_series(1, 1000);
+		""")
+
+		con = node.connect()
+		con.execute("SET enable_seqscan = off;")
+		con.execute("SET enable_bitmapscan = off;")
+		self.assertEqual(
+		    con.execute("""
+				SELECT count(*) FROM generate_series(1, 1000) i,
+					LATERAL (SELECT id FROM o_test WHERE id = i) v;
+			""")[0][0], 1000)
+		self.assertEqual(self.ahi_stats(con), (0, 0))
+		con.close()
+		node.stop()
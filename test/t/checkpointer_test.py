@@ -11,6 +11,7 @@ from .base_test import BaseTest
 from .base_test import wait_checkpointer_stopevent
 from .base_test import generate_string
 from testgres.enums import NodeStatus
+from testgres.exceptions import StartNodeException
 
 import string
 import random
@@ -99,6 +100,260 @@ class CheckpointerTest(BaseTest):
 		    10000)
 		node.stop()
 
+	def test_checkpoint_parallel_workers(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.checkpoint_workers = 3\n")
+		node.start()
+		node.safe_psql('postgres',
+		               "CREATE EXTENSION IF NOT EXISTS orioledb;\n")
+		for i in range(5):
+			node.safe_psql(
+			    'postgres', """
+				CREATE TABLE o_test_%d (
+					id integer NOT NULL PRIMARY KEY,
+					val text NOT NULL
+				) USING orioledb;
+				CREATE INDEX o_test_%d_val_idx ON o_test_%d (val);
+				INSERT INTO o_test_%d
+					SELECT id, 'val' || id FROM generate_series(1, 20000) id;
+			""" % (i, i, i, i))
+		node.safe_psql('postgres', "CHECKPOINT;")
+		node.safe_psql(
+		    'postgres', """
+			UPDATE o_test_0 SET val = val || 'x' WHERE id % 10 = 0;
+			DELETE FROM o_test_1 WHERE id % 2 = 0;
+			CHECKPOINT;
+		""")
+		node.stop(['-m', 'immediate'])
+
+		self.assertTrue(self.is_checkpoint_exist())
+
+		node.start()
+		for i in range(5):
+			self.assertEqual(
+			    node.execute(
+			        "SELECT count(*) FROM o_test_%d WHERE val LIKE 'val1%%';" %
+			        i)[0][0], 11111 if i != 1 else 5556)
+		self.assertEqual(
+		    node.execute(
+		        "SELECT count(*) FROM o_test_0 WHERE val LIKE '%x';")[0][0],
+		    2000)
+		self.assertEqual(
+		    node.execute("SELECT count(*) FROM o_test_1;")[0][0], 10000)
+		node.stop()
+
+	def test_checkpoint_io_uring_writeback(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.io_method = io_uring\n"
+		    "orioledb.main_buffers = 8MB\n"
+		    "checkpoint_flush_after = 8kB\n"
+		    "backend_flush_after = 8kB\n"
+		    "bgwriter_flush_after = 8kB\n")
+		try:
+			node.start()
+		except StartNodeException:
+			self.skipTest("orioledb is built without io_uring")
+
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, repeat('x', 100) || id
+				FROM generate_series(1, 150000) id;
+			CHECKPOINT;
+			UPDATE o_test SET val = val || 'y' WHERE id % 10 = 0;
+			CHECKPOINT;
+		""")
+		with open(node.pg_log_file) as f:
+			log = f.read()
+		if "failed to initialize io_uring" in log:
+			node.stop()
+			self.skipTest("io_uring is not available")
+		self.assertNotIn("io_uring submission failed", log)
+		self.assertNotIn("io_uring completion wait failed", log)
+
+		node.stop(['-m', 'immediate'])
+		node.start()
+		self.assertTrue(
+		    node.execute("SELECT orioledb_tbl_check('o_test'::regclass);")[0]
+		    [0])
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*), count(*) FILTER (WHERE val LIKE '%y')
+				FROM o_test;
+			""")[0], (150000, 15000))
+		node.stop()
+
+	def test_checkpoint_skip_unmodified_subtrees(self):
+		node = self.node
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, repeat('x', 100) || id
+				FROM generate_series(1, 100000) id;
+			CHECKPOINT;
+		""")
+		for i in range(3):
+			node.safe_psql(
+			    'postgres', """
+				UPDATE o_test SET val = val || 'y'
+					WHERE id BETWEEN 50001 AND 50100;
+				DELETE FROM o_test WHERE id = %d;
+				INSERT INTO o_test VALUES (%d, 'z');
+				CHECKPOINT;
+			""" % (70001 + i, 100001 + i))
+		# The changes touch only a few level 1 subtrees, the rest are skipped
+		self.assertGreater(
+		    node.execute("SELECT orioledb_checkpoint_skipped_subtrees();")[0]
+		    [0], 0)
+		node.stop(['-m', 'immediate'])
+
+		node.start()
+		self.assertTrue(
+		    node.execute("SELECT orioledb_tbl_check('o_test'::regclass);")[0]
+		    [0])
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*), count(*) FILTER (WHERE val LIKE '%yyy')
+				FROM o_test;
+			""")[0], (100000, 100))
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*) FROM o_test
+				WHERE id BETWEEN 70001 AND 70003 OR val = 'z';
+			""")[0][0], 3)
+		node.stop()
+
+	def test_checkpoint_compact(self):
+		node = self.node
+		node.append_conf('postgresql.conf',
+		                 "orioledb.compaction_pages_per_checkpoint = 50\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			CREATE INDEX o_test_val_idx ON o_test (val);
+			INSERT INTO o_test
+				SELECT id, repeat('x', 100) || id
+				FROM generate_series(1, 50000) id;
+			CHECKPOINT;
+		""")
+		for i in range(3):
+			node.safe_psql(
+			    'postgres', """
+				UPDATE o_test SET val = val || 'y' WHERE id %% 7 = %d;
+				CHECKPOINT;
+			""" % i)
+		node.stop()
+
+		# all the leaves are on disk after restart
+		node.start()
+		self.assertEqual(
+		    node.execute("SELECT orioledb_tbl_compact('o_test'::regclass);")
+		    [0][0], 3)
+		self.assertEqual(
+		    node.execute(
+		        "SELECT orioledb_tbl_compact_pending('o_test'::regclass);")[0]
+		    [0], 3)
+
+		# the request is cleared once a pass relocates less than the limit
+		for i in range(30):
+			node.safe_psql('postgres', "CHECKPOINT;")
+			pending = node.execute(
+			    "SELECT orioledb_tbl_compact_pending('o_test'::regclass);"
+			)[0][0]
+			if pending == 0:
+				break
+		self.assertEqual(pending, 0)
+		self.assertGreater(i, 0)
+
+		# all the leaves are in order now, so the next request takes a pass
+		node.safe_psql('postgres',
+		               "SELECT orioledb_tbl_compact('o_test'::regclass);")
+		node.safe_psql('postgres', "CHECKPOINT;")
+		self.assertEqual(
+		    node.execute(
+		        "SELECT orioledb_tbl_compact_pending('o_test'::regclass);")[0]
+		    [0], 0)
+		self.assertTrue(
+		    node.execute(
+		        "SELECT orioledb_tbl_check('o_test'::regclass, true);")[0][0])
+		node.stop(['-m', 'immediate'])
+
+		node.start()
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*), count(*) FILTER (WHERE val LIKE '%y')
+				FROM o_test;
+			""")[0], (50000, 21428))
+		self.assertEqual(
+		    node.execute("""
+				SELECT id FROM o_test WHERE val = repeat('x', 100) || '12345';
+			"""), [(12345, )])
+		self.assertTrue(
+		    node.execute(
+		        "SELECT orioledb_tbl_check('o_test'::regclass, true);")[0][0])
+		node.stop()
+
+	def test_checkpoint_adaptive_pacing(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.debug_checkpoint_timeout = 10s\n"
+		    "orioledb.checkpoint_completion_ratio = 1.0\n"
+		    "orioledb.checkpoint_writeback_latency = 1ms\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, repeat('x', 100) || id
+				FROM generate_series(1, 200000) id;
+		""")
+
+		# The timed checkpoint is throttled to finish by its deadline
+		rate = 0
+		for i in range(300):
+			(rate, batch, latency) = node.execute(
+			    "SELECT * FROM orioledb_checkpoint_pacing();")[0]
+			if rate > 0:
+				break
+			time.sleep(0.1)
+		self.assertGreater(rate, 0)
+		self.assertGreaterEqual(batch, 16)
+		self.assertLessEqual(batch, 1024)
+		self.assertGreaterEqual(latency, 0)
+
+		# The immediate checkpoint request makes the throttled one finish at
+		# full speed instead of waiting for its deadline
+		start = time.time()
+		node.safe_psql('postgres', "CHECKPOINT;")
+		self.assertLess(time.time() - start, 5)
+		node.stop(['-m', 'immediate'])
+
+		node.start()
+		self.assertEqual(
+		    node.execute("SELECT count(*) FROM o_test;")[0][0], 200000)
+		node.stop()
+
 	def is_checkpoint_exist(self):
 		orioledb_dir = self.node.data_dir + "/orioledb_data"
 		exist = False
@@ -62,6 +62,36 @@ class EvictionBGWriterTest(BaseTest):
 
 		node.stop()
 
+	def test_eviction_bgwriter_regions(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.main_buffers = 8MB\n"
+		    "orioledb.bgwriter_num_workers = 4\n"
+		    "bgwriter_delay = 10ms\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', "CREATE EXTENSION IF NOT EXISTS orioledb;\n"
+		    "CREATE TABLE o_eviction (\n"
+		    "	key integer NOT NULL,\n"
+		    "	val text NOT NULL,\n"
+		    "	PRIMARY KEY(key)\n"
+		    ") USING orioledb;\n\n")
+		for i in range(4):
+			node.safe_psql(
+			    'postgres', "INSERT INTO o_eviction\n"
+			    "	(SELECT id, repeat('x', 50) || id\n"
+			    "	 FROM generate_series(%d, %d, 1) id);\n" %
+			    (i * 50000 + 1, (i + 1) * 50000))
+		self.assertEqual(
+		    node.execute("SELECT COUNT(*) FROM o_eviction;")[0][0], 200000)
+		self.assertTrue(node.execute("SELECT orioledb_ucm_check();")[0][0])
+		node.stop()
+
+		node.start()
+		self.assertEqual(
+		    node.execute("SELECT COUNT(*) FROM o_eviction;")[0][0], 200000)
+		node.stop()
+
 
 if __name__ == "__main__":
 	unittest.main()
@@ -1,10 +1,14 @@
 #!/usr/bin/env python3
 # coding: utf-8
 
+import glob
+import os
 import unittest
 
 from .base_test import BaseTest
 
+from testgres.exceptions import QueryException
+
 
 class EvictionCompressionTest(BaseTest):
 
@@ -170,5 +174,258 @@ class EvictionCompressionTest(BaseTest):
 		node.stop()
 
 
+	def test_eviction_compress_seqscan_readahead(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.main_buffers = 8MB\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				key integer NOT NULL,
+				val text NOT NULL,
+				PRIMARY KEY (key)
+			) USING orioledb WITH (primary_compress);
+			INSERT INTO o_test
+				SELECT id, repeat('x', id % 100) || id
+				FROM generate_series(1, 200000) id;
+		""")
+
+		con = node.connect()
+		con.execute("SET enable_indexscan = off;")
+		con.execute("SET enable_bitmapscan = off;")
+		for readahead in (0, 1, 32, 1024):
+			con.execute("SET orioledb.seqscan_readahead = %d;" % readahead)
+			self.assertEqual(
+			    con.execute("""
+					SELECT count(*), sum(key), sum(length(val)) FROM o_test;
+				""")[0], (200000, 20000100000, 10988895))
+		con.close()
+		node.stop()
+
+	def test_eviction_compress_dict(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.main_buffers = 8MB\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				key integer NOT NULL,
+				val text NOT NULL,
+				PRIMARY KEY (key)
+			) USING orioledb WITH (primary_compress);
+			INSERT INTO o_test
+				SELECT id, 'customer_' || (id % 1000) || '@example.com'
+				FROM generate_series(1, 100000) id;
+		""")
+
+		self.assertEqual(
+		    node.execute(
+		        "SELECT orioledb_tbl_train_compress_dict('o_test'::regclass);")
+		    [0][0], 1)
+		node.safe_psql(
+		    'postgres', """
+			UPDATE o_test SET val = val || '.org' WHERE key % 3 = 0;
+			INSERT INTO o_test
+				SELECT id, 'customer_' || (id % 1000) || '@example.com'
+				FROM generate_series(100001, 200000) id;
+		""")
+		# Pages compressed with both dictionaries must remain readable
+		self.assertEqual(
+		    node.execute(
+		        "SELECT orioledb_tbl_train_compress_dict('o_test'::regclass);")
+		    [0][0], 1)
+		node.safe_psql('postgres', "CHECKPOINT;")
+
+		query = """
+			SELECT count(*), sum(key), count(*) FILTER (WHERE val LIKE '%.org')
+			FROM o_test;
+		"""
+		expected = [(200000, 20000100000, 33333)]
+		self.assertEqual(node.execute(query), expected)
+		node.stop(['-m', 'immediate'])
+		node.start()
+		self.assertEqual(node.execute(query), expected)
+		node.stop()
+
+	def test_eviction_compress_dict_missing(self):
+		node = self.node
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				key integer NOT NULL,
+				val text NOT NULL,
+				PRIMARY KEY (key)
+			) USING orioledb WITH (primary_compress);
+			INSERT INTO o_test
+				SELECT id, 'customer_' || (id % 1000) || '@example.com'
+				FROM generate_series(1, 100000) id;
+		""")
+		self.assertEqual(
+		    node.execute(
+		        "SELECT orioledb_tbl_train_compress_dict('o_test'::regclass);")
+		    [0][0], 1)
+		node.safe_psql(
+		    'postgres', """
+			UPDATE o_test SET val = val || '.org';
+			CHECKPOINT;
+		""")
+		node.stop()
+		node.start()
+
+		# Load the upper levels of the tree, leave the rest of leaves on disk
+		self.assertEqual(
+		    node.execute("SELECT val FROM o_test WHERE key = 1;"),
+		    [('customer_1@example.com.org', )])
+		dicts = glob.glob(node.data_dir + "/orioledb_data/*/*.dict")
+		self.assertEqual(len(dicts), 1)
+		os.rename(dicts[0], dicts[0] + ".moved")
+
+		# Lookups load leaves to the main pool via the IO downlinks
+		query = """
+			SELECT count(*) FROM generate_series(1, 100000, 1000) i,
+				LATERAL (SELECT val FROM o_test WHERE key = i) v;
+		"""
+		# The failed load must leave the tree usable for the next readers
+		for i in range(2):
+			con = node.connect()
+			with self.assertRaises(QueryException) as e:
+				con.execute(query)
+			self.assertIn("could not read page", e.exception.message)
+			con.close()
+
+		os.rename(dicts[0] + ".moved", dicts[0])
+		self.assertEqual(node.execute(query), [(100, )])
+		self.assertEqual(node.execute("SELECT count(*), sum(key) FROM o_test;"),
+		                 [(100000, 5000050000)])
+		node.stop()
+
+	def test_eviction_compress_lz4(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.main_buffers = 8MB\n")
+		node.start()
+		try:
+			node.safe_psql('postgres',
+			               "SET default_toast_compression = 'lz4';")
+		except Exception:
+			node.stop()
+			self.skipTest("PostgreSQL is built without lz4")
+
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				key integer NOT NULL,
+				val text NOT NULL,
+				PRIMARY KEY (key)
+			) USING orioledb WITH (primary_compress = 'lz4');
+			CREATE INDEX o_test_ix1 ON o_test (val) WITH (compress = 5);
+			INSERT INTO o_test
+				SELECT id, 'value_' || (id % 5000) || '_' || id
+				FROM generate_series(1, 200000) id;
+			CHECKPOINT;
+		""")
+		description = node.execute("""
+			SELECT orioledb_table_description('o_test'::regclass);
+		""")[0][0]
+		self.assertIn("Primary compress = lz4,", description)
+
+		query = """
+			SELECT count(*), sum(key), sum(length(val)) FROM o_test;
+		"""
+		index_query = """
+			SELECT key FROM o_test WHERE val = 'value_1234_101234';
+		"""
+		expected = node.execute(query)
+		self.assertEqual(expected[0][0], 200000)
+		self.assertEqual(node.execute(index_query), [(101234, )])
+		node.stop(['-m', 'immediate'])
+		node.start()
+		self.assertEqual(node.execute(query), expected)
+		self.assertEqual(node.execute(index_query), [(101234, )])
+		node.stop()
+
+	def test_checkpoint_compress_offload(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.main_buffers = 64MB\n"
+		    "orioledb.bgwriter_num_workers = 3\n"
+		    "orioledb.compress_offload_pages = 16\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				key integer NOT NULL,
+				val text NOT NULL,
+				PRIMARY KEY (key)
+			) USING orioledb WITH (compress = 3);
+			INSERT INTO o_test
+				SELECT id, 'value_' || (id % 5000) || '_' || id
+				FROM generate_series(1, 200000) id;
+			CHECKPOINT;
+			UPDATE o_test SET val = val || '_upd' WHERE key % 7 = 0;
+			DELETE FROM o_test WHERE key % 11 = 0;
+			CHECKPOINT;
+		""")
+
+		query = """
+			SELECT count(*), sum(key), sum(length(val)) FROM o_test;
+		"""
+		expected = node.execute(query)
+		node.stop(['-m', 'immediate'])
+		node.start()
+		self.assertEqual(node.execute(query), expected)
+		self.assertEqual(
+		    node.execute(
+		        "SELECT val FROM o_test WHERE key = 70007;")[0][0],
+		    'value_7_70007_upd')
+		node.stop()
+
+	def test_eviction_compress_extents_reuse(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.main_buffers = 8MB\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				key integer NOT NULL,
+				val text NOT NULL,
+				PRIMARY KEY (key)
+			) USING orioledb WITH (primary_compress);
+			INSERT INTO o_test
+				SELECT id, 'value_' || id FROM generate_series(1, 100000) id;
+			CHECKPOINT;
+		""")
+		for i in range(4):
+			node.safe_psql(
+			    'postgres', """
+				UPDATE o_test SET val = val || '_%d' WHERE key %% 3 = %d;
+				CHECKPOINT;
+			""" % (i, i % 3))
+			self.assertTrue(
+			    node.execute(
+			        "SELECT orioledb_tbl_check('o_test'::regclass, true);")[0]
+			    [0])
+
+		query = """
+			SELECT count(*), sum(length(val)) FROM o_test;
+		"""
+		expected = node.execute(query)
+		node.stop(['-m', 'immediate'])
+		node.start()
+		self.assertEqual(node.execute(query), expected)
+		self.assertEqual(
+		    node.execute("SELECT val FROM o_test WHERE key = 30000;")[0][0],
+		    'value_30000_0_3')
+		self.assertTrue(
+		    node.execute(
+		        "SELECT orioledb_tbl_check('o_test'::regclass, true);")[0][0])
+		node.stop()
+
 if __name__ == "__main__":
 	unittest.main()
@@ -684,3 +684,303 @@ class EvictionTest(BaseTest):
 			    )[0][0].split('\n')[0], INDEX_EMPTY_NOT_LOADED)
 		finally:
 			con1.close()
+
+	def test_eviction_scan_resistant(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.main_buffers = 8MB\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_hot (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			CREATE TABLE o_big (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_hot
+				SELECT id, repeat('x', 100) FROM generate_series(1, 5000) id;
+			INSERT INTO o_big
+				SELECT id, repeat('y', 100) FROM generate_series(1, 200000) id;
+		""")
+
+		hot_pages_sql = """
+			SELECT coalesce(sum(pages), 0) FROM orioledb_tree_residency
+			WHERE reloid = 'o_hot_pkey'::regclass;
+		"""
+		hot_lookup_sql = """
+			SELECT count(*) FROM generate_series(1, 5000, 7) i,
+				LATERAL (SELECT val FROM o_hot WHERE id = i) v;
+		"""
+
+		con = node.connect()
+		for scan_resistant in ['on', 'off']:
+			con.execute("SET orioledb.scan_resistant_eviction = %s;" %
+			            scan_resistant)
+			self.assertEqual(con.execute(hot_lookup_sql)[0][0], 715)
+			hot_pages = con.execute(hot_pages_sql)[0][0]
+			self.assertGreater(hot_pages, 0)
+			for i in range(3):
+				self.assertEqual(
+				    con.execute("SELECT count(*) FROM o_big;")[0][0], 200000)
+
+				# The hot set stays resident across the scan
+				if scan_resistant == 'on':
+					self.assertGreaterEqual(
+					    con.execute(hot_pages_sql)[0][0], hot_pages * 0.9)
+				self.assertEqual(con.execute(hot_lookup_sql)[0][0], 715)
+				con.execute("ANALYZE o_big;")
+			self.assertTrue(con.execute("SELECT orioledb_ucm_check();")[0][0])
+		con.close()
+		node.stop()
+
+	def test_eviction_separate_buffers_region(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.main_buffers = 8MB\n"
+		    "orioledb.huge_pages = try\n"
+		    "orioledb.prefault_buffers = on\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, repeat('x', 100) FROM generate_series(1, 100000) id;
+		""")
+
+		stats = node.execute("""
+			SELECT memory_page_size, tlb_entries, all_pages
+			FROM orioledb_page_stats() WHERE pool_name = 'main';
+		""")[0]
+		self.assertGreater(stats[0], 0)
+		self.assertEqual(stats[1], (stats[2] * 8192 + stats[0] - 1) // stats[0])
+
+		node.stop(['-m', 'immediate'])
+		node.start()
+		self.assertEqual(
+		    node.execute("SELECT count(*) FROM o_test;")[0][0], 100000)
+		self.assertTrue(node.execute("SELECT orioledb_ucm_check();")[0][0])
+		node.stop()
+
+	def test_eviction_memory_pin(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.main_buffers = 8MB\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_hot (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb WITH (memory_pin = true);
+			CREATE TABLE o_big (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_hot
+				SELECT id, repeat('x', 100) FROM generate_series(1, 5000) id;
+			ALTER TABLE o_big SET (memory_quota = 2);
+			INSERT INTO o_big
+				SELECT id, repeat('y', 100) FROM generate_series(1, 200000) id;
+		""")
+
+		hot_pages_sql = """
+			SELECT coalesce(sum(r.pages), 0)
+			FROM orioledb_tree_residency r
+			JOIN pg_class c ON c.oid = r.reloid
+			WHERE c.relname IN ('o_hot', 'o_hot_pkey');
+		"""
+		hot_pages = node.execute(hot_pages_sql)[0][0]
+		self.assertGreater(hot_pages, 0)
+
+		for i in range(3):
+			self.assertEqual(
+			    node.execute("SELECT count(*) FROM o_big;")[0][0], 200000)
+		self.assertGreater(node.execute(hot_pages_sql)[0][0], 0)
+		self.assertEqual(
+		    node.execute("SELECT count(*) FROM o_hot;")[0][0], 5000)
+		self.assertTrue(node.execute("SELECT orioledb_ucm_check();")[0][0])
+		node.stop()
+
+	def test_eviction_compressed_tier(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.main_buffers = 8MB\n"
+		    "orioledb.compressed_buffers = 8MB\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, repeat('x', 100) || id FROM generate_series(1, 150000) id;
+		""")
+
+		for i in range(3):
+			self.assertEqual(
+			    node.execute("""
+					SELECT count(*), sum(length(val)) FROM o_test;
+				""")[0], (150000, 15788895))
+			self.assertEqual(
+			    node.execute("""
+					SELECT count(*) FROM generate_series(1, 150000, 13) i,
+						LATERAL (SELECT val FROM o_test WHERE id = i) v
+					WHERE v.val = repeat('x', 100) || i;
+				""")[0][0], 11539)
+
+		# The table doesn't fit main_buffers, so the reloads of the evicted
+		# pages should be served from the compressed tier.
+		puts, hits, misses = node.execute("""
+			SELECT puts, hits, misses FROM orioledb_compressed_tier_stats();
+		""")[0]
+		self.assertGreater(puts, 0)
+		self.assertGreater(hits, 0)
+
+		node.safe_psql('postgres', "UPDATE o_test SET val = val || 'y';")
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*) FROM o_test WHERE val LIKE '%y';
+			""")[0][0], 150000)
+		self.assertTrue(node.execute("SELECT orioledb_ucm_check();")[0][0])
+		node.stop()
+
+	def test_eviction_bulk_read_ring(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.main_buffers = 8MB\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_hot (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			CREATE TABLE o_big (
+				id integer NOT NULL PRIMARY KEY,
+				j integer NOT NULL
+			) USING orioledb;
+			CREATE INDEX o_big_ix ON o_big USING btree (j)
+				WITH (orioledb_index = off);
+			INSERT INTO o_hot
+				SELECT id, repeat('x', 100) FROM generate_series(1, 5000) id;
+			INSERT INTO o_big
+				SELECT id, id FROM generate_series(1, 600000) id;
+		""")
+		node.stop()
+		node.start()
+
+		hot_pages_query = """
+			SELECT coalesce(sum(pages), 0) FROM orioledb_tree_residency
+			WHERE reloid = 'o_hot_pkey'::regclass;
+		"""
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*) FROM generate_series(1, 5000) i,
+					LATERAL (SELECT val FROM o_hot WHERE id = i) v;
+			""")[0][0], 5000)
+		hot_pages = node.execute(hot_pages_query)[0][0]
+		self.assertGreater(hot_pages, 0)
+
+		node.safe_psql('postgres', "VACUUM o_big;")
+		self.assertEqual(node.execute(hot_pages_query)[0][0], hot_pages)
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*) FROM o_big WHERE j <= 1000;
+			""")[0][0], 1000)
+		self.assertTrue(node.execute("SELECT orioledb_ucm_check();")[0][0])
+		node.stop()
+
+	def test_eviction_tree_stats(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "orioledb.main_buffers = 8MB\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, repeat('x', 100) FROM generate_series(1, 200000) id;
+		""")
+
+		stats_query = """
+			SELECT pages, (SELECT sum(l) FROM unnest(pages_by_level) l),
+				   cardinality(pages_by_level), avg_usage BETWEEN 0 AND 6,
+				   loads, evictions, splits
+			FROM orioledb_tree_stats
+			WHERE reloid = 'o_test_pkey'::regclass;
+		"""
+		(pages, level_pages, levels, usage_ok, loads, evictions,
+		 splits) = node.execute(stats_query)[0]
+		self.assertGreater(pages, 0)
+		self.assertEqual(level_pages, pages)
+		self.assertGreater(levels, 1)
+		self.assertTrue(usage_ok)
+		self.assertGreater(evictions, 0)
+		self.assertGreater(splits, 0)
+
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*) FROM generate_series(1, 200000, 97) i,
+					LATERAL (SELECT val FROM o_test WHERE id = i) v;
+			""")[0][0], 2062)
+		self.assertGreater(node.execute(stats_query)[0][4], loads)
+		node.stop()
+
+	def test_eviction_page_cache_flush(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.main_buffers = 8MB\n"
+		    "checkpoint_timeout = 86400\n"
+		    "orioledb.debug_disable_bgwriter = true\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val integer NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, id FROM generate_series(1, 100) id;
+		""")
+
+		free_pages_query = """
+			SELECT free_pages FROM orioledb_page_stats()
+			WHERE pool_name = 'main';
+		"""
+		node.safe_psql('postgres', "UPDATE o_test SET val = val + 1;")
+		free_pages = node.execute(free_pages_query)[0][0]
+
+		for i in range(50):
+			con = node.connect()
+			con.execute("UPDATE o_test SET val = val + 1;")
+			con.commit()
+			con.close()
+		self.assertEqual(node.execute(free_pages_query)[0][0], free_pages)
+
+		# Backends terminated in the middle of transaction return their
+		# cached pages too
+		for i in range(10):
+			con = node.connect()
+			pid = con.execute("SELECT pg_backend_pid();")[0][0]
+			con.execute("UPDATE o_test SET val = val + 1;")
+			self.assertTrue(
+			    node.execute("SELECT pg_terminate_backend(%d, 10000);" %
+			                 pid)[0][0])
+			con.close()
+		self.assertEqual(node.execute(free_pages_query)[0][0], free_pages)
+		self.assertEqual(
+		    node.execute("SELECT count(*) FROM o_test;")[0][0], 100)
+		node.stop()
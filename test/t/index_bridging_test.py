@@ -5,6 +5,8 @@ import re
 import unittest
 
 from .base_test import BaseTest
+from .base_test import ThreadQueryExecutor
+from .base_test import wait_stopevent
 
 
 class IndexBridgingTest(BaseTest):
@@ -252,3 +254,100 @@ class IndexBridgingTest(BaseTest):
 							SET LOCAL enable_seqscan = off;
 							SELECT * FROM o_test ORDER BY j;
 						 """))
+
+	def test_bitmap_batch_primary_lookups(self):
+		node = self.node
+		node.start()
+
+		# Ids are even, so odd ids inserted later fall between the existing
+		# ones and split the leaves and their parents.  Secondary key k
+		# spreads the matching ids over the whole primary key range.
+		node.safe_psql("""
+			CREATE EXTENSION orioledb;
+			CREATE TABLE o_bitmap (
+				id int NOT NULL PRIMARY KEY,
+				j int,
+				k int,
+				pad text
+			) USING orioledb;
+			CREATE INDEX o_bitmap_ix1 ON o_bitmap (j) WITH (orioledb_index=off);
+			CREATE INDEX o_bitmap_ix2 ON o_bitmap (k);
+			INSERT INTO o_bitmap
+				SELECT 2 * v, v, (v * 7919) % 60000, repeat('x', 200)
+				FROM generate_series(1, 60000) v;
+			ANALYZE o_bitmap;
+			CHECKPOINT;
+		""")
+
+		query = """
+			SELECT id, j, k FROM o_bitmap
+			WHERE j = -1 OR k BETWEEN 1000 AND 3000
+			ORDER BY id;
+		"""
+
+		def expected_by_key_lookups():
+			con = node.connect()
+			con.execute("SET enable_seqscan = off;")
+			con.execute("SET enable_bitmapscan = off;")
+			result = con.execute("""
+				SELECT id, j, k FROM o_bitmap
+				WHERE k BETWEEN 1000 AND 3000
+				ORDER BY id;
+			""")
+			con.close()
+			return result
+
+		def bitmap_connection():
+			con = node.connect()
+			con.execute("SET enable_seqscan = off;")
+			con.execute("SET enable_indexscan = off;")
+			plan = con.execute("EXPLAIN (COSTS OFF, FORMAT JSON) " +
+			                   query)[0][0][0]["Plan"]
+			while plan["Node Type"] != 'BitmapOr':
+				plan = plan["Plans"][0]
+			# The bridged index goes first, so the orioledb index looks up
+			# primary tuples in batches
+			self.assertEqual('o_bitmap_ix1', plan["Plans"][0]["Index Name"])
+			self.assertEqual('o_bitmap_ix2', plan["Plans"][1]["Index Name"])
+			return con
+
+		expected = expected_by_key_lookups()
+		self.assertEqual(2001, len(expected))
+
+		# Leaves are on disk after the restart
+		node.stop()
+		node.start()
+		con1 = bitmap_connection()
+		self.assertEqual(expected, con1.execute(query))
+		self.assertEqual(expected, con1.execute(query))
+		con1.close()
+
+		# Split the pages while the batch holds the parent image
+		node.stop()
+		node.start()
+		con1 = bitmap_connection()
+		con1.execute("SET orioledb.enable_stopevents = true;")
+		con2 = node.connect()
+		con2.execute(
+		    "SELECT pg_stopevent_set('page_read', "
+		    "'$.treeName == \"o_bitmap_pkey\" && $.level == 1 && "
+		    "$pid == %d');" % (con1.pid, ))
+
+		t1 = ThreadQueryExecutor(con1, query)
+		t1.start()
+		wait_stopevent(node, con1.pid)
+
+		con2.execute("""
+			INSERT INTO o_bitmap
+				SELECT 2 * v + 1, NULL, NULL, repeat('y', 200)
+				FROM generate_series(1, 60000, 3) v;
+		""")
+		con2.commit()
+		con2.execute("SELECT pg_stopevent_reset('page_read');")
+
+		self.assertEqual(expected, t1.join())
+		self.assertEqual(expected, con1.execute(query))
+		self.assertEqual(expected, expected_by_key_lookups())
+		con1.close()
+		con2.close()
+		node.stop()
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# coding: utf-8
+
+import os
+import time
+import unittest
+
+from .base_test import BaseTest
+
+
+class PrewarmTest(BaseTest):
+
+	def resident_pages(self, node):
+		return node.execute("""
+			SELECT coalesce(sum(pages), 0) FROM orioledb_tree_residency
+			WHERE datoid = (SELECT oid FROM pg_database
+							WHERE datname = current_database());
+		""")[0][0]
+
+	def test_prewarm_restart(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.main_buffers = 32MB\n"
+		    "orioledb.prewarm = on\n"
+		    "orioledb.prewarm_workers = 3\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			CREATE INDEX o_test_val_idx ON o_test (val);
+			INSERT INTO o_test
+				SELECT id, 'val' || id FROM generate_series(1, 50000) id;
+			CHECKPOINT;
+		""")
+		before = self.resident_pages(node)
+		self.assertGreater(before, 0)
+		node.stop()
+
+		node.start()
+		after = 0
+		for i in range(100):
+			after = self.resident_pages(node)
+			if after >= before // 2:
+				break
+			time.sleep(0.1)
+		self.assertGreaterEqual(after, before // 2)
+
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*), count(DISTINCT val) FROM o_test;
+			""")[0], (50000, 50000))
+		self.assertEqual(
+		    node.execute("""
+				SELECT count(*) FROM o_test WHERE val LIKE 'val1%';
+			""")[0][0], 11111)
+		node.stop()
+
+	def test_prewarm_periodic_dump(self):
+		node = self.node
+		node.append_conf(
+		    'postgresql.conf', "orioledb.main_buffers = 32MB\n"
+		    "orioledb.prewarm = on\n"
+		    "orioledb.prewarm_interval = 1\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, 'val' || id FROM generate_series(1, 50000) id;
+			CHECKPOINT;
+		""")
+		before = self.resident_pages(node)
+		self.assertGreater(before, 0)
+
+		# The list saved by the background writer survives the crash
+		prewarm_file = os.path.join(node.data_dir, 'orioledb_data', 'prewarm')
+		for i in range(100):
+			if os.path.exists(prewarm_file) and \
+			   os.path.getsize(prewarm_file) > 1024:
+				break
+			time.sleep(0.1)
+		self.assertTrue(os.path.exists(prewarm_file))
+		node.stop(['-m', 'immediate'])
+
+		node.start()
+		after = 0
+		for i in range(100):
+			after = self.resident_pages(node)
+			if after >= before // 2:
+				break
+			time.sleep(0.1)
+		self.assertGreaterEqual(after, before // 2)
+		self.assertEqual(
+		    node.execute("SELECT count(*) FROM o_test;")[0][0], 50000)
+		node.stop()
+
+	def test_prewarm_workers_not_started(self):
+		node = self.node
+		# The background writer takes the only slot, so prewarm workers
+		# can't start
+		node.append_conf(
+		    'postgresql.conf', "orioledb.main_buffers = 32MB\n"
+		    "orioledb.prewarm = on\n"
+		    "orioledb.prewarm_workers = 2\n"
+		    "orioledb.prewarm_interval = 1\n"
+		    "max_worker_processes = 1\n")
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_test (
+				id integer NOT NULL PRIMARY KEY,
+				val text NOT NULL
+			) USING orioledb;
+			INSERT INTO o_test
+				SELECT id, 'val' || id FROM generate_series(1, 50000) id;
+			CHECKPOINT;
+		""")
+
+		# The dumps aren't blocked by the workers never started
+		prewarm_file = os.path.join(node.data_dir, 'orioledb_data', 'prewarm')
+		for i in range(100):
+			if os.path.exists(prewarm_file) and \
+			   os.path.getsize(prewarm_file) > 1024:
+				break
+			time.sleep(0.1)
+		self.assertTrue(os.path.exists(prewarm_file))
+		self.assertGreater(os.path.getsize(prewarm_file), 1024)
+		node.stop()
+
+
+if __name__ == "__main__":
+	unittest.main()
@@ -2214,6 +2214,58 @@ class RecoveryTest(BaseTest):
 
 		node.stop()
 
+	def test_recovery_copy_multi_insert(self):
+		node = self.node
+		node.append_conf('postgresql.conf', "checkpoint_timeout = 1d\n")
+		node.start()
+
+		node.safe_psql("""
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+
+			CREATE TABLE o_test (
+				id int primary key,
+				val int NOT NULL
+			) USING orioledb;
+
+			CREATE INDEX o_test_val_idx ON o_test (val);
+			CREATE UNIQUE INDEX o_test_neg_idx ON o_test ((-id));
+		""")
+
+		# COPY passes tuples to multi_insert in batches, which are inserted
+		# in primary key order.  Feed keys in descending and interleaved order.
+		node.safe_psql("""
+			COPY o_test (id, val) FROM PROGRAM
+				'seq 20000 -2 2 | sed "s/.*/&,&/"' WITH (FORMAT csv);
+		""")
+		node.safe_psql("""
+			COPY o_test (id, val) FROM PROGRAM
+				'seq 1 2 19999 | sed "s/.*/&,&/"' WITH (FORMAT csv);
+		""")
+
+		with self.assertRaises(Exception):
+			node.safe_psql("""
+				COPY o_test (id, val) FROM PROGRAM
+					'seq 30000 -1 19990 | sed "s/.*/&,&/"' WITH (FORMAT csv);
+			""")
+
+		def check():
+			self.assertEqual(
+			    node.execute("SELECT count(*), sum(id), sum(val) "
+			                 "FROM o_test;")[0], (20000, 200010000, 200010000))
+			self.assertEqual(
+			    node.execute("SET enable_seqscan = off; "
+			                 "SELECT count(*) FROM o_test WHERE val > 10000;")
+			    [0][0], 10000)
+			self.assertTrue(
+			    node.execute("SELECT orioledb_tbl_check('o_test'::regclass);")
+			    [0][0])
+
+		check()
+		node.stop(['-m', 'immediate'])
+		node.start()
+		check()
+		node.stop()
+
 
 class RecoveryWithArchivingTest(BaseTest):
 
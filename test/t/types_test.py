@@ -767,3 +767,132 @@ class TypesTest(BaseTest):
 		con3.close()
 		self.check_total_deleted(node, 'TABLESPACE_CACHE', 5, 2)
 		node.stop()
+
+	def test_fastpath_prefix_keys(self):
+		node = self.node
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_prefix_text (
+				id text COLLATE "C" NOT NULL PRIMARY KEY,
+				val int NOT NULL
+			) USING orioledb;
+			CREATE TABLE o_prefix_tenant (
+				tenant_id int NOT NULL,
+				name text COLLATE "C" NOT NULL,
+				val int NOT NULL,
+				PRIMARY KEY (tenant_id, name)
+			) USING orioledb;
+			CREATE TABLE o_prefix_numeric (
+				id int NOT NULL PRIMARY KEY,
+				num numeric,
+				val int NOT NULL
+			) USING orioledb;
+			CREATE INDEX o_prefix_numeric_idx ON o_prefix_numeric (num DESC NULLS LAST);
+			INSERT INTO o_prefix_text
+				SELECT 'common_prefix_' || md5(i::text), i
+				FROM generate_series(1, 50000) i;
+			INSERT INTO o_prefix_tenant
+				SELECT i % 5, 'tenant_name_' || md5(i::text), i
+				FROM generate_series(1, 50000) i;
+			INSERT INTO o_prefix_numeric
+				SELECT i, CASE WHEN i % 100 = 0 THEN NULL
+							   ELSE 1000000000000 + i / 3 + 0.125 END, i
+				FROM generate_series(1, 50000) i;
+		""")
+
+		con = node.connect()
+		con.execute("SET enable_seqscan = off;")
+		con.execute("SET enable_bitmapscan = off;")
+		# Repeat the lookups so that the cached prefixes are used too
+		for _ in range(3):
+			for i in [1, 777, 12345, 33333, 49999]:
+				self.assertEqual([(i, )],
+				                 con.execute("""
+					SELECT val FROM o_prefix_text
+					WHERE id = 'common_prefix_' || md5('%d');
+				""" % (i, )))
+				self.assertEqual([(i, )],
+				                 con.execute("""
+					SELECT val FROM o_prefix_tenant
+					WHERE tenant_id = %d AND name = 'tenant_name_' || md5('%d');
+				""" % (i % 5, i)))
+				self.assertEqual([(i, )],
+				                 con.execute("""
+					SELECT val FROM o_prefix_numeric
+					WHERE num = 1000000000000 + %d / 3 + 0.125 AND val = %d;
+				""" % (i, i)))
+		index_results = con.execute("""
+			SELECT count(*) FROM o_prefix_tenant
+			WHERE tenant_id = 3 AND name > 'tenant_name_8';
+		""") + con.execute("""
+			SELECT count(*) FROM o_prefix_numeric
+			WHERE num > 1000000000000 + 10000.125;
+		""") + con.execute("""
+			SELECT count(*) FROM o_prefix_numeric WHERE num IS NULL;
+		""")
+		con.execute("SET enable_seqscan = on;")
+		con.execute("SET enable_indexscan = off;")
+		seq_results = con.execute("""
+			SELECT count(*) FROM o_prefix_tenant
+			WHERE tenant_id = 3 AND name > 'tenant_name_8';
+		""") + con.execute("""
+			SELECT count(*) FROM o_prefix_numeric
+			WHERE num > 1000000000000 + 10000.125;
+		""") + con.execute("""
+			SELECT count(*) FROM o_prefix_numeric WHERE num IS NULL;
+		""")
+		self.assertEqual(seq_results, index_results)
+		self.assertEqual((500, ), index_results[2])
+		con.close()
+		node.stop()
+
+	def test_fastpath_composite_keys(self):
+		node = self.node
+		node.start()
+		node.safe_psql(
+		    'postgres', """
+			CREATE EXTENSION IF NOT EXISTS orioledb;
+			CREATE TABLE o_fastpath_uuid (
+				tenant_id int2 NOT NULL,
+				id uuid NOT NULL,
+				val int NOT NULL,
+				PRIMARY KEY (tenant_id, id)
+			) USING orioledb;
+			CREATE TABLE o_fastpath_ts (
+				ts timestamptz NOT NULL,
+				d date NOT NULL,
+				val int NOT NULL,
+				PRIMARY KEY (ts, d)
+			) USING orioledb;
+			INSERT INTO o_fastpath_uuid
+				SELECT i % 7, md5(i::text)::uuid, i
+				FROM generate_series(1, 50000) i;
+			INSERT INTO o_fastpath_ts
+				SELECT '2020-01-01'::timestamptz + (i / 3) * interval '1 minute',
+					   '2020-01-01'::date + i % 3, i
+				FROM generate_series(1, 50000) i;
+		""")
+
+		con = node.connect()
+		con.execute("SET enable_seqscan = off;")
+		con.execute("SET enable_bitmapscan = off;")
+		for i in [1, 777, 12345, 49999]:
+			self.assertEqual([(i, )],
+			                 con.execute("""
+				SELECT val FROM o_fastpath_uuid
+				WHERE tenant_id = %d AND id = md5('%d')::uuid;
+			""" % (i % 7, i)))
+			self.assertEqual([(i, )],
+			                 con.execute("""
+				SELECT val FROM o_fastpath_ts
+				WHERE ts = '2020-01-01'::timestamptz + %d * interval '1 minute'
+				  AND d = '2020-01-01'::date + %d;
+			""" % (i // 3, i % 3)))
+		self.assertEqual([(len([i for i in range(1, 50001) if i % 7 == 3]), )],
+		                 con.execute("""
+			SELECT count(*) FROM o_fastpath_uuid WHERE tenant_id = 3;
+		"""))
+		con.close()
+		node.stop()